@@ -0,0 +1,41 @@
+import esphome.codegen as cg
+import esphome.config_validation as cv
+from esphome.components.audio_utils import STREAM_FORMATS, add_stream_format_defines
+from esphome.const import CONF_ID
+
+CODEOWNERS = ["@dwitgen"]
+DEPENDENCIES = ["esp32"]
+AUTO_LOAD = ["audio_utils"]
+
+CONF_BLOCK_SIZES = "block_sizes"
+CONF_RUNS = "runs"
+CONF_START_DELAY = "start_delay"
+
+audio_bench_ns = cg.esphome_ns.namespace("audio_bench")
+AudioBench = audio_bench_ns.class_("AudioBench", cg.Component)
+
+# Benchmarks the audio kernels with the cycle counter and logs one JSON line per case, for
+# comparison against a baseline with the host benchmark (host_sim/, esp_adf_bench --results)
+CONFIG_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.declare_id(AudioBench),
+        cv.Optional(CONF_BLOCK_SIZES, default=[32, 256, 1024]): cv.ensure_list(
+            cv.int_range(min=1, max=4096)
+        ),
+        cv.Optional(CONF_RUNS, default=5): cv.int_range(min=1, max=100),
+        cv.Optional(
+            CONF_START_DELAY, default="10s"
+        ): cv.positive_time_period_milliseconds,
+    }
+).extend(cv.COMPONENT_SCHEMA)
+
+
+async def to_code(config):
+    var = cg.new_Pvariable(config[CONF_ID])
+    await cg.register_component(var, config)
+    for block_frames in config[CONF_BLOCK_SIZES]:
+        cg.add(var.add_block_size(block_frames))
+    cg.add(var.set_runs(config[CONF_RUNS]))
+    cg.add(var.set_start_delay(config[CONF_START_DELAY]))
+    # The conversion cases run every stream format
+    add_stream_format_defines(STREAM_FORMATS)
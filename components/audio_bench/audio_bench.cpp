@@ -0,0 +1,78 @@
+#include "audio_bench.h"
+
+#ifdef USE_ESP32
+
+#include "esphome/core/hal.h"
+#include "esphome/core/log.h"
+
+#if __has_include(<esp_cpu.h>)
+#include <esp_cpu.h>
+#define AUDIO_BENCH_CYCLE_COUNT() esp_cpu_get_cycle_count()
+#else
+#include <xtensa/hal.h>
+#define AUDIO_BENCH_CYCLE_COUNT() xthal_get_ccount()
+#endif
+
+namespace esphome {
+namespace audio_bench {
+
+static const char *const TAG = "audio_bench";
+
+// The 32-bit counter wraps every few seconds; a single timed run is far shorter, so the
+// difference of two readings is always right
+static uint64_t cycle_clock() {
+  static uint32_t last = 0;
+  static uint64_t high = 0;
+  uint32_t now = AUDIO_BENCH_CYCLE_COUNT();
+  if (now < last)
+    high += 1ULL << 32;
+  last = now;
+  return high | now;
+}
+
+void AudioBench::setup() { this->start_ms_ = millis(); }
+
+void AudioBench::loop() {
+  if (this->done_ || this->block_sizes_.empty() || millis() - this->start_ms_ < this->start_delay_ms_)
+    return;
+
+  if (!this->checked_) {
+    this->checked_ = true;
+    for (size_t index = 0; index < get_check_count(); index++) {
+      char line[160];
+      if (run_check(index, line, sizeof(line))) {
+        ESP_LOGI(TAG, "%s", line);
+      } else {
+        ESP_LOGE(TAG, "%s", line);
+        this->status_set_error();
+      }
+    }
+    return;
+  }
+
+  BenchResult result = run_case(this->case_index_, this->block_sizes_[this->block_index_], cycle_clock, this->runs_);
+  char line[160];
+  format_result(line, sizeof(line), result, "cycles");
+  ESP_LOGI(TAG, "%s", line);
+
+  if (++this->block_index_ == this->block_sizes_.size()) {
+    this->block_index_ = 0;
+    if (++this->case_index_ == get_case_count()) {
+      this->done_ = true;
+      ESP_LOGI(TAG, "Finished %u cases", (unsigned) get_case_count());
+    }
+  }
+}
+
+void AudioBench::dump_config() {
+  ESP_LOGCONFIG(TAG, "Audio Benchmark:");
+  ESP_LOGCONFIG(TAG, "  Cases: %u, runs: %u, start delay: %u ms", (unsigned) get_case_count(), (unsigned) this->runs_,
+                (unsigned) this->start_delay_ms_);
+  for (size_t block_frames : this->block_sizes_)
+    ESP_LOGCONFIG(TAG, "  Block size: %u frames", (unsigned) block_frames);
+}
+
+}  // namespace audio_bench
+}  // namespace esphome
+
+#endif  // USE_ESP32
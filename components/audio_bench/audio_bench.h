@@ -0,0 +1,43 @@
+#pragma once
+
+#ifdef USE_ESP32
+
+#include "bench_cases.h"
+
+#include "esphome/core/component.h"
+
+#include <vector>
+
+namespace esphome {
+namespace audio_bench {
+
+/// Runs the audio kernel benchmarks on the device, timed with the CPU cycle counter. One case and
+/// block size per loop() so the watchdog and the API keep running. Results are logged in the same
+/// JSON lines format as the host benchmark, which can compare a captured log against a baseline.
+/// The kernel checks run first; a failed one is logged as an error and sets the error status.
+class AudioBench : public Component {
+ public:
+  void setup() override;
+  void loop() override;
+  void dump_config() override;
+  float get_setup_priority() const override { return setup_priority::LATE; }
+
+  void add_block_size(size_t block_frames) { this->block_sizes_.push_back(block_frames); }
+  void set_runs(uint32_t runs) { this->runs_ = runs; }
+  void set_start_delay(uint32_t start_delay_ms) { this->start_delay_ms_ = start_delay_ms; }
+
+ protected:
+  std::vector<size_t> block_sizes_;
+  uint32_t runs_{5};
+  uint32_t start_delay_ms_{10000};
+  uint32_t start_ms_{0};
+  bool checked_{false};  // the kernel checks ran, ahead of the first case
+  size_t case_index_{0};
+  size_t block_index_{0};
+  bool done_{false};
+};
+
+}  // namespace audio_bench
+}  // namespace esphome
+
+#endif  // USE_ESP32
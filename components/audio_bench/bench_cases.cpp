@@ -0,0 +1,243 @@
+#include "bench_cases.h"
+
+#include "esphome/components/audio_utils/audio_stream_info.h"
+#include "esphome/components/audio_utils/biquad.h"
+#include "esphome/components/audio_utils/gain_ramp.h"
+#include "esphome/components/audio_utils/noise_suppressor.h"
+#include "esphome/components/audio_utils/pcm_format.h"
+#include "esphome/components/audio_utils/resampler.h"
+#include "esphome/components/audio_utils/sample_convert.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace esphome {
+namespace audio_bench {
+
+/// Buffers and kernel state shared by the cases. Inputs are filled once with a deterministic
+/// signal, outputs are sized for the widest conversion.
+struct BenchContext {
+  size_t block_frames;
+  std::vector<uint8_t> input;
+  std::vector<uint8_t> output;
+  audio_utils::GainRamp gain_ramp;
+  audio_utils::BiquadFilter biquad;
+  audio_utils::NoiseSuppressor noise_suppressor;
+  audio_utils::PolyphaseResampler<int16_t> resampler16;
+  audio_utils::PolyphaseResampler<float> resampler_float;
+  std::vector<float> input_float;
+  std::vector<float> output_float;
+  double linear_phase{0.0};
+  int16_t linear_previous{0};
+
+  int16_t *input16() { return reinterpret_cast<int16_t *>(this->input.data()); }
+  int32_t *input32() { return reinterpret_cast<int32_t *>(this->input.data()); }
+  int16_t *output16() { return reinterpret_cast<int16_t *>(this->output.data()); }
+};
+
+struct BenchCase {
+  const char *name;
+  size_t output_channels;  // samples per frame the result is normalized to
+  void (*setup)(BenchContext &context);
+  void (*process)(BenchContext &context);
+};
+
+static void convert(BenchContext &context, uint8_t in_bits, uint8_t in_channels, uint8_t out_bits,
+                    uint8_t out_channels) {
+  audio_utils::AudioStreamInfo info;
+  info.bits_per_sample = in_bits;
+  info.channels = in_channels;
+  audio_utils::convert_frames(context.input.data(), info, context.output.data(), out_bits, out_channels,
+                              context.block_frames);
+}
+
+static void no_setup(BenchContext &) {}
+
+using audio_utils::ResampleQuality;
+
+static void resample_setup(BenchContext &context, uint32_t source_rate, uint32_t dest_rate, ResampleQuality quality) {
+  context.resampler16.configure(source_rate, dest_rate, 1, quality);
+}
+
+static void resample(BenchContext &context) {
+  size_t consumed;
+  context.resampler16.process(context.input16(), context.block_frames, &consumed, context.output16(),
+                              context.output.size() / sizeof(int16_t));
+}
+
+static void resample_float(BenchContext &context) {
+  size_t consumed;
+  context.resampler_float.process(context.input_float.data(), context.block_frames, &consumed,
+                                  context.output_float.data(), context.output_float.size());
+}
+
+/// Linear interpolation, what the host simulation runs in place of ADF's rsp_filter. Kept as the
+/// cheapest possible reference for the resample cases.
+static void resample_linear(BenchContext &context, uint32_t source_rate, uint32_t dest_rate) {
+  double &phase = context.linear_phase;
+  const double step = static_cast<double>(source_rate) / dest_rate;
+  const int16_t *in = context.input16();
+  int16_t *out = context.output16();
+  size_t written = 0;
+  for (; phase < context.block_frames; phase += step) {
+    size_t index = static_cast<size_t>(phase);
+    float fraction = static_cast<float>(phase - index);
+    float a = index == 0 ? context.linear_previous : in[index - 1];
+    float b = in[index];
+    out[written++] = static_cast<int16_t>(a + (b - a) * fraction);
+  }
+  phase -= context.block_frames;
+  context.linear_previous = in[context.block_frames - 1];
+}
+
+static const BenchCase CASES[] = {
+    // I2SAudioMicrophone::read with 32-bit slots
+    {"mic_convert_32_to_16", 1, no_setup,
+     [](BenchContext &c) {
+       audio_utils::FormatConverter<audio_utils::PcmFormat<audio_utils::Pcm32<2>, 1>, audio_utils::S16Mono>::convert(
+           c.input.data(), c.output.data(), c.block_frames);
+     }},
+    // I2SAudioSpeaker: 16-bit mono duplicated into both slots, at 16 and 32 bits
+    {"spk_dup_mono16_to_stereo16", 2, no_setup, [](BenchContext &c) { convert(c, 16, 1, 16, 2); }},
+    {"spk_dup_mono16_to_stereo32", 2, no_setup, [](BenchContext &c) { convert(c, 16, 1, 32, 2); }},
+    // I2SAudioSpeaker: stereo streams mixed down to a mono port
+    {"spk_mix_stereo16_to_mono16", 1, no_setup, [](BenchContext &c) { convert(c, 16, 2, 16, 1); }},
+    {"spk_mix_stereo24_to_mono16", 1, no_setup, [](BenchContext &c) { convert(c, 24, 2, 16, 1); }},
+    // Ducking: a ramp that stays in motion for the whole run
+    {"gain_ramp_16",
+     1,
+     [](BenchContext &c) {
+       c.gain_ramp.set_sample_rate(16000);
+       c.gain_ramp.set_attack_ms(60000);
+       c.gain_ramp.set_target_db(-40.0f);
+     },
+     [](BenchContext &c) { c.gain_ramp.process(c.input16(), c.block_frames); }},
+    {"biquad_16",
+     1,
+     [](BenchContext &c) {
+       // Peaking EQ at 1 kHz / 16 kHz, +6 dB, Q 1 in Q2.30
+       c.biquad.set_coefficients({1201231619, -1747324393, 690058675, -1747324393, 817548470});
+     },
+     [](BenchContext &c) { c.biquad.process(c.input16(), c.block_frames); }},
+    {"noise_suppressor_16",
+     1,
+     [](BenchContext &c) {
+       c.noise_suppressor.init(16000);
+       c.noise_suppressor.set_strength(0.7f);
+     },
+     [](BenchContext &c) { c.noise_suppressor.process(c.input16(), c.block_frames); }},
+    // PolyphaseResampler, normalized per input sample. 44.1 kHz streams into the 16 kHz speaker
+    // at each quality, then the other common pairs at the default quality
+    {"resample_44k1_16k_low", 1, [](BenchContext &c) { resample_setup(c, 44100, 16000, ResampleQuality::LOW); },
+     resample},
+    {"resample_44k1_16k_medium", 1,
+     [](BenchContext &c) { resample_setup(c, 44100, 16000, ResampleQuality::MEDIUM); }, resample},
+    {"resample_44k1_16k_high", 1, [](BenchContext &c) { resample_setup(c, 44100, 16000, ResampleQuality::HIGH); },
+     resample},
+    {"resample_48k_16k_medium", 1, [](BenchContext &c) { resample_setup(c, 48000, 16000, ResampleQuality::MEDIUM); },
+     resample},
+    {"resample_22k05_48k_medium", 1,
+     [](BenchContext &c) { resample_setup(c, 22050, 48000, ResampleQuality::MEDIUM); }, resample},
+    {"resample_44k1_16k_medium_float",
+     1,
+     [](BenchContext &c) {
+       c.resampler_float.configure(44100, 16000, 1, ResampleQuality::MEDIUM);
+       c.input_float.assign(c.input16(), c.input16() + c.block_frames);
+       c.output_float.resize(c.resampler_float.max_output_frames(c.block_frames));
+     },
+     resample_float},
+    {"resample_44k1_16k_linear", 1, no_setup, [](BenchContext &c) { resample_linear(c, 44100, 16000); }},
+};
+
+static const size_t CASE_COUNT = sizeof(CASES) / sizeof(CASES[0]);
+
+size_t get_case_count() { return CASE_COUNT; }
+
+const char *get_case_name(size_t index) { return index < CASE_COUNT ? CASES[index].name : nullptr; }
+
+BenchResult run_case(size_t index, size_t block_frames, BenchClock clock, uint32_t runs, size_t min_samples) {
+  const BenchCase &bench = CASES[index];
+  BenchContext context;
+  context.block_frames = block_frames;
+  // Room for up to 32-bit stereo frames on either side
+  context.input.resize(block_frames * 8);
+  context.output.resize(block_frames * 8);
+
+  // Quiet pseudo-random signal, so the in-place kernels never drift into clipping
+  uint32_t seed = 0x12345678;
+  for (auto &byte : context.input) {
+    seed = seed * 1664525 + 1013904223;
+    byte = static_cast<uint8_t>(seed >> 24);
+  }
+  int16_t *samples16 = context.input16();
+  for (size_t i = 0; i < context.input.size() / 2; i++)
+    samples16[i] /= 8;
+  bench.setup(context);
+
+  uint32_t iterations = static_cast<uint32_t>(std::max<size_t>(1, min_samples / block_frames));
+  bench.process(context);  // warm the caches
+
+  uint64_t best = UINT64_MAX;
+  for (uint32_t run = 0; run < runs; run++) {
+    uint64_t start = clock();
+    for (uint32_t i = 0; i < iterations; i++)
+      bench.process(context);
+    best = std::min(best, clock() - start);
+  }
+
+  BenchResult result;
+  result.name = bench.name;
+  result.block_frames = block_frames;
+  result.iterations = iterations;
+  result.per_sample = static_cast<double>(best) / (static_cast<double>(iterations) * block_frames * bench.output_channels);
+  return result;
+}
+
+/// resample_dot_f32() against the scalar loop at every tap count the resampler uses (multiples of 8
+/// up to 32 taps times the largest ratio), on 16-byte aligned rows like the coefficient table.
+static bool check_resample_dot_f32(char *buffer, size_t size) {
+  static const size_t MAX_TAPS = 32 * 8;
+  std::vector<float> storage(2 * MAX_TAPS + 8);
+  uintptr_t address = reinterpret_cast<uintptr_t>(storage.data());
+  float *samples = reinterpret_cast<float *>((address + 15) & ~static_cast<uintptr_t>(15));
+  float *coefficients = samples + MAX_TAPS;
+  uint32_t seed = 0x12345678;
+  for (size_t i = 0; i < 2 * MAX_TAPS; i++) {
+    seed = seed * 1664525 + 1013904223;
+    samples[i] = static_cast<float>(static_cast<int32_t>(seed) >> 16) / (i < MAX_TAPS ? 4096.0f : 32768.0f);
+  }
+
+  double max_error = 0.0;
+  for (size_t taps = 8; taps <= MAX_TAPS; taps += 8) {
+    float fast = audio_utils::resample_dot_f32(samples, coefficients, taps);
+    float scalar = audio_utils::resample_dot_f32_scalar(samples, coefficients, taps);
+    // Relative to the sum of magnitudes, what a different summation order may round away
+    double scale = 0.0;
+    for (size_t i = 0; i < taps; i++)
+      scale += std::fabs(samples[i] * coefficients[i]);
+    max_error = std::max(max_error, std::fabs(fast - scalar) / std::max(scale, 1e-30));
+  }
+  bool ok = max_error < 1e-5;
+  snprintf(buffer, size, "{\"check\":\"resample_dot_f32\",\"max_error\":%.3g,\"ok\":%s}", max_error,
+           ok ? "true" : "false");
+  return ok;
+}
+
+static bool (*const CHECKS[])(char *buffer, size_t size) = {
+    check_resample_dot_f32,
+};
+
+size_t get_check_count() { return sizeof(CHECKS) / sizeof(CHECKS[0]); }
+
+bool run_check(size_t index, char *buffer, size_t size) { return CHECKS[index](buffer, size); }
+
+int format_result(char *buffer, size_t size, const BenchResult &result, const char *unit) {
+  return snprintf(buffer, size, "{\"case\":\"%s\",\"block\":%u,\"unit\":\"%s\",\"per_sample\":%.4f,\"iterations\":%u}",
+                  result.name, static_cast<unsigned>(result.block_frames), unit, result.per_sample,
+                  static_cast<unsigned>(result.iterations));
+}
+
+}  // namespace audio_bench
+}  // namespace esphome
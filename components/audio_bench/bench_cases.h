@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace audio_bench {
+
+/// Monotonic counter the cases are timed with: nanoseconds on the host, CPU cycles on the device.
+using BenchClock = uint64_t (*)();
+
+struct BenchResult {
+  const char *name;
+  size_t block_frames;
+  uint32_t iterations;  // blocks processed per timed run
+  double per_sample;    // clock units per output sample, best of all runs
+};
+
+/// The per-sample kernels of the audio components. Only depends on audio_utils and the standard
+/// library, so the host benchmark and the firmware run exactly the same cases.
+size_t get_case_count();
+const char *get_case_name(size_t index);
+
+/// Time one case at one block size. Each run processes at least `min_samples` samples in blocks of
+/// `block_frames`, and the fastest of `runs` runs is reported, which filters out preemption.
+BenchResult run_case(size_t index, size_t block_frames, BenchClock clock, uint32_t runs = 5,
+                     size_t min_samples = 16384);
+
+/// Checks of the kernels that take a platform specific path (esp-dsp SIMD on the ESP32-S3) against
+/// the portable loops they replace, over the case inputs. Run before timing anything: a fast kernel
+/// with wrong output is a bug, not a speedup. Writes one JSON line to `buffer`; false on mismatch.
+size_t get_check_count();
+bool run_check(size_t index, char *buffer, size_t size);
+
+/// One JSON object per line, the format the baseline comparison reads:
+/// {"case":"...","block":256,"unit":"ns","per_sample":1.234,"iterations":64}
+int format_result(char *buffer, size_t size, const BenchResult &result, const char *unit);
+
+}  // namespace audio_bench
+}  // namespace esphome
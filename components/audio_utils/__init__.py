@@ -0,0 +1,226 @@
+import math
+
+import esphome.codegen as cg
+import esphome.config_validation as cv
+from esphome.components import microphone
+
+CODEOWNERS = ["@dwitgen"]
+
+audio_utils_ns = cg.esphome_ns.namespace("audio_utils")
+
+CONFIG_SCHEMA = cv.Schema({})
+
+LatencyProfile = audio_utils_ns.enum("LatencyProfile", is_class=True)
+
+CONF_LATENCY_PROFILE = "latency_profile"
+CONF_AUTO_TUNE = "auto_tune"
+
+LATENCY_PROFILES = {
+    "ultra_low": LatencyProfile.ULTRA_LOW,
+    "balanced": LatencyProfile.BALANCED,
+    "robust": LatencyProfile.ROBUST,
+}
+
+# Shared by the speakers; with auto_tune the profile is the largest one the tuner may grow to.
+# robust is the 8 x 1024 frame DMA setup the speakers used before profiles existed
+LATENCY_SCHEMA = {
+    cv.Optional(CONF_LATENCY_PROFILE, default="robust"): cv.enum(
+        LATENCY_PROFILES, lower=True
+    ),
+    cv.Optional(CONF_AUTO_TUNE, default=False): cv.boolean,
+}
+
+ResourcePriority = audio_utils_ns.enum("ResourcePriority", is_class=True)
+
+CONF_PRIORITY = "priority"
+
+RESOURCE_PRIORITIES = {
+    "media": ResourcePriority.MEDIA,
+    "voice_capture": ResourcePriority.VOICE_CAPTURE,
+    "announcement": ResourcePriority.ANNOUNCEMENT,
+}
+
+
+def resource_priority_schema(default):
+    """Priority of a component when it competes for a shared I2S port or codec."""
+    return {
+        cv.Optional(CONF_PRIORITY, default=default): cv.enum(
+            RESOURCE_PRIORITIES, lower=True
+        ),
+    }
+
+
+ResampleQuality = audio_utils_ns.enum("ResampleQuality", is_class=True)
+
+CONF_RESAMPLE_QUALITY = "resample_quality"
+
+RESAMPLE_QUALITIES = {
+    "low": ResampleQuality.LOW,
+    "medium": ResampleQuality.MEDIUM,
+    "high": ResampleQuality.HIGH,
+}
+
+# Shared by the speakers: with a quality set, streams at other rates are resampled in the player
+# task and the output stays at its configured rate
+RESAMPLE_SCHEMA = {
+    cv.Optional(CONF_RESAMPLE_QUALITY): cv.enum(RESAMPLE_QUALITIES, lower=True),
+}
+
+CONF_STREAM_FORMATS = "stream_formats"
+
+STREAM_FORMATS = ["s16", "s24", "s32", "float"]
+
+
+def add_stream_format_defines(formats):
+    """Compiles in the converters from these stream formats, see select_format_converter()."""
+    for stream_format in formats:
+        cg.add_define(f"USE_AUDIO_UTILS_STREAM_{stream_format.upper()}")
+
+
+# Shared by the speakers: the formats play() may be handed, each costing a set of converters in
+# flash. float is 32-bit samples in [-1, 1)
+STREAM_FORMATS_SCHEMA = {
+    cv.Optional(CONF_STREAM_FORMATS, default=["s16", "s24", "s32"]): cv.All(
+        cv.ensure_list(cv.one_of(*STREAM_FORMATS, lower=True)),
+        cv.Length(min=1),
+    ),
+}
+
+SharedClock = audio_utils_ns.class_("SharedClock")
+
+CONF_PLAYBACK_CLOCK = "playback_clock"
+
+# Shared by the speakers: schedule playback on a LAN wide clock and keep it there by trimming the
+# resampling ratio, which needs resample_quality
+PLAYBACK_CLOCK_SCHEMA = {
+    cv.Optional(CONF_PLAYBACK_CLOCK): cv.use_id(SharedClock),
+}
+
+
+def validate_playback_clock(config):
+    if CONF_PLAYBACK_CLOCK in config and CONF_RESAMPLE_QUALITY not in config:
+        raise cv.Invalid(
+            f"{CONF_PLAYBACK_CLOCK} corrects drift through the resampler, set {CONF_RESAMPLE_QUALITY}"
+        )
+    return config
+
+
+CONF_DUCKING = "ducking"
+CONF_MICROPHONES = "microphones"
+CONF_LEVEL = "level"
+CONF_ATTACK = "attack"
+CONF_RELEASE = "release"
+
+# Shared by the speakers: lower the output while any of the microphones is capturing
+DUCKING_SCHEMA = {
+    cv.Optional(CONF_DUCKING): cv.Schema(
+        {
+            cv.Required(CONF_MICROPHONES): cv.ensure_list(
+                cv.use_id(microphone.Microphone)
+            ),
+            cv.Optional(CONF_LEVEL, default="-20dB"): cv.All(
+                cv.decibel, cv.Range(min=-60.0, max=0.0)
+            ),
+            cv.Optional(
+                CONF_ATTACK, default="50ms"
+            ): cv.positive_time_period_milliseconds,
+            cv.Optional(
+                CONF_RELEASE, default="500ms"
+            ): cv.positive_time_period_milliseconds,
+        }
+    ),
+}
+
+
+async def ducking_to_code(var, config):
+    if ducking := config.get(CONF_DUCKING):
+        for mic_id in ducking[CONF_MICROPHONES]:
+            mic = await cg.get_variable(mic_id)
+            cg.add(var.add_ducking_microphone(mic))
+        cg.add(var.set_ducking_level(ducking[CONF_LEVEL]))
+        cg.add(var.set_ducking_attack(ducking[CONF_ATTACK]))
+        cg.add(var.set_ducking_release(ducking[CONF_RELEASE]))
+
+BiquadCoefficients = audio_utils_ns.struct("BiquadCoefficients")
+BiquadFilter = audio_utils_ns.class_("BiquadFilter")
+
+CONF_TYPE = "type"
+CONF_FREQUENCY = "frequency"
+CONF_Q = "q"
+CONF_GAIN = "gain"
+
+BIQUAD_TYPES = ["high_pass", "low_shelf", "peaking"]
+
+BIQUAD_SCHEMA = cv.Schema(
+    {
+        cv.Required(CONF_TYPE): cv.one_of(*BIQUAD_TYPES, lower=True),
+        cv.Required(CONF_FREQUENCY): cv.All(
+            cv.frequency, cv.Range(min=10.0, max=20000.0)
+        ),
+        cv.Optional(CONF_Q, default=0.707): cv.All(
+            cv.positive_float, cv.Range(min=0.1, max=20.0)
+        ),
+        cv.Optional(CONF_GAIN, default="0dB"): cv.All(
+            cv.decibel, cv.Range(min=-24.0, max=24.0)
+        ),
+    }
+)
+
+_Q30 = 1 << 30
+
+
+def design_biquad(config, sample_rate):
+    """RBJ cookbook biquad, normalized to a0 = 1 and quantized to signed Q2.30.
+
+    Returns (b0, b1, b2, a1, a2) as integers, identical for the codec and the software kernel.
+    """
+    if config[CONF_FREQUENCY] >= sample_rate / 2:
+        raise cv.Invalid(
+            f"Equalizer frequency must be below {sample_rate / 2:.0f} Hz at {sample_rate} Hz"
+        )
+    w0 = 2.0 * math.pi * config[CONF_FREQUENCY] / sample_rate
+    cos_w0 = math.cos(w0)
+    alpha = math.sin(w0) / (2.0 * config[CONF_Q])
+    a = 10.0 ** (config[CONF_GAIN] / 40.0)
+
+    kind = config[CONF_TYPE]
+    if kind == "high_pass":
+        b = [(1 + cos_w0) / 2, -(1 + cos_w0), (1 + cos_w0) / 2]
+        den = [1 + alpha, -2 * cos_w0, 1 - alpha]
+    elif kind == "peaking":
+        b = [1 + alpha * a, -2 * cos_w0, 1 - alpha * a]
+        den = [1 + alpha / a, -2 * cos_w0, 1 - alpha / a]
+    else:  # low_shelf
+        sq = 2 * math.sqrt(a) * alpha
+        b = [
+            a * ((a + 1) - (a - 1) * cos_w0 + sq),
+            2 * a * ((a - 1) - (a + 1) * cos_w0),
+            a * ((a + 1) - (a - 1) * cos_w0 - sq),
+        ]
+        den = [
+            (a + 1) + (a - 1) * cos_w0 + sq,
+            -2 * ((a - 1) + (a + 1) * cos_w0),
+            (a + 1) + (a - 1) * cos_w0 - sq,
+        ]
+
+    def quantize(value):
+        q = int(round(value / den[0] * _Q30))
+        if not -(1 << 31) <= q < (1 << 31):
+            raise cv.Invalid(
+                "Equalizer coefficient out of range, reduce the gain or Q"
+            )
+        return q
+
+    return tuple(quantize(v) for v in (b[0], b[1], b[2], den[1], den[2]))
+
+
+def biquad_coefficients_expression(coefficients):
+    b0, b1, b2, a1, a2 = coefficients
+    return cg.StructInitializer(
+        BiquadCoefficients,
+        ("b0", b0),
+        ("b1", b1),
+        ("b2", b2),
+        ("a1", a1),
+        ("a2", a2),
+    )
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace audio_utils {
+
+/// How a sample's bits are read: signed integers, or IEEE 754 floats in [-1, 1) (32 bits only).
+enum class SampleEncoding : uint8_t {
+  INT,
+  FLOAT,
+};
+
+/// Describes interleaved little-endian PCM. 24-bit samples are packed into three bytes.
+struct AudioStreamInfo {
+  uint32_t sample_rate{16000};
+  uint8_t bits_per_sample{16};
+  uint8_t channels{1};
+  SampleEncoding encoding{SampleEncoding::INT};
+
+  size_t bytes_per_sample() const { return (this->bits_per_sample + 7) / 8; }
+  size_t frame_size() const { return this->bytes_per_sample() * this->channels; }
+  size_t bytes_to_frames(size_t bytes) const { return bytes / this->frame_size(); }
+  size_t frames_to_bytes(size_t frames) const { return frames * this->frame_size(); }
+  uint32_t frames_to_microseconds(uint64_t frames) const {
+    return static_cast<uint32_t>(frames * 1000000 / this->sample_rate);
+  }
+
+  bool operator==(const AudioStreamInfo &rhs) const {
+    return this->sample_rate == rhs.sample_rate && this->bits_per_sample == rhs.bits_per_sample &&
+           this->channels == rhs.channels && this->encoding == rhs.encoding;
+  }
+  bool operator!=(const AudioStreamInfo &rhs) const { return !(*this == rhs); }
+};
+
+}  // namespace audio_utils
+}  // namespace esphome
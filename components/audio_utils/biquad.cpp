@@ -0,0 +1,40 @@
+#include "biquad.h"
+
+namespace esphome {
+namespace audio_utils {
+
+void BiquadFilter::reset() {
+  this->x1_ = 0;
+  this->x2_ = 0;
+  this->y1_ = 0;
+  this->y2_ = 0;
+}
+
+void BiquadFilter::process(int16_t *samples, size_t count) {
+  const BiquadCoefficients &c = this->coefficients_;
+  const int64_t rounding = int64_t(1) << (COEFFICIENT_FRACTION_BITS - 1);
+
+  for (size_t i = 0; i < count; i++) {
+    // The state carries STATE_FRACTION_BITS below the sample LSB. Rounding the feedback path to whole
+    // samples would leave a DC offset of hundreds of LSB for low-frequency high-pass filters.
+    int32_t x0 = static_cast<int32_t>(samples[i]) * (1 << STATE_FRACTION_BITS);
+    int64_t acc = int64_t(c.b0) * x0 + int64_t(c.b1) * this->x1_ + int64_t(c.b2) * this->x2_ -
+                  int64_t(c.a1) * this->y1_ - int64_t(c.a2) * this->y2_;
+    int64_t y0 = (acc + rounding) >> COEFFICIENT_FRACTION_BITS;
+    const int64_t limit = int64_t(INT16_MAX) << STATE_FRACTION_BITS;
+    if (y0 > limit) {
+      y0 = limit;
+    } else if (y0 < -limit) {
+      y0 = -limit;
+    }
+
+    this->x2_ = this->x1_;
+    this->x1_ = x0;
+    this->y2_ = this->y1_;
+    this->y1_ = static_cast<int32_t>(y0);
+    samples[i] = static_cast<int16_t>((y0 + (1 << (STATE_FRACTION_BITS - 1))) >> STATE_FRACTION_BITS);
+  }
+}
+
+}  // namespace audio_utils
+}  // namespace esphome
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace audio_utils {
+
+/// Normalized biquad coefficients (a0 = 1) in signed Q2.30, the format of the ES8311 equalizer:
+/// y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2]
+///
+/// Coefficients are designed and quantized at code generation time (see design_biquad() in
+/// __init__.py), so the codec and the software kernel below run on identical numbers.
+struct BiquadCoefficients {
+  int32_t b0;
+  int32_t b1;
+  int32_t b2;
+  int32_t a1;
+  int32_t a2;
+};
+
+/// Fixed-point direct form I biquad for 16-bit PCM, the software counterpart of a codec equalizer
+/// stage. Integer arithmetic only, so every platform produces the same output bit for bit.
+class BiquadFilter {
+ public:
+  static const int COEFFICIENT_FRACTION_BITS = 30;
+  static const int STATE_FRACTION_BITS = 8;
+
+  void set_coefficients(const BiquadCoefficients &coefficients) { this->coefficients_ = coefficients; }
+  const BiquadCoefficients &get_coefficients() const { return this->coefficients_; }
+
+  void reset();
+  void process(int16_t *samples, size_t count);
+
+ protected:
+  BiquadCoefficients coefficients_{1 << COEFFICIENT_FRACTION_BITS, 0, 0, 0, 0};
+  int32_t x1_{0};
+  int32_t x2_{0};
+  int32_t y1_{0};
+  int32_t y2_{0};
+};
+
+}  // namespace audio_utils
+}  // namespace esphome
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "sample_clock.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace esphome {
+namespace audio_utils {
+
+/// Follows which written frames the DMA of the legacy I2S driver has played, from its TX events,
+/// and anchors a SampleClock to the buffer boundaries they mark.
+///
+/// The DMA plays its ring of buffers continuously, cleared ones while nothing was written. Every
+/// buffer it finishes posts I2S_EVENT_TX_DONE. When all buffers were free at that moment the driver
+/// clears the one starting next and posts I2S_EVENT_TX_Q_OVF ahead of the TX_DONE. i2s_write()
+/// fills buffers in the order the DMA reaches them, so a TX_DONE without an overflow starts a
+/// buffer holding written frames.
+///
+/// That only holds once the ring runs idle, which is what sync() establishes; until then, e.g.
+/// right after the driver was installed, events come from buffers nothing was written to. From
+/// there on every event has to be handled, so the event queue must be drained before it fills.
+/// Events handled as they arrive carry their time and anchor the clock directly; ones found queued
+/// are placed on the ring's period from the last timed one.
+///
+/// Only the task calling i2s_write() uses it.
+class DmaPlayout {
+ public:
+  explicit DmaPlayout(SampleClock *clock) : clock_(clock) {}
+
+  /// Starts over at position 0, for a new session or after the port's clock changed. sync() must
+  /// follow before the first write.
+  void reset(uint32_t buffer_frames, uint32_t sample_rate, int64_t timestamp_us) {
+    this->buffer_frames_ = buffer_frames;
+    this->sample_rate_ = sample_rate;
+    this->written_ = 0;
+    this->played_ = 0;
+    this->playing_written_ = false;
+    this->silence_next_ = false;
+    this->ran_dry_ = false;
+    this->clock_->reset(sample_rate, timestamp_us);
+  }
+
+  /// The ring was seen idle: an overflow was received as it happened at `timestamp_us`, and the
+  /// event queue was cleared after it. The next write goes into the buffer after the one that
+  /// started then.
+  void sync(int64_t timestamp_us) {
+    this->playing_written_ = false;
+    this->silence_next_ = false;
+    this->played_ = this->written_;
+    this->ref_us_ = timestamp_us;
+    this->since_ref_ = 0;
+    this->clock_->update(this->played_, timestamp_us + this->buffer_time_us_(1));
+  }
+
+  /// Counts frames i2s_write() took. Returns true if the ring ran dry in front of them, cutting the
+  /// stream short: an underrun. Running dry at the end of a stream, or before the first write,
+  /// is not one.
+  bool add_written(uint32_t frames) {
+    if (frames == 0)
+      return false;
+    this->written_ += frames;
+    bool underrun = this->ran_dry_;
+    this->ran_dry_ = false;
+    return underrun;
+  }
+
+  /// Handles an I2S_EVENT_TX_Q_OVF: every buffer was free, the one starting now is a cleared one.
+  void on_overflow() {
+    this->silence_next_ = true;
+    if (this->playing_written_)
+      this->ran_dry_ = true;  // nothing written follows the buffer ending now
+  }
+
+  /// Handles an I2S_EVENT_TX_DONE received at `timestamp_us`, or 0 for one that was found queued.
+  void on_buffer_done(int64_t timestamp_us) {
+    if (timestamp_us != 0) {
+      this->ref_us_ = timestamp_us;
+      this->since_ref_ = 0;
+    } else {
+      this->since_ref_++;
+    }
+    if (this->playing_written_) {
+      // After an overflow everything written has gone out, a partly filled buffer included
+      this->played_ =
+          this->silence_next_ ? this->written_ : std::min(this->played_ + this->buffer_frames_, this->written_);
+    }
+    this->playing_written_ = !this->silence_next_ && this->played_ < this->written_;
+    this->silence_next_ = false;
+
+    // Frames not yet playing go into the buffer after the one starting now
+    int64_t boundary_us = this->ref_us_ + this->buffer_time_us_(this->since_ref_);
+    this->clock_->update(this->played_, this->playing_written_ ? boundary_us : boundary_us + this->buffer_time_us_(1));
+  }
+
+  /// Play time of one DMA buffer.
+  int64_t get_buffer_time_us() const { return this->buffer_time_us_(1); }
+
+  /// Frames handed to the driver.
+  uint64_t get_written() const { return this->written_; }
+  /// Frames the DMA has finished playing.
+  uint64_t get_played() const { return this->played_; }
+
+ protected:
+  int64_t buffer_time_us_(uint32_t buffers) const {
+    return static_cast<int64_t>(buffers) * this->buffer_frames_ * 1000000 / this->sample_rate_;
+  }
+
+  SampleClock *clock_;
+  uint32_t buffer_frames_{256};
+  uint32_t sample_rate_{16000};
+  uint64_t written_{0};
+  uint64_t played_{0};
+  bool playing_written_{false};  // the buffer the DMA plays holds written frames
+  bool silence_next_{false};     // an overflow cleared the buffer after it
+  bool ran_dry_{false};          // written frames ran out since the last write
+  int64_t ref_us_{0};            // time of the last timed buffer boundary
+  uint32_t since_ref_{0};        // boundaries since then
+};
+
+}  // namespace audio_utils
+}  // namespace esphome
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+namespace esphome {
+namespace audio_utils {
+
+/// Turns the timing error of a scheduled stream into a resampling trim that steers it back.
+///
+/// A trim of p ppm moves the error by p microseconds per second, so the output is a PI controller
+/// on the smoothed error: the proportional part pulls the error in with a time constant of
+/// 1 / KP seconds, the integral settles at the crystal mismatch between the devices. KI is chosen
+/// for critical damping (KI = KP^2 / 4). Errors beyond MAX_SLEW_ERROR_US take too long to slew out
+/// and should be fixed by skipping input or inserting silence, see needs_jump().
+class DriftController {
+ public:
+  static constexpr float KP = 0.2f;  // ppm per microsecond of error
+  static constexpr float KI = KP * KP / 4.0f;
+  static constexpr float SMOOTHING = 0.25f;
+  static constexpr float MAX_TRIM_PPM = 500.0f;
+  static const int32_t MAX_SLEW_ERROR_US = 20000;
+
+  /// Forgets the error history. The integral is kept unless `full`, the crystals did not change.
+  void reset(bool full = true) {
+    this->filtered_us_ = 0.0f;
+    this->primed_ = false;
+    if (full)
+      this->integral_ppm_ = 0.0f;
+  }
+
+  static bool needs_jump(int64_t error_us) { return error_us > MAX_SLEW_ERROR_US || error_us < -MAX_SLEW_ERROR_US; }
+
+  /// `error_us` is how late the stream plays, `elapsed_s` the time since the previous update.
+  /// Returns the trim to apply, positive to consume the input faster.
+  float update(float error_us, float elapsed_s) {
+    if (!this->primed_) {
+      this->filtered_us_ = error_us;
+      this->primed_ = true;
+    } else {
+      this->filtered_us_ += (error_us - this->filtered_us_) * SMOOTHING;
+    }
+    this->integral_ppm_ = clamp_(this->integral_ppm_ + KI * this->filtered_us_ * elapsed_s);
+    return clamp_(KP * this->filtered_us_ + this->integral_ppm_);
+  }
+
+  float get_error_us() const { return this->filtered_us_; }
+  /// The integral part, an estimate of how much slower this output runs than the shared clock.
+  float get_drift_ppm() const { return this->integral_ppm_; }
+
+ protected:
+  static float clamp_(float ppm) {
+    const float limit = MAX_TRIM_PPM;
+    return std::max(-limit, std::min(limit, ppm));
+  }
+
+  float filtered_us_{0.0f};
+  float integral_ppm_{0.0f};
+  bool primed_{false};
+};
+
+}  // namespace audio_utils
+}  // namespace esphome
@@ -0,0 +1,115 @@
+#include "event_bus.h"
+
+#include "esphome/core/hal.h"
+
+namespace esphome {
+namespace audio_utils {
+
+static_assert((EventBus::CAPACITY & (EventBus::CAPACITY - 1)) == 0, "CAPACITY must be a power of two");
+
+// A full bus means the main loop is busy; one tick is the shortest a task can sleep
+static const uint32_t RETRY_INTERVAL_MS = 10;
+
+const char *audio_event_type_to_string(AudioEventType type) {
+  switch (type) {
+    case AudioEventType::STARTING:
+      return "starting";
+    case AudioEventType::STARTED:
+      return "started";
+    case AudioEventType::RUNNING:
+      return "running";
+    case AudioEventType::STOPPING:
+      return "stopping";
+    case AudioEventType::STOPPED:
+      return "stopped";
+    case AudioEventType::WARNING:
+      return "warning";
+    default:
+      return "unknown";
+  }
+}
+
+bool EventSubscriber::publish(const AudioEvent &event, uint32_t wait_ms) {
+  return EventBus::get().publish(this, event, wait_ms);
+}
+
+uint32_t EventSubscriber::take_new_drops() {
+  uint32_t dropped = this->get_dropped();
+  uint32_t new_drops = dropped - this->reported_dropped_;
+  this->reported_dropped_ = dropped;
+  return new_drops;
+}
+
+EventBus &EventBus::get() {
+  static EventBus instance;
+  return instance;
+}
+
+EventBus::EventBus() {
+  for (size_t i = 0; i < CAPACITY; i++)
+    this->cells_[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+bool EventBus::try_publish_(EventSubscriber *subscriber, const AudioEvent &event) {
+  // A cell is free for the producer at `position` when its sequence equals the position, and
+  // holds an event for the consumer when it equals position + 1
+  uint32_t position = this->enqueue_position_.load(std::memory_order_relaxed);
+  while (true) {
+    Cell &cell = this->cells_[position & (CAPACITY - 1)];
+    uint32_t sequence = cell.sequence.load(std::memory_order_acquire);
+    int32_t difference = static_cast<int32_t>(sequence - position);
+    if (difference == 0) {
+      if (this->enqueue_position_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+        cell.subscriber = subscriber;
+        cell.event = event;
+        cell.sequence.store(position + 1, std::memory_order_release);
+
+        size_t queued = position + 1 - this->dequeue_position_.load(std::memory_order_relaxed);
+        size_t high_water = this->high_water_.load(std::memory_order_relaxed);
+        if (queued <= CAPACITY && queued > high_water)
+          this->high_water_.compare_exchange_weak(high_water, queued, std::memory_order_relaxed);
+        return true;
+      }
+    } else if (difference < 0) {
+      return false;  // full, the consumer has not freed this cell yet
+    } else {
+      position = this->enqueue_position_.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+bool EventBus::publish(EventSubscriber *subscriber, const AudioEvent &event, uint32_t wait_ms) {
+  uint32_t waited = 0;
+  while (!this->try_publish_(subscriber, event)) {
+    if (waited >= wait_ms) {
+      subscriber->dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    delay(RETRY_INTERVAL_MS);
+    if (wait_ms != WAIT_FOREVER)
+      waited += RETRY_INTERVAL_MS;
+  }
+  return true;
+}
+
+size_t EventBus::dispatch(size_t max_events) {
+  uint32_t position = this->dequeue_position_.load(std::memory_order_relaxed);
+  size_t handled = 0;
+  while (handled < max_events) {
+    Cell &cell = this->cells_[position & (CAPACITY - 1)];
+    if (cell.sequence.load(std::memory_order_acquire) != position + 1)
+      break;  // empty
+    EventSubscriber *subscriber = cell.subscriber;
+    AudioEvent event = cell.event;
+    cell.sequence.store(position + CAPACITY, std::memory_order_release);
+    this->dequeue_position_.store(++position, std::memory_order_relaxed);
+    handled++;
+
+    if (subscriber->handler_)
+      subscriber->handler_(event);
+  }
+  return handled;
+}
+
+}  // namespace audio_utils
+}  // namespace esphome
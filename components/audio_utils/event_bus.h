@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace esphome {
+namespace audio_utils {
+
+/// Lifecycle of the task behind an audio component.
+enum class AudioEventType : uint8_t {
+  STARTING = 0,
+  STARTED,
+  RUNNING,  // audio moved, clears a previous warning
+  STOPPING,
+  STOPPED,
+  WARNING = 255,
+};
+
+const char *audio_event_type_to_string(AudioEventType type);
+
+struct AudioEvent {
+  AudioEventType type;
+  int32_t error;   // WARNING: the esp_err_t that caused it
+  uint32_t bytes;  // RUNNING: bytes moved since the last RUNNING event, 0 if not counted
+
+  static AudioEvent of(AudioEventType type) { return {type, 0, 0}; }
+  static AudioEvent warning(int32_t error) { return {AudioEventType::WARNING, error, 0}; }
+  static AudioEvent running(uint32_t bytes) { return {AudioEventType::RUNNING, 0, bytes}; }
+};
+
+class EventBus;
+
+/// One component receiving events from its tasks through the shared EventBus.
+class EventSubscriber {
+ public:
+  explicit EventSubscriber(const char *name) : name_(name) {}
+
+  const char *get_name() const { return this->name_; }
+
+  /// Called from the main loop for every event, in the order they were published.
+  void set_handler(std::function<void(const AudioEvent &)> &&handler) { this->handler_ = std::move(handler); }
+
+  /// Any task. Queues the event for this subscriber; if the bus is full, retries until `wait_ms`
+  /// have passed and counts the event as dropped if it still does not fit.
+  bool publish(const AudioEvent &event, uint32_t wait_ms = 0);
+
+  /// Events lost to a full bus since boot.
+  uint32_t get_dropped() const { return this->dropped_.load(std::memory_order_relaxed); }
+  /// Drops since the previous call, for a periodic warning.
+  uint32_t take_new_drops();
+
+ protected:
+  friend class EventBus;
+
+  const char *name_;
+  std::function<void(const AudioEvent &)> handler_;
+  std::atomic<uint32_t> dropped_{0};
+  uint32_t reported_dropped_{0};
+};
+
+/// Multi-producer, single-consumer event queue shared by all audio components.
+///
+/// Any task publishes without taking a lock or entering a critical section: a bounded ring of
+/// sequence-numbered cells where producers claim a slot with one compare-and-swap. The main loop
+/// is the only consumer. Each component's loop() calls dispatch(), which hands every queued event
+/// to its subscriber's handler in batches, so a burst is handled within one loop iteration instead
+/// of one event per iteration.
+class EventBus {
+ public:
+  static const size_t CAPACITY = 64;  // power of two
+  static const size_t BATCH_SIZE = 32;
+  static const uint32_t WAIT_FOREVER = UINT32_MAX;
+
+  static EventBus &get();
+
+  bool publish(EventSubscriber *subscriber, const AudioEvent &event, uint32_t wait_ms);
+
+  /// Main loop only. Handles up to `max_events` events and returns how many it handled.
+  size_t dispatch(size_t max_events = BATCH_SIZE);
+
+  /// Most events that were queued at once.
+  size_t get_high_water() const { return this->high_water_.load(std::memory_order_relaxed); }
+
+ protected:
+  struct Cell {
+    std::atomic<uint32_t> sequence;
+    EventSubscriber *subscriber;
+    AudioEvent event;
+  };
+
+  EventBus();
+  bool try_publish_(EventSubscriber *subscriber, const AudioEvent &event);
+
+  Cell cells_[CAPACITY];
+  std::atomic<uint32_t> enqueue_position_{0};
+  std::atomic<uint32_t> dequeue_position_{0};  // written by the consumer only
+  std::atomic<size_t> high_water_{0};
+};
+
+}  // namespace audio_utils
+}  // namespace esphome
@@ -0,0 +1,78 @@
+#include "gain_ramp.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace esphome {
+namespace audio_utils {
+
+const size_t GainRamp::BLOCK_FRAMES;
+
+static inline float db_to_gain(float db) { return std::pow(10.0f, db / 20.0f); }
+
+void GainRamp::reset() {
+  this->current_db_ = this->get_target_db();
+  this->ramp_target_db_ = this->current_db_;
+  this->step_db_ = 0.0f;
+}
+
+float GainRamp::step_(size_t frames) {
+  float target = this->get_target_db();
+  if (target != this->ramp_target_db_) {
+    // Cover the whole distance in the attack or release time, whatever the ramp was doing before
+    uint32_t time_ms = target < this->current_db_ ? this->attack_ms_ : this->release_ms_;
+    float ramp_frames = std::max(1.0f, time_ms * this->sample_rate_ / 1000.0f);
+    this->step_db_ = std::fabs(target - this->current_db_) / ramp_frames;
+    this->ramp_target_db_ = target;
+  }
+
+  float delta = this->step_db_ * frames;
+  if (std::fabs(target - this->current_db_) <= delta) {
+    this->current_db_ = target;
+  } else {
+    this->current_db_ += target < this->current_db_ ? -delta : delta;
+  }
+  return this->current_db_;
+}
+
+void GainRamp::advance(size_t frames) { this->step_(frames); }
+
+template<typename T> void GainRamp::process_(T *samples, size_t frames, size_t channels) {
+  const float min_value = static_cast<float>(std::numeric_limits<T>::min());
+  float max_value = static_cast<float>(std::numeric_limits<T>::max());
+  if (static_cast<double>(max_value) > std::numeric_limits<T>::max())
+    max_value = std::nextafter(max_value, 0.0f);  // INT32_MAX rounds up to 2^31 as a float
+
+  while (frames > 0) {
+    size_t block = std::min(frames, BLOCK_FRAMES);
+    float start_db = this->current_db_;
+    float end_db = this->step_(block);
+
+    if (start_db == 0.0f && end_db == 0.0f) {
+      samples += block * channels;  // unity, leave the samples alone
+    } else {
+      float gain = db_to_gain(start_db);
+      float gain_step = (db_to_gain(end_db) - gain) / block;
+      for (size_t i = 0; i < block; i++) {
+        for (size_t c = 0; c < channels; c++) {
+          float value = *samples * gain;
+          *samples++ = static_cast<T>(std::min(std::max(value, min_value), max_value));
+        }
+        gain += gain_step;
+      }
+    }
+    frames -= block;
+  }
+}
+
+void GainRamp::process(int16_t *samples, size_t frames, size_t channels) {
+  this->process_(samples, frames, channels);
+}
+
+void GainRamp::process(int32_t *samples, size_t frames, size_t channels) {
+  this->process_(samples, frames, channels);
+}
+
+}  // namespace audio_utils
+}  // namespace esphome
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace audio_utils {
+
+/// Smoothly moving gain for interleaved PCM, e.g. to duck playback while a microphone listens.
+///
+/// The target can be changed from any task; the task that owns the audio applies it. The gain moves
+/// linearly in dB, taking the attack time for a change towards less gain and the release time for a
+/// change back up. It is updated every BLOCK_FRAMES frames and interpolated in between, so a change
+/// is audible within one buffer and never produces a zipper.
+class GainRamp {
+ public:
+  static const size_t BLOCK_FRAMES = 32;
+
+  void set_sample_rate(uint32_t sample_rate) { this->sample_rate_ = sample_rate; }
+  void set_attack_ms(uint32_t attack_ms) { this->attack_ms_ = attack_ms; }
+  void set_release_ms(uint32_t release_ms) { this->release_ms_ = release_ms; }
+
+  /// 0 dB is unity gain.
+  void set_target_db(float target_db) { this->target_db_.store(target_db, std::memory_order_relaxed); }
+  float get_target_db() const { return this->target_db_.load(std::memory_order_relaxed); }
+  float get_gain_db() const { return this->current_db_; }
+  bool is_unity() const { return this->current_db_ == 0.0f && this->get_target_db() == 0.0f; }
+
+  /// Jump straight to the target.
+  void reset();
+
+  void process(int16_t *samples, size_t frames, size_t channels = 1);
+  void process(int32_t *samples, size_t frames, size_t channels = 1);
+
+  /// Move the gain as if `frames` frames had been processed, for paths where something else
+  /// applies the gain.
+  void advance(size_t frames);
+
+ protected:
+  /// Move towards the target by up to `frames` frames worth of ramp and return the new gain in dB.
+  float step_(size_t frames);
+
+  template<typename T> void process_(T *samples, size_t frames, size_t channels);
+
+  uint32_t sample_rate_{16000};
+  uint32_t attack_ms_{50};
+  uint32_t release_ms_{500};
+
+  std::atomic<float> target_db_{0.0f};
+  float current_db_{0.0f};
+  float ramp_target_db_{0.0f};  // target the current step size was computed for
+  float step_db_{0.0f};         // dB per frame
+};
+
+}  // namespace audio_utils
+}  // namespace esphome
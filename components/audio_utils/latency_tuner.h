@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace audio_utils {
+
+enum class LatencyProfile : uint8_t {
+  ULTRA_LOW = 0,
+  BALANCED,
+  ROBUST,
+};
+
+/// Buffer sizes of one output path. DMA sizes are in frames, ring buffer sizes in bytes.
+struct BufferPlan {
+  int dma_buffer_count;
+  int dma_buffer_length;
+  size_t ring_buffer_size;      // buffer in front of the I2S writer
+  size_t pipeline_buffer_size;  // ring buffers between the other pipeline elements
+};
+
+/// Buffer sizes of each profile, smallest first.
+inline BufferPlan get_buffer_plan(LatencyProfile profile) {
+  switch (profile) {
+    case LatencyProfile::ULTRA_LOW:
+      return {4, 128, 2 * 1024, 2 * 1024};
+    case LatencyProfile::BALANCED:
+      return {6, 256, 4 * 1024, 4 * 1024};
+    case LatencyProfile::ROBUST:
+    default:
+      return {8, 1024, 8 * 1024, 8 * 1024};
+  }
+}
+
+inline const char *latency_profile_to_string(LatencyProfile profile) {
+  switch (profile) {
+    case LatencyProfile::ULTRA_LOW:
+      return "ultra_low";
+    case LatencyProfile::BALANCED:
+      return "balanced";
+    case LatencyProfile::ROBUST:
+      return "robust";
+    default:
+      return "unknown";
+  }
+}
+
+/// Chooses the buffer plan for the next output session.
+///
+/// Without auto tuning the configured profile is used as is. With auto tuning the first session
+/// starts at ULTRA_LOW and every session that saw at least UNDERRUN_THRESHOLD underruns moves the
+/// next one up a profile, never past the configured one. Buffers are only resized between
+/// sessions, so the I2S driver is never reinstalled while audio is playing.
+class LatencyTuner {
+ public:
+  static const uint32_t UNDERRUN_THRESHOLD = 3;
+
+  void set_profile(LatencyProfile profile) {
+    this->max_profile_ = profile;
+    if (!this->auto_tune_)
+      this->current_ = profile;
+  }
+  void set_auto_tune(bool auto_tune) {
+    this->auto_tune_ = auto_tune;
+    this->current_ = auto_tune ? LatencyProfile::ULTRA_LOW : this->max_profile_;
+  }
+  bool get_auto_tune() const { return this->auto_tune_; }
+
+  LatencyProfile get_profile() const { return this->current_; }
+  BufferPlan get_plan() const { return get_buffer_plan(this->current_); }
+
+  /// Call from the task feeding the I2S driver whenever it runs dry during playback.
+  void report_underrun() {
+    this->session_underruns_++;
+    this->total_underruns_++;
+  }
+  uint32_t get_session_underruns() const { return this->session_underruns_; }
+  uint32_t get_total_underruns() const { return this->total_underruns_; }
+
+  /// Call once a session has stopped. Returns true if the next session uses larger buffers.
+  bool end_session() {
+    bool grow = this->auto_tune_ && this->session_underruns_ >= UNDERRUN_THRESHOLD &&
+                this->current_ < this->max_profile_;
+    if (grow)
+      this->current_ = static_cast<LatencyProfile>(static_cast<uint8_t>(this->current_) + 1);
+    this->session_underruns_ = 0;
+    return grow;
+  }
+
+ protected:
+  LatencyProfile max_profile_{LatencyProfile::ROBUST};
+  LatencyProfile current_{LatencyProfile::ROBUST};
+  bool auto_tune_{false};
+  uint32_t session_underruns_{0};
+  uint32_t total_underruns_{0};
+};
+
+}  // namespace audio_utils
+}  // namespace esphome
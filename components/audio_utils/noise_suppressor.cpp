@@ -0,0 +1,225 @@
+#include "noise_suppressor.h"
+
+#include "esphome/core/hal.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(USE_ESP_IDF) && defined(__has_include)
+#if __has_include(<dsps_fft2r.h>)
+#include <dsps_fft2r.h>
+#define USE_AUDIO_UTILS_ESP_DSP
+#endif
+#endif
+
+namespace esphome {
+namespace audio_utils {
+
+const float NoiseSuppressor::MAX_ATTENUATION_DB = 30.0f;
+
+static const float PI_F = 3.14159265358979f;
+static const float POWER_SMOOTHING = 0.8f;   // recursive smoothing of the signal power per bin
+static const float NOISE_RISE = 1.0025f;     // noise floor may rise ~3 dB in ~2 s at 16 kHz
+static const float PRIOR_SNR_ALPHA = 0.98f;  // decision-directed a-priori SNR smoothing
+static const float MIN_POWER = 1e-10f;
+
+bool NoiseSuppressor::init(uint32_t sample_rate) {
+  this->sample_rate_ = sample_rate;
+
+  this->window_.resize(FRAME_SIZE);
+  for (size_t i = 0; i < FRAME_SIZE; i++) {
+    // sqrt-Hann, applied at analysis and synthesis so that the 50% overlap sums to one
+    this->window_[i] = std::sqrt(0.5f - 0.5f * std::cos(2.0f * PI_F * i / FRAME_SIZE));
+  }
+
+#ifdef USE_AUDIO_UTILS_ESP_DSP
+  static bool dsp_initialized = false;
+  if (!dsp_initialized) {
+    if (dsps_fft2r_init_fc32(nullptr, CONFIG_DSP_MAX_FFT_SIZE) != ESP_OK)
+      return false;
+    dsp_initialized = true;
+  }
+#else
+  this->twiddle_.resize(FRAME_SIZE);
+  for (size_t i = 0; i < FRAME_SIZE / 2; i++) {
+    this->twiddle_[2 * i] = std::cos(2.0f * PI_F * i / FRAME_SIZE);
+    this->twiddle_[2 * i + 1] = -std::sin(2.0f * PI_F * i / FRAME_SIZE);
+  }
+#endif
+
+  const size_t bins = FRAME_SIZE / 2 + 1;
+  this->spectrum_.resize(FRAME_SIZE * 2);
+  this->input_.resize(FRAME_SIZE);
+  this->overlap_.resize(HOP_SIZE);
+  this->output_.resize(HOP_SIZE);
+  this->noise_.resize(bins);
+  this->smoothed_.resize(bins);
+  this->prev_gain_.resize(bins);
+  this->prev_snr_.resize(bins);
+
+  this->set_strength(this->strength_);
+  this->reset();
+  return true;
+}
+
+void NoiseSuppressor::set_strength(float strength) {
+  this->strength_ = std::min(std::max(strength, 0.0f), 1.0f);
+  this->gain_floor_ = std::pow(10.0f, -this->strength_ * MAX_ATTENUATION_DB / 20.0f);
+}
+
+void NoiseSuppressor::reset() {
+  std::fill(this->input_.begin(), this->input_.end(), 0.0f);
+  std::fill(this->overlap_.begin(), this->overlap_.end(), 0.0f);
+  std::fill(this->output_.begin(), this->output_.end(), 0.0f);
+  std::fill(this->noise_.begin(), this->noise_.end(), 0.0f);
+  std::fill(this->smoothed_.begin(), this->smoothed_.end(), 0.0f);
+  std::fill(this->prev_gain_.begin(), this->prev_gain_.end(), 1.0f);
+  std::fill(this->prev_snr_.begin(), this->prev_snr_.end(), 1.0f);
+  this->position_ = 0;
+  this->noise_initialized_ = false;
+}
+
+void NoiseSuppressor::process(int16_t *samples, size_t count) {
+  if (this->window_.empty())
+    return;
+
+  float *current_hop = this->input_.data() + HOP_SIZE;
+  for (size_t i = 0; i < count; i++) {
+    current_hop[this->position_] = samples[i] * (1.0f / 32768.0f);
+    float out = this->output_[this->position_] * 32768.0f;
+    samples[i] = static_cast<int16_t>(std::min(std::max(out, -32768.0f), 32767.0f));
+    if (++this->position_ == HOP_SIZE) {
+      this->process_frame_();
+      this->position_ = 0;
+    }
+  }
+}
+
+void NoiseSuppressor::process_frame_() {
+  uint32_t start = micros();
+
+  float *spectrum = this->spectrum_.data();
+  for (size_t i = 0; i < FRAME_SIZE; i++) {
+    spectrum[2 * i] = this->input_[i] * this->window_[i];
+    spectrum[2 * i + 1] = 0.0f;
+  }
+  this->fft_(spectrum, false);
+
+  const size_t bins = FRAME_SIZE / 2 + 1;
+  for (size_t k = 0; k < bins; k++) {
+    float re = spectrum[2 * k];
+    float im = spectrum[2 * k + 1];
+    float power = re * re + im * im + MIN_POWER;
+
+    float &smoothed = this->smoothed_[k];
+    float &noise = this->noise_[k];
+    if (!this->noise_initialized_) {
+      smoothed = power;
+      noise = power;
+    } else {
+      smoothed = POWER_SMOOTHING * smoothed + (1.0f - POWER_SMOOTHING) * power;
+      noise = smoothed < noise ? smoothed : noise * NOISE_RISE;
+    }
+
+    float posterior_snr = power / noise;
+    float prior_snr = PRIOR_SNR_ALPHA * this->prev_gain_[k] * this->prev_gain_[k] * this->prev_snr_[k] +
+                      (1.0f - PRIOR_SNR_ALPHA) * std::max(posterior_snr - 1.0f, 0.0f);
+    float gain = std::max(prior_snr / (1.0f + prior_snr), this->gain_floor_);
+
+    this->prev_gain_[k] = gain;
+    this->prev_snr_[k] = posterior_snr;
+
+    spectrum[2 * k] *= gain;
+    spectrum[2 * k + 1] *= gain;
+    if (k != 0 && k != FRAME_SIZE / 2) {
+      // keep the spectrum conjugate-symmetric so that the inverse transform stays real
+      spectrum[2 * (FRAME_SIZE - k)] *= gain;
+      spectrum[2 * (FRAME_SIZE - k) + 1] *= gain;
+    }
+  }
+  this->noise_initialized_ = true;
+
+  this->fft_(spectrum, true);
+
+  for (size_t i = 0; i < HOP_SIZE; i++) {
+    this->output_[i] = this->overlap_[i] + spectrum[2 * i] * this->window_[i];
+    this->overlap_[i] = spectrum[2 * (i + HOP_SIZE)] * this->window_[i + HOP_SIZE];
+  }
+  std::copy(this->input_.begin() + HOP_SIZE, this->input_.end(), this->input_.begin());
+
+  uint32_t elapsed = micros() - start;
+  this->last_frame_us_ = elapsed;
+  this->max_frame_us_ = std::max(this->max_frame_us_, elapsed);
+  this->total_frame_us_ += elapsed;
+  this->frames_processed_++;
+}
+
+void NoiseSuppressor::fft_(float *data, bool inverse) {
+  if (inverse) {
+    for (size_t i = 0; i < FRAME_SIZE; i++)
+      data[2 * i + 1] = -data[2 * i + 1];
+  }
+
+#ifdef USE_AUDIO_UTILS_ESP_DSP
+  dsps_fft2r_fc32(data, FRAME_SIZE);
+  dsps_bit_rev_fc32(data, FRAME_SIZE);
+#else
+  // Iterative radix-2 decimation-in-time
+  for (size_t i = 1, j = 0; i < FRAME_SIZE; i++) {
+    size_t bit = FRAME_SIZE >> 1;
+    for (; j & bit; bit >>= 1)
+      j ^= bit;
+    j ^= bit;
+    if (i < j) {
+      std::swap(data[2 * i], data[2 * j]);
+      std::swap(data[2 * i + 1], data[2 * j + 1]);
+    }
+  }
+  for (size_t len = 2; len <= FRAME_SIZE; len <<= 1) {
+    size_t stride = FRAME_SIZE / len;
+    for (size_t i = 0; i < FRAME_SIZE; i += len) {
+      for (size_t j = 0; j < len / 2; j++) {
+        float wr = this->twiddle_[2 * j * stride];
+        float wi = this->twiddle_[2 * j * stride + 1];
+        float *a = data + 2 * (i + j);
+        float *b = data + 2 * (i + j + len / 2);
+        float tr = b[0] * wr - b[1] * wi;
+        float ti = b[0] * wi + b[1] * wr;
+        b[0] = a[0] - tr;
+        b[1] = a[1] - ti;
+        a[0] += tr;
+        a[1] += ti;
+      }
+    }
+  }
+#endif
+
+  if (inverse) {
+    const float scale = 1.0f / FRAME_SIZE;
+    for (size_t i = 0; i < FRAME_SIZE; i++) {
+      data[2 * i] *= scale;
+      data[2 * i + 1] *= -scale;
+    }
+  }
+}
+
+float NoiseSuppressor::get_average_frame_us() const {
+  if (this->frames_processed_ == 0)
+    return 0.0f;
+  return static_cast<float>(this->total_frame_us_) / this->frames_processed_;
+}
+
+float NoiseSuppressor::get_cpu_load() const {
+  float hop_us = HOP_SIZE * 1e6f / this->sample_rate_;
+  return 100.0f * this->get_average_frame_us() / hop_us;
+}
+
+void NoiseSuppressor::reset_stats() {
+  this->frames_processed_ = 0;
+  this->last_frame_us_ = 0;
+  this->max_frame_us_ = 0;
+  this->total_frame_us_ = 0;
+}
+
+}  // namespace audio_utils
+}  // namespace esphome
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace esphome {
+namespace audio_utils {
+
+/// Spectral noise suppressor for 16-bit mono PCM.
+///
+/// Runs a 50% overlap STFT with a sqrt-Hann window, tracks the noise floor per bin with a
+/// minimum-following estimator and applies a decision-directed Wiener gain limited by the
+/// configured strength. Processing is in place and delays the signal by FRAME_SIZE samples.
+///
+/// Only depends on the standard library and esphome/core/hal.h, so the same code runs on the
+/// host platform. On ESP-IDF the FFT is done with esp-dsp.
+class NoiseSuppressor {
+ public:
+  static const size_t FRAME_SIZE = 256;
+  static const size_t HOP_SIZE = FRAME_SIZE / 2;
+
+  /// Allocate working buffers and, with esp-dsp, its FFT tables. Returns false if the FFT tables
+  /// could not be set up; the buffers are plain vectors, so running out of heap for them aborts.
+  bool init(uint32_t sample_rate);
+
+  /// 0.0 leaves the signal untouched, 1.0 allows up to MAX_ATTENUATION_DB of attenuation per bin.
+  void set_strength(float strength);
+  float get_strength() const { return this->strength_; }
+
+  /// Forget the noise estimate and the overlap state, e.g. at the start of a new capture session.
+  void reset();
+
+  /// Denoise `count` samples in place.
+  void process(int16_t *samples, size_t count);
+
+  // Per-frame CPU accounting (one frame = HOP_SIZE new samples)
+  uint32_t get_frames_processed() const { return this->frames_processed_; }
+  uint32_t get_last_frame_us() const { return this->last_frame_us_; }
+  uint32_t get_max_frame_us() const { return this->max_frame_us_; }
+  float get_average_frame_us() const;
+  /// Share of real time spent in the suppressor, in percent.
+  float get_cpu_load() const;
+  void reset_stats();
+
+ protected:
+  static const float MAX_ATTENUATION_DB;
+
+  void process_frame_();
+  void fft_(float *data, bool inverse);
+
+  uint32_t sample_rate_{16000};
+  float strength_{0.7f};
+  float gain_floor_{1.0f};
+
+  std::vector<float> window_;
+  std::vector<float> twiddle_;   // interleaved cos/sin for the portable FFT
+  std::vector<float> spectrum_;  // interleaved complex, FRAME_SIZE bins
+  std::vector<float> input_;     // previous hop followed by the current hop
+  std::vector<float> overlap_;   // second half of the last synthesis frame
+  std::vector<float> output_;    // hop ready to be handed out
+  std::vector<float> noise_;     // noise power estimate per bin
+  std::vector<float> smoothed_;  // smoothed signal power per bin
+  std::vector<float> prev_gain_;
+  std::vector<float> prev_snr_;
+
+  size_t position_{0};
+  bool noise_initialized_{false};
+
+  uint32_t frames_processed_{0};
+  uint32_t last_frame_us_{0};
+  uint32_t max_frame_us_{0};
+  uint64_t total_frame_us_{0};
+};
+
+}  // namespace audio_utils
+}  // namespace esphome
@@ -0,0 +1,165 @@
+#pragma once
+
+#include "audio_stream_info.h"
+
+#include "esphome/core/defines.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace esphome {
+namespace audio_utils {
+
+/// Sample encodings. load() widens one sample to a left-justified int32, store() narrows it back;
+/// every conversion goes through that common scale, so any encoding pair composes.
+struct Pcm16 {
+  static const uint8_t BITS = 16;
+  static const size_t BYTES = 2;
+  static inline int32_t load(const uint8_t *src) {
+    int16_t sample;
+    std::memcpy(&sample, src, sizeof(sample));
+    return static_cast<int32_t>(sample) * 65536;
+  }
+  static inline void store(uint8_t *dst, int32_t value) {
+    int16_t sample = static_cast<int16_t>(value >> 16);
+    std::memcpy(dst, &sample, sizeof(sample));
+  }
+};
+
+/// Packed into three bytes.
+struct Pcm24 {
+  static const uint8_t BITS = 24;
+  static const size_t BYTES = 3;
+  static inline int32_t load(const uint8_t *src) {
+    return static_cast<int32_t>((static_cast<uint32_t>(src[0]) << 8) | (static_cast<uint32_t>(src[1]) << 16) |
+                                (static_cast<uint32_t>(src[2]) << 24));
+  }
+  static inline void store(uint8_t *dst, int32_t value) {
+    dst[0] = static_cast<uint8_t>(value >> 8);
+    dst[1] = static_cast<uint8_t>(value >> 16);
+    dst[2] = static_cast<uint8_t>(value >> 24);
+  }
+};
+
+/// A 32-bit slot read with `GAIN_BITS` of gain, saturating, for microphones that leave the top
+/// bits of the slot unused. Stores undo the gain.
+template<int GAIN_BITS = 0> struct Pcm32 {
+  static const uint8_t BITS = 32;
+  static const size_t BYTES = 4;
+  static inline int32_t load(const uint8_t *src) {
+    int32_t sample;
+    std::memcpy(&sample, src, sizeof(sample));
+    if (GAIN_BITS == 0)
+      return sample;
+    sample = std::min<int32_t>(std::max<int32_t>(sample, INT32_MIN >> GAIN_BITS), INT32_MAX >> GAIN_BITS);
+    return static_cast<int32_t>(static_cast<uint32_t>(sample) << GAIN_BITS);
+  }
+  static inline void store(uint8_t *dst, int32_t value) {
+    int32_t sample = value >> GAIN_BITS;
+    std::memcpy(dst, &sample, sizeof(sample));
+  }
+};
+
+/// Floats in [-1, 1), clipped on the way to integers.
+struct PcmFloat {
+  static const uint8_t BITS = 32;
+  static const size_t BYTES = 4;
+  static inline int32_t load(const uint8_t *src) {
+    float sample;
+    std::memcpy(&sample, src, sizeof(sample));
+    sample = std::min(std::max(sample * 2147483648.0f, -2147483648.0f), 2147483520.0f);
+    return static_cast<int32_t>(sample);
+  }
+  static inline void store(uint8_t *dst, int32_t value) {
+    float sample = static_cast<float>(value) * (1.0f / 2147483648.0f);
+    std::memcpy(dst, &sample, sizeof(sample));
+  }
+};
+
+/// An encoding and a channel count, the compile-time counterpart of AudioStreamInfo without the rate.
+/// Stereo frames are left first unless `RIGHT_FIRST`, the slot order the ESP32 I2S driver transmits
+/// in RIGHT_LEFT mode.
+template<typename E, uint8_t C, bool RIGHT_FIRST = false> struct PcmFormat {
+  using Encoding = E;
+  static const uint8_t CHANNELS = C;
+  static const size_t FRAME_SIZE = E::BYTES * C;
+  static const size_t LEFT_OFFSET = C > 1 && RIGHT_FIRST ? E::BYTES : 0;
+  static const size_t RIGHT_OFFSET = C > 1 && !RIGHT_FIRST ? E::BYTES : 0;
+};
+
+using S16Mono = PcmFormat<Pcm16, 1>;
+using S16Stereo = PcmFormat<Pcm16, 2>;
+using S24Mono = PcmFormat<Pcm24, 1>;
+using S24Stereo = PcmFormat<Pcm24, 2>;
+using S32Mono = PcmFormat<Pcm32<>, 1>;
+using S32Stereo = PcmFormat<Pcm32<>, 2>;
+using FloatMono = PcmFormat<PcmFloat, 1>;
+using FloatStereo = PcmFormat<PcmFloat, 2>;
+using S16StereoRightFirst = PcmFormat<Pcm16, 2, true>;
+using S32StereoRightFirst = PcmFormat<Pcm32<>, 2, true>;
+
+/// Converts `frames` frames of `In` to `Out`, returning the bytes written. Mono is duplicated into
+/// both channels and stereo is averaged down to mono.
+///
+/// Frames are converted front to back, so `dst` may alias `src` when Out frames are no wider.
+/// Everything is inline with the format fixed at compile time, leaving the compiler a straight
+/// loop to unroll or vectorize for each pair that is actually used.
+template<typename In, typename Out> struct FormatConverter {
+  static size_t convert(const uint8_t *src, uint8_t *dst, size_t frames) {
+    using InEncoding = typename In::Encoding;
+    using OutEncoding = typename Out::Encoding;
+    for (size_t i = 0; i < frames; i++) {
+      const uint8_t *in = src + i * In::FRAME_SIZE;
+      uint8_t *out = dst + i * Out::FRAME_SIZE;
+      int32_t left = InEncoding::load(in + In::LEFT_OFFSET);
+      int32_t right = InEncoding::load(in + In::RIGHT_OFFSET);
+      if (Out::CHANNELS == 1) {
+        OutEncoding::store(out, In::CHANNELS == 1 ? left : (left >> 1) + (right >> 1));
+      } else {
+        OutEncoding::store(out + Out::LEFT_OFFSET, left);
+        OutEncoding::store(out + Out::RIGHT_OFFSET, right);
+      }
+    }
+    return frames * Out::FRAME_SIZE;
+  }
+};
+
+using FormatConvertFn = size_t (*)(const uint8_t *src, uint8_t *dst, size_t frames);
+
+/// Picks the converter from a stream of 16, 24 or 32-bit integer or 32-bit float mono or stereo PCM,
+/// left first, into `Out`. Only the sinks a caller names get instantiated, and for each only the
+/// stream formats the configuration accepts (USE_AUDIO_UTILS_STREAM_S16 and friends, from
+/// audio_utils/__init__.py). Returns nullptr for an unsupported or excluded stream.
+template<typename Out> FormatConvertFn select_format_converter(const AudioStreamInfo &in) {
+  const bool stereo = in.channels == 2;
+  if (in.channels != 1 && !stereo)
+    return nullptr;
+  if (in.encoding == SampleEncoding::FLOAT) {
+#ifdef USE_AUDIO_UTILS_STREAM_FLOAT
+    if (in.bits_per_sample == 32)
+      return stereo ? &FormatConverter<FloatStereo, Out>::convert : &FormatConverter<FloatMono, Out>::convert;
+#endif
+    return nullptr;
+  }
+  switch (in.bits_per_sample) {
+#ifdef USE_AUDIO_UTILS_STREAM_S16
+    case 16:
+      return stereo ? &FormatConverter<S16Stereo, Out>::convert : &FormatConverter<S16Mono, Out>::convert;
+#endif
+#ifdef USE_AUDIO_UTILS_STREAM_S24
+    case 24:
+      return stereo ? &FormatConverter<S24Stereo, Out>::convert : &FormatConverter<S24Mono, Out>::convert;
+#endif
+#ifdef USE_AUDIO_UTILS_STREAM_S32
+    case 32:
+      return stereo ? &FormatConverter<S32Stereo, Out>::convert : &FormatConverter<S32Mono, Out>::convert;
+#endif
+    default:
+      return nullptr;
+  }
+}
+
+}  // namespace audio_utils
+}  // namespace esphome
@@ -0,0 +1,313 @@
+#include "resampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#if defined(USE_ESP_IDF) && defined(__has_include)
+#if __has_include(<dsps_dotprod.h>) && __has_include(<sdkconfig.h>)
+#include <sdkconfig.h>
+#if CONFIG_IDF_TARGET_ESP32S3
+#include <dsps_dotprod.h>
+#define USE_AUDIO_UTILS_ESP_DSP_DOTPROD
+#endif
+#endif
+#endif
+
+namespace esphome {
+namespace audio_utils {
+
+static const double PI = 3.14159265358979323846;
+static const size_t TAP_MULTIPLE = 8;  // keeps rows a whole number of SIMD loads
+static const size_t ALIGNMENT = 16;
+static const int COEFFICIENT_FRACTION_BITS = 14;  // 16-bit path; leaves headroom for the sum
+static const uint64_t TRIM_SCALE = 1 << 24;       // step resolution below 0.1 ppm, even at 1:1
+
+struct QualityParameters {
+  size_t taps;     // at 1:1, scaled up by the downsampling ratio
+  double beta;     // Kaiser window shape, sets the stopband attenuation
+  double rolloff;  // cutoff as a share of the lower Nyquist frequency
+};
+
+static const QualityParameters QUALITY_PARAMETERS[] = {
+    {8, 5.0, 0.80},
+    {16, 7.0, 0.87},
+    {32, 9.0, 0.92},
+};
+
+const char *resample_quality_to_string(ResampleQuality quality) {
+  switch (quality) {
+    case ResampleQuality::LOW:
+      return "low";
+    case ResampleQuality::MEDIUM:
+      return "medium";
+    case ResampleQuality::HIGH:
+      return "high";
+    default:
+      return "unknown";
+  }
+}
+
+/// Zeroth order modified Bessel function of the first kind, for the Kaiser window.
+static double bessel_i0(double x) {
+  double sum = 1.0;
+  double term = 1.0;
+  for (int k = 1; k < 32; k++) {
+    term *= (x / (2.0 * k)) * (x / (2.0 * k));
+    sum += term;
+    if (term < sum * 1e-12)
+      break;
+  }
+  return sum;
+}
+
+float resample_dot_f32(const float *samples, const float *coefficients, size_t taps) {
+#ifdef USE_AUDIO_UTILS_ESP_DSP_DOTPROD
+  float sum;
+  dsps_dotprod_f32(samples, coefficients, &sum, static_cast<int>(taps));
+  return sum;
+#else
+  return resample_dot_f32_scalar(samples, coefficients, taps);
+#endif
+}
+
+float resample_dot_f32_scalar(const float *samples, const float *coefficients, size_t taps) {
+  float sum = 0.0f;
+  for (size_t i = 0; i < taps; i++)
+    sum += samples[i] * coefficients[i];
+  return sum;
+}
+
+/// Per sample type arithmetic: the dot product, blending two phases and rounding to the output.
+template<typename T> struct ResampleKernel;
+
+template<> struct ResampleKernel<int16_t> {
+  using Accumulator = int32_t;  // Q14 scaled samples
+
+  // Not through esp-dsp: dsps_dotprod_s16() hands back a shifted, unsaturated int16, so no shift
+  // keeps both the fraction bits blend() needs and the headroom for filter overshoot
+  static Accumulator dot(const int16_t *samples, const int16_t *coefficients, size_t taps) {
+    int32_t sum = 0;
+    for (size_t i = 0; i < taps; i++)
+      sum += static_cast<int32_t>(samples[i]) * coefficients[i];
+    return sum;
+  }
+
+  static Accumulator blend(Accumulator a, Accumulator b, uint64_t numerator, uint64_t denominator) {
+    int64_t weight = static_cast<int64_t>((numerator << 16) / denominator);
+    return a + static_cast<int32_t>((static_cast<int64_t>(b) - a) * weight >> 16);
+  }
+
+  static int16_t store(Accumulator sum) {
+    int32_t value = (sum + (1 << (COEFFICIENT_FRACTION_BITS - 1))) >> COEFFICIENT_FRACTION_BITS;
+    return static_cast<int16_t>(std::max<int32_t>(INT16_MIN, std::min<int32_t>(INT16_MAX, value)));
+  }
+
+  /// Quantizes one row to Q14 with the sum kept at exactly 1.0, so DC passes unchanged.
+  static void quantize(const double *row, int16_t *coefficients, size_t taps) {
+    int32_t sum = 0;
+    size_t largest = 0;
+    for (size_t i = 0; i < taps; i++) {
+      coefficients[i] = static_cast<int16_t>(std::lround(row[i] * (1 << COEFFICIENT_FRACTION_BITS)));
+      sum += coefficients[i];
+      if (std::fabs(row[i]) > std::fabs(row[largest]))
+        largest = i;
+    }
+    coefficients[largest] += static_cast<int16_t>((1 << COEFFICIENT_FRACTION_BITS) - sum);
+  }
+};
+
+template<> struct ResampleKernel<float> {
+  using Accumulator = float;
+
+  static Accumulator dot(const float *samples, const float *coefficients, size_t taps) {
+    return resample_dot_f32(samples, coefficients, taps);
+  }
+
+  static Accumulator blend(Accumulator a, Accumulator b, uint64_t numerator, uint64_t denominator) {
+    return a + (b - a) * static_cast<float>(static_cast<double>(numerator) / denominator);
+  }
+
+  static float store(Accumulator sum) { return sum; }
+
+  static void quantize(const double *row, float *coefficients, size_t taps) {
+    for (size_t i = 0; i < taps; i++)
+      coefficients[i] = static_cast<float>(row[i]);
+  }
+};
+
+template<typename T>
+bool PolyphaseResampler<T>::configure(uint32_t source_rate, uint32_t dest_rate, uint8_t channels,
+                                      ResampleQuality quality) {
+  if (channels == 0 || channels > MAX_CHANNELS || source_rate == 0 || dest_rate == 0)
+    return false;
+  if (source_rate > static_cast<uint64_t>(dest_rate) * MAX_RATIO ||
+      dest_rate > static_cast<uint64_t>(source_rate) * MAX_RATIO)
+    return false;
+
+  this->source_rate_ = source_rate;
+  this->dest_rate_ = dest_rate;
+  this->channels_ = channels;
+
+  // Downsampling narrows the passband relative to the input, the filter grows to keep its slope
+  const QualityParameters &parameters = QUALITY_PARAMETERS[static_cast<size_t>(quality)];
+  double ratio = std::max(1.0, static_cast<double>(source_rate) / dest_rate);
+  size_t taps = static_cast<size_t>(std::ceil(parameters.taps * ratio));
+  this->taps_ = (taps + TAP_MULTIPLE - 1) / TAP_MULTIPLE * TAP_MULTIPLE;
+  this->center_ = this->taps_ / 2 - 1;
+
+  uint32_t divisor = std::gcd(source_rate, dest_rate);
+  uint32_t upsample = dest_rate / divisor;
+  uint32_t downsample = source_rate / divisor;
+  // A multiple of L keeps the untrimmed outputs on exact phases
+  this->phases_ = upsample;
+  if (this->phases_ < MIN_PHASES)
+    this->phases_ = (MIN_PHASES + upsample - 1) / upsample * upsample;
+  if ((this->phases_ + 1) * this->taps_ > MAX_COEFFICIENTS)
+    this->phases_ = MAX_COEFFICIENTS / this->taps_ - 1;
+  this->exact_ = this->phases_ % upsample == 0;
+
+  this->step_num_ = static_cast<uint64_t>(downsample) * TRIM_SCALE;
+  this->step_den_ = static_cast<uint64_t>(upsample) * TRIM_SCALE;
+  this->set_trim_ppm(this->trim_ppm_);
+
+  size_t padding = ALIGNMENT / sizeof(T);
+  this->coefficient_storage_.assign((this->phases_ + 1) * this->taps_ + padding, T{});
+  uintptr_t address = reinterpret_cast<uintptr_t>(this->coefficient_storage_.data());
+  this->coefficients_ = reinterpret_cast<T *>((address + ALIGNMENT - 1) & ~(uintptr_t) (ALIGNMENT - 1));
+  for (size_t c = 0; c < this->channels_; c++)
+    this->history_[c].assign(this->taps_ + BLOCK_FRAMES + MAX_RATIO + 1, T{});
+  for (size_t c = this->channels_; c < MAX_CHANNELS; c++)
+    this->history_[c] = std::vector<T>();
+
+  this->design_(quality);
+  this->reset();
+  return true;
+}
+
+template<typename T> void PolyphaseResampler<T>::design_(ResampleQuality quality) {
+  const QualityParameters &parameters = QUALITY_PARAMETERS[static_cast<size_t>(quality)];
+  // Cutoff in cycles per input sample
+  double cutoff = 0.5 * parameters.rolloff * std::min(1.0, static_cast<double>(this->dest_rate_) / this->source_rate_);
+  double half_length = this->taps_ / 2.0;
+  double window_scale = 1.0 / bessel_i0(parameters.beta);
+
+  std::vector<double> row(this->taps_);
+  // Row p is the filter for an output p / phases_ of an input sample after the center tap; the
+  // extra last row (p = phases_) is only read when interpolating between phases
+  for (size_t p = 0; p <= this->phases_; p++) {
+    double fraction = static_cast<double>(p) / this->phases_;
+    double sum = 0.0;
+    for (size_t i = 0; i < this->taps_; i++) {
+      double t = static_cast<double>(i) - this->center_ - fraction;
+      double x = 2.0 * cutoff * t;
+      double sinc = std::fabs(x) < 1e-12 ? 1.0 : std::sin(PI * x) / (PI * x);
+      double r = t / half_length;
+      double window = std::fabs(r) >= 1.0 ? 0.0 : bessel_i0(parameters.beta * std::sqrt(1.0 - r * r)) * window_scale;
+      row[i] = sinc * window;
+      sum += row[i];
+    }
+    for (auto &value : row)
+      value /= sum;
+    ResampleKernel<T>::quantize(row.data(), this->coefficients_ + p * this->taps_, this->taps_);
+  }
+}
+
+template<typename T> void PolyphaseResampler<T>::reset() {
+  // center_ frames of silence line the first output up with the first input frame
+  for (size_t c = 0; c < this->channels_; c++)
+    std::fill(this->history_[c].begin(), this->history_[c].end(), T{});
+  this->filled_ = this->center_;
+  this->index_ = 0;
+  this->phase_ = 0;
+}
+
+template<typename T> void PolyphaseResampler<T>::set_trim_ppm(float ppm) {
+  const float limit = static_cast<float>(MAX_TRIM_PPM);
+  this->trim_ppm_ = std::max(-limit, std::min(limit, ppm));
+  int64_t delta = std::llround(static_cast<double>(this->step_num_) * this->trim_ppm_ * 1e-6);
+  uint64_t step = this->step_num_ + delta;
+  this->step_int_ = step / this->step_den_;
+  this->step_frac_ = step % this->step_den_;
+}
+
+template<typename T> double PolyphaseResampler<T>::get_buffered_frames() const {
+  double next = static_cast<double>(this->index_ + this->center_) +
+                static_cast<double>(this->phase_) / static_cast<double>(this->step_den_);
+  return static_cast<double>(this->filled_) - next;
+}
+
+template<typename T> void PolyphaseResampler<T>::produce_(T *out) {
+  using Kernel = ResampleKernel<T>;
+  uint64_t position = this->phase_ * this->phases_;
+  size_t row = static_cast<size_t>(position / this->step_den_);
+  uint64_t remainder = position % this->step_den_;
+  const T *coefficients = this->coefficients_ + row * this->taps_;
+
+  for (size_t c = 0; c < this->channels_; c++) {
+    const T *window = this->history_[c].data() + this->index_;
+    typename Kernel::Accumulator sum = Kernel::dot(window, coefficients, this->taps_);
+    if (remainder != 0) {
+      typename Kernel::Accumulator next = Kernel::dot(window, coefficients + this->taps_, this->taps_);
+      sum = Kernel::blend(sum, next, remainder, this->step_den_);
+    }
+    out[c] = Kernel::store(sum);
+  }
+}
+
+template<typename T>
+size_t PolyphaseResampler<T>::process(const T *in, size_t in_frames, size_t *consumed, T *out, size_t out_frames) {
+  size_t written = 0;
+  size_t read = 0;
+  const size_t capacity = this->history_[0].size();
+  while (true) {
+    while (written < out_frames && this->index_ + this->taps_ <= this->filled_) {
+      this->produce_(out + written * this->channels_);
+      written++;
+      this->index_ += this->step_int_;
+      this->phase_ += this->step_frac_;
+      if (this->phase_ >= this->step_den_) {
+        this->phase_ -= this->step_den_;
+        this->index_++;
+      }
+    }
+    if (written == out_frames || read == in_frames)
+      break;
+
+    // Drop the frames no later output reaches, then stage more input behind the rest
+    size_t drop = std::min(this->index_, this->filled_);
+    if (drop > 0) {
+      for (size_t c = 0; c < this->channels_; c++) {
+        T *history = this->history_[c].data();
+        std::copy(history + drop, history + this->filled_, history);
+      }
+      this->filled_ -= drop;
+      this->index_ -= drop;
+    }
+    size_t frames = std::min(in_frames - read, capacity - this->filled_);
+    const T *source = in + read * this->channels_;
+    for (size_t c = 0; c < this->channels_; c++) {
+      T *history = this->history_[c].data() + this->filled_;
+      for (size_t f = 0; f < frames; f++)
+        history[f] = source[f * this->channels_ + c];
+    }
+    this->filled_ += frames;
+    read += frames;
+  }
+  *consumed = read;
+  return written;
+}
+
+template<typename T> size_t PolyphaseResampler<T>::max_output_frames(size_t in_frames) const {
+  // Slowest trim included
+  const uint64_t trim_margin = 1000000 + MAX_TRIM_PPM;
+  return static_cast<size_t>((static_cast<uint64_t>(in_frames) + this->taps_) * this->dest_rate_ * trim_margin /
+                             (static_cast<uint64_t>(this->source_rate_) * 1000000)) +
+         2;
+}
+
+template class PolyphaseResampler<int16_t>;
+template class PolyphaseResampler<float>;
+
+}  // namespace audio_utils
+}  // namespace esphome
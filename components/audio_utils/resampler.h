@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace esphome {
+namespace audio_utils {
+
+/// Filter length and stopband trade-off. Taps per output sample at 1:1, more when downsampling.
+/// Alias rejection is measured in float; Q14 coefficients hold the 16-bit path near 70 dB.
+enum class ResampleQuality : uint8_t {
+  LOW = 0,  // 8 taps, about 45 dB alias rejection
+  MEDIUM,   // 16 taps, about 70 dB
+  HIGH,     // 32 taps, about 95 dB
+};
+
+const char *resample_quality_to_string(ResampleQuality quality);
+
+/// Streaming polyphase sample rate converter for interleaved 16-bit or float PCM.
+///
+/// The rate pair is reduced to L/M and a Kaiser windowed sinc is sampled at L phase offsets, so
+/// pairs like 44.1 kHz to 16 kHz (160/441) run from an exact phase table. When L phases do not fit
+/// in MAX_COEFFICIENTS the table gets fewer phases and outputs are interpolated between the two
+/// nearest ones. The cutoff follows the lower of the two rates, so the same kernel serves as the
+/// anti-aliasing filter when downsampling and the anti-imaging filter when upsampling.
+///
+/// Runs inline in the caller's task, with no ring buffer of its own. Coefficients are designed in
+/// configure(); 16-bit samples use Q14 coefficients and 32-bit accumulation, the same plain loop on
+/// every target. On the ESP32-S3 the float dot products go through esp-dsp, which uses the SIMD
+/// instructions.
+///
+/// set_trim_ppm() stretches the ratio by a few hundred ppm at most, for following a remote clock.
+/// The table always has at least MIN_PHASES phases so trimmed outputs interpolate between nearby
+/// phases, also at 1:1.
+/// Dot product of the float path, esp-dsp's SIMD routine where available. The audio_bench checks it
+/// against resample_dot_f32_scalar(), the loop it replaces.
+float resample_dot_f32(const float *samples, const float *coefficients, size_t taps);
+float resample_dot_f32_scalar(const float *samples, const float *coefficients, size_t taps);
+
+template<typename T> class PolyphaseResampler {
+ public:
+  static const size_t MAX_CHANNELS = 2;
+  static const size_t MAX_COEFFICIENTS = 16384;
+  static const size_t BLOCK_FRAMES = 256;  // input frames staged per pass
+  static const uint32_t MAX_RATIO = 8;
+  static const size_t MIN_PHASES = 64;
+  static const uint32_t MAX_TRIM_PPM = 1000;
+
+  /// Allocates the phase table and history. Returns false for unsupported rates or channel
+  /// counts; the table and history are vectors, so running out of heap for them aborts.
+  bool configure(uint32_t source_rate, uint32_t dest_rate, uint8_t channels, ResampleQuality quality);
+  /// Clears the history, e.g. at the start of a new stream. Keeps the trim.
+  void reset();
+  /// Consumes input `ppm` parts per million faster than the nominal ratio (slower when negative),
+  /// clamped to MAX_TRIM_PPM. Takes effect from the next output frame.
+  void set_trim_ppm(float ppm);
+  float get_trim_ppm() const { return this->trim_ppm_; }
+
+  /// Resamples interleaved frames. Reads up to `in_frames` frames, writes up to `out_frames` and
+  /// returns the number written; `*consumed` is set to the number read. Input that cannot produce
+  /// output yet is kept in the history, so feeding blocks of any size gives the same result.
+  size_t process(const T *in, size_t in_frames, size_t *consumed, T *out, size_t out_frames);
+
+  /// Most frames process() writes for `in_frames` frames of input.
+  size_t max_output_frames(size_t in_frames) const;
+
+  uint32_t get_source_rate() const { return this->source_rate_; }
+  uint32_t get_dest_rate() const { return this->dest_rate_; }
+  size_t get_taps() const { return this->taps_; }
+  size_t get_phases() const { return this->phases_; }
+  /// True when every output uses one exact phase, false when phases are interpolated.
+  bool is_exact() const { return this->exact_; }
+  /// Input frames the filter looks ahead, the latency it adds.
+  size_t get_lookahead_frames() const { return this->taps_ - this->center_; }
+  /// Input frames taken by process() that lie at or after the next output's instant, including the
+  /// fraction; the input position of the next output is the frames consumed less this.
+  double get_buffered_frames() const;
+
+ protected:
+  void design_(ResampleQuality quality);
+  void produce_(T *out);
+
+  uint32_t source_rate_{0};
+  uint32_t dest_rate_{0};
+  uint8_t channels_{1};
+  size_t taps_{0};
+  size_t center_{0};  // tap the output instant lines up with
+  size_t phases_{0};
+  bool exact_{true};
+
+  // Position of the next output: history index of the window start plus phase_ / step_den_. The
+  // denominator carries TRIM_SCALE so the trimmed step stays exact
+  uint64_t step_num_{0};  // untrimmed step, in 1 / step_den_ input frames
+  uint64_t step_den_{1};
+  uint64_t step_int_{0};
+  uint64_t step_frac_{0};
+  uint64_t phase_{0};
+  size_t index_{0};
+  size_t filled_{0};
+  float trim_ppm_{0.0f};
+
+  std::vector<T> coefficient_storage_;
+  T *coefficients_{nullptr};  // phases_ + 1 rows of taps_, 16-byte aligned
+  std::vector<T> history_[MAX_CHANNELS];
+};
+
+}  // namespace audio_utils
+}  // namespace esphome
@@ -0,0 +1,98 @@
+#include "resource_arbiter.h"
+
+#include "esphome/core/hal.h"
+#include "esphome/core/log.h"
+
+#include <algorithm>
+
+namespace esphome {
+namespace audio_utils {
+
+static const char *const TAG = "resource_arbiter";
+
+const char *resource_priority_to_string(ResourcePriority priority) {
+  switch (priority) {
+    case ResourcePriority::MEDIA:
+      return "media";
+    case ResourcePriority::VOICE_CAPTURE:
+      return "voice_capture";
+    case ResourcePriority::ANNOUNCEMENT:
+      return "announcement";
+    default:
+      return "unknown";
+  }
+}
+
+bool ResourceArbiter::request(ResourceClient *client) {
+  if (this->owner_ == client)
+    return true;
+  if (std::find(this->waiting_.begin(), this->waiting_.end(), client) != this->waiting_.end())
+    return false;
+
+  client->requested_ms_ = millis();
+  if (this->owner_ == nullptr) {
+    this->owner_ = client;  // the caller goes on by itself, no grant callback
+    return true;
+  }
+
+  auto pos = std::find_if(this->waiting_.begin(), this->waiting_.end(), [client](const ResourceClient *waiting) {
+    return waiting->priority_ < client->priority_;
+  });
+  this->waiting_.insert(pos, client);
+  ESP_LOGD(TAG, "%s: %s (%s) waits for %s", this->name_, client->name_,
+           resource_priority_to_string(client->priority_), this->owner_->name_);
+
+  if (client->priority_ > this->owner_->priority_)
+    this->preempt_owner_();
+  return false;
+}
+
+void ResourceArbiter::release(ResourceClient *client) {
+  if (this->owner_ != client) {
+    auto it = std::find(this->waiting_.begin(), this->waiting_.end(), client);
+    if (it != this->waiting_.end())
+      this->waiting_.erase(it);
+    return;
+  }
+
+  this->owner_ = nullptr;
+  if (this->waiting_.empty()) {
+    this->preempting_ = false;
+    return;
+  }
+  ResourceClient *next = this->waiting_.front();
+  this->waiting_.erase(this->waiting_.begin());
+  this->grant_(next);
+}
+
+void ResourceArbiter::grant_(ResourceClient *client) {
+  this->owner_ = client;
+  uint32_t now = millis();
+
+  if (this->preempting_) {
+    this->preempting_ = false;
+    uint32_t handover_ms = now - this->preempt_started_ms_;
+    this->max_handover_ms_ = std::max(this->max_handover_ms_, handover_ms);
+    if (handover_ms > PREEMPT_BUDGET_MS) {
+      ESP_LOGW(TAG, "%s: handover to %s took %u ms, over the %u ms budget", this->name_, client->name_,
+               (unsigned) handover_ms, (unsigned) PREEMPT_BUDGET_MS);
+    }
+  }
+  ESP_LOGD(TAG, "%s: granted to %s after %u ms", this->name_, client->name_, (unsigned) (now - client->requested_ms_));
+
+  if (client->grant_callback_)
+    client->grant_callback_();
+}
+
+void ResourceArbiter::preempt_owner_() {
+  if (this->preempting_)
+    return;
+  this->preempting_ = true;
+  this->preempt_started_ms_ = millis();
+  ESP_LOGD(TAG, "%s: preempting %s for %s", this->name_, this->owner_->name_, this->waiting_.front()->name_);
+  if (this->owner_->preempt_callback_)
+    this->owner_->preempt_callback_();
+}
+
+}  // namespace audio_utils
+}  // namespace esphome
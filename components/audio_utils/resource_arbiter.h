@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace esphome {
+namespace audio_utils {
+
+enum class ResourcePriority : uint8_t {
+  MEDIA = 0,
+  VOICE_CAPTURE,
+  ANNOUNCEMENT,
+};
+
+const char *resource_priority_to_string(ResourcePriority priority);
+
+class ResourceArbiter;
+
+/// One component that needs exclusive use of an arbitrated resource, e.g. an I2S port.
+class ResourceClient {
+ public:
+  ResourceClient(const char *name, ResourcePriority priority) : name_(name), priority_(priority) {}
+
+  const char *get_name() const { return this->name_; }
+  void set_priority(ResourcePriority priority) { this->priority_ = priority; }
+  ResourcePriority get_priority() const { return this->priority_; }
+
+  /// Called when the resource is handed to this client after it had to wait, from the call that
+  /// released it.
+  void set_grant_callback(std::function<void()> &&callback) { this->grant_callback_ = std::move(callback); }
+  /// Called when a client with a higher priority is waiting. The owner should stop and release.
+  void set_preempt_callback(std::function<void()> &&callback) { this->preempt_callback_ = std::move(callback); }
+
+ protected:
+  friend class ResourceArbiter;
+
+  const char *name_;
+  ResourcePriority priority_;
+  std::function<void()> grant_callback_;
+  std::function<void()> preempt_callback_;
+  uint32_t requested_ms_{0};
+};
+
+/// Hands a shared resource to one client at a time, highest priority first.
+///
+/// Replaces polling a mutex from every loop(): a client that cannot have the resource right away is
+/// queued, and release() passes the resource straight on to the next client in line and calls its
+/// grant callback. A request with a higher priority than the owner's asks the owner to stop through
+/// its preempt callback. The time from that request to the grant is the handover latency; it is
+/// tracked and logged when it exceeds PREEMPT_BUDGET_MS.
+///
+/// Not thread safe, only call it from the main loop.
+class ResourceArbiter {
+ public:
+  static const uint32_t PREEMPT_BUDGET_MS = 500;
+
+  explicit ResourceArbiter(const char *name) : name_(name) {}
+
+  /// Returns true if the client owns the resource on return. Otherwise it is queued; asking again
+  /// while queued does nothing.
+  bool request(ResourceClient *client);
+  /// Give the resource up, or leave the queue if it was never granted.
+  void release(ResourceClient *client);
+
+  bool is_owner(const ResourceClient *client) const { return this->owner_ == client; }
+  ResourceClient *get_owner() const { return this->owner_; }
+  size_t get_waiting_count() const { return this->waiting_.size(); }
+
+  /// Longest time a preempting client waited for the resource, in milliseconds.
+  uint32_t get_max_handover_ms() const { return this->max_handover_ms_; }
+
+ protected:
+  void grant_(ResourceClient *client);
+  void preempt_owner_();
+
+  const char *name_;
+  ResourceClient *owner_{nullptr};
+  std::vector<ResourceClient *> waiting_;  // highest priority first, then in order of arrival
+  bool preempting_{false};                 // the owner has been asked to stop
+  uint32_t preempt_started_ms_{0};
+  uint32_t max_handover_ms_{0};
+};
+
+}  // namespace audio_utils
+}  // namespace esphome
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace esphome {
+namespace audio_utils {
+
+/// Maps sample positions of an audio stream to microsecond timestamps.
+///
+/// The task servicing the I2S driver anchors the clock once per completed DMA buffer: "the frame at
+/// `position` is at the I2S pins at `timestamp_us`". Any other position is extrapolated from the
+/// latest anchor using the nominal sample rate, which gives capture times for past frames and
+/// presentation times for frames that are still queued.
+///
+/// The anchor is published with a sequence counter, so a single writer and any number of readers
+/// on other tasks can use it without locking.
+class SampleClock {
+ public:
+  void reset(uint32_t sample_rate, int64_t timestamp_us = 0) {
+    this->sample_rate_ = sample_rate;
+    this->update(0, timestamp_us);
+  }
+
+  void update(uint64_t position, int64_t timestamp_us) {
+    uint32_t sequence = this->sequence_.load(std::memory_order_relaxed);
+    this->sequence_.store(sequence + 1, std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_release);
+    this->position_ = position;
+    this->timestamp_us_ = timestamp_us;
+    this->sequence_.store(sequence + 2, std::memory_order_release);
+  }
+
+  /// Position and time of the latest anchor.
+  void get_anchor(uint64_t *position, int64_t *timestamp_us) const {
+    uint32_t sequence;
+    do {
+      sequence = this->sequence_.load(std::memory_order_acquire);
+      *position = this->position_;
+      *timestamp_us = this->timestamp_us_;
+      std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((sequence & 1) != 0 || sequence != this->sequence_.load(std::memory_order_relaxed));
+  }
+
+  /// Time at which the frame at `position` was captured or will be played.
+  int64_t time_of(uint64_t position) const {
+    uint64_t anchor_position;
+    int64_t anchor_us;
+    this->get_anchor(&anchor_position, &anchor_us);
+    int64_t delta = static_cast<int64_t>(position - anchor_position);
+    return anchor_us + delta * 1000000 / static_cast<int64_t>(this->sample_rate_);
+  }
+
+  uint64_t get_position() const {
+    uint64_t position;
+    int64_t timestamp_us;
+    this->get_anchor(&position, &timestamp_us);
+    return position;
+  }
+
+  uint32_t get_sample_rate() const { return this->sample_rate_; }
+
+ protected:
+  std::atomic<uint32_t> sequence_{0};
+  uint64_t position_{0};
+  int64_t timestamp_us_{0};
+  uint32_t sample_rate_{16000};
+};
+
+}  // namespace audio_utils
+}  // namespace esphome
@@ -0,0 +1,22 @@
+#include "sample_convert.h"
+
+#include "pcm_format.h"
+
+namespace esphome {
+namespace audio_utils {
+
+size_t convert_frames(const uint8_t *src, const AudioStreamInfo &in, uint8_t *dst, uint8_t out_bits,
+                      uint8_t out_channels, size_t frames) {
+  FormatConvertFn convert;
+  if (out_bits == 16) {
+    convert = out_channels == 1 ? select_format_converter<S16Mono>(in)
+                                : select_format_converter<S16StereoRightFirst>(in);
+  } else {
+    convert = out_channels == 1 ? select_format_converter<S32Mono>(in)
+                                : select_format_converter<S32StereoRightFirst>(in);
+  }
+  return convert != nullptr ? convert(src, dst, frames) : 0;
+}
+
+}  // namespace audio_utils
+}  // namespace esphome
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "audio_stream_info.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace audio_utils {
+
+/// Convert `frames` frames of `in` into 16- or 32-bit slots with `out_channels` channels.
+/// Mono is duplicated into both channels, stereo is averaged down to mono, and stereo slots are
+/// written right channel first like the I2S driver sends them. Returns the bytes written,
+/// 0 for an unsupported stream. Carries every converter in pcm_format.h for these sinks that the
+/// stream format defines enable; callers with a sink fixed at build time should select theirs with
+/// select_format_converter() instead.
+size_t convert_frames(const uint8_t *src, const AudioStreamInfo &in, uint8_t *dst, uint8_t out_bits,
+                      uint8_t out_channels, size_t frames);
+
+}  // namespace audio_utils
+}  // namespace esphome
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace esphome {
+namespace audio_utils {
+
+/// Maps this device's esp_timer microseconds to a clock shared by several devices, e.g. for
+/// starting playback in several rooms at the same instant.
+///
+/// Whatever keeps the devices in step (see the playback_clock component) publishes the mapping as
+/// an anchor pair plus the rate of the shared clock relative to the local one. Like SampleClock it
+/// is published with a sequence counter, so one writer and readers on other tasks need no lock.
+class SharedClock {
+ public:
+  /// `shared_us` is the shared time at local time `local_us`; `skew_ppm` is how much faster the
+  /// shared clock runs.
+  void publish(int64_t local_us, int64_t shared_us, float skew_ppm) {
+    uint32_t sequence = this->sequence_.load(std::memory_order_relaxed);
+    this->sequence_.store(sequence + 1, std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_release);
+    this->local_us_ = local_us;
+    this->shared_us_ = shared_us;
+    this->skew_ppm_ = skew_ppm;
+    this->sequence_.store(sequence + 2, std::memory_order_release);
+  }
+
+  /// Until the first publish() the shared time is the local time.
+  bool is_synchronized() const { return this->sequence_.load(std::memory_order_acquire) != 0; }
+
+  int64_t to_shared_us(int64_t local_us) const {
+    int64_t anchor_local, anchor_shared;
+    float skew_ppm;
+    this->get_mapping_(&anchor_local, &anchor_shared, &skew_ppm);
+    int64_t elapsed = local_us - anchor_local;
+    return anchor_shared + elapsed + static_cast<int64_t>(static_cast<float>(elapsed) * skew_ppm * 1e-6f);
+  }
+
+  int64_t to_local_us(int64_t shared_us) const {
+    int64_t anchor_local, anchor_shared;
+    float skew_ppm;
+    this->get_mapping_(&anchor_local, &anchor_shared, &skew_ppm);
+    int64_t elapsed = shared_us - anchor_shared;
+    return anchor_local + elapsed - static_cast<int64_t>(static_cast<float>(elapsed) * skew_ppm * 1e-6f);
+  }
+
+  float get_skew_ppm() const {
+    int64_t anchor_local, anchor_shared;
+    float skew_ppm;
+    this->get_mapping_(&anchor_local, &anchor_shared, &skew_ppm);
+    return skew_ppm;
+  }
+
+ protected:
+  void get_mapping_(int64_t *local_us, int64_t *shared_us, float *skew_ppm) const {
+    uint32_t sequence;
+    do {
+      sequence = this->sequence_.load(std::memory_order_acquire);
+      *local_us = this->local_us_;
+      *shared_us = this->shared_us_;
+      *skew_ppm = this->skew_ppm_;
+      std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((sequence & 1) != 0 || sequence != this->sequence_.load(std::memory_order_relaxed));
+  }
+
+  std::atomic<uint32_t> sequence_{0};
+  int64_t local_us_{0};
+  int64_t shared_us_{0};
+  float skew_ppm_{0.0f};
+};
+
+}  // namespace audio_utils
+}  // namespace esphome
@@ -1,25 +1,116 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
 
-from esphome.components import i2c
-from esphome.const import CONF_ID
+from esphome.components import i2c, microphone, speaker
+from esphome.components.audio_utils import (
+    BIQUAD_SCHEMA,
+    biquad_coefficients_expression,
+    design_biquad,
+)
+from esphome.const import CONF_ID, CONF_MICROPHONE, CONF_SPEAKER
 
 CODEOWNERS = ["@kroimon"]
+AUTO_LOAD = ["audio_utils"]
 
 es8311_ns = cg.esphome_ns.namespace("es8311")
 ES8311Component = es8311_ns.class_("ES8311Component", cg.Component, i2c.I2CDevice)
 
 CONF_USE_MCLK = "use_mclk"
+CONF_SAMPLE_RATE = "sample_rate"
+CONF_BITS_PER_SAMPLE = "bits_per_sample"
+CONF_ADC_EQUALIZER = "adc_equalizer"
+CONF_ALC = "alc"
+CONF_MAX_LEVEL = "max_level"
+CONF_MIN_LEVEL = "min_level"
+CONF_WINDOW_SIZE = "window_size"
+CONF_NOISE_GATE = "noise_gate"
+CONF_THRESHOLD = "threshold"
+CONF_ATTENUATION = "attenuation"
+CONF_POWER_OFF_DELAY = "power_off_delay"
+
+
+def _alc_level_code(level_db):
+    # 4-bit ALC level: 20 * log10((code + 1) / 32) dBFS, -30.1 dB to -6.0 dB
+    code = round(32 * 10 ** (level_db / 20.0)) - 1
+    return max(0, min(15, code))
+
+
+def _noise_gate_code(threshold_db):
+    # 4-bit automute threshold in 6 dB steps from -96 dBFS
+    return max(0, min(15, round((threshold_db + 96.0) / 6.0)))
+
+
+def _validate_alc(config):
+    if config[CONF_MIN_LEVEL] > config[CONF_MAX_LEVEL]:
+        raise cv.Invalid(f"{CONF_MIN_LEVEL} must not be above {CONF_MAX_LEVEL}")
+    return config
+
+
+ALC_SCHEMA = cv.All(
+    cv.Schema(
+        {
+            cv.Optional(CONF_MAX_LEVEL, default="-6dB"): cv.All(
+                cv.decibel, cv.Range(min=-30.1, max=-6.0)
+            ),
+            cv.Optional(CONF_MIN_LEVEL, default="-18dB"): cv.All(
+                cv.decibel, cv.Range(min=-30.1, max=-6.0)
+            ),
+            # Raw ALC_WINSIZE field of REG18, larger values react more slowly
+            cv.Optional(CONF_WINDOW_SIZE, default=4): cv.int_range(min=0, max=15),
+            cv.Optional(CONF_NOISE_GATE): cv.Schema(
+                {
+                    cv.Optional(CONF_THRESHOLD, default="-72dB"): cv.All(
+                        cv.decibel, cv.Range(min=-96.0, max=-6.0)
+                    ),
+                    cv.Optional(CONF_ATTENUATION, default="-28dB"): cv.All(
+                        cv.decibel, cv.Range(min=-28.0, max=0.0)
+                    ),
+                    cv.Optional(CONF_WINDOW_SIZE, default=4): cv.int_range(
+                        min=0, max=15
+                    ),
+                }
+            ),
+        }
+    ),
+    _validate_alc,
+)
+
+# Rates with a coefficient set for MCLK = 256 x rate
+SAMPLE_RATES = [8000, 11025, 12000, 16000, 22050, 24000, 32000, 44100, 48000, 64000]
+
+_validate_bits = cv.float_with_unit("bits", "bit")
+
+
+def _validate_adc_equalizer(config):
+    if CONF_ADC_EQUALIZER in config:
+        design_biquad(config[CONF_ADC_EQUALIZER], config[CONF_SAMPLE_RATE])
+    return config
+
 
 CONFIG_SCHEMA = (
     cv.Schema(
         {
             cv.GenerateID(): cv.declare_id(ES8311Component),
             cv.Optional(CONF_USE_MCLK): cv.boolean,
+            cv.Optional(CONF_SAMPLE_RATE, default=16000): cv.All(
+                cv.int_, cv.one_of(*SAMPLE_RATES)
+            ),
+            cv.Optional(CONF_BITS_PER_SAMPLE, default="16bit"): cv.All(
+                _validate_bits, cv.int_, cv.one_of(16, 18, 20, 24, 32)
+            ),
+            cv.Optional(CONF_ADC_EQUALIZER): BIQUAD_SCHEMA,
+            cv.Optional(CONF_ALC): ALC_SCHEMA,
+            # The codec powers its ADC and DAC paths up only while these are running
+            cv.Optional(CONF_SPEAKER): cv.use_id(speaker.Speaker),
+            cv.Optional(CONF_MICROPHONE): cv.use_id(microphone.Microphone),
+            cv.Optional(
+                CONF_POWER_OFF_DELAY, default="60s"
+            ): cv.positive_time_period_milliseconds,
         }
     )
     .extend(i2c.i2c_device_schema(0x18))
     .extend(cv.COMPONENT_SCHEMA)
+    .add_extra(_validate_adc_equalizer)
 )
 
 
@@ -30,3 +121,38 @@ async def to_code(config):
 
     if CONF_USE_MCLK in config:
         cg.add(var.set_use_mclk(config[CONF_USE_MCLK]))
+    cg.add(var.set_sample_rate(config[CONF_SAMPLE_RATE]))
+    cg.add(var.set_bits_per_sample(config[CONF_BITS_PER_SAMPLE]))
+
+    if CONF_SPEAKER in config:
+        spk = await cg.get_variable(config[CONF_SPEAKER])
+        cg.add(var.set_speaker(spk))
+    if CONF_MICROPHONE in config:
+        mic = await cg.get_variable(config[CONF_MICROPHONE])
+        cg.add(var.set_microphone(mic))
+    cg.add(var.set_power_off_delay(config[CONF_POWER_OFF_DELAY]))
+
+    if eq_config := config.get(CONF_ADC_EQUALIZER):
+        coefficients = design_biquad(eq_config, config[CONF_SAMPLE_RATE])
+        cg.add(
+            var.set_adc_equalizer(biquad_coefficients_expression(coefficients))
+        )
+
+    if alc_config := config.get(CONF_ALC):
+        # Microphones leave gain control to the codec instead of running a software ALC
+        cg.add_define("USE_ES8311_HARDWARE_ALC")
+        cg.add(
+            var.set_alc(
+                _alc_level_code(alc_config[CONF_MAX_LEVEL]),
+                _alc_level_code(alc_config[CONF_MIN_LEVEL]),
+                alc_config[CONF_WINDOW_SIZE],
+            )
+        )
+        if gate_config := alc_config.get(CONF_NOISE_GATE):
+            cg.add(
+                var.set_noise_gate(
+                    _noise_gate_code(gate_config[CONF_THRESHOLD]),
+                    round(-gate_config[CONF_ATTENUATION] / 4.0),
+                    gate_config[CONF_WINDOW_SIZE],
+                )
+            )
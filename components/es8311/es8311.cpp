@@ -8,26 +8,53 @@ namespace es8311 {
 
 static const char *const TAG = "es8311";
 
+// Leaving STANDBY or OFF must not delay the first sample noticeably
+static const uint32_t WAKE_BUDGET_US = 5000;
+
+static const char *power_state_to_string(ES8311PowerState state) {
+  switch (state) {
+    case ES8311PowerState::OFF:
+      return "off";
+    case ES8311PowerState::STANDBY:
+      return "standby";
+    case ES8311PowerState::CAPTURE:
+      return "capture";
+    case ES8311PowerState::PLAYBACK:
+      return "playback";
+    case ES8311PowerState::DUPLEX:
+      return "duplex";
+    default:
+      return "unknown";
+  }
+}
+
 #define ES8311_ERROR_CHECK(func) \
   if (!(func)) { \
     this->mark_failed(); \
     ESP_LOGE(TAG, "Operation failed at: " #func); \
     return; \
   }
-#define ES8311_READ_BYTE(reg, value) ES8311_ERROR_CHECK(this->read_byte(reg, value));
-#define ES8311_WRITE_BYTE(reg, value) ES8311_ERROR_CHECK(this->write_byte(reg, value));
+#define ES8311_WRITE_BYTE(reg, value) this->write_register_(reg, value);
+#define ES8311_FLUSH() ES8311_ERROR_CHECK(this->flush_());
 
 void ES8311Component::setup() {
   ESP_LOGCONFIG(TAG, "Setting up ES8311...");
 
   // Reset
   ESP_LOGCONFIG(TAG, "Resetting ES8311...");
-  ES8311_WRITE_BYTE(ES8311_REG00_RESET, 0x1F);
+  ES8311_ERROR_CHECK(this->write_byte(ES8311_REG00_RESET, 0x1F));
   delay(20);
-  ES8311_WRITE_BYTE(ES8311_REG00_RESET, 0x00);
+  ES8311_ERROR_CHECK(this->write_byte(ES8311_REG00_RESET, 0x00));
+  this->transaction_count_ += 2;
+
+  // Start the shadow from the codec's reset state
+  ES8311_ERROR_CHECK(this->load_registers_());
 
   // Configure clock and audio format
-  this->configure_clock_();
+  if (!this->configure_clock_()) {
+    this->mark_failed();
+    return;
+  }
   this->configure_format_();
 
   // Check if any operation has failed during configuration
@@ -41,65 +68,96 @@ void ES8311Component::setup() {
 
   // Configure microphone
   this->configure_microphone_();
+  this->configure_alc_();
 
-  // Power up
+  // Power up, fully unless a speaker or microphone tells us when the paths are needed
   ESP_LOGCONFIG(TAG, "Powering up ES8311...");
-  ES8311_WRITE_BYTE(ES8311_REG0D_SYSTEM, 0x01);  // Power up analog circuitry
-  ES8311_WRITE_BYTE(ES8311_REG0E_SYSTEM, 0x02);  // Enable analog PGA, enable ADC modulator
-  ES8311_WRITE_BYTE(ES8311_REG12_SYSTEM, 0x00);  // Power up DAC
-  ES8311_WRITE_BYTE(ES8311_REG13_SYSTEM, 0x10);  // Enable output to HP drive
+  this->idle_since_ms_ = millis();
+  this->power_state_ = this->requested_power_state_();
+  this->write_power_state_(this->power_state_);
   ES8311_WRITE_BYTE(ES8311_REG1C_ADC, 0x6A);     // ADC Equalizer bypass, cancel DC offset in digital domain
+  this->configure_adc_equalizer_();
   ES8311_WRITE_BYTE(ES8311_REG37_DAC, 0x08);     // Bypass DAC equalizer
-  ES8311_WRITE_BYTE(ES8311_REG00_RESET, 0x80);   // Power On
+  ES8311_FLUSH();
 
-  ESP_LOGCONFIG(TAG, "ES8311 setup complete.");
+  // Power on last, once everything above has reached the codec
+  ES8311_WRITE_BYTE(ES8311_REG00_RESET, 0x80);
+  ES8311_FLUSH();
+
+  ESP_LOGCONFIG(TAG, "ES8311 setup complete in %u I2C transactions.", (unsigned) this->transaction_count_);
 }
 
-void ES8311Component::configure_clock_() {
+bool ES8311Component::configure_clock_() {
   ESP_LOGCONFIG(TAG, "Configuring ES8311 clock...");
-  
+
+  // The codec runs from MCLK = 256 x rate, or from SCLK multiplied up to the same frequency
+  this->mclk_frequency_ = this->sample_frequency_ * 256;
+  const ES8311Coefficient *coeff = get_coefficient(this->mclk_frequency_, this->sample_frequency_);
+  if (coeff == nullptr) {
+    ESP_LOGE(TAG, "Unsupported sample rate %d Hz", this->sample_frequency_);
+    return false;
+  }
+
   // Register 0x01: select clock source for internal MCLK and determine its frequency
   uint8_t reg01 = 0x3F;  // Enable all clocks, set for slave mode
   reg01 |= BIT(7);       // Use SCLK instead of MCLK
   if (this->mclk_inverted_) {
     reg01 |= BIT(6);  // Invert MCLK pin
   }
+  if (this->power_state_ == ES8311PowerState::OFF) {
+    reg01 &= ~0x3F;  // Keep the clocks gated until a session needs them
+  }
   ES8311_WRITE_BYTE(ES8311_REG01_CLK_MANAGER, reg01);
 
-  // Set clock dividers and multipliers directly for 16kHz sample rate and 16-bit resolution
-  const ES8311Coefficient *coeff = get_coefficient(4096000, 16000);
-  if (coeff != nullptr) {
-    ES8311_WRITE_BYTE(ES8311_REG02_CLK_MANAGER, coeff->pre_div);
-    ES8311_WRITE_BYTE(ES8311_REG03_CLK_MANAGER, coeff->fs_mode);
-    ES8311_WRITE_BYTE(ES8311_REG04_CLK_MANAGER, coeff->dac_osr);
-    ES8311_WRITE_BYTE(ES8311_REG05_CLK_MANAGER, (coeff->adc_div << 4) | coeff->dac_div);
-    ES8311_WRITE_BYTE(ES8311_REG06_CLK_MANAGER, (this->sclk_inverted_ ? BIT(5) : 0) | coeff->bclk_div);
-    ES8311_WRITE_BYTE(ES8311_REG07_CLK_MANAGER, coeff->lrck_h);
-    ES8311_WRITE_BYTE(ES8311_REG08_CLK_MANAGER, coeff->lrck_l);
-  }
+  // SCLK carries two 16- or 32-bit slots per frame, multiply it up to 256 x rate
+  uint8_t slot_bits = this->resolution_out_ > ES8311_RESOLUTION_16 ? 32 : 16;
+  uint8_t pre_mult = (reg01 & BIT(7)) ? 256 / (2 * slot_bits) : coeff->pre_mult;
+  uint8_t pre_mult_bits = pre_mult == 8 ? 3 : pre_mult == 4 ? 2 : pre_mult == 2 ? 1 : 0;
+
+  ES8311_WRITE_BYTE(ES8311_REG02_CLK_MANAGER, ((coeff->pre_div - 1) << 5) | (pre_mult_bits << 3));
+  ES8311_WRITE_BYTE(ES8311_REG03_CLK_MANAGER, (coeff->fs_mode << 6) | coeff->adc_osr);
+  ES8311_WRITE_BYTE(ES8311_REG04_CLK_MANAGER, coeff->dac_osr);
+  ES8311_WRITE_BYTE(ES8311_REG05_CLK_MANAGER, ((coeff->adc_div - 1) << 4) | (coeff->dac_div - 1));
+  uint8_t bclk_div = coeff->bclk_div < 19 ? coeff->bclk_div - 1 : coeff->bclk_div;
+  ES8311_WRITE_BYTE(ES8311_REG06_CLK_MANAGER, (this->sclk_inverted_ ? BIT(5) : 0) | bclk_div);
+  this->update_register_(ES8311_REG07_CLK_MANAGER, 0x3F, coeff->lrck_h);
+  ES8311_WRITE_BYTE(ES8311_REG08_CLK_MANAGER, coeff->lrck_l);
 
   ESP_LOGCONFIG(TAG, "ES8311 clock configured.");
+  return true;
 }
 
 void ES8311Component::configure_format_() {
   ESP_LOGCONFIG(TAG, "Configuring ES8311 format...");
-  // Configure I2S mode and format
-  uint8_t reg09;
-  ES8311_READ_BYTE(ES8311_REG09_SDPIN, &reg09);
-  reg09 &= 0x80; // Clear existing format bits
-  reg09 |= (1 << 4); // Set I2S format (Standard I2S)
-  ES8311_WRITE_BYTE(ES8311_REG09_SDPIN, reg09);
-
-  // Configure sample rate to 16kHz (ADC)
-  uint8_t reg0A;
-  ES8311_READ_BYTE(ES8311_REG0A_SDPOUT, &reg0A);
-  reg0A &= 0xF0; // Clear existing sample rate bits
-  reg0A |= 0x02; // Set sample rate to 16kHz (Standard setting for 16kHz)
-  ES8311_WRITE_BYTE(ES8311_REG0A_SDPOUT, reg0A);
-
+  // Standard I2S format (bits 1:0 = 0) with the word length in bits 4:2
+  this->update_register_(ES8311_REG09_SDPIN, 0x1F, calculate_resolution_value(this->resolution_out_));
+  this->update_register_(ES8311_REG0A_SDPOUT, 0x1F, calculate_resolution_value(this->resolution_in_));
   ESP_LOGCONFIG(TAG, "ES8311 format configured.");
 }
 
+bool ES8311Component::set_format(uint32_t sample_rate, uint8_t bits_per_sample) {
+  if (this->is_failed())
+    return false;
+
+  if (get_coefficient(sample_rate * 256, sample_rate) == nullptr) {
+    ESP_LOGE(TAG, "Unsupported sample rate %u Hz", (unsigned) sample_rate);
+    return false;
+  }
+  this->sample_frequency_ = sample_rate;
+  this->set_bits_per_sample(bits_per_sample);
+  this->configure_clock_();
+  this->configure_format_();
+
+  [[maybe_unused]] uint32_t before = this->transaction_count_;
+  if (!this->flush_()) {
+    ESP_LOGE(TAG, "Failed to switch to %u Hz / %u bit", (unsigned) sample_rate, bits_per_sample);
+    return false;
+  }
+  ESP_LOGD(TAG, "Switched to %u Hz / %u bit with %u I2C writes", (unsigned) sample_rate, bits_per_sample,
+           (unsigned) (this->transaction_count_ - before));
+  return true;
+}
+
 uint8_t ES8311Component::calculate_resolution_value(ES8311Resolution resolution) {
   switch (resolution) {
     case ES8311_RESOLUTION_16:
@@ -128,6 +186,124 @@ void ES8311Component::configure_microphone_() {
   ES8311_WRITE_BYTE(ES8311_REG17_ADC, 0xC8);                    // Set ADC gain
 }
 
+void ES8311Component::loop() {
+  if (this->is_failed())
+    return;
+  ES8311PowerState requested = this->requested_power_state_();
+  if (requested != this->power_state_)
+    this->set_power_state(requested);
+}
+
+ES8311PowerState ES8311Component::requested_power_state_() {
+  bool managed = false;
+  bool playback = false;
+  bool capture = false;
+#ifdef USE_SPEAKER
+  if (this->speaker_ != nullptr) {
+    managed = true;
+    playback = !this->speaker_->is_stopped();
+  }
+#endif
+#ifdef USE_MICROPHONE
+  if (this->microphone_ != nullptr) {
+    managed = true;
+    capture = !this->microphone_->is_stopped();
+  }
+#endif
+  if (!managed)
+    return ES8311PowerState::DUPLEX;
+
+  if (playback && capture)
+    return ES8311PowerState::DUPLEX;
+  if (playback)
+    return ES8311PowerState::PLAYBACK;
+  if (capture)
+    return ES8311PowerState::CAPTURE;
+
+  // Idle: stay in standby for a quick restart, power off after a while
+  uint32_t now = millis();
+  if (this->power_state_ != ES8311PowerState::STANDBY && this->power_state_ != ES8311PowerState::OFF)
+    this->idle_since_ms_ = now;
+  if (this->power_state_ == ES8311PowerState::OFF || now - this->idle_since_ms_ >= this->power_off_delay_ms_)
+    return ES8311PowerState::OFF;
+  return ES8311PowerState::STANDBY;
+}
+
+void ES8311Component::write_power_state_(ES8311PowerState state) {
+  const bool dac = state == ES8311PowerState::PLAYBACK || state == ES8311PowerState::DUPLEX;
+  const bool adc = state == ES8311PowerState::CAPTURE || state == ES8311PowerState::DUPLEX;
+  const bool analog = dac || adc;
+
+  // Register values follow the Espressif reference driver's start/stop/suspend sequences
+  this->update_register_(ES8311_REG01_CLK_MANAGER, 0x3F, state == ES8311PowerState::OFF ? 0x00 : 0x3F);
+  this->write_register_(ES8311_REG0D_SYSTEM,
+                        analog ? 0x01 : (state == ES8311PowerState::OFF ? 0xFC : 0xFA));  // Analog circuitry
+  this->write_register_(ES8311_REG0E_SYSTEM, adc ? 0x02 : 0xFF);  // Analog PGA and ADC modulator
+  this->write_register_(ES8311_REG12_SYSTEM, dac ? 0x00 : 0x02);  // DAC
+  this->write_register_(ES8311_REG13_SYSTEM, dac ? 0x10 : 0x00);  // Output to HP drive
+  this->update_register_(ES8311_REG09_SDPIN, 1 << 6, dac ? 0 : 1 << 6);   // DAC serial port mute
+  this->update_register_(ES8311_REG0A_SDPOUT, 1 << 6, adc ? 0 : 1 << 6);  // ADC serial port mute
+}
+
+void ES8311Component::set_power_state(ES8311PowerState state) {
+  if (this->is_failed() || state == this->power_state_)
+    return;
+
+  const bool waking = this->power_state_ == ES8311PowerState::OFF || this->power_state_ == ES8311PowerState::STANDBY;
+  [[maybe_unused]] const uint32_t transactions = this->transaction_count_;
+  const uint32_t start = micros();
+  this->write_power_state_(state);
+  if (!this->flush_()) {
+    ESP_LOGE(TAG, "Failed to switch power state to %s", power_state_to_string(state));
+    this->status_set_warning();
+    return;
+  }
+  const uint32_t elapsed = micros() - start;
+
+  ESP_LOGD(TAG, "Power state %s -> %s in %u us (%u I2C writes)", power_state_to_string(this->power_state_),
+           power_state_to_string(state), (unsigned) elapsed, (unsigned) (this->transaction_count_ - transactions));
+  if (waking && state != ES8311PowerState::OFF && state != ES8311PowerState::STANDBY) {
+    this->last_wake_us_ = elapsed;
+    if (elapsed > WAKE_BUDGET_US)
+      ESP_LOGW(TAG, "Waking up took %u us, over the %u us budget", (unsigned) elapsed, (unsigned) WAKE_BUDGET_US);
+  }
+  this->power_state_ = state;
+}
+
+void ES8311Component::configure_alc_() {
+  if (!this->use_alc_)
+    return;
+
+  // REG18: ALC enable (bit 7), automute enable (bit 6), window size (bits 3:0)
+  uint8_t reg18 = BIT(7) | (this->alc_window_size_ & 0x0F);
+  if (this->use_noise_gate_)
+    reg18 |= BIT(6);
+  ES8311_WRITE_BYTE(ES8311_REG18_ADC, reg18);
+  ES8311_WRITE_BYTE(ES8311_REG19_ADC, (this->alc_max_level_ << 4) | (this->alc_min_level_ & 0x0F));
+
+  if (this->use_noise_gate_) {
+    // REG1A: automute window size and noise gate, REG1B bits 7:5: automute volume
+    ES8311_WRITE_BYTE(ES8311_REG1A_ADC, (this->noise_gate_window_size_ << 4) | (this->noise_gate_threshold_ & 0x0F));
+    this->update_register_(ES8311_REG1B_ADC, 0xE0, this->noise_gate_volume_ << 5);
+  }
+}
+
+void ES8311Component::configure_adc_equalizer_() {
+  if (!this->use_adc_equalizer_)
+    return;
+
+  // Five 32-bit Q2.30 coefficients, MSB first, in the order B0, A1, A2, B1, B2
+  const int32_t coefficients[] = {this->adc_equalizer_.b0, this->adc_equalizer_.a1, this->adc_equalizer_.a2,
+                                  this->adc_equalizer_.b1, this->adc_equalizer_.b2};
+  uint8_t reg = ES8311_REG1D_ADCEQ;
+  for (int32_t coefficient : coefficients) {
+    uint32_t value = static_cast<uint32_t>(coefficient);
+    for (int shift = 24; shift >= 0; shift -= 8)
+      ES8311_WRITE_BYTE(reg++, (value >> shift) & 0xFF);
+  }
+  this->update_register_(ES8311_REG1C_ADC, BIT(6), 0);  // Take the equalizer out of bypass
+}
+
 void ES8311Component::dump_config() {
   ESP_LOGCONFIG(TAG, "ES8311 Audio Codec:");
   ESP_LOGCONFIG(TAG, "  Use MCLK: %s", YESNO(this->use_mclk_));
@@ -135,12 +311,14 @@ void ES8311Component::dump_config() {
     ESP_LOGCONFIG(TAG, "  Failed to initialize!");
     return;
   }
+  ESP_LOGCONFIG(TAG, "  ADC equalizer: %s", ONOFF(this->use_adc_equalizer_));
+  ESP_LOGCONFIG(TAG, "  ALC: %s, noise gate: %s", ONOFF(this->use_alc_), ONOFF(this->use_noise_gate_));
+  ESP_LOGCONFIG(TAG, "  Power state: %s", power_state_to_string(this->power_state_));
+  ESP_LOGCONFIG(TAG, "  I2C transactions: %u", (unsigned) this->transaction_count_);
 #ifdef ESPHOME_LOG_HAS_VERBOSE
   ESP_LOGV(TAG, "  Register Values:");
-  for (uint8_t reg = 0; reg <= 0x45; reg++) {
-    uint8_t value;
-    ES8311_READ_BYTE(reg, &value);
-    ESP_LOGV(TAG, "    %02x = %02x", reg, value);
+  for (uint8_t reg = 0; reg < ES8311_REGISTER_COUNT; reg++) {
+    ESP_LOGV(TAG, "    %02x = %02x", reg, this->read_register_(reg));
   }
 #endif
 }
@@ -149,31 +327,72 @@ void ES8311Component::set_volume(float volume) {
   volume = clamp(volume, 0.0f, 1.0f);
   uint8_t reg32 = remap<uint8_t, float>(volume, 0.0f, 1.0f, 0, 255);
   ES8311_WRITE_BYTE(ES8311_REG32_DAC, reg32);
+  ES8311_FLUSH();
 }
 
 float ES8311Component::get_volume() {
-  uint8_t reg32;
-  this->read_byte(ES8311_REG32_DAC, &reg32);
-  return remap<uint8_t, float>(reg32, 0, 255, 0.0f, 1.0f);
+  return remap<uint8_t, float>(this->read_register_(ES8311_REG32_DAC), 0, 255, 0.0f, 1.0f);
 }
 
 void ES8311Component::set_mute(bool mute) {
-  uint8_t reg31;
-  ES8311_READ_BYTE(ES8311_REG31_DAC, &reg31);
+  this->update_register_(ES8311_REG31_DAC, BIT(6) | BIT(5), mute ? BIT(6) | BIT(5) : 0);
+  ES8311_FLUSH();
+}
 
-  if (mute) {
-    reg31 |= BIT(6) | BIT(5);
-  } else {
-    reg31 &= ~(BIT(6) | BIT(5));
-  }
+bool ES8311Component::load_registers_() {
+  this->transaction_count_++;
+  if (!this->read_bytes(0x00, this->shadow_, ES8311_REGISTER_COUNT))
+    return false;
+  for (auto &word : this->dirty_)
+    word = 0;
+  return true;
+}
 
-  ES8311_WRITE_BYTE(ES8311_REG31_DAC, reg31);
+void ES8311Component::write_register_(uint8_t reg, uint8_t value) {
+  if (this->shadow_[reg] == value)
+    return;
+  this->shadow_[reg] = value;
+  this->dirty_[reg / 32] |= 1u << (reg % 32);
+}
+
+void ES8311Component::update_register_(uint8_t reg, uint8_t mask, uint8_t value) {
+  this->write_register_(reg, (this->shadow_[reg] & ~mask) | (value & mask));
+}
+
+bool ES8311Component::flush_() {
+  auto is_dirty = [this](uint8_t reg) { return (this->dirty_[reg / 32] >> (reg % 32)) & 1; };
+
+  bool ok = true;
+  uint8_t reg = 0;
+  while (reg < ES8311_REGISTER_COUNT) {
+    if (!is_dirty(reg)) {
+      reg++;
+      continue;
+    }
+    uint8_t start = reg;
+    while (reg < ES8311_REGISTER_COUNT && is_dirty(reg))
+      reg++;
+
+    this->transaction_count_++;
+    if (this->write_bytes(start, &this->shadow_[start], reg - start)) {
+      for (uint8_t r = start; r < reg; r++)
+        this->dirty_[r / 32] &= ~(1u << (r % 32));
+    } else {
+      ok = false;  // leave the run dirty so the next flush retries it
+    }
+  }
+  return ok;
 }
 
 const ES8311Coefficient *ES8311Component::get_coefficient(uint32_t mclk, uint32_t rate) {
-  for (const auto &coefficient : ES8311_COEFFICIENTS) {
-    if (coefficient.mclk == mclk && coefficient.rate == rate)
-      return &coefficient;
+  for (const auto &group : ES8311_RATE_GROUPS) {
+    if (group.rate != rate)
+      continue;
+    for (uint8_t i = group.first; i < group.first + group.count; i++) {
+      if (ES8311_COEFFICIENTS[i].mclk == mclk)
+        return &ES8311_COEFFICIENTS[i];
+    }
+    break;
   }
   return nullptr;
 }
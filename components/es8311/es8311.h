@@ -1,11 +1,21 @@
 #pragma once
 
+#include "esphome/components/audio_utils/biquad.h"
 #include "esphome/components/i2c/i2c.h"
 #include "esphome/core/component.h"
 
+#ifdef USE_MICROPHONE
+#include "esphome/components/microphone/microphone.h"
+#endif
+#ifdef USE_SPEAKER
+#include "esphome/components/speaker/speaker.h"
+#endif
+
 namespace esphome {
 namespace es8311 {
 
+static const uint8_t ES8311_REGISTER_COUNT = 0x46;  // registers 0x00-0x45
+
 enum ES8311MicGain {
   ES8311_MIC_GAIN_MIN = -1,
   ES8311_MIC_GAIN_0DB,
@@ -42,25 +52,128 @@ struct ES8311Coefficient {
   uint8_t dac_osr;   // dac osr
 };
 
+enum class ES8311PowerState : uint8_t {
+  OFF = 0,   // analog blocks and internal clocks down
+  STANDBY,   // clocks running, references charged, ADC and DAC paths down
+  CAPTURE,   // ADC path only
+  PLAYBACK,  // DAC path only
+  DUPLEX,
+};
+
+struct ES8311RateGroup {
+  uint32_t rate;
+  uint8_t first;  // index of the first coefficient for this rate
+  uint8_t count;
+};
+
 class ES8311Component : public Component, public i2c::I2CDevice {
  public:
   void setup() override;
+  void loop() override;
   float get_setup_priority() const override { return setup_priority::LATE - 1; }
   void dump_config() override;
 
   void set_use_mclk(bool use_mclk) { this->use_mclk_ = use_mclk; }
+  void set_sample_rate(uint32_t sample_rate) { this->sample_frequency_ = sample_rate; }
+  void set_bits_per_sample(uint8_t bits_per_sample) {
+    this->resolution_in_ = this->resolution_out_ = static_cast<ES8311Resolution>(bits_per_sample);
+  }
+
+  /// Reprogram the clock tree and serial port for another sample rate or word length, e.g. to follow
+  /// a stream's native rate. Only registers whose value changes are written. Returns false if the
+  /// rate cannot be derived from MCLK = 256 x rate.
+  bool set_format(uint32_t sample_rate, uint8_t bits_per_sample);
+  uint32_t get_sample_rate() const { return this->sample_frequency_; }
+
+  /// Run the ADC through the codec's equalizer biquad, in place of a software pre-filter.
+  void set_adc_equalizer(const audio_utils::BiquadCoefficients &coefficients) {
+    this->adc_equalizer_ = coefficients;
+    this->use_adc_equalizer_ = true;
+  }
+
+  /// Codec-side ALC on the ADC path. Levels are the 4-bit REG19 codes, window the REG18 ALC_WINSIZE.
+  void set_alc(uint8_t max_level, uint8_t min_level, uint8_t window_size) {
+    this->use_alc_ = true;
+    this->alc_max_level_ = max_level;
+    this->alc_min_level_ = min_level;
+    this->alc_window_size_ = window_size;
+  }
+  /// Automute below `threshold` (REG1A noise gate code), attenuating by `volume` x 4 dB.
+  void set_noise_gate(uint8_t threshold, uint8_t volume, uint8_t window_size) {
+    this->use_noise_gate_ = true;
+    this->noise_gate_threshold_ = threshold;
+    this->noise_gate_volume_ = volume;
+    this->noise_gate_window_size_ = window_size;
+  }
 
   void set_volume(float volume);
   float get_volume();
   void set_mute(bool mute);
 
+  /// Switch the analog blocks on or off. Only the registers that differ between the two states are
+  /// written. With a speaker or microphone configured, loop() does this on its own.
+  void set_power_state(ES8311PowerState state);
+  ES8311PowerState get_power_state() const { return this->power_state_; }
+  /// Time the last transition out of OFF or STANDBY took, in microseconds.
+  uint32_t get_last_wake_us() const { return this->last_wake_us_; }
+
+#ifdef USE_SPEAKER
+  void set_speaker(speaker::Speaker *speaker) { this->speaker_ = speaker; }
+#endif
+#ifdef USE_MICROPHONE
+  void set_microphone(microphone::Microphone *microphone) { this->microphone_ = microphone; }
+#endif
+  void set_power_off_delay(uint32_t power_off_delay_ms) { this->power_off_delay_ms_ = power_off_delay_ms; }
+
+  /// Number of I2C transactions issued since boot.
+  uint32_t get_transaction_count() const { return this->transaction_count_; }
+
  protected:
   static const ES8311Coefficient *get_coefficient(uint32_t mclk, uint32_t rate);
   static uint8_t calculate_resolution_value(ES8311Resolution resolution);
 
-  void configure_clock_();
+  bool configure_clock_();
   void configure_format_();
   void configure_microphone_();
+  void configure_adc_equalizer_();
+  void configure_alc_();
+  void write_power_state_(ES8311PowerState state);
+  ES8311PowerState requested_power_state_();
+
+  // Register access goes through a shadow copy of 0x00-0x45. Writes only update the shadow and
+  // mark changed registers dirty; flush_() sends each run of dirty registers as one burst.
+  bool load_registers_();
+  uint8_t read_register_(uint8_t reg) const { return this->shadow_[reg]; }
+  void write_register_(uint8_t reg, uint8_t value);
+  void update_register_(uint8_t reg, uint8_t mask, uint8_t value);
+  bool flush_();
+
+  uint8_t shadow_[ES8311_REGISTER_COUNT]{};
+  uint32_t dirty_[(ES8311_REGISTER_COUNT + 31) / 32]{};
+  uint32_t transaction_count_{0};
+
+  audio_utils::BiquadCoefficients adc_equalizer_{};
+  bool use_adc_equalizer_{false};
+
+  ES8311PowerState power_state_{ES8311PowerState::STANDBY};
+  uint32_t last_wake_us_{0};
+  uint32_t power_off_delay_ms_{60000};
+  uint32_t idle_since_ms_{0};
+#ifdef USE_SPEAKER
+  speaker::Speaker *speaker_{nullptr};
+#endif
+#ifdef USE_MICROPHONE
+  microphone::Microphone *microphone_{nullptr};
+#endif
+
+  bool use_alc_{false};
+  uint8_t alc_max_level_{15};
+  uint8_t alc_min_level_{3};
+  uint8_t alc_window_size_{4};
+  bool use_noise_gate_{false};
+  uint8_t noise_gate_threshold_{4};
+  uint8_t noise_gate_volume_{7};
+  uint8_t noise_gate_window_size_{4};
 
   bool use_microphone_{false};
   ES8311MicGain microphone_gain_{ES8311_MIC_GAIN_42DB};
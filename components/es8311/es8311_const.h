@@ -82,8 +82,8 @@ static const uint8_t ES8311_REGFD_CHD1 = 0xFD;         // Chip: ID1
 static const uint8_t ES8311_REGFE_CHD2 = 0xFE;         // Chip: ID2
 static const uint8_t ES8311_REGFF_CHVER = 0xFF;        // Chip: Version
 
-// ES8311 clock divider coefficients
-static const ES8311Coefficient ES8311_COEFFICIENTS[] = {
+// ES8311 clock divider coefficients, grouped by sample rate
+static constexpr ES8311Coefficient ES8311_COEFFICIENTS[] = {
     // clang-format off
 
   //   mclk,  rate, pre_  pre_  adc_  dac_  fs_   lrck  lrck bclk_  adc_  dac_
@@ -191,5 +191,34 @@ static const ES8311Coefficient ES8311_COEFFICIENTS[] = {
     // clang-format on
 };
 
+static constexpr size_t ES8311_COEFFICIENT_COUNT = sizeof(ES8311_COEFFICIENTS) / sizeof(ES8311_COEFFICIENTS[0]);
+
+static constexpr uint8_t es8311_rate_first(uint32_t rate) {
+  for (size_t i = 0; i < ES8311_COEFFICIENT_COUNT; i++) {
+    if (ES8311_COEFFICIENTS[i].rate == rate)
+      return i;
+  }
+  return ES8311_COEFFICIENT_COUNT;
+}
+
+static constexpr uint8_t es8311_rate_count(uint32_t rate) {
+  uint8_t count = 0;
+  for (size_t i = es8311_rate_first(rate); i < ES8311_COEFFICIENT_COUNT && ES8311_COEFFICIENTS[i].rate == rate; i++)
+    count++;
+  return count;
+}
+
+#define ES8311_RATE_GROUP(rate) \
+  { rate, es8311_rate_first(rate), es8311_rate_count(rate) }
+
+// Slice of ES8311_COEFFICIENTS per sample rate, resolved by the compiler, sorted by rate
+static constexpr ES8311RateGroup ES8311_RATE_GROUPS[] = {
+    ES8311_RATE_GROUP(8000),  ES8311_RATE_GROUP(11025), ES8311_RATE_GROUP(12000), ES8311_RATE_GROUP(16000),
+    ES8311_RATE_GROUP(22050), ES8311_RATE_GROUP(24000), ES8311_RATE_GROUP(32000), ES8311_RATE_GROUP(44100),
+    ES8311_RATE_GROUP(48000), ES8311_RATE_GROUP(64000), ES8311_RATE_GROUP(88200), ES8311_RATE_GROUP(96000),
+};
+
+#undef ES8311_RATE_GROUP
+
 }  // namespace es8311
 }  // namespace esphome
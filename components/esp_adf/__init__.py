@@ -3,18 +3,36 @@ import esphome.codegen as cg
 import esphome.config_validation as cv
 import esphome.final_validate as fv
 from esphome.components import esp32
-from esphome.const import CONF_ID, CONF_BOARD
+from esphome.const import CONF_ID, CONF_BOARD, CONF_SAMPLE_RATE, CONF_TYPE
 
 CODEOWNERS = ["@jesserockz"]
 DEPENDENCIES = ["esp32"]
+AUTO_LOAD = ["audio_utils"]
 
 CONF_ESP_ADF_ID = "esp_adf_id"
 CONF_ESP_ADF = "esp_adf"
+CONF_MEMORY_SUMMARY_INTERVAL = "memory_summary_interval"
+
+CONF_PIPELINE = "pipeline"
+CONF_SOURCE = "source"
+CONF_DECODER = "decoder"
+CONF_FILTERS = "filters"
+CONF_SINK = "sink"
+CONF_RING_BUFFER_SIZE = "ring_buffer_size"
+CONF_BUFFER_SIZE = "buffer_size"
+CONF_TASK_CORE = "task_core"
+CONF_TASK_PRIORITY = "task_priority"
+CONF_SOURCE_SAMPLE_RATE = "source_sample_rate"
+CONF_SOURCE_CHANNELS = "source_channels"
+CONF_CHANNELS = "channels"
+CONF_COMPLEXITY = "complexity"
 
 esp_adf_ns = cg.esphome_ns.namespace("esp_adf")
 ESPADF = esp_adf_ns.class_("ESPADF", cg.Component)
 ESPADFPipeline = esp_adf_ns.class_("ESPADFPipeline", cg.Parented.template(ESPADF))
 ButtonHandler = esp_adf_ns.class_("ButtonHandler")
+PipelineElementType = esp_adf_ns.enum("PipelineElementType", is_class=True)
+PipelineElementConfig = esp_adf_ns.struct("PipelineElementConfig")
 
 SUPPORTED_BOARDS = {
     "esp32s3box": "CONFIG_ESP32_S3_BOX_BOARD",
@@ -44,11 +62,158 @@ def final_validate_usable_board(platform: str):
         extra=cv.ALLOW_EXTRA,
     )
 
+
+# Element type -> (enum, define that compiles its factory in)
+PIPELINE_ELEMENTS = {
+    "raw": (PipelineElementType.RAW_STREAM, "USE_ESP_ADF_PIPELINE_RAW_STREAM"),
+    "i2s": (PipelineElementType.I2S_STREAM, "USE_ESP_ADF_PIPELINE_I2S_STREAM"),
+    "http": (PipelineElementType.HTTP_STREAM, "USE_ESP_ADF_PIPELINE_HTTP_STREAM"),
+    "mp3": (PipelineElementType.MP3_DECODER, "USE_ESP_ADF_PIPELINE_MP3_DECODER"),
+    "resample": (
+        PipelineElementType.RESAMPLE_FILTER,
+        "USE_ESP_ADF_PIPELINE_RESAMPLE_FILTER",
+    ),
+}
+DECODERS = ["mp3"]
+# Sources whose output has to be decoded before its format is known
+COMPRESSED_SOURCES = ["http"]
+
+ELEMENT_SCHEMA = cv.Schema(
+    {
+        cv.Optional(CONF_BUFFER_SIZE): cv.int_range(min=512, max=256 * 1024),
+        cv.Optional(CONF_TASK_CORE): cv.int_range(min=0, max=1),
+        cv.Optional(CONF_TASK_PRIORITY): cv.int_range(min=1, max=24),
+    }
+)
+
+RESAMPLE_SCHEMA = ELEMENT_SCHEMA.extend(
+    {
+        cv.Required(CONF_SOURCE_SAMPLE_RATE): cv.int_range(min=8000, max=96000),
+        cv.Optional(CONF_SOURCE_CHANNELS, default=2): cv.int_range(min=1, max=2),
+        cv.Optional(CONF_SAMPLE_RATE, default=16000): cv.int_range(
+            min=8000, max=96000
+        ),
+        cv.Optional(CONF_CHANNELS, default=1): cv.int_range(min=1, max=2),
+        cv.Optional(CONF_COMPLEXITY, default=2): cv.int_range(min=1, max=5),
+    }
+)
+
+
+def _element_schema(types):
+    """An element given by its type alone, or as a mapping with a type and settings."""
+    schema = ELEMENT_SCHEMA.extend(
+        {cv.Required(CONF_TYPE): cv.one_of(*types, lower=True)}
+    )
+
+    def validator(value):
+        if isinstance(value, str):
+            value = {CONF_TYPE: value}
+        return schema(value)
+
+    return validator
+
+
+def _validate_topology(source_formats, sink_format):
+    """Follow (sample rate, channels) from the source through the filters."""
+
+    def validator(config):
+        source = config[CONF_SOURCE][CONF_TYPE]
+        if source in COMPRESSED_SOURCES and CONF_DECODER not in config:
+            raise cv.Invalid(f"A {source} source needs a decoder", path=[CONF_DECODER])
+        if source not in COMPRESSED_SOURCES and CONF_DECODER in config:
+            raise cv.Invalid(
+                f"A {source} source carries PCM, there is nothing to decode",
+                path=[CONF_DECODER],
+            )
+
+        # None while the decoder decides, the first resample filter follows the stream
+        audio_format = source_formats[source]
+        for index, element in enumerate(config[CONF_FILTERS]):
+            expected = (element[CONF_SOURCE_SAMPLE_RATE], element[CONF_SOURCE_CHANNELS])
+            if audio_format is not None and expected != audio_format:
+                raise cv.Invalid(
+                    f"Filter expects {expected[0]} Hz with {expected[1]} channel(s) "
+                    f"but receives {audio_format[0]} Hz with {audio_format[1]}",
+                    path=[CONF_FILTERS, index],
+                )
+            audio_format = (element[CONF_SAMPLE_RATE], element[CONF_CHANNELS])
+
+        if audio_format != sink_format:
+            raise cv.Invalid(
+                f"The {config[CONF_SINK][CONF_TYPE]} sink needs {sink_format[0]} Hz "
+                f"with {sink_format[1]} channel(s), add a resample filter",
+                path=[CONF_FILTERS],
+            )
+        return config
+
+    return validator
+
+
+def pipeline_schema(source_formats, sinks, sink_format):
+    """Schema for a pipeline option.
+
+    source_formats maps each allowed source type to the (sample rate, channels) it
+    produces, or None for compressed sources. sink_format is what the sink consumes.
+    """
+    return cv.All(
+        cv.Schema(
+            {
+                cv.Required(CONF_SOURCE): _element_schema(list(source_formats)),
+                cv.Optional(CONF_DECODER): _element_schema(DECODERS),
+                cv.Optional(CONF_FILTERS, default=[]): cv.ensure_list(
+                    cv.typed_schema({"resample": RESAMPLE_SCHEMA}, lower=True)
+                ),
+                cv.Required(CONF_SINK): _element_schema(sinks),
+                cv.Optional(CONF_RING_BUFFER_SIZE): cv.int_range(
+                    min=1024, max=256 * 1024
+                ),
+            }
+        ),
+        _validate_topology(source_formats, sink_format),
+    )
+
+
+async def pipeline_to_code(builder, config):
+    """Emit one typed add_element() per element, compiling in only those factories."""
+    if CONF_RING_BUFFER_SIZE in config:
+        cg.add(builder.set_ring_buffer_size(config[CONF_RING_BUFFER_SIZE]))
+
+    elements = [config[CONF_SOURCE]]
+    if CONF_DECODER in config:
+        elements.append(config[CONF_DECODER])
+    elements.extend(config[CONF_FILTERS])
+    elements.append(config[CONF_SINK])
+
+    for element in elements:
+        element_type, define = PIPELINE_ELEMENTS[element[CONF_TYPE]]
+        cg.add_define(define)
+        cg.add(
+            builder.add_element(
+                cg.StructInitializer(
+                    PipelineElementConfig,
+                    ("type", element_type),
+                    ("buffer_size", element.get(CONF_BUFFER_SIZE, 0)),
+                    ("task_core", element.get(CONF_TASK_CORE, -1)),
+                    ("task_priority", element.get(CONF_TASK_PRIORITY, -1)),
+                    ("source_rate", element.get(CONF_SOURCE_SAMPLE_RATE, 0)),
+                    ("source_channels", element.get(CONF_SOURCE_CHANNELS, 0)),
+                    ("dest_rate", element.get(CONF_SAMPLE_RATE, 0)),
+                    ("dest_channels", element.get(CONF_CHANNELS, 0)),
+                    ("complexity", element.get(CONF_COMPLEXITY, 0)),
+                )
+            )
+        )
+
+
 CONFIG_SCHEMA = cv.All(
     cv.Schema(
         {
             cv.GenerateID(): cv.declare_id(ESPADF),
             cv.Optional(CONF_BOARD): cv.string_strict,
+            # Log heap use per audio subsystem, "never" to turn it off
+            cv.Optional(
+                CONF_MEMORY_SUMMARY_INTERVAL, default="5min"
+            ): cv.update_interval,
         }
     ),
     _default_board,
@@ -60,6 +225,7 @@ async def to_code(config):
     await cg.register_component(var, config)
 
     cg.add_define("USE_ESP_ADF")
+    cg.add(var.set_memory_summary_interval(config[CONF_MEMORY_SUMMARY_INTERVAL]))
 
     cg.add_platformio_option("build_unflags", "-Wl,--end-group")
 
@@ -82,6 +248,9 @@ async def to_code(config):
         "board_build.embed_txtfiles", "components/dueros_service/duer_profile"
     )
 
+    # SessionArena learns from a deletion callback when a finished task's memory is free again
+    esp32.add_idf_sdkconfig_option("CONFIG_FREERTOS_TLSP_DELETION_CALLBACKS", True)
+
     if board := config.get(CONF_BOARD):
         cg.add_define("USE_ESP_ADF_BOARD")
 
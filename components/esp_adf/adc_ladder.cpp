@@ -0,0 +1,119 @@
+#include "adc_ladder.h"
+
+#include <algorithm>
+
+namespace esphome {
+namespace esp_adf {
+
+const char *ladder_event_type_to_string(LadderEventType type) {
+  switch (type) {
+    case LadderEventType::CLICK:
+      return "click";
+    case LadderEventType::LONG_PRESS:
+      return "long press";
+    case LadderEventType::REPEAT:
+      return "repeat";
+    default:
+      return "unknown";
+  }
+}
+
+void AdcLadderDecoder::add_key(uint8_t id, uint16_t raw, uint32_t debounce_ms) {
+  Key key{id, raw, debounce_ms, 0, 0};
+  auto position = std::upper_bound(this->keys_.begin(), this->keys_.end(), key,
+                                   [](const Key &a, const Key &b) { return a.raw < b.raw; });
+  this->keys_.insert(position, key);
+  this->update_windows_();
+}
+
+void AdcLadderDecoder::update_windows_() {
+  for (size_t i = 0; i < this->keys_.size(); i++) {
+    Key &key = this->keys_[i];
+    key.lower = int32_t(key.raw) - this->tolerance_;
+    key.upper = int32_t(key.raw) + this->tolerance_;
+    // Neighbours split the gap between them
+    if (i > 0)
+      key.lower = std::max(key.lower, (int32_t(this->keys_[i - 1].raw) + key.raw) / 2 + 1);
+    if (i + 1 < this->keys_.size())
+      key.upper = std::min(key.upper, (int32_t(key.raw) + this->keys_[i + 1].raw) / 2);
+  }
+}
+
+uint8_t AdcLadderDecoder::classify_(uint16_t raw) const {
+  if (this->held_ != NO_KEY) {
+    const Key &held = this->keys_[this->held_];
+    if (raw >= held.lower - this->hysteresis_ && raw <= held.upper + this->hysteresis_)
+      return this->held_;
+  }
+  for (size_t i = 0; i < this->keys_.size(); i++) {
+    if (raw >= this->keys_[i].lower && raw <= this->keys_[i].upper)
+      return static_cast<uint8_t>(i);
+  }
+  return NO_KEY;
+}
+
+uint32_t AdcLadderDecoder::debounce_ms_(uint8_t candidate) const {
+  uint32_t debounce_ms = 0;
+  if (this->held_ != NO_KEY)
+    debounce_ms = this->keys_[this->held_].debounce_ms;
+  if (candidate != NO_KEY)
+    debounce_ms = std::max(debounce_ms, this->keys_[candidate].debounce_ms);
+  return debounce_ms;
+}
+
+bool AdcLadderDecoder::feed(uint16_t raw, uint32_t now_ms, LadderEvent *event) {
+  uint8_t reading = this->classify_(raw);
+
+  if (reading != this->held_) {
+    if (!this->changing_ || reading != this->candidate_) {
+      this->candidate_ = reading;
+      this->candidate_since_ms_ = now_ms;
+      this->changing_ = true;
+      this->last_activity_ms_ = now_ms;
+      this->active_ = true;
+    }
+    if (now_ms - this->candidate_since_ms_ < this->debounce_ms_(reading))
+      return false;
+
+    // Debounced: release whatever was held, a short press counts as a click
+    uint8_t released = this->held_;
+    bool long_pressed = this->long_pressed_;
+    this->held_ = reading;
+    this->held_since_ms_ = this->candidate_since_ms_;
+    this->long_pressed_ = false;
+    this->changing_ = false;
+    this->last_activity_ms_ = now_ms;
+    if (released == NO_KEY || long_pressed)
+      return false;
+    *event = {this->keys_[released].id, LadderEventType::CLICK, now_ms};
+    return true;
+  }
+
+  this->changing_ = false;  // a bounce back to the held state
+  if (this->held_ == NO_KEY)
+    return false;
+
+  if (!this->long_pressed_) {
+    if (now_ms - this->held_since_ms_ < this->long_press_ms_)
+      return false;
+    this->long_pressed_ = true;
+    this->next_repeat_ms_ = now_ms + this->repeat_ms_;
+    *event = {this->keys_[this->held_].id, LadderEventType::LONG_PRESS, now_ms};
+    return true;
+  }
+  if (this->repeat_ms_ == 0 || static_cast<int32_t>(now_ms - this->next_repeat_ms_) < 0)
+    return false;
+  this->next_repeat_ms_ += this->repeat_ms_;
+  *event = {this->keys_[this->held_].id, LadderEventType::REPEAT, now_ms};
+  return true;
+}
+
+uint32_t AdcLadderDecoder::get_sample_interval_ms(uint32_t now_ms) const {
+  bool recent = this->active_ && now_ms - this->last_activity_ms_ < this->active_hold_ms_;
+  if (this->held_ != NO_KEY || this->changing_ || recent)
+    return this->active_interval_ms_;
+  return this->idle_interval_ms_;
+}
+
+}  // namespace esp_adf
+}  // namespace esphome
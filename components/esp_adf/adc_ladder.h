@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace esphome {
+namespace esp_adf {
+
+enum class LadderEventType : uint8_t {
+  CLICK = 0,   // released before the long press time
+  LONG_PRESS,  // held for the long press time, no click follows
+  REPEAT,      // still held, every repeat interval after the long press
+};
+
+const char *ladder_event_type_to_string(LadderEventType type);
+
+struct LadderEvent {
+  uint8_t id;
+  LadderEventType type;
+  uint32_t time_ms;  // of the reading that produced it
+};
+
+/// Decodes a resistor ladder, several keys sharing one ADC input, from raw readings.
+///
+/// Each key owns a window around its nominal reading, bounded by the tolerance and by the midpoint
+/// to its neighbours. A reading must stay in a new window (or outside all of them, for a release)
+/// for the debounce time before the state changes, and the held key keeps its window widened by the
+/// hysteresis so noise at the edge does not release it. Each key has its own debounce time, since
+/// keys on one ladder can be different switches; a change waits for the longer of the key being
+/// left and the key being entered. The caller samples at get_sample_interval_ms(): slowly while
+/// idle, quickly around activity.
+///
+/// Pure logic with no ADC or timer access, so it runs unchanged on the host.
+class AdcLadderDecoder {
+ public:
+  static const uint8_t NO_KEY = 0xFF;
+  static const uint32_t DEFAULT_DEBOUNCE_MS = 30;
+
+  /// `raw` is the reading while only this key is pressed; `debounce_ms` how long a press or release
+  /// of it must hold before it counts.
+  void add_key(uint8_t id, uint16_t raw, uint32_t debounce_ms = DEFAULT_DEBOUNCE_MS);
+  void set_tolerance(uint16_t tolerance) {
+    this->tolerance_ = tolerance;
+    this->update_windows_();
+  }
+  void set_hysteresis(uint16_t hysteresis) { this->hysteresis_ = hysteresis; }
+  void set_long_press_ms(uint32_t long_press_ms) { this->long_press_ms_ = long_press_ms; }
+  /// 0 disables repeats.
+  void set_repeat_ms(uint32_t repeat_ms) { this->repeat_ms_ = repeat_ms; }
+  void set_idle_interval_ms(uint32_t interval_ms) { this->idle_interval_ms_ = interval_ms; }
+  void set_active_interval_ms(uint32_t interval_ms) { this->active_interval_ms_ = interval_ms; }
+  /// How long the fast rate is kept after the last change.
+  void set_active_hold_ms(uint32_t hold_ms) { this->active_hold_ms_ = hold_ms; }
+
+  size_t get_key_count() const { return this->keys_.size(); }
+
+  /// One reading. Returns true and fills `event` when it completes a click, long press or repeat;
+  /// a reading never produces more than one.
+  bool feed(uint16_t raw, uint32_t now_ms, LadderEvent *event);
+
+  /// Id of the debounced key that is down, NO_KEY when none is.
+  uint8_t get_held_id() const { return this->held_ == NO_KEY ? NO_KEY : this->keys_[this->held_].id; }
+  /// Delay until the next reading should be taken.
+  uint32_t get_sample_interval_ms(uint32_t now_ms) const;
+
+ protected:
+  struct Key {
+    uint8_t id;
+    uint16_t raw;
+    uint32_t debounce_ms;
+    int32_t lower;  // window, inclusive
+    int32_t upper;
+  };
+
+  void update_windows_();
+  /// Index into keys_ of the window `raw` falls in, NO_KEY for none.
+  uint8_t classify_(uint16_t raw) const;
+  /// How long a change from held_ to `candidate` must hold, both indices into keys_ or NO_KEY.
+  uint32_t debounce_ms_(uint8_t candidate) const;
+
+  std::vector<Key> keys_;  // sorted by raw
+  uint16_t tolerance_{150};
+  uint16_t hysteresis_{30};
+  uint32_t long_press_ms_{800};
+  uint32_t repeat_ms_{0};
+  uint32_t idle_interval_ms_{100};
+  uint32_t active_interval_ms_{20};  // about one main loop iteration
+  uint32_t active_hold_ms_{1000};
+
+  uint8_t held_{NO_KEY};  // indices into keys_
+  uint8_t candidate_{NO_KEY};
+  bool changing_{false};  // candidate_ differs from held_ and is being debounced
+  uint32_t candidate_since_ms_{0};
+  uint32_t held_since_ms_{0};
+  uint32_t next_repeat_ms_{0};
+  bool long_pressed_{false};
+  uint32_t last_activity_ms_{0};
+  bool active_{false};  // last_activity_ms_ is valid
+};
+
+}  // namespace esp_adf
+}  // namespace esphome
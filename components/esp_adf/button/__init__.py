@@ -1,35 +1,11 @@
-import esphome.codegen as cg
 import esphome.config_validation as cv
-from esphome.const import CONF_ID
 
-from .. import (
-    CONF_ESP_ADF_ID,
-    ESPADF,
-    ESPADFPipeline,
-    esp_adf_ns,
-    final_validate_usable_board,
-)
-
-AUTO_LOAD = ["esp_adf"]
 DEPENDENCIES = ["esp32"]
 
-ESPADFButton = esp_adf_ns.class_(
-    "ESPADFButton", ESPADFPipeline, cg.Component
-)
-
-CONFIG_SCHEMA = cv.All(
-    cv.Schema(
-        {
-            cv.GenerateID(): cv.declare_id(ESPADFButton),
-            cv.GenerateID(CONF_ESP_ADF_ID): cv.use_id(ESPADF),
-        }
-    ).extend(cv.COMPONENT_SCHEMA),
-    cv.only_with_esp_idf,
+# The board buttons are handled by the esp_adf speaker now, which runs their actions on the main
+# loop; this platform only points old configs there
+CONFIG_SCHEMA = cv.invalid(
+    "The esp_adf button platform has been removed. The board buttons are handled by the esp_adf "
+    "speaker: remove this entry, and on boards with a resistor ladder on an ADC pin configure "
+    "'button_ladder' on the speaker instead."
 )
-
-FINAL_VALIDATE_SCHEMA = final_validate_usable_board("button")
-
-async def to_code(config):
-    var = cg.new_Pvariable(config[CONF_ID])
-    await cg.register_component(var, config)
-    await cg.register_parented(var, config[CONF_ESP_ADF_ID])
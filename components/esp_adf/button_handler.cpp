@@ -0,0 +1,98 @@
+#include "button_handler.h"
+
+#ifdef USE_ESP_IDF
+
+#include "esphome/core/log.h"
+
+#include <esp_timer.h>
+#include <input_key_service.h>
+
+namespace esphome {
+namespace esp_adf {
+
+static const char *const TAG = "esp_adf.button";
+
+static_assert((ButtonHandler::QUEUE_SIZE & (ButtonHandler::QUEUE_SIZE - 1)) == 0, "QUEUE_SIZE must be a power of two");
+
+void ButtonHandler::set_debounce_ms(int32_t id, uint32_t debounce_ms) {
+  if (id >= 0 && id < MAX_BUTTONS)
+    this->debounce_ms_[id] = debounce_ms;
+}
+
+esp_err_t ButtonHandler::input_key_service_cb(periph_service_handle_t handle, periph_service_event_t *evt,
+                                              void *ctx) {
+  // Peripheral task: no logging, no I/O, just queue clicks and long presses
+  if (evt->type != INPUT_KEY_SERVICE_ACTION_CLICK && evt->type != INPUT_KEY_SERVICE_ACTION_PRESS)
+    return ESP_OK;
+  int32_t id = static_cast<int32_t>(reinterpret_cast<uintptr_t>(evt->data));
+  if (id < 0 || id >= MAX_BUTTONS)
+    return ESP_OK;
+  static_cast<ButtonHandler *>(ctx)->push(
+      {static_cast<uint8_t>(id), static_cast<uint8_t>(evt->type), esp_timer_get_time()});
+  return ESP_OK;
+}
+
+bool ButtonHandler::push(const ButtonEvent &event) {
+  uint32_t head = this->head_.load(std::memory_order_relaxed);
+  if (head - this->tail_.load(std::memory_order_acquire) >= QUEUE_SIZE) {
+    this->dropped_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  this->events_[head & (QUEUE_SIZE - 1)] = event;
+  this->head_.store(head + 1, std::memory_order_release);
+  return true;
+}
+
+size_t ButtonHandler::process() {
+  uint32_t dropped = this->get_dropped();
+  if (dropped != this->reported_dropped_) {
+    ESP_LOGW(TAG, "%u button presses dropped, the queue was full", (unsigned) (dropped - this->reported_dropped_));
+    this->reported_dropped_ = dropped;
+  }
+
+  size_t handled = 0;
+  uint32_t tail = this->tail_.load(std::memory_order_relaxed);
+  uint32_t head = this->head_.load(std::memory_order_acquire);
+  for (; tail != head; tail++) {
+    ButtonEvent event = this->events_[tail & (QUEUE_SIZE - 1)];
+    this->tail_.store(tail + 1, std::memory_order_release);
+
+    // Debounced against the time of the press, not the time it reached the main loop
+    int64_t &last_press_us = this->last_press_us_[event.id];
+    if (last_press_us != 0 && event.pressed_us - last_press_us <= int64_t(this->debounce_ms_[event.id]) * 1000) {
+      ESP_LOGV(TAG, "Button %u bounced", event.id);
+      continue;
+    }
+    last_press_us = event.pressed_us;
+
+    int64_t queued_us = esp_timer_get_time() - event.pressed_us;
+    if (this->action_)
+      this->action_(event.id);
+    uint32_t latency_us = static_cast<uint32_t>(esp_timer_get_time() - event.pressed_us);
+
+    this->last_latency_us_ = latency_us;
+    if (latency_us > this->max_latency_us_)
+      this->max_latency_us_ = latency_us;
+    this->total_latency_us_ += latency_us;
+    this->handled_++;
+    handled++;
+    ESP_LOGD(TAG, "Button %u %s: %u us queued, %u us to action done", event.id,
+             event.type == INPUT_KEY_SERVICE_ACTION_PRESS ? "long press" : "click", (unsigned) queued_us,
+             (unsigned) latency_us);
+  }
+  return handled;
+}
+
+void ButtonHandler::dump_config(const char *tag) const {
+  ESP_LOGCONFIG(tag, "  Buttons: %u presses handled, %u dropped", (unsigned) this->handled_,
+                (unsigned) this->get_dropped());
+  if (this->handled_ > 0) {
+    ESP_LOGCONFIG(tag, "  Press to action: last %u us, average %u us, max %u us", (unsigned) this->last_latency_us_,
+                  (unsigned) this->get_average_latency_us(), (unsigned) this->max_latency_us_);
+  }
+}
+
+}  // namespace esp_adf
+}  // namespace esphome
+
+#endif  // USE_ESP_IDF
@@ -0,0 +1,79 @@
+#pragma once
+
+#ifdef USE_ESP_IDF
+
+#include <periph_service.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace esphome {
+namespace esp_adf {
+
+/// One key press as reported by the input key service, timestamped when it was queued.
+struct ButtonEvent {
+  uint8_t id;
+  uint8_t type;  // input_key_service_action_id_t
+  int64_t pressed_us;
+};
+
+/// Board keys, taken off the peripheral service task.
+///
+/// The input key service runs its callback on the peripheral task, which also scans the ADC and
+/// GPIO keys; anything slow there delays every later press. The callback only filters the event
+/// type and pushes a ButtonEvent into a single-producer, single-consumer ring. process(), called
+/// from the owning component's loop(), debounces and runs the action, and records how long each
+/// press waited between the callback and the end of its action.
+class ButtonHandler {
+ public:
+  static const size_t QUEUE_SIZE = 16;  // power of two
+  static const uint8_t MAX_BUTTONS = 8;
+  static const uint32_t DEFAULT_DEBOUNCE_MS = 200;
+
+  /// Runs on the main loop with the id of a debounced click or long press.
+  void set_action(std::function<void(int32_t id)> &&action) { this->action_ = std::move(action); }
+  void set_debounce_ms(int32_t id, uint32_t debounce_ms);
+
+  /// periph_service_set_callback() target, `ctx` is the ButtonHandler.
+  static esp_err_t input_key_service_cb(periph_service_handle_t handle, periph_service_event_t *evt, void *ctx);
+
+  /// Producer side, one task only. Returns false and counts a drop when the ring is full.
+  bool push(const ButtonEvent &event);
+
+  /// Main loop only. Handles every queued press and returns how many ran an action.
+  size_t process();
+
+  uint32_t get_dropped() const { return this->dropped_.load(std::memory_order_relaxed); }
+  uint32_t get_last_latency_us() const { return this->last_latency_us_; }
+  uint32_t get_max_latency_us() const { return this->max_latency_us_; }
+  uint32_t get_average_latency_us() const {
+    return this->handled_ == 0 ? 0 : static_cast<uint32_t>(this->total_latency_us_ / this->handled_);
+  }
+
+  void dump_config(const char *tag) const;
+
+ protected:
+  ButtonEvent events_[QUEUE_SIZE];
+  std::atomic<uint32_t> head_{0};  // written by the producer only
+  std::atomic<uint32_t> tail_{0};  // written by the consumer only
+  std::atomic<uint32_t> dropped_{0};
+
+  std::function<void(int32_t id)> action_;
+  uint32_t debounce_ms_[MAX_BUTTONS] = {DEFAULT_DEBOUNCE_MS, DEFAULT_DEBOUNCE_MS, DEFAULT_DEBOUNCE_MS,
+                                       DEFAULT_DEBOUNCE_MS, DEFAULT_DEBOUNCE_MS, DEFAULT_DEBOUNCE_MS,
+                                       DEFAULT_DEBOUNCE_MS, DEFAULT_DEBOUNCE_MS};
+  int64_t last_press_us_[MAX_BUTTONS]{};
+
+  uint32_t handled_{0};
+  uint64_t total_latency_us_{0};
+  uint32_t last_latency_us_{0};
+  uint32_t max_latency_us_{0};
+  uint32_t reported_dropped_{0};
+};
+
+}  // namespace esp_adf
+}  // namespace esphome
+
+#endif  // USE_ESP_IDF
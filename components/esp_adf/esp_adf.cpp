@@ -11,6 +11,8 @@
 
 #include "esphome/core/log.h"
 
+#include "include/memory_utils.h"
+
 namespace esphome {
 namespace esp_adf {
 
@@ -21,6 +23,9 @@ static const char *const TAG = "esp_adf";
 #endif
 
 void ESPADF::setup() {
+  this->set_interval("memory_summary", this->memory_summary_interval_ms_,
+                     []() { MemoryAccounting::get().log_summary(TAG); });
+
 #ifdef USE_ESP_ADF_BOARD
   ESP_LOGI(TAG, "Start codec chip");
   audio_board_handle_t board_handle = audio_board_init();
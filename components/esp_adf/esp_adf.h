@@ -4,6 +4,8 @@
 
 #include "esphome/core/component.h"
 #include "esphome/core/helpers.h"
+#include "esphome/components/audio_utils/event_bus.h"
+#include "esphome/components/audio_utils/resource_arbiter.h"
 
 #include <periph_adc_button.h>
 #include <esp_event.h>
@@ -13,20 +15,6 @@ namespace esp_adf {
 
 static const size_t BUFFER_SIZE = 1024;
 
-enum class TaskEventType : uint8_t {
-  STARTING = 0,
-  STARTED,
-  RUNNING,
-  STOPPING,
-  STOPPED,
-  WARNING = 255,
-};
-
-struct TaskEvent {
-  TaskEventType type;
-  esp_err_t err;
-};
-
 struct CommandEvent {
   bool stop;
 };
@@ -47,12 +35,15 @@ class ESPADF : public Component {
 
   float get_setup_priority() const override;
 
-  void lock() { this->lock_.lock(); }
-  bool try_lock() { return this->lock_.try_lock(); }
-  void unlock() { this->lock_.unlock(); }
+  /// Decides which pipeline owns the codec and I2S bus.
+  audio_utils::ResourceArbiter *get_arbiter() { return &this->arbiter_; }
+
+  /// How often heap use per audio subsystem is logged, SCHEDULER_DONT_RUN for never.
+  void set_memory_summary_interval(uint32_t interval_ms) { this->memory_summary_interval_ms_ = interval_ms; }
 
  protected:
-  Mutex lock_;
+  audio_utils::ResourceArbiter arbiter_{"esp_adf"};
+  uint32_t memory_summary_interval_ms_{SCHEDULER_DONT_RUN};
   static void button_event_handler(void *handler_args, esp_event_base_t base, int32_t id, void *event_data);
   void handle_button_event(int32_t id);
 };
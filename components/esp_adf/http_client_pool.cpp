@@ -0,0 +1,126 @@
+#include "http_client_pool.h"
+
+#if defined(USE_ESP_IDF) && defined(USE_ESP_ADF_PIPELINE_HTTP_STREAM)
+
+#include "esphome/core/hal.h"
+#include "esphome/core/log.h"
+
+#include <esp_timer.h>
+
+#include <cctype>
+#include <iterator>
+
+namespace esphome {
+namespace esp_adf {
+
+static const char *const TAG = "esp_adf.http_pool";
+
+static const size_t MAX_URL_LENGTH = 512;
+
+std::string url_origin(const std::string &url) {
+  size_t scheme_end = url.find("://");
+  if (scheme_end == std::string::npos)
+    return "";
+  size_t authority_start = scheme_end + 3;
+  size_t authority_end = url.find_first_of("/?#", authority_start);
+  if (authority_end == std::string::npos)
+    authority_end = url.size();
+  size_t at = url.rfind('@', authority_end);
+  if (at != std::string::npos && at >= authority_start)
+    authority_start = at + 1;
+
+  std::string origin = url.substr(0, authority_end);
+  origin.erase(scheme_end + 3, authority_start - scheme_end - 3);
+  for (char &c : origin)
+    c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+  // A port after the host, not inside an IPv6 literal
+  size_t colon = origin.rfind(':');
+  size_t bracket = origin.rfind(']');
+  if (colon == scheme_end || (bracket != std::string::npos && colon < bracket))
+    origin += origin.compare(0, scheme_end, "https") == 0 ? ":443" : ":80";
+  return origin;
+}
+
+HttpClientPool &HttpClientPool::get() {
+  static HttpClientPool instance;
+  return instance;
+}
+
+HttpConnection *HttpClientPool::acquire(const std::string &url) {
+  this->expire();
+  std::string origin = url_origin(url);
+
+  HttpConnection *connection = nullptr;
+  for (auto it = this->idle_.rbegin(); it != this->idle_.rend(); ++it) {
+    if ((*it)->origin == origin) {
+      connection = *it;
+      this->idle_.erase(std::next(it).base());
+      break;
+    }
+  }
+  if (connection != nullptr) {
+    this->hits_++;
+    connection->reused = true;
+    ESP_LOGV(TAG, "Reusing the connection to %s, idle for %u ms", origin.c_str(),
+             (unsigned) (millis() - connection->idle_since_ms));
+  } else {
+    this->misses_++;
+    connection = new HttpConnection();
+    connection->origin = origin;
+  }
+
+  connection->reusable = false;
+  connection->server_closes = false;
+  connection->stale = false;
+  connection->status = 0;
+  connection->requested_us = esp_timer_get_time();
+  connection->headers_us = 0;
+  connection->first_byte_us.store(0, std::memory_order_relaxed);
+  return connection;
+}
+
+void HttpClientPool::release(HttpConnection *connection) {
+  if (connection == nullptr)
+    return;
+  if (connection->stale)
+    this->stale_++;
+  if (connection->client == nullptr || !connection->reusable) {
+    this->destroy_(connection);
+    return;
+  }
+
+  // Redirects may have moved it to another server
+  char url[MAX_URL_LENGTH];
+  if (esp_http_client_get_url(connection->client, url, sizeof(url)) == ESP_OK)
+    connection->origin = url_origin(url);
+  connection->idle_since_ms = millis();
+  this->idle_.push_back(connection);
+  while (this->idle_.size() > MAX_IDLE_CONNECTIONS) {
+    this->destroy_(this->idle_.front());
+    this->idle_.erase(this->idle_.begin());
+  }
+}
+
+void HttpClientPool::expire() {
+  const uint32_t now = millis();
+  for (auto it = this->idle_.begin(); it != this->idle_.end();) {
+    if (now - (*it)->idle_since_ms >= IDLE_TIMEOUT_MS) {
+      ESP_LOGV(TAG, "Closing the idle connection to %s", (*it)->origin.c_str());
+      this->destroy_(*it);
+      it = this->idle_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void HttpClientPool::destroy_(HttpConnection *connection) {
+  if (connection->client != nullptr)
+    esp_http_client_cleanup(connection->client);
+  delete connection;
+}
+
+}  // namespace esp_adf
+}  // namespace esphome
+
+#endif  // USE_ESP_IDF && USE_ESP_ADF_PIPELINE_HTTP_STREAM
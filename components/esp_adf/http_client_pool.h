@@ -0,0 +1,76 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+
+#if defined(USE_ESP_IDF) && defined(USE_ESP_ADF_PIPELINE_HTTP_STREAM)
+
+#include <esp_http_client.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace esphome {
+namespace esp_adf {
+
+/// Lower-cased scheme://host:port of a URL, the key connections are pooled under.
+std::string url_origin(const std::string &url);
+
+/// One esp_http_client handle and the connection it holds. The pool owns it while it is idle, the
+/// http source element of a pipeline while the pipeline is built; only one of them touches it at a time.
+struct HttpConnection {
+  esp_http_client_handle_t client{nullptr};  // created by the source on first use
+  std::string origin;                        // what it was acquired for, redirects may leave it elsewhere
+  uint32_t idle_since_ms{0};
+
+  // Written by the source
+  bool reusable{false};       // the last response was read to the end and the server keeps the connection open
+  bool server_closes{false};  // "Connection: close" seen in the last response
+  bool reused{false};         // came out of the pool connected, cleared if that connection had gone stale
+  bool stale{false};          // the kept connection was closed by the server, the fetch opened a new one
+  int status{0};
+
+  // Time to first byte of the current fetch, in microseconds from acquire(); 0 until the first body
+  // byte reached the pipeline. headers_us is written before first_byte_us is published.
+  int64_t requested_us{0};
+  uint32_t headers_us{0};
+  std::atomic<uint32_t> first_byte_us{0};
+};
+
+/// Keeps HTTP connections open between play_url() fetches, so that a TTS reply or announcement from
+/// the same server skips DNS, the TCP handshake and, for HTTPS, the TLS handshake. Idle connections
+/// are keyed by origin and closed after IDLE_TIMEOUT_MS; servers usually drop theirs sooner, which the
+/// source notices on its first request and answers by reconnecting once. Main loop only.
+class HttpClientPool {
+ public:
+  static HttpClientPool &get();
+
+  /// An idle connection to the URL's origin, or a fresh one the source connects on first use.
+  HttpConnection *acquire(const std::string &url);
+  /// Takes a connection back once its pipeline is destroyed. Kept only if the source left it reusable.
+  void release(HttpConnection *connection);
+  /// Closes connections idle for longer than IDLE_TIMEOUT_MS.
+  void expire();
+
+  uint32_t get_hits() const { return this->hits_; }
+  uint32_t get_misses() const { return this->misses_; }
+  uint32_t get_stale() const { return this->stale_; }
+  size_t get_idle_count() const { return this->idle_.size(); }
+
+  static const uint32_t IDLE_TIMEOUT_MS = 60000;
+  static const size_t MAX_IDLE_CONNECTIONS = 2;
+
+ protected:
+  void destroy_(HttpConnection *connection);
+
+  std::vector<HttpConnection *> idle_;  // oldest first
+  uint32_t hits_{0};
+  uint32_t misses_{0};
+  uint32_t stale_{0};
+};
+
+}  // namespace esp_adf
+}  // namespace esphome
+
+#endif  // USE_ESP_IDF && USE_ESP_ADF_PIPELINE_HTTP_STREAM
@@ -0,0 +1,244 @@
+#include "http_source.h"
+
+#if defined(USE_ESP_IDF) && defined(USE_ESP_ADF_PIPELINE_HTTP_STREAM)
+
+#include "esphome/core/log.h"
+
+#include <esp_idf_version.h>
+#include <esp_timer.h>
+#ifdef CONFIG_MBEDTLS_CERTIFICATE_BUNDLE
+#include <esp_crt_bundle.h>
+#endif
+
+#include <cinttypes>
+#include <cstdio>
+#include <strings.h>
+
+namespace esphome {
+namespace esp_adf {
+
+static const char *const TAG = "esp_adf.http_source";
+
+static const int HTTP_READ_SIZE = 2048;    // per read, as http_stream
+static const int HTTP_TIMEOUT_MS = 30000;  // as http_stream
+static const int MAX_REDIRECTS = 5;
+static const int MAX_DRAIN_BYTES = 4096;  // of a redirect body before the connection is given up instead
+
+struct HttpSource {
+  HttpConnection *connection{nullptr};
+  bool opened{false};  // only the first request of a fetch may find its pooled connection stale
+};
+
+static esp_err_t http_event_handler(esp_http_client_event_t *event) {
+  auto *connection = static_cast<HttpConnection *>(event->user_data);
+  if (event->event_id == HTTP_EVENT_ON_HEADER && strcasecmp(event->header_key, "Connection") == 0)
+    connection->server_closes = strncasecmp(event->header_value, "close", 5) == 0;
+  return ESP_OK;
+}
+
+static bool create_client(HttpConnection *connection, const char *uri) {
+  esp_http_client_config_t cfg = {};
+  cfg.url = uri;
+  cfg.event_handler = http_event_handler;
+  cfg.user_data = connection;
+  cfg.timeout_ms = HTTP_TIMEOUT_MS;
+  cfg.buffer_size = HTTP_READ_SIZE;
+#ifdef CONFIG_MBEDTLS_CERTIFICATE_BUNDLE
+  cfg.crt_bundle_attach = esp_crt_bundle_attach;
+#endif
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 1, 0) && defined(CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS)
+  // Reconnecting a handle whose connection the server closed resumes the TLS session
+  cfg.save_client_session = true;
+#endif
+  connection->client = esp_http_client_init(&cfg);
+  return connection->client != nullptr;
+}
+
+/// Sends the GET and reads the response head. False if the connection failed before a response came back.
+static bool send_request(HttpConnection *connection, int64_t byte_pos, int64_t *length) {
+  esp_http_client_handle_t client = connection->client;
+  if (byte_pos > 0) {
+    char range[32];
+    snprintf(range, sizeof(range), "bytes=%" PRId64 "-", byte_pos);
+    esp_http_client_set_header(client, "Range", range);
+  } else {
+    esp_http_client_delete_header(client, "Range");
+  }
+  connection->server_closes = false;
+  if (esp_http_client_open(client, 0) != ESP_OK)
+    return false;
+  *length = esp_http_client_fetch_headers(client);  // 0 for a chunked response
+  return *length >= 0;
+}
+
+/// Reads off a short response body so the connection can carry the next request.
+static void drain_response(esp_http_client_handle_t client) {
+  char buffer[256];
+  int drained = 0;
+  while (drained < MAX_DRAIN_BYTES && !esp_http_client_is_complete_data_received(client)) {
+    int read = esp_http_client_read(client, buffer, sizeof(buffer));
+    if (read <= 0)
+      break;
+    drained += read;
+  }
+  if (!esp_http_client_is_complete_data_received(client))
+    esp_http_client_close(client);
+}
+
+static esp_err_t http_source_open(audio_element_handle_t self) {
+  auto *source = static_cast<HttpSource *>(audio_element_getdata(self));
+  HttpConnection *connection = source->connection;
+  const char *uri = audio_element_get_uri(self);
+  if (connection == nullptr || uri == nullptr) {
+    ESP_LOGE(TAG, "No URL or connection to fetch it over");
+    return ESP_FAIL;
+  }
+
+  if (connection->client == nullptr) {
+    if (!create_client(connection, uri)) {
+      ESP_LOGE(TAG, "Failed to create the HTTP client");
+      return ESP_FAIL;
+    }
+  } else if (esp_http_client_set_url(connection->client, uri) != ESP_OK) {
+    ESP_LOGE(TAG, "Invalid URL %s", uri);
+    return ESP_FAIL;
+  }
+
+  audio_element_info_t info;
+  audio_element_getinfo(self, &info);
+  const bool may_be_stale = connection->reused && !source->opened;
+  source->opened = true;
+
+  int64_t length = -1;
+  int status = 0;
+  for (int redirects = 0;; redirects++) {
+    bool responded = send_request(connection, info.byte_pos, &length);
+    if (!responded && may_be_stale && redirects == 0) {
+      // The server closed the kept connection while it sat in the pool
+      ESP_LOGD(TAG, "Pooled connection was closed by the server, reconnecting");
+      connection->stale = true;
+      esp_http_client_close(connection->client);
+      responded = send_request(connection, info.byte_pos, &length);
+    }
+    status = responded ? esp_http_client_get_status_code(connection->client) : 0;
+    if (status != 301 && status != 302 && status != 303 && status != 307 && status != 308)
+      break;
+    if (redirects == MAX_REDIRECTS) {
+      ESP_LOGE(TAG, "Too many redirects fetching %s", uri);
+      esp_http_client_close(connection->client);
+      return ESP_FAIL;
+    }
+    drain_response(connection->client);
+    esp_http_client_set_redirection(connection->client);
+  }
+
+  connection->status = status;
+  if (status != 200 && status != 206) {
+    if (status == 0) {
+      ESP_LOGE(TAG, "Failed to fetch %s", uri);
+    } else {
+      ESP_LOGE(TAG, "Fetching %s failed with HTTP status %d", uri, status);
+    }
+    esp_http_client_close(connection->client);
+    return ESP_FAIL;
+  }
+  if (connection->headers_us == 0)
+    connection->headers_us = static_cast<uint32_t>(esp_timer_get_time() - connection->requested_us);
+
+  // A resumed stream keeps the length of the whole one
+  if (info.byte_pos <= 0) {
+    info.total_bytes = length > 0 ? length : 0;
+    audio_element_setinfo(self, &info);
+  }
+  return ESP_OK;
+}
+
+static audio_element_err_t http_source_read(audio_element_handle_t self, char *buffer, int len,
+                                            TickType_t ticks_to_wait, void *context) {
+  auto *source = static_cast<HttpSource *>(audio_element_getdata(self));
+  HttpConnection *connection = source->connection;
+  int read = esp_http_client_read(connection->client, buffer, len);
+  if (read < 0) {
+    ESP_LOGE(TAG, "Reading the stream failed");
+    return AEL_IO_FAIL;
+  }
+  if (read == 0)
+    return AEL_IO_DONE;
+
+  if (connection->first_byte_us.load(std::memory_order_relaxed) == 0) {
+    int64_t elapsed = esp_timer_get_time() - connection->requested_us;
+    connection->first_byte_us.store(elapsed > 0 ? static_cast<uint32_t>(elapsed) : 1, std::memory_order_release);
+  }
+  audio_element_update_byte_pos(self, read);
+  return static_cast<audio_element_err_t>(read);
+}
+
+static audio_element_err_t http_source_process(audio_element_handle_t self, char *in_buffer, int in_len) {
+  int read = audio_element_input(self, in_buffer, in_len);
+  if (audio_element_is_stopping(self))
+    return AEL_IO_ABORT;
+  if (read <= 0)
+    return static_cast<audio_element_err_t>(read);
+  return static_cast<audio_element_err_t>(audio_element_output(self, in_buffer, read));
+}
+
+static esp_err_t http_source_close(audio_element_handle_t self) {
+  auto *source = static_cast<HttpSource *>(audio_element_getdata(self));
+  HttpConnection *connection = source->connection;
+  // Pausing closes too, resuming reopens from the byte position with a Range request
+  if (audio_element_get_state(self) != AEL_STATE_PAUSED) {
+    audio_element_report_pos(self);
+    audio_element_set_byte_pos(self, 0);
+  }
+  if (connection != nullptr && connection->client != nullptr) {
+    connection->reusable = (connection->status == 200 || connection->status == 206) &&
+                           !connection->server_closes &&
+                           esp_http_client_is_complete_data_received(connection->client);
+    if (!connection->reusable)
+      esp_http_client_close(connection->client);
+  }
+  return ESP_OK;
+}
+
+static esp_err_t http_source_destroy(audio_element_handle_t self) {
+  delete static_cast<HttpSource *>(audio_element_getdata(self));
+  return ESP_OK;
+}
+
+audio_element_handle_t http_source_init(const HttpSourceConfig &config) {
+  audio_element_cfg_t cfg = DEFAULT_AUDIO_ELEMENT_CONFIG();
+  cfg.open = http_source_open;
+  cfg.read = http_source_read;
+  cfg.process = http_source_process;
+  cfg.close = http_source_close;
+  cfg.destroy = http_source_destroy;
+  cfg.task_stack = config.task_stack;
+  cfg.task_core = config.task_core;
+  cfg.task_prio = config.task_prio;
+  cfg.out_rb_size = config.out_rb_size;
+  cfg.buffer_len = HTTP_READ_SIZE;
+  cfg.stack_in_ext = false;
+  cfg.tag = "http";
+
+  auto *source = new HttpSource();
+  audio_element_handle_t element = audio_element_init(&cfg);
+  if (element == nullptr) {
+    delete source;
+    return nullptr;
+  }
+  audio_element_setdata(element, source);
+  audio_element_info_t info = AUDIO_ELEMENT_INFO_DEFAULT();
+  audio_element_setinfo(element, &info);
+  return element;
+}
+
+void http_source_set_connection(audio_element_handle_t self, HttpConnection *connection) {
+  auto *source = static_cast<HttpSource *>(audio_element_getdata(self));
+  source->connection = connection;
+  source->opened = false;
+}
+
+}  // namespace esp_adf
+}  // namespace esphome
+
+#endif  // USE_ESP_IDF && USE_ESP_ADF_PIPELINE_HTTP_STREAM
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+
+#if defined(USE_ESP_IDF) && defined(USE_ESP_ADF_PIPELINE_HTTP_STREAM)
+
+#include "http_client_pool.h"
+
+#include <audio_element.h>
+
+namespace esphome {
+namespace esp_adf {
+
+/// Task settings of the http source, with the defaults of ADF's http_stream.
+struct HttpSourceConfig {
+  int out_rb_size{20 * 1024};
+  int task_stack{6 * 1024};
+  int task_core{0};
+  int task_prio{4};
+};
+
+/// Pipeline source fetching the element's URI over a pooled HttpConnection, in place of ADF's
+/// http_stream which opens and tears down a connection of its own for every stream. It follows
+/// redirects, resumes with a Range request after a pause, and leaves the connection open for the
+/// pool when the response was read to the end. Playlists (m3u/m3u8) are not followed.
+audio_element_handle_t http_source_init(const HttpSourceConfig &config);
+
+/// Hands the source the connection of the next fetch; set before the pipeline runs. The caller takes
+/// it back to the pool once the pipeline is destroyed.
+void http_source_set_connection(audio_element_handle_t self, HttpConnection *connection);
+
+}  // namespace esp_adf
+}  // namespace esphome
+
+#endif  // USE_ESP_IDF && USE_ESP_ADF_PIPELINE_HTTP_STREAM
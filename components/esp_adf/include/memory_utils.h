@@ -4,14 +4,208 @@
 #include "esp_heap_caps.h"
 #include "esp_log.h"
 
+#if __has_include(<esp_memory_utils.h>)
+#include <esp_memory_utils.h>
+#else
+#include <soc/soc_memory_layout.h>
+#endif
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
 namespace esphome {
 namespace esp_adf {
 
-inline void check_heap_memory(const char *tag) {
-    ESP_LOGI(tag, "Free heap: %d", heap_caps_get_free_size(MALLOC_CAP_8BIT));
-    ESP_LOGI(tag, "Minimum free heap: %d", heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT));
+// Who a block of heap is charged to
+enum class MemoryTag : uint8_t {
+    SPEAKER = 0,
+    MICROPHONE,
+    PIPELINE,  // ESP-ADF pipelines and their stream elements
+    DECODER,
+};
+static const size_t MEMORY_TAG_COUNT = 4;
+
+enum class MemoryRegion : uint8_t {
+    INTERNAL = 0,
+    PSRAM,
+};
+static const size_t MEMORY_REGION_COUNT = 2;
+
+inline const char *memory_tag_to_string(MemoryTag tag) {
+    switch (tag) {
+        case MemoryTag::SPEAKER:
+            return "speaker";
+        case MemoryTag::MICROPHONE:
+            return "microphone";
+        case MemoryTag::PIPELINE:
+            return "pipeline";
+        case MemoryTag::DECODER:
+            return "decoder";
+        default:
+            return "unknown";
+    }
+}
+
+inline uint32_t memory_region_caps(MemoryRegion region) {
+    return region == MemoryRegion::PSRAM ? MALLOC_CAP_SPIRAM : (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+}
+
+inline MemoryRegion memory_region_of(const void *ptr) {
+    return esp_ptr_external_ram(ptr) ? MemoryRegion::PSRAM : MemoryRegion::INTERNAL;
 }
 
+struct HeapStats {
+    size_t free_bytes;
+    size_t minimum_free_bytes;
+    size_t largest_free_block;
+
+    /// Share of the free heap that is not part of the largest block, 0 % to 100 %.
+    float fragmentation() const {
+        return this->free_bytes == 0 ? 0.0f : 100.0f * (1.0f - (float) this->largest_free_block / this->free_bytes);
+    }
+};
+
+inline HeapStats get_heap_stats(MemoryRegion region) {
+    uint32_t caps = memory_region_caps(region);
+    return {heap_caps_get_free_size(caps), heap_caps_get_minimum_free_size(caps), heap_caps_get_largest_free_block(caps)};
+}
+
+/// Current and peak bytes per tag and region. Updated from any task.
+class MemoryAccounting {
+  public:
+    static MemoryAccounting &get() {
+        static MemoryAccounting instance;
+        return instance;
+    }
+
+    void charge(MemoryTag tag, MemoryRegion region, size_t bytes) {
+        Counter &counter = this->counter_(tag, region);
+        size_t current = counter.current.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        size_t peak = counter.peak.load(std::memory_order_relaxed);
+        while (current > peak && !counter.peak.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {
+        }
+    }
+
+    void credit(MemoryTag tag, MemoryRegion region, size_t bytes) {
+        Counter &counter = this->counter_(tag, region);
+        size_t current = counter.current.load(std::memory_order_relaxed);
+        size_t next;
+        do {
+            next = current > bytes ? current - bytes : 0;
+        } while (!counter.current.compare_exchange_weak(current, next, std::memory_order_relaxed));
+    }
+
+    size_t get_current(MemoryTag tag, MemoryRegion region) const {
+        return this->counter_(tag, region).current.load(std::memory_order_relaxed);
+    }
+    size_t get_peak(MemoryTag tag, MemoryRegion region) const {
+        return this->counter_(tag, region).peak.load(std::memory_order_relaxed);
+    }
+    size_t get_current(MemoryTag tag) const {
+        return this->get_current(tag, MemoryRegion::INTERNAL) + this->get_current(tag, MemoryRegion::PSRAM);
+    }
+
+    void log_summary(const char *log_tag) const {
+        for (size_t r = 0; r < MEMORY_REGION_COUNT; r++) {
+            MemoryRegion region = static_cast<MemoryRegion>(r);
+            HeapStats stats = get_heap_stats(region);
+            if (region == MemoryRegion::PSRAM && stats.free_bytes == 0)
+                continue;  // no PSRAM fitted
+            ESP_LOGI(log_tag, "%s heap: %u free, %u minimum, largest block %u (%.0f%% fragmented)",
+                     region == MemoryRegion::PSRAM ? "PSRAM" : "Internal", (unsigned) stats.free_bytes,
+                     (unsigned) stats.minimum_free_bytes, (unsigned) stats.largest_free_block, stats.fragmentation());
+            for (size_t t = 0; t < MEMORY_TAG_COUNT; t++) {
+                MemoryTag tag = static_cast<MemoryTag>(t);
+                ESP_LOGI(log_tag, "  %-10s %7u bytes, peak %7u", memory_tag_to_string(tag),
+                         (unsigned) this->get_current(tag, region), (unsigned) this->get_peak(tag, region));
+            }
+        }
+    }
+
+  protected:
+    struct Counter {
+        std::atomic<size_t> current{0};
+        std::atomic<size_t> peak{0};
+    };
+
+    Counter &counter_(MemoryTag tag, MemoryRegion region) {
+        return this->counters_[static_cast<size_t>(tag)][static_cast<size_t>(region)];
+    }
+    const Counter &counter_(MemoryTag tag, MemoryRegion region) const {
+        return this->counters_[static_cast<size_t>(tag)][static_cast<size_t>(region)];
+    }
+
+    Counter counters_[MEMORY_TAG_COUNT][MEMORY_REGION_COUNT];
+};
+
+/// Like ExternalRAMAllocator with ALLOW_FAILURE: prefers PSRAM, falls back to internal RAM and
+/// returns nullptr when neither has room. Every block is charged to the tag until deallocated.
+template<class T> class TrackedAllocator {
+  public:
+    using value_type = T;
+
+    explicit TrackedAllocator(MemoryTag tag) : tag_(tag) {}
+
+    T *allocate(size_t n) {
+        size_t bytes = n * sizeof(T);
+        void *ptr = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM);
+        if (ptr == nullptr)
+            ptr = heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (ptr != nullptr)
+            MemoryAccounting::get().charge(this->tag_, memory_region_of(ptr), bytes);
+        return static_cast<T *>(ptr);
+    }
+
+    void deallocate(T *ptr, size_t n) {
+        if (ptr == nullptr)
+            return;
+        MemoryAccounting::get().credit(this->tag_, memory_region_of(ptr), n * sizeof(T));
+        heap_caps_free(ptr);
+    }
+
+  protected:
+    MemoryTag tag_;
+};
+
+/// Charges heap allocated by code we cannot hand an allocator to, such as ESP-ADF elements and
+/// decoders: whatever the free heap drops by between begin() and end() is charged to the tag, and
+/// release() gives it all back once the objects are destroyed. Other tasks allocating in between are
+/// counted as well, so the numbers are an estimate.
+class MemoryCharge {
+  public:
+    explicit MemoryCharge(MemoryTag tag) : tag_(tag) {}
+
+    void begin() {
+        for (size_t r = 0; r < MEMORY_REGION_COUNT; r++)
+            this->start_free_[r] = heap_caps_get_free_size(memory_region_caps(static_cast<MemoryRegion>(r)));
+    }
+
+    void end() {
+        for (size_t r = 0; r < MEMORY_REGION_COUNT; r++) {
+            MemoryRegion region = static_cast<MemoryRegion>(r);
+            size_t free_bytes = heap_caps_get_free_size(memory_region_caps(region));
+            if (free_bytes < this->start_free_[r]) {
+                size_t bytes = this->start_free_[r] - free_bytes;
+                this->charged_[r] += bytes;
+                MemoryAccounting::get().charge(this->tag_, region, bytes);
+            }
+        }
+    }
+
+    void release() {
+        for (size_t r = 0; r < MEMORY_REGION_COUNT; r++) {
+            MemoryAccounting::get().credit(this->tag_, static_cast<MemoryRegion>(r), this->charged_[r]);
+            this->charged_[r] = 0;
+        }
+    }
+
+  protected:
+    MemoryTag tag_;
+    size_t start_free_[MEMORY_REGION_COUNT]{};
+    size_t charged_[MEMORY_REGION_COUNT]{};
+};
+
 }  // namespace esp_adf
 }  // namespace esphome
 
@@ -0,0 +1,118 @@
+#ifndef SESSION_ARENA_H
+#define SESSION_ARENA_H
+
+#include "memory_utils.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace esp_adf {
+
+/// One block of internal RAM, allocated once at setup, that every session of a component carves
+/// its task stack, task control block and scratch buffers from. reset() hands all of it back at the
+/// end of a session in one step, so starting and stopping never touches the heap.
+///
+/// The session's task returns from its function instead of being deleted by another task: it then
+/// deletes itself, and FreeRTOS keeps using its control block until the idle task has cleaned it up,
+/// which on a dual-core chip can come well after. is_task_deleted() tells when that is done, and
+/// only then may reset() hand the memory out again.
+class SessionArena {
+  public:
+    static const size_t ALIGNMENT = 8;
+
+    static constexpr size_t align(size_t bytes) { return (bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1); }
+    /// Arena space needed by create_task() for a task with this stack.
+    static constexpr size_t task_size(uint32_t stack_size) { return align(sizeof(StaticTask_t)) + align(stack_size); }
+
+    explicit SessionArena(MemoryTag tag) : tag_(tag) {}
+
+    /// Allocate the backing block. Returns false if internal RAM has no block this large.
+    bool init(size_t capacity) {
+        capacity = align(capacity);
+        this->base_ = static_cast<uint8_t *>(heap_caps_malloc(capacity, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+        if (this->base_ == nullptr)
+            return false;
+        MemoryAccounting::get().charge(this->tag_, MemoryRegion::INTERNAL, capacity);
+        this->capacity_ = capacity;
+        this->used_ = 0;
+        return true;
+    }
+
+    /// Returns nullptr once the arena is exhausted; the memory is valid until reset().
+    template<typename T> T *allocate(size_t count) {
+        size_t bytes = align(count * sizeof(T));
+        if (this->base_ == nullptr || bytes > this->capacity_ - this->used_)
+            return nullptr;
+        T *ptr = reinterpret_cast<T *>(this->base_ + this->used_);
+        this->used_ += bytes;
+        if (this->used_ > this->high_water_)
+            this->high_water_ = this->used_;
+        return ptr;
+    }
+
+    /// xTaskCreate() with the stack and control block taken from the arena. `function` returns when
+    /// the session is over and the task deletes itself. One task per session.
+    bool create_task(TaskFunction_t function, const char *name, uint32_t stack_size, void *params,
+                     UBaseType_t priority, TaskHandle_t *handle) {
+        if (!this->is_task_deleted())
+            return false;
+        StaticTask_t *tcb = this->allocate<StaticTask_t>(1);
+        StackType_t *stack = this->allocate<StackType_t>(stack_size / sizeof(StackType_t));
+        if (tcb == nullptr || stack == nullptr)
+            return false;
+        this->task_function_ = function;
+        this->task_params_ = params;
+        this->task_deleted_.store(false, std::memory_order_relaxed);
+        *handle = xTaskCreateStatic(SessionArena::task_entry_, name, stack_size, this, priority, stack, tcb);
+        if (*handle == nullptr) {
+            this->task_deleted_.store(true, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    /// True once FreeRTOS no longer touches the stack and control block of the last task created,
+    /// or if there was none.
+    bool is_task_deleted() const { return this->task_deleted_.load(std::memory_order_acquire); }
+
+    /// End of session: everything allocated so far is free again. Only once is_task_deleted().
+    void reset() { this->used_ = 0; }
+
+    size_t get_capacity() const { return this->capacity_; }
+    size_t get_used() const { return this->used_; }
+    size_t get_high_water() const { return this->high_water_; }
+
+  protected:
+    // Thread local storage slot of the deletion callback, the last one applications may use
+    static const BaseType_t TLS_INDEX = CONFIG_FREERTOS_THREAD_LOCAL_STORAGE_POINTERS - 1;
+
+    static void task_entry_(void *params) {
+        auto *arena = static_cast<SessionArena *>(params);
+        // Runs when FreeRTOS cleans the task up, after the last access to its control block
+        vTaskSetThreadLocalStoragePointerAndDelCallback(nullptr, TLS_INDEX, arena, SessionArena::task_deleted_cb_);
+        arena->task_function_(arena->task_params_);
+        vTaskDelete(nullptr);
+    }
+    static void task_deleted_cb_(int, void *arena) {
+        static_cast<SessionArena *>(arena)->task_deleted_.store(true, std::memory_order_release);
+    }
+
+    MemoryTag tag_;
+    uint8_t *base_{nullptr};
+    size_t capacity_{0};
+    size_t used_{0};
+    size_t high_water_{0};
+    TaskFunction_t task_function_{nullptr};
+    void *task_params_{nullptr};
+    std::atomic<bool> task_deleted_{true};
+};
+
+}  // namespace esp_adf
+}  // namespace esphome
+
+#endif  // SESSION_ARENA_H
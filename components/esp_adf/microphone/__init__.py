@@ -1,17 +1,34 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
 from esphome.components import microphone
-from esphome.const import CONF_ID
+from esphome.const import CONF_ID, CONF_TYPE
+from esphome.components.audio_utils import (
+    BIQUAD_SCHEMA,
+    CONF_PRIORITY,
+    BiquadFilter,
+    audio_utils_ns,
+    biquad_coefficients_expression,
+    design_biquad,
+    resource_priority_schema,
+)
 
 from .. import (
     CONF_ESP_ADF_ID,
+    CONF_FILTERS,
+    CONF_PIPELINE,
+    CONF_SINK,
+    CONF_SOURCE,
+    CONF_SOURCE_CHANNELS,
+    CONF_SOURCE_SAMPLE_RATE,
     ESPADF,
     ESPADFPipeline,
     esp_adf_ns,
     final_validate_usable_board,
+    pipeline_schema,
+    pipeline_to_code,
 )
 
-AUTO_LOAD = ["esp_adf"]
+AUTO_LOAD = ["esp_adf", "audio_utils"]
 CONFLICTS_WITH = ["i2s_audio"]
 DEPENDENCIES = ["esp32"]
 
@@ -19,14 +36,60 @@ ESPADFMicrophone = esp_adf_ns.class_(
     "ESPADFMicrophone", ESPADFPipeline, microphone.Microphone, cg.Component
 )
 
+NoiseSuppressor = audio_utils_ns.class_("NoiseSuppressor")
+
+CONF_NOISE_SUPPRESSION = "noise_suppression"
+CONF_STRENGTH = "strength"
+CONF_EQUALIZER = "equalizer"
+
+SAMPLE_RATE = 16000
+
+NOISE_SUPPRESSION_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.declare_id(NoiseSuppressor),
+        cv.Optional(CONF_STRENGTH, default="70%"): cv.percentage,
+    }
+)
+
+# The codec delivers both channels, read() hands out mono
+PIPELINE_SCHEMA = pipeline_schema(
+    {"i2s": (SAMPLE_RATE, 2)}, ["raw"], (SAMPLE_RATE, 1)
+)
+DEFAULT_PIPELINE = {
+    CONF_SOURCE: "i2s",
+    CONF_FILTERS: [
+        {
+            CONF_TYPE: "resample",
+            CONF_SOURCE_SAMPLE_RATE: SAMPLE_RATE,
+            CONF_SOURCE_CHANNELS: 2,
+        }
+    ],
+    CONF_SINK: "raw",
+}
+
+
+def _validate_equalizer(config):
+    design_biquad(config, SAMPLE_RATE)
+    return config
+
 
 CONFIG_SCHEMA = cv.All(
     microphone.MICROPHONE_SCHEMA.extend(
         {
             cv.GenerateID(): cv.declare_id(ESPADFMicrophone),
             cv.GenerateID(CONF_ESP_ADF_ID): cv.use_id(ESPADF),
+            cv.Optional(CONF_PIPELINE, default=DEFAULT_PIPELINE): PIPELINE_SCHEMA,
+            cv.Optional(CONF_NOISE_SUPPRESSION): NOISE_SUPPRESSION_SCHEMA,
+            cv.Optional(CONF_EQUALIZER): cv.All(
+                BIQUAD_SCHEMA.extend(
+                    {cv.GenerateID(): cv.declare_id(BiquadFilter)}
+                ),
+                _validate_equalizer,
+            ),
         }
-    ).extend(cv.COMPONENT_SCHEMA),
+    )
+    .extend(resource_priority_schema("voice_capture"))
+    .extend(cv.COMPONENT_SCHEMA),
     cv.only_with_esp_idf,
     cv.require_esphome_version(2023, 12, 7),
 )
@@ -40,3 +103,16 @@ async def to_code(config):
     await cg.register_parented(var, config[CONF_ESP_ADF_ID])
 
     await microphone.register_microphone(var, config)
+    cg.add(var.set_priority(config[CONF_PRIORITY]))
+    await pipeline_to_code(var.get_pipeline(), config[CONF_PIPELINE])
+
+    if ns_config := config.get(CONF_NOISE_SUPPRESSION):
+        ns = cg.new_Pvariable(ns_config[CONF_ID])
+        cg.add(ns.set_strength(ns_config[CONF_STRENGTH]))
+        cg.add(var.set_noise_suppressor(ns))
+
+    if eq_config := config.get(CONF_EQUALIZER):
+        eq = cg.new_Pvariable(eq_config[CONF_ID])
+        coefficients = design_biquad(eq_config, SAMPLE_RATE)
+        cg.add(eq.set_coefficients(biquad_coefficients_expression(coefficients)))
+        cg.add(var.set_equalizer(eq))
@@ -3,6 +3,7 @@
 #ifdef USE_ESP_IDF
 
 #include <driver/i2s.h>
+#include <esp_timer.h>
 
 #include "esphome/core/hal.h"
 #include "esphome/core/log.h"
@@ -11,10 +12,10 @@
 #include <audio_element.h>
 #include <audio_hal.h>
 #include <audio_pipeline.h>
-#include <filter_resample.h>
 #include <i2s_stream.h>
 #include <raw_stream.h>
 #include <recorder_sr.h>
+#include <ringbuf.h>
 
 #include <board.h>
 
@@ -23,30 +24,60 @@ namespace esp_adf {
 
 static const char *const TAG = "esp_adf.microphone";
 
+using audio_utils::AudioEvent;
+using audio_utils::AudioEventType;
+using audio_utils::EventBus;
+
+static const uint32_t SAMPLE_RATE = 16000;
+using StreamFormat = audio_utils::S16Mono;  // what the pipeline delivers and read() returns
+static const uint32_t READ_TASK_STACK_SIZE = 8192;
+
 void ESPADFMicrophone::setup() {
   ESP_LOGCONFIG(TAG, "Setting up ESP ADF Microphone...");
-  this->ring_buffer_ = RingBuffer::create(8000 * sizeof(int16_t));
-  if (this->ring_buffer_ == nullptr) {
-    ESP_LOGE(TAG, "Could not allocate ring buffer");
+  if (!this->session_arena_.init(SessionArena::task_size(READ_TASK_STACK_SIZE) + SessionArena::align(BUFFER_SIZE))) {
+    ESP_LOGE(TAG, "Could not allocate session arena");
     this->mark_failed();
     return;
   }
+  this->samples_.reserve(BUFFER_SIZE);
 
-  this->read_event_queue_ = xQueueCreate(20, sizeof(TaskEvent));
-  if (this->read_event_queue_ == nullptr) {
-    ESP_LOGW(TAG, "Could not allocate event queue");
+  MemoryCharge ring_buffer_memory(MemoryTag::MICROPHONE);
+  ring_buffer_memory.begin();
+  this->ring_buffer_ = RingBuffer::create(8000 * StreamFormat::FRAME_SIZE);
+  ring_buffer_memory.end();
+  if (this->ring_buffer_ == nullptr) {
+    ESP_LOGE(TAG, "Could not allocate ring buffer");
     this->mark_failed();
     return;
   }
+
+  this->events_.set_handler([this](const audio_utils::AudioEvent &event) { this->handle_event_(event); });
   this->read_command_queue_ = xQueueCreate(20, sizeof(CommandEvent));
   if (this->read_command_queue_ == nullptr) {
     ESP_LOGW(TAG, "Could not allocate command queue");
     this->mark_failed();
     return;
   }
+  if (this->noise_suppressor_ != nullptr && !this->noise_suppressor_->init(SAMPLE_RATE)) {
+    ESP_LOGW(TAG, "Could not set up noise suppressor, capturing without it");
+    this->noise_suppressor_ = nullptr;
+  }
+  this->resource_client_.set_grant_callback([this]() {
+    if (this->state_ == microphone::STATE_STARTING)
+      this->start_();
+  });
+  this->resource_client_.set_preempt_callback([this]() {
+    ESP_LOGD(TAG, "Stopping for a higher priority user of the codec");
+    this->stop();
+  });
   ESP_LOGCONFIG(TAG, "Successfully set up ESP ADF Microphone");
 }
 
+void ESPADFMicrophone::dump_config() {
+  ESP_LOGCONFIG(TAG, "ESP ADF Microphone:");
+  this->pipeline_.dump_config(TAG);
+}
+
 void ESPADFMicrophone::start() {
   if (this->is_failed())
     return;
@@ -57,41 +88,48 @@ void ESPADFMicrophone::start() {
   this->state_ = microphone::STATE_STARTING;
 }
 void ESPADFMicrophone::start_() {
-  if (!this->parent_->try_lock()) {
+  if (this->read_task_handle_ != nullptr) {
     return;
   }
+  if (!this->session_arena_.is_task_deleted()) {
+    return;  // The last session's task is still being cleaned up, loop() tries again
+  }
+  if (!this->parent_->get_arbiter()->request(&this->resource_client_)) {
+    return;  // Queued, the arbiter calls back once the codec is free
+  }
 
-  xTaskCreate(ESPADFMicrophone::read_task, "read_task", 8192, (void *) this, 0, &this->read_task_handle_);
+  this->read_position_ = 0;
+  this->sample_clock_.reset(SAMPLE_RATE, esp_timer_get_time());
+  this->session_arena_.reset();
+  this->read_buffer_ = this->session_arena_.allocate<int16_t>(BUFFER_SIZE / sizeof(int16_t));
+  if (!this->session_arena_.create_task(ESPADFMicrophone::read_task, "read_task", READ_TASK_STACK_SIZE, (void *) this,
+                                        0, &this->read_task_handle_)) {
+    ESP_LOGE(TAG, "Failed to start the read task");
+    this->read_task_handle_ = nullptr;
+    this->parent_->get_arbiter()->release(&this->resource_client_);
+    this->state_ = microphone::STATE_STOPPED;
+  }
 }
 
 void ESPADFMicrophone::read_task(void *params) {
   ESPADFMicrophone *this_mic = (ESPADFMicrophone *) params;
-  TaskEvent event;
 
-  ExternalRAMAllocator<int16_t> allocator(ExternalRAMAllocator<int16_t>::ALLOW_FAILURE);
-  int16_t *buffer = allocator.allocate(BUFFER_SIZE / sizeof(int16_t));
+  int16_t *buffer = this_mic->read_buffer_;
   if (buffer == nullptr) {
-    event.type = TaskEventType::WARNING;
-    event.err = ESP_ERR_NO_MEM;
-    xQueueSend(this_mic->read_event_queue_, &event, portMAX_DELAY);
-
-    event.type = TaskEventType::STOPPED;
-    event.err = ESP_OK;
-    xQueueSend(this_mic->read_event_queue_, &event, portMAX_DELAY);
-
-    while (true) {
-      delay(10);
-    }
+    this_mic->events_.publish(AudioEvent::warning(ESP_ERR_NO_MEM), EventBus::WAIT_FOREVER);
+    this_mic->events_.publish(AudioEvent::of(AudioEventType::STOPPED), EventBus::WAIT_FOREVER);
     return;
   }
 
-  event.type = TaskEventType::STARTING;
-  xQueueSend(this_mic->read_event_queue_, &event, portMAX_DELAY);
+  this_mic->events_.publish(AudioEvent::of(AudioEventType::STARTING), EventBus::WAIT_FOREVER);
 
-  audio_pipeline_cfg_t pipeline_cfg = {
-      .rb_size = 8 * 1024,
-  };
-  audio_pipeline_handle_t pipeline = audio_pipeline_init(&pipeline_cfg);
+  if (this_mic->equalizer_ != nullptr) {
+    this_mic->equalizer_->reset();
+  }
+  if (this_mic->noise_suppressor_ != nullptr) {
+    this_mic->noise_suppressor_->reset();
+    this_mic->noise_suppressor_->reset_stats();
+  }
 
   i2s_driver_config_t i2s_config = {
       .mode = (i2s_mode_t) (I2S_MODE_MASTER | I2S_MODE_RX),
@@ -113,8 +151,14 @@ void ESPADFMicrophone::read_task(void *params) {
       .type = AUDIO_STREAM_READER,
       .i2s_config = i2s_config,
       .i2s_port = static_cast<i2s_port_t>(CODEC_ADC_I2S_PORT),
+#ifdef USE_ES8311_HARDWARE_ALC
+      // The codec already levels the signal, a second software ALC would fight it
+      .use_alc = false,
+      .volume = 0,
+#else
       .use_alc = true,
       .volume = 6,
+#endif
       .out_rb_size = I2S_STREAM_RINGBUFFER_SIZE,
       .task_stack = I2S_STREAM_TASK_STACK,
       .task_core = I2S_STREAM_TASK_CORE,
@@ -125,49 +169,26 @@ void ESPADFMicrophone::read_task(void *params) {
       .need_expand = false,
       .expand_src_bits = I2S_BITS_PER_SAMPLE_16BIT,
   };
-  audio_element_handle_t i2s_stream_reader = i2s_stream_init(&i2s_cfg);
-
-  rsp_filter_cfg_t rsp_cfg = {
-      .src_rate = 16000,
-      .src_ch = 2,
-      .dest_rate = 16000,
-      .dest_bits = 16,
-      .dest_ch = 1,
-      .src_bits = I2S_BITS_PER_SAMPLE_16BIT,
-      .mode = RESAMPLE_DECODE_MODE,
-      .max_indata_bytes = RSP_FILTER_BUFFER_BYTE,
-      .out_len_bytes = RSP_FILTER_BUFFER_BYTE,
-      .type = ESP_RESAMPLE_TYPE_AUTO,
-      .complexity = 2,
-      .down_ch_idx = 0,
-      .prefer_flag = ESP_RSP_PREFER_TYPE_SPEED,
-      .out_rb_size = RSP_FILTER_RINGBUFFER_SIZE,
-      .task_stack = RSP_FILTER_TASK_STACK,
-      .task_core = RSP_FILTER_TASK_CORE,
-      .task_prio = RSP_FILTER_TASK_PRIO,
-      .stack_in_ext = true,
+  PipelineContext context = {
+      .ring_buffer_size = 8 * 1024,
+      .element_buffer_size = 0,
+      .i2s_config = i2s_cfg,
   };
-  audio_element_handle_t filter = rsp_filter_init(&rsp_cfg);
 
-  raw_stream_cfg_t raw_cfg = {
-      .type = AUDIO_STREAM_READER,
-      .out_rb_size = 8 * 1024,
-  };
-  audio_element_handle_t raw_read = raw_stream_init(&raw_cfg);
-
-  audio_pipeline_register(pipeline, i2s_stream_reader, "i2s");
-  audio_pipeline_register(pipeline, filter, "filter");
-  audio_pipeline_register(pipeline, raw_read, "raw");
-
-  const char *link_tag[3] = {"i2s", "filter", "raw"};
-  audio_pipeline_link(pipeline, &link_tag[0], 3);
-
-  audio_pipeline_run(pipeline);
+  PipelineBuilder &pipeline = this_mic->pipeline_;
+  if (!pipeline.build(context) || !pipeline.run()) {
+    pipeline.destroy();
+    this_mic->events_.publish(AudioEvent::warning(ESP_FAIL), EventBus::WAIT_FOREVER);
+    this_mic->events_.publish(AudioEvent::of(AudioEventType::STOPPED), EventBus::WAIT_FOREVER);
+    return;
+  }
+  audio_element_handle_t raw_read = pipeline.get_sink();
 
-  event.type = TaskEventType::STARTED;
-  xQueueSend(this_mic->read_event_queue_, &event, portMAX_DELAY);
+  this_mic->events_.publish(AudioEvent::of(AudioEventType::STARTED), EventBus::WAIT_FOREVER);
 
   CommandEvent command_event;
+  uint64_t capture_position = 0;
+  ringbuf_handle_t raw_input_rb = audio_element_get_input_ringbuf(raw_read);
 
   while (true) {
     if (xQueueReceive(this_mic->read_command_queue_, &command_event, 0) == pdTRUE) {
@@ -183,50 +204,45 @@ void ESPADFMicrophone::read_task(void *params) {
       // No data in buffers to read.
       continue;
     } else if (bytes_read < 0) {
-      event.type = TaskEventType::WARNING;
-      event.err = bytes_read;
-      xQueueSend(this_mic->read_event_queue_, &event, 0);
+      this_mic->events_.publish(AudioEvent::warning(bytes_read));
       continue;
     }
 
-    size_t written = this_mic->ring_buffer_->write((void *) buffer, bytes_read);
-
-    event.type = TaskEventType::RUNNING;
-    event.err = written;
-    xQueueSend(this_mic->read_event_queue_, &event, 0);
-  }
+    if (this_mic->equalizer_ != nullptr) {
+      this_mic->equalizer_->process(buffer, bytes_read / StreamFormat::FRAME_SIZE);
+    }
+    if (this_mic->noise_suppressor_ != nullptr) {
+      this_mic->noise_suppressor_->process(buffer, bytes_read / StreamFormat::FRAME_SIZE);
+    }
 
-  allocator.deallocate(buffer, BUFFER_SIZE / sizeof(int16_t));
+    size_t written = this_mic->ring_buffer_->write((void *) buffer, bytes_read);
 
-  audio_pipeline_stop(pipeline);
-  audio_pipeline_wait_for_stop(pipeline);
-  audio_pipeline_terminate(pipeline);
+    // The i2s_stream element owns the driver, so the anchor is derived from the frames that came out
+    // of the pipeline, backdated by what is still queued in front of the raw reader.
+    capture_position += written / StreamFormat::FRAME_SIZE;
+    int64_t pending_us = (int64_t) rb_bytes_filled(raw_input_rb) * 1000000 / (SAMPLE_RATE * StreamFormat::FRAME_SIZE);
+    this_mic->sample_clock_.update(capture_position, esp_timer_get_time() - pending_us);
 
-  event.type = TaskEventType::STOPPING;
-  xQueueSend(this_mic->read_event_queue_, &event, portMAX_DELAY);
+    this_mic->events_.publish(AudioEvent::running(written));
+  }
 
-  audio_pipeline_unregister(pipeline, i2s_stream_reader);
-  audio_pipeline_unregister(pipeline, filter);
-  // audio_pipeline_unregister(pipeline, algo_stream);
-  audio_pipeline_unregister(pipeline, raw_read);
+  pipeline.stop();
 
-  audio_pipeline_deinit(pipeline);
-  audio_element_deinit(i2s_stream_reader);
-  audio_element_deinit(filter);
-  // audio_element_deinit(algo_stream);
-  audio_element_deinit(raw_read);
+  this_mic->events_.publish(AudioEvent::of(AudioEventType::STOPPING), EventBus::WAIT_FOREVER);
 
-  event.type = TaskEventType::STOPPED;
-  xQueueSend(this_mic->read_event_queue_, &event, portMAX_DELAY);
+  pipeline.destroy();
 
-  while (true) {
-    delay(10);
-  }
+  this_mic->events_.publish(AudioEvent::of(AudioEventType::STOPPED), EventBus::WAIT_FOREVER);
 }
 
 void ESPADFMicrophone::stop() {
   if (this->state_ == microphone::STATE_STOPPED || this->state_ == microphone::STATE_STOPPING || this->is_failed())
     return;
+  if (this->state_ == microphone::STATE_STARTING && this->read_task_handle_ == nullptr) {
+    this->parent_->get_arbiter()->release(&this->resource_client_);
+    this->state_ = microphone::STATE_STOPPED;
+    return;
+  }
   this->state_ = microphone::STATE_STOPPING;
   CommandEvent command_event;
   command_event.stop = true;
@@ -234,6 +250,14 @@ void ESPADFMicrophone::stop() {
   ESP_LOGD(TAG, "Stopping microphone");
 }
 
+size_t ESPADFMicrophone::read(int16_t *buf, size_t len, int64_t *capture_time_us) {
+  uint64_t position = this->read_position_;
+  size_t bytes = this->read(buf, len);
+  if (capture_time_us != nullptr)
+    *capture_time_us = this->sample_clock_.time_of(position);
+  return bytes;
+}
+
 size_t ESPADFMicrophone::read(int16_t *buf, size_t len) {
   if (this->is_failed()) {
     ESP_LOGE(TAG, "Microphone is failed, cannot read");
@@ -250,50 +274,57 @@ size_t ESPADFMicrophone::read(int16_t *buf, size_t len) {
     return 0;
   }
   this->status_clear_warning();
+  this->read_position_ += bytes_read / StreamFormat::FRAME_SIZE;
 
   return bytes_read;
 }
 
 void ESPADFMicrophone::read_() {
-  std::vector<int16_t> samples;
-  samples.resize(BUFFER_SIZE);
-  this->read(samples.data(), samples.size());
+  // Reuses the same allocation every time, the loop runs this hundreds of times a second
+  this->samples_.resize(BUFFER_SIZE / sizeof(int16_t));
+  size_t bytes_read = this->read(this->samples_.data(), BUFFER_SIZE, &this->last_capture_time_us_);
+  this->samples_.resize(bytes_read / sizeof(int16_t));
 
-  this->data_callbacks_.call(samples);
+  this->data_callbacks_.call(this->samples_);
 }
 
-void ESPADFMicrophone::watch_() {
-  TaskEvent event;
-  if (xQueueReceive(this->read_event_queue_, &event, 0) == pdTRUE) {
-    switch (event.type) {
-      case TaskEventType::STARTING:
-      case TaskEventType::STOPPING:
-        break;
-      case TaskEventType::STARTED:
-        ESP_LOGD(TAG, "Microphone started");
-        this->state_ = microphone::STATE_RUNNING;
-        break;
-      case TaskEventType::RUNNING:
-        this->status_clear_warning();
-        // ESP_LOGD(TAG, "Putting %d bytes into ring buffer", event.err);
-        break;
-      case TaskEventType::STOPPED:
-        this->parent_->unlock();
-        this->state_ = microphone::STATE_STOPPED;
-        vTaskDelete(this->read_task_handle_);
-        this->read_task_handle_ = nullptr;
-        ESP_LOGD(TAG, "Microphone stopped");
-        break;
-      case TaskEventType::WARNING:
-        ESP_LOGW(TAG, "Error writing to pipeline: %s", esp_err_to_name(event.err));
-        this->status_set_warning();
-        break;
-    }
+void ESPADFMicrophone::handle_event_(const audio_utils::AudioEvent &event) {
+  switch (event.type) {
+    case AudioEventType::STARTING:
+    case AudioEventType::STOPPING:
+      break;
+    case AudioEventType::STARTED:
+      ESP_LOGD(TAG, "Microphone started");
+      this->state_ = microphone::STATE_RUNNING;
+      break;
+    case AudioEventType::RUNNING:
+      this->status_clear_warning();
+      break;
+    case AudioEventType::STOPPED:
+      this->state_ = microphone::STATE_STOPPED;
+      // The task deletes itself on return; start_() reuses its memory once that is done
+      this->read_task_handle_ = nullptr;
+      this->read_buffer_ = nullptr;
+      this->parent_->get_arbiter()->release(&this->resource_client_);
+      ESP_LOGD(TAG, "Microphone stopped");
+      if (this->noise_suppressor_ != nullptr && this->noise_suppressor_->get_frames_processed() > 0) {
+        ESP_LOGD(TAG, "Noise suppression: %u frames, avg %.1f us, max %u us per frame (%.1f%% CPU)",
+                 this->noise_suppressor_->get_frames_processed(), this->noise_suppressor_->get_average_frame_us(),
+                 this->noise_suppressor_->get_max_frame_us(), this->noise_suppressor_->get_cpu_load());
+      }
+      break;
+    case AudioEventType::WARNING:
+      ESP_LOGW(TAG, "Error writing to pipeline: %s", esp_err_to_name(event.error));
+      this->status_set_warning();
+      break;
   }
 }
 
 void ESPADFMicrophone::loop() {
-  this->watch_();
+  audio_utils::EventBus::get().dispatch();
+  if (uint32_t dropped = this->events_.take_new_drops())
+    ESP_LOGW(TAG, "%u read task events dropped, the event bus was full", (unsigned) dropped);
+
   switch (this->state_) {
     case microphone::STATE_STOPPED:
     case microphone::STATE_STOPPING:
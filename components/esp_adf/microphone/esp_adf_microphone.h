@@ -3,12 +3,23 @@
 #ifdef USE_ESP_IDF
 
 #include "../esp_adf.h"
+#include "../pipeline_builder.h"
+#include "../include/memory_utils.h"
+#include "../include/session_arena.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
 
 #include "esphome/core/component.h"
 #include "esphome/core/ring_buffer.h"
 #include <algorithm_stream.h>
 #include "esp_vad.h"
 
+#include "esphome/components/audio_utils/biquad.h"
+#include "esphome/components/audio_utils/noise_suppressor.h"
+#include "esphome/components/audio_utils/pcm_format.h"
+#include "esphome/components/audio_utils/resource_arbiter.h"
+#include "esphome/components/audio_utils/sample_clock.h"
 #include "esphome/components/microphone/microphone.h"
 
 namespace esphome {
@@ -17,24 +28,50 @@ namespace esp_adf {
 class ESPADFMicrophone : public ESPADFPipeline, public microphone::Microphone, public Component {
  public:
   void setup() override;
+  void dump_config() override;
   void start() override;
   void stop() override;
 
   void loop() override;
 
   size_t read(int16_t *buf, size_t len) override;
+  /// Like read(), additionally reporting when the first returned sample was captured.
+  size_t read(int16_t *buf, size_t len, int64_t *capture_time_us);
+
+  /// Capture time of the first sample of the block most recently handed to the data callbacks.
+  int64_t get_last_capture_time_us() const { return this->last_capture_time_us_; }
+  const audio_utils::SampleClock &get_sample_clock() const { return this->sample_clock_; }
+
+  void set_noise_suppressor(audio_utils::NoiseSuppressor *noise_suppressor) {
+    this->noise_suppressor_ = noise_suppressor;
+  }
+  /// Software pre-filter, for boards whose codec has no equalizer of its own.
+  void set_equalizer(audio_utils::BiquadFilter *equalizer) { this->equalizer_ = equalizer; }
+  void set_priority(audio_utils::ResourcePriority priority) { this->resource_client_.set_priority(priority); }
+  PipelineBuilder &get_pipeline() { return this->pipeline_; }
 
  protected:
   void start_();
   void read_();
-  void watch_();
+  void handle_event_(const audio_utils::AudioEvent &event);
 
   static void read_task(void *params);
 
+  audio_utils::ResourceClient resource_client_{"esp_adf_microphone", audio_utils::ResourcePriority::VOICE_CAPTURE};
   std::unique_ptr<RingBuffer> ring_buffer_;
+  audio_utils::NoiseSuppressor *noise_suppressor_{nullptr};
+  audio_utils::BiquadFilter *equalizer_{nullptr};
+
+  audio_utils::SampleClock sample_clock_;
+  uint64_t read_position_{0};  // frames handed out by read(), main loop only
+  int64_t last_capture_time_us_{0};
 
+  PipelineBuilder pipeline_;  // built and destroyed by the read task
   TaskHandle_t read_task_handle_{nullptr};
-  QueueHandle_t read_event_queue_;
+  SessionArena session_arena_{MemoryTag::MICROPHONE};  // read task stack and control block, read buffer
+  int16_t *read_buffer_{nullptr};                      // in the arena, valid while the read task runs
+  std::vector<int16_t> samples_;                       // handed to the data callbacks, reused
+  audio_utils::EventSubscriber events_{"esp_adf_microphone"};
   QueueHandle_t read_command_queue_;
 };
 
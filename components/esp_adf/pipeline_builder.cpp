@@ -0,0 +1,227 @@
+#include "pipeline_builder.h"
+
+#ifdef USE_ESP_IDF
+
+#include "esphome/core/log.h"
+
+#include <algorithm>
+#include <string>
+
+#ifdef USE_ESP_ADF_PIPELINE_RAW_STREAM
+#include <raw_stream.h>
+#endif
+#ifdef USE_ESP_ADF_PIPELINE_HTTP_STREAM
+#include "http_source.h"
+#endif
+#ifdef USE_ESP_ADF_PIPELINE_MP3_DECODER
+#include <mp3_decoder.h>
+#endif
+#ifdef USE_ESP_ADF_PIPELINE_RESAMPLE_FILTER
+#include <filter_resample.h>
+#endif
+
+namespace esphome {
+namespace esp_adf {
+
+static const char *const TAG = "esp_adf.pipeline";
+
+// Network jitter needs more room than PCM, whatever the latency profile
+static const int HTTP_STREAM_MIN_BUFFER_SIZE = 12 * 1024;
+
+const char *pipeline_element_type_to_string(PipelineElementType type) {
+  switch (type) {
+    case PipelineElementType::RAW_STREAM:
+      return "raw";
+    case PipelineElementType::I2S_STREAM:
+      return "i2s";
+    case PipelineElementType::HTTP_STREAM:
+      return "http";
+    case PipelineElementType::MP3_DECODER:
+      return "mp3";
+    case PipelineElementType::RESAMPLE_FILTER:
+      return "resample";
+    default:
+      return "unknown";
+  }
+}
+
+template<typename T> static void apply_task_settings(T *cfg, const PipelineElementConfig &config, int buffer_size) {
+  if (buffer_size > 0)
+    cfg->out_rb_size = buffer_size;
+  if (config.task_core >= 0)
+    cfg->task_core = config.task_core;
+  if (config.task_priority >= 0)
+    cfg->task_prio = config.task_priority;
+}
+
+audio_element_handle_t PipelineBuilder::create_element_(const PipelineElementConfig &config, bool is_source,
+                                                        bool is_sink, const PipelineContext &context) {
+  int buffer_size = config.buffer_size > 0 ? config.buffer_size : context.element_buffer_size;
+  switch (config.type) {
+#ifdef USE_ESP_ADF_PIPELINE_RAW_STREAM
+    case PipelineElementType::RAW_STREAM: {
+      raw_stream_cfg_t cfg = RAW_STREAM_CFG_DEFAULT();
+      cfg.type = is_source ? AUDIO_STREAM_WRITER : AUDIO_STREAM_READER;
+      if (buffer_size > 0)
+        cfg.out_rb_size = buffer_size;
+      return raw_stream_init(&cfg);
+    }
+#endif
+#ifdef USE_ESP_ADF_PIPELINE_I2S_STREAM
+    case PipelineElementType::I2S_STREAM: {
+      i2s_stream_cfg_t cfg = context.i2s_config;
+      cfg.type = is_source ? AUDIO_STREAM_READER : AUDIO_STREAM_WRITER;
+      apply_task_settings(&cfg, config, is_sink ? 0 : buffer_size);
+      return i2s_stream_init(&cfg);
+    }
+#endif
+#ifdef USE_ESP_ADF_PIPELINE_HTTP_STREAM
+    case PipelineElementType::HTTP_STREAM: {
+      // Fetches over a pooled connection, the owner hands it over with http_source_set_connection()
+      HttpSourceConfig cfg;
+      if (config.buffer_size <= 0)
+        buffer_size = std::max(HTTP_STREAM_MIN_BUFFER_SIZE, context.ring_buffer_size);
+      apply_task_settings(&cfg, config, buffer_size);
+      return http_source_init(cfg);
+    }
+#endif
+#ifdef USE_ESP_ADF_PIPELINE_MP3_DECODER
+    case PipelineElementType::MP3_DECODER: {
+      mp3_decoder_cfg_t cfg = DEFAULT_MP3_DECODER_CONFIG();
+      apply_task_settings(&cfg, config, buffer_size);
+      return mp3_decoder_init(&cfg);
+    }
+#endif
+#ifdef USE_ESP_ADF_PIPELINE_RESAMPLE_FILTER
+    case PipelineElementType::RESAMPLE_FILTER: {
+      rsp_filter_cfg_t cfg = DEFAULT_RESAMPLE_FILTER_CONFIG();
+      cfg.src_rate = config.source_rate;
+      cfg.src_ch = config.source_channels;
+      cfg.dest_rate = config.dest_rate;
+      cfg.dest_ch = config.dest_channels;
+      cfg.complexity = config.complexity;
+      apply_task_settings(&cfg, config, buffer_size);
+      return rsp_filter_init(&cfg);
+    }
+#endif
+    default:
+      ESP_LOGE(TAG, "Element type %s is not compiled in", pipeline_element_type_to_string(config.type));
+      return nullptr;
+  }
+}
+
+bool PipelineBuilder::build(const PipelineContext &context) {
+  if (this->pipeline_ != nullptr)
+    this->destroy();
+  if (this->elements_.size() < 2) {
+    ESP_LOGE(TAG, "A pipeline needs a source and a sink");
+    return false;
+  }
+
+  this->pipeline_memory_.begin();
+  audio_pipeline_cfg_t pipeline_cfg = {
+      .rb_size = this->ring_buffer_size_ > 0 ? this->ring_buffer_size_ : context.ring_buffer_size,
+  };
+  this->pipeline_ = audio_pipeline_init(&pipeline_cfg);
+  this->pipeline_memory_.end();
+  if (this->pipeline_ == nullptr) {
+    ESP_LOGE(TAG, "Failed to initialize the pipeline");
+    return false;
+  }
+
+  std::vector<std::string> tags(this->elements_.size());
+  std::vector<const char *> link_tags(this->elements_.size());
+  for (size_t i = 0; i < this->elements_.size(); i++) {
+    const PipelineElementConfig &config = this->elements_[i];
+    MemoryCharge &charge =
+        config.type == PipelineElementType::MP3_DECODER ? this->decoder_memory_ : this->pipeline_memory_;
+    charge.begin();
+    audio_element_handle_t element =
+        this->create_element_(config, i == 0, i == this->elements_.size() - 1, context);
+    charge.end();
+    if (element == nullptr) {
+      ESP_LOGE(TAG, "Failed to initialize the %s element", pipeline_element_type_to_string(config.type));
+      this->destroy();
+      return false;
+    }
+    this->handles_.push_back(element);
+
+    // Registration copies the tag, linking looks elements up by it
+    tags[i] = std::string(pipeline_element_type_to_string(config.type)) + "_" + std::to_string(i);
+    link_tags[i] = tags[i].c_str();
+    if (audio_pipeline_register(this->pipeline_, element, link_tags[i]) != ESP_OK) {
+      ESP_LOGE(TAG, "Failed to register %s", link_tags[i]);
+      this->destroy();
+      return false;
+    }
+  }
+
+  if (audio_pipeline_link(this->pipeline_, link_tags.data(), link_tags.size()) != ESP_OK) {
+    ESP_LOGE(TAG, "Failed to link the pipeline elements");
+    this->destroy();
+    return false;
+  }
+  return true;
+}
+
+bool PipelineBuilder::run() {
+  if (this->pipeline_ == nullptr)
+    return false;
+  this->running_ = audio_pipeline_run(this->pipeline_) == ESP_OK;
+  return this->running_;
+}
+
+void PipelineBuilder::stop() {
+  if (this->pipeline_ == nullptr || !this->running_)
+    return;
+  audio_pipeline_stop(this->pipeline_);
+  audio_pipeline_wait_for_stop(this->pipeline_);
+  audio_pipeline_terminate(this->pipeline_);
+  this->running_ = false;
+}
+
+void PipelineBuilder::destroy() {
+  if (this->pipeline_ != nullptr) {
+    this->stop();
+    for (auto *element : this->handles_)
+      audio_pipeline_unregister(this->pipeline_, element);
+    audio_pipeline_deinit(this->pipeline_);
+    this->pipeline_ = nullptr;
+  }
+  for (auto *element : this->handles_)
+    audio_element_deinit(element);
+  this->handles_.clear();
+  this->pipeline_memory_.release();
+  this->decoder_memory_.release();
+}
+
+audio_element_handle_t PipelineBuilder::get_element(PipelineElementType type) const {
+  for (size_t i = 0; i < this->handles_.size(); i++) {
+    if (this->elements_[i].type == type)
+      return this->handles_[i];
+  }
+  return nullptr;
+}
+
+const PipelineElementConfig *PipelineBuilder::get_element_config(PipelineElementType type) const {
+  for (const auto &config : this->elements_) {
+    if (config.type == type)
+      return &config;
+  }
+  return nullptr;
+}
+
+void PipelineBuilder::dump_config(const char *tag, const char *name) const {
+  std::string topology;
+  for (const auto &config : this->elements_) {
+    if (!topology.empty())
+      topology += " -> ";
+    topology += pipeline_element_type_to_string(config.type);
+  }
+  ESP_LOGCONFIG(tag, "  %s: %s", name, topology.c_str());
+}
+
+}  // namespace esp_adf
+}  // namespace esphome
+
+#endif  // USE_ESP_IDF
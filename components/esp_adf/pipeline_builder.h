@@ -0,0 +1,94 @@
+#pragma once
+
+#ifdef USE_ESP_IDF
+
+#include "esphome/core/defines.h"
+
+#include "include/memory_utils.h"
+
+#include <audio_element.h>
+#include <audio_pipeline.h>
+#include <i2s_stream.h>
+
+#include <vector>
+
+namespace esphome {
+namespace esp_adf {
+
+/// Element kinds a pipeline can be built from. Whether a raw or I2S stream reads or writes follows from
+/// its position: as the source it feeds the pipeline, as the sink it drains it.
+enum class PipelineElementType : uint8_t {
+  RAW_STREAM = 0,
+  I2S_STREAM,
+  HTTP_STREAM,
+  MP3_DECODER,
+  RESAMPLE_FILTER,
+};
+
+const char *pipeline_element_type_to_string(PipelineElementType type);
+
+/// One element of a `pipeline:` option, emitted by codegen. Zero and -1 keep the defaults.
+struct PipelineElementConfig {
+  PipelineElementType type;
+  int buffer_size;    // output ring buffer in bytes
+  int task_core;      // -1 for the element's default core
+  int task_priority;  // -1 for the element's default priority
+  // Resample filter only
+  int source_rate;
+  int source_channels;
+  int dest_rate;
+  int dest_channels;
+  int complexity;
+};
+
+/// Settings the owning component decides per session rather than in YAML.
+struct PipelineContext {
+  int ring_buffer_size;         // between linked elements, unless the YAML sets one
+  int element_buffer_size;      // output ring buffer of elements without a buffer_size, 0 for the ADF default
+  i2s_stream_cfg_t i2s_config;  // for the I2S source or sink, type and task settings are filled in per element
+};
+
+/// Builds the ESP-ADF pipeline described by a `pipeline:` option and tears it down again. Factories for
+/// element types that no configured pipeline uses are compiled out.
+class PipelineBuilder {
+ public:
+  void add_element(const PipelineElementConfig &config) { this->elements_.push_back(config); }
+  void set_ring_buffer_size(int ring_buffer_size) { this->ring_buffer_size_ = ring_buffer_size; }
+
+  /// Creates, registers and links every element. On failure everything created so far is destroyed.
+  bool build(const PipelineContext &context);
+  bool run();
+  /// Stops the element tasks, the elements stay registered until destroy().
+  void stop();
+  /// Stops if needed, then unregisters and frees the pipeline and its elements.
+  void destroy();
+
+  bool is_built() const { return this->pipeline_ != nullptr; }
+  audio_pipeline_handle_t get_pipeline() const { return this->pipeline_; }
+  audio_element_handle_t get_source() const { return this->handles_.empty() ? nullptr : this->handles_.front(); }
+  audio_element_handle_t get_sink() const { return this->handles_.empty() ? nullptr : this->handles_.back(); }
+  /// First element of this type, nullptr when the pipeline has none or is not built.
+  audio_element_handle_t get_element(PipelineElementType type) const;
+  /// Settings of the first element of this type, nullptr when the pipeline has none.
+  const PipelineElementConfig *get_element_config(PipelineElementType type) const;
+
+  void dump_config(const char *tag, const char *name = "Pipeline") const;
+
+ protected:
+  audio_element_handle_t create_element_(const PipelineElementConfig &config, bool is_source, bool is_sink,
+                                         const PipelineContext &context);
+
+  std::vector<PipelineElementConfig> elements_;
+  std::vector<audio_element_handle_t> handles_;  // parallel to elements_ while built
+  int ring_buffer_size_{0};
+  audio_pipeline_handle_t pipeline_{nullptr};
+  bool running_{false};
+
+  MemoryCharge pipeline_memory_{MemoryTag::PIPELINE};
+  MemoryCharge decoder_memory_{MemoryTag::DECODER};
+};
+
+}  // namespace esp_adf
+}  // namespace esphome
+
+#endif  // USE_ESP_IDF
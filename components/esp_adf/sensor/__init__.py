@@ -0,0 +1,88 @@
+import esphome.codegen as cg
+import esphome.config_validation as cv
+from esphome.components import sensor
+from esphome.const import (
+    CONF_ID,
+    ENTITY_CATEGORY_DIAGNOSTIC,
+    STATE_CLASS_MEASUREMENT,
+    UNIT_PERCENT,
+)
+
+from .. import esp_adf_ns
+
+AUTO_LOAD = ["esp_adf"]
+DEPENDENCIES = ["esp32"]
+
+ESPADFMemorySensor = esp_adf_ns.class_("ESPADFMemorySensor", cg.PollingComponent)
+MemoryRegion = esp_adf_ns.enum("MemoryRegion", is_class=True)
+MemoryTag = esp_adf_ns.enum("MemoryTag", is_class=True)
+
+UNIT_BYTES = "B"
+ICON_MEMORY = "mdi:memory"
+
+REGIONS = {
+    "internal": MemoryRegion.INTERNAL,
+    "psram": MemoryRegion.PSRAM,
+}
+TAGS = {
+    "speaker": MemoryTag.SPEAKER,
+    "microphone": MemoryTag.MICROPHONE,
+    "pipeline": MemoryTag.PIPELINE,
+    "decoder": MemoryTag.DECODER,
+}
+
+_bytes_schema = sensor.sensor_schema(
+    unit_of_measurement=UNIT_BYTES,
+    icon=ICON_MEMORY,
+    accuracy_decimals=0,
+    state_class=STATE_CLASS_MEASUREMENT,
+    entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+)
+_percent_schema = sensor.sensor_schema(
+    unit_of_measurement=UNIT_PERCENT,
+    icon=ICON_MEMORY,
+    accuracy_decimals=1,
+    state_class=STATE_CLASS_MEASUREMENT,
+    entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+)
+
+# e.g. internal_free, psram_largest_free_block, speaker_memory, decoder_memory_peak
+REGION_SENSORS = {
+    "free": ("set_free_sensor", _bytes_schema),
+    "largest_free_block": ("set_largest_free_block_sensor", _bytes_schema),
+    "fragmentation": ("set_fragmentation_sensor", _percent_schema),
+}
+TAG_SENSORS = {
+    "memory": "set_current_sensor",
+    "memory_peak": "set_peak_sensor",
+}
+
+_schema = {cv.GenerateID(): cv.declare_id(ESPADFMemorySensor)}
+for _region in REGIONS:
+    for _kind, (_, _kind_schema) in REGION_SENSORS.items():
+        _schema[cv.Optional(f"{_region}_{_kind}")] = _kind_schema
+for _tag in TAGS:
+    for _kind in TAG_SENSORS:
+        _schema[cv.Optional(f"{_tag}_{_kind}")] = _bytes_schema
+
+CONFIG_SCHEMA = cv.All(
+    cv.Schema(_schema).extend(cv.polling_component_schema("60s")),
+    cv.only_with_esp_idf,
+)
+
+
+async def to_code(config):
+    var = cg.new_Pvariable(config[CONF_ID])
+    await cg.register_component(var, config)
+
+    for region, region_enum in REGIONS.items():
+        for kind, (setter, _) in REGION_SENSORS.items():
+            if sensor_config := config.get(f"{region}_{kind}"):
+                sens = await sensor.new_sensor(sensor_config)
+                cg.add(getattr(var, setter)(region_enum, sens))
+
+    for tag, tag_enum in TAGS.items():
+        for kind, setter in TAG_SENSORS.items():
+            if sensor_config := config.get(f"{tag}_{kind}"):
+                sens = await sensor.new_sensor(sensor_config)
+                cg.add(getattr(var, setter)(tag_enum, sens))
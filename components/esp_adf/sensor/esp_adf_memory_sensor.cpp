@@ -0,0 +1,55 @@
+#include "esp_adf_memory_sensor.h"
+
+#ifdef USE_ESP_IDF
+
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace esp_adf {
+
+static const char *const TAG = "esp_adf.memory";
+
+void ESPADFMemorySensor::update() {
+  for (size_t r = 0; r < MEMORY_REGION_COUNT; r++) {
+    if (this->free_sensors_[r] == nullptr && this->largest_free_block_sensors_[r] == nullptr &&
+        this->fragmentation_sensors_[r] == nullptr)
+      continue;
+    HeapStats stats = get_heap_stats(static_cast<MemoryRegion>(r));
+    if (this->free_sensors_[r] != nullptr)
+      this->free_sensors_[r]->publish_state(stats.free_bytes);
+    if (this->largest_free_block_sensors_[r] != nullptr)
+      this->largest_free_block_sensors_[r]->publish_state(stats.largest_free_block);
+    if (this->fragmentation_sensors_[r] != nullptr)
+      this->fragmentation_sensors_[r]->publish_state(stats.fragmentation());
+  }
+
+  const MemoryAccounting &accounting = MemoryAccounting::get();
+  for (size_t t = 0; t < MEMORY_TAG_COUNT; t++) {
+    MemoryTag tag = static_cast<MemoryTag>(t);
+    if (this->current_sensors_[t] != nullptr)
+      this->current_sensors_[t]->publish_state(accounting.get_current(tag));
+    if (this->peak_sensors_[t] != nullptr) {
+      this->peak_sensors_[t]->publish_state(accounting.get_peak(tag, MemoryRegion::INTERNAL) +
+                                            accounting.get_peak(tag, MemoryRegion::PSRAM));
+    }
+  }
+}
+
+void ESPADFMemorySensor::dump_config() {
+  ESP_LOGCONFIG(TAG, "ESP ADF Memory Sensor:");
+  LOG_UPDATE_INTERVAL(this);
+  for (size_t r = 0; r < MEMORY_REGION_COUNT; r++) {
+    LOG_SENSOR("  ", "Free", this->free_sensors_[r]);
+    LOG_SENSOR("  ", "Largest Free Block", this->largest_free_block_sensors_[r]);
+    LOG_SENSOR("  ", "Fragmentation", this->fragmentation_sensors_[r]);
+  }
+  for (size_t t = 0; t < MEMORY_TAG_COUNT; t++) {
+    LOG_SENSOR("  ", "Current", this->current_sensors_[t]);
+    LOG_SENSOR("  ", "Peak", this->peak_sensors_[t]);
+  }
+}
+
+}  // namespace esp_adf
+}  // namespace esphome
+
+#endif  // USE_ESP_IDF
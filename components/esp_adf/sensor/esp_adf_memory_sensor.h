@@ -0,0 +1,46 @@
+#pragma once
+
+#ifdef USE_ESP_IDF
+
+#include "../include/memory_utils.h"
+
+#include "esphome/components/sensor/sensor.h"
+#include "esphome/core/component.h"
+
+namespace esphome {
+namespace esp_adf {
+
+/// Publishes the heap state and the bytes charged to each audio subsystem.
+class ESPADFMemorySensor : public PollingComponent {
+ public:
+  void update() override;
+  void dump_config() override;
+
+  void set_free_sensor(MemoryRegion region, sensor::Sensor *sensor) {
+    this->free_sensors_[static_cast<size_t>(region)] = sensor;
+  }
+  void set_largest_free_block_sensor(MemoryRegion region, sensor::Sensor *sensor) {
+    this->largest_free_block_sensors_[static_cast<size_t>(region)] = sensor;
+  }
+  void set_fragmentation_sensor(MemoryRegion region, sensor::Sensor *sensor) {
+    this->fragmentation_sensors_[static_cast<size_t>(region)] = sensor;
+  }
+  void set_current_sensor(MemoryTag tag, sensor::Sensor *sensor) {
+    this->current_sensors_[static_cast<size_t>(tag)] = sensor;
+  }
+  void set_peak_sensor(MemoryTag tag, sensor::Sensor *sensor) {
+    this->peak_sensors_[static_cast<size_t>(tag)] = sensor;
+  }
+
+ protected:
+  sensor::Sensor *free_sensors_[MEMORY_REGION_COUNT]{};
+  sensor::Sensor *largest_free_block_sensors_[MEMORY_REGION_COUNT]{};
+  sensor::Sensor *fragmentation_sensors_[MEMORY_REGION_COUNT]{};
+  sensor::Sensor *current_sensors_[MEMORY_TAG_COUNT]{};  // internal RAM and PSRAM together
+  sensor::Sensor *peak_sensors_[MEMORY_TAG_COUNT]{};
+};
+
+}  // namespace esp_adf
+}  // namespace esphome
+
+#endif  // USE_ESP_IDF
@@ -1,17 +1,38 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
-from esphome.components import speaker
-from esphome.const import CONF_ID
+from esphome.components import esp32, speaker
+from esphome.components.adc import ESP32_VARIANT_ADC1_PIN_TO_CHANNEL, validate_adc_pin
+from esphome.const import CONF_ID, CONF_KEY, CONF_NUMBER, CONF_TYPE
+from esphome.components.audio_utils import (
+    CONF_AUTO_TUNE,
+    CONF_LATENCY_PROFILE,
+    CONF_PLAYBACK_CLOCK,
+    CONF_PRIORITY,
+    DUCKING_SCHEMA,
+    LATENCY_SCHEMA,
+    PLAYBACK_CLOCK_SCHEMA,
+    ducking_to_code,
+    resource_priority_schema,
+)
 
 from .. import (
+    CONF_DECODER,
     CONF_ESP_ADF_ID,
+    CONF_FILTERS,
+    CONF_PIPELINE,
+    CONF_SINK,
+    CONF_SOURCE,
+    CONF_SOURCE_CHANNELS,
+    CONF_SOURCE_SAMPLE_RATE,
     ESPADF,
     ESPADFPipeline,
     esp_adf_ns,
     final_validate_usable_board,
+    pipeline_schema,
+    pipeline_to_code,
 )
 
-AUTO_LOAD = ["esp_adf"]
+AUTO_LOAD = ["esp_adf", "audio_utils"]
 CONFLICTS_WITH = ["i2s_audio"]
 DEPENDENCIES = ["esp32"]
 
@@ -19,14 +40,132 @@ ESPADFSpeaker = esp_adf_ns.class_(
     "ESPADFSpeaker", ESPADFPipeline, speaker.Speaker, cg.Component
 )
 
+CONF_URL_PIPELINE = "url_pipeline"
+CONF_BUTTON_LADDER = "button_ladder"
+CONF_ADC_PIN = "adc_pin"
+CONF_KEYS = "keys"
+CONF_RAW = "raw"
+CONF_TOLERANCE = "tolerance"
+CONF_HYSTERESIS = "hysteresis"
+CONF_DEBOUNCE = "debounce"
+CONF_LONG_PRESS = "long_press"
+CONF_REPEAT = "repeat"
+CONF_IDLE_INTERVAL = "idle_interval"
+CONF_ACTIVE_INTERVAL = "active_interval"
+
+# Ids the speaker's button actions are keyed by, as the ADF input key service reports them
+BUTTON_KEYS = {
+    "rec": 1,
+    "set": 2,
+    "play": 3,
+    "mode": 4,
+    "volume_down": 5,
+    "volume_up": 6,
+}
+
+# The I2S writer runs at 16 kHz mono, play() takes the same
+OUTPUT_FORMAT = (16000, 1)
+
+PIPELINE_SCHEMA = pipeline_schema({"raw": OUTPUT_FORMAT}, ["i2s"], OUTPUT_FORMAT)
+URL_PIPELINE_SCHEMA = pipeline_schema({"http": None}, ["i2s"], OUTPUT_FORMAT)
+
+DEFAULT_PIPELINE = {CONF_SOURCE: "raw", CONF_SINK: "i2s"}
+DEFAULT_URL_PIPELINE = {
+    CONF_SOURCE: "http",
+    CONF_DECODER: "mp3",
+    CONF_FILTERS: [
+        {
+            CONF_TYPE: "resample",
+            CONF_SOURCE_SAMPLE_RATE: 44100,
+            CONF_SOURCE_CHANNELS: 2,
+        }
+    ],
+    CONF_SINK: "i2s",
+}
+
+
+def validate_adc1_pin(value):
+    value = validate_adc_pin(value)
+    # The ladder is read through the ADC1 driver; ADC2 is shared with Wi-Fi
+    variant = esp32.get_esp32_variant()
+    if value[CONF_NUMBER] not in ESP32_VARIANT_ADC1_PIN_TO_CHANNEL.get(variant, {}):
+        raise cv.Invalid(
+            f"GPIO{value[CONF_NUMBER]} is not an ADC1 pin on {variant}, "
+            "the button ladder needs one"
+        )
+    return value
+
+
+BUTTON_LADDER_SCHEMA = cv.Schema(
+    {
+        cv.Required(CONF_ADC_PIN): validate_adc1_pin,
+        cv.Required(CONF_KEYS): cv.All(
+            cv.ensure_list(
+                cv.Schema(
+                    {
+                        cv.Required(CONF_KEY): cv.enum(BUTTON_KEYS, lower=True),
+                        # 12 bit reading with only this key pressed
+                        cv.Required(CONF_RAW): cv.int_range(min=0, max=4095),
+                        # Defaults to the ladder's debounce
+                        cv.Optional(
+                            CONF_DEBOUNCE
+                        ): cv.positive_time_period_milliseconds,
+                    }
+                )
+            ),
+            cv.Length(min=1),
+        ),
+        cv.Optional(CONF_TOLERANCE, default=150): cv.int_range(min=1, max=2048),
+        cv.Optional(CONF_HYSTERESIS, default=30): cv.int_range(min=0, max=512),
+        cv.Optional(
+            CONF_DEBOUNCE, default="30ms"
+        ): cv.positive_time_period_milliseconds,
+        cv.Optional(
+            CONF_LONG_PRESS, default="800ms"
+        ): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_REPEAT, default="0ms"): cv.positive_time_period_milliseconds,
+        cv.Optional(
+            CONF_IDLE_INTERVAL, default="100ms"
+        ): cv.positive_time_period_milliseconds,
+        cv.Optional(
+            CONF_ACTIVE_INTERVAL, default="20ms"
+        ): cv.positive_time_period_milliseconds,
+    }
+)
+
+
+def validate_url_playback_clock(config):
+    # play_url() streams keep to the playback clock by trimming the resample filter
+    filters = config[CONF_URL_PIPELINE][CONF_FILTERS]
+    if CONF_PLAYBACK_CLOCK in config and not any(
+        element[CONF_TYPE] == "resample" for element in filters
+    ):
+        raise cv.Invalid(
+            f"{CONF_PLAYBACK_CLOCK} corrects drift through the resample filter of "
+            f"{CONF_URL_PIPELINE}, add one",
+            path=[CONF_URL_PIPELINE, CONF_FILTERS],
+        )
+    return config
+
 
 CONFIG_SCHEMA = cv.All(
     cv.Schema(
         {
             cv.GenerateID(): cv.declare_id(ESPADFSpeaker),
             cv.GenerateID(CONF_ESP_ADF_ID): cv.use_id(ESPADF),
+            cv.Optional(CONF_PIPELINE, default=DEFAULT_PIPELINE): PIPELINE_SCHEMA,
+            cv.Optional(
+                CONF_URL_PIPELINE, default=DEFAULT_URL_PIPELINE
+            ): URL_PIPELINE_SCHEMA,
+            cv.Optional(CONF_BUTTON_LADDER): BUTTON_LADDER_SCHEMA,
         }
-    ).extend(cv.COMPONENT_SCHEMA),
+    )
+    .extend(LATENCY_SCHEMA)
+    .extend(DUCKING_SCHEMA)
+    .extend(PLAYBACK_CLOCK_SCHEMA)
+    .extend(resource_priority_schema("media"))
+    .extend(cv.COMPONENT_SCHEMA),
+    validate_url_playback_clock,
     cv.only_with_esp_idf,
 )
 
@@ -39,3 +178,33 @@ async def to_code(config):
     await cg.register_parented(var, config[CONF_ESP_ADF_ID])
 
     await speaker.register_speaker(var, config)
+
+    cg.add(var.set_latency_profile(config[CONF_LATENCY_PROFILE]))
+    cg.add(var.set_auto_tune(config[CONF_AUTO_TUNE]))
+    cg.add(var.set_priority(config[CONF_PRIORITY]))
+    await ducking_to_code(var, config)
+    await pipeline_to_code(var.get_pipeline(), config[CONF_PIPELINE])
+    await pipeline_to_code(var.get_url_pipeline(), config[CONF_URL_PIPELINE])
+    if CONF_PLAYBACK_CLOCK in config:
+        clock = await cg.get_variable(config[CONF_PLAYBACK_CLOCK])
+        cg.add(var.set_playback_clock(clock))
+
+    if ladder := config.get(CONF_BUTTON_LADDER):
+        cg.add_define("USE_ESP_ADF_ADC_LADDER")
+        variant = esp32.get_esp32_variant()
+        pin_num = ladder[CONF_ADC_PIN][CONF_NUMBER]
+        cg.add(
+            var.set_button_ladder_channel(
+                ESP32_VARIANT_ADC1_PIN_TO_CHANNEL[variant][pin_num]
+            )
+        )
+        decoder = var.get_button_ladder()
+        for key in ladder[CONF_KEYS]:
+            debounce = key.get(CONF_DEBOUNCE, ladder[CONF_DEBOUNCE])
+            cg.add(decoder.add_key(key[CONF_KEY], key[CONF_RAW], debounce))
+        cg.add(decoder.set_tolerance(ladder[CONF_TOLERANCE]))
+        cg.add(decoder.set_hysteresis(ladder[CONF_HYSTERESIS]))
+        cg.add(decoder.set_long_press_ms(ladder[CONF_LONG_PRESS]))
+        cg.add(decoder.set_repeat_ms(ladder[CONF_REPEAT]))
+        cg.add(decoder.set_idle_interval_ms(ladder[CONF_IDLE_INTERVAL]))
+        cg.add(decoder.set_active_interval_ms(ladder[CONF_ACTIVE_INTERVAL]))
@@ -4,21 +4,26 @@
 
 #include <driver/i2s.h>
 #include <driver/gpio.h>
-#include <driver/adc.h>
-#include <esp_adc_cal.h>
+#include <esp_timer.h>
+
+#include <cmath>
 
 #include "esphome/core/application.h"
 #include "esphome/core/hal.h"
 #include "esphome/core/log.h"
 
-#include <audio_hal.h>
+#ifdef USE_ESP_ADF_PIPELINE_HTTP_STREAM
+#include "../http_source.h"
+#endif
+#ifdef USE_ESP_ADF_PIPELINE_RESAMPLE_FILTER
 #include <filter_resample.h>
+#endif
+
+#include <audio_hal.h>
 #include <i2s_stream.h>
 #include <raw_stream.h>
-#include "esp_http_client.h"
-#include "http_stream.h"
 #include "audio_pipeline.h"
-#include "mp3_decoder.h"
+#include "ringbuf.h"
 
 #include "esp_peripherals.h"
 #include "periph_adc_button.h"
@@ -32,10 +37,17 @@ namespace esphome {
 namespace esp_adf {
 
 static const size_t BUFFER_COUNT = 50;
+static const uint32_t PLAYER_TASK_STACK_SIZE = 8192;
+static const uint32_t SAMPLE_RATE = 16000;
+using StreamFormat = audio_utils::S16Mono;  // what the pipeline hands to the I2S writer
 static const char *const TAG = "esp_adf.speaker";
+static const int64_t MAX_START_LEAD_US = 10000000;  // how far ahead play_at() may schedule
+// How often loop() steers a scheduled URL stream, having seen a few of the I2S writer's hand-overs
+static const int64_t SYNC_WINDOW_US = 500000;
 
-#define ADC_WIDTH_BIT    ADC_WIDTH_BIT_12
-#define ADC_ATTEN        ADC_ATTEN_DB_12
+using audio_utils::AudioEvent;
+using audio_utils::AudioEventType;
+using audio_utils::EventBus;
 
 #ifndef ESP_EVENT_ANY_ID
 #define ESP_EVENT_ANY_ID -1
@@ -91,36 +103,65 @@ void ESPADFSpeaker::volume_down() {
     this->set_volume(current_volume - 10);
 }
 
-void ESPADFSpeaker::initialize_audio_pipeline() {
-    esp_err_t ret;
+static i2s_stream_cfg_t i2s_writer_config(const audio_utils::BufferPlan &plan, bool use_alc) {
+    i2s_driver_config_t i2s_config = {
+        .mode = (i2s_mode_t) (I2S_MODE_MASTER | I2S_MODE_TX),
+        .sample_rate = SAMPLE_RATE,
+        .bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT,
+        .channel_format = I2S_CHANNEL_FMT_ONLY_LEFT,
+        .communication_format = I2S_COMM_FORMAT_STAND_I2S,
+        .intr_alloc_flags = ESP_INTR_FLAG_LEVEL2 | ESP_INTR_FLAG_IRAM,
+        .dma_buf_count = plan.dma_buffer_count,
+        .dma_buf_len = plan.dma_buffer_length,
+        .use_apll = false,
+        .tx_desc_auto_clear = true,
+        .fixed_mclk = 0,
+        .mclk_multiple = I2S_MCLK_MULTIPLE_256,
+        .bits_per_chan = I2S_BITS_PER_CHAN_DEFAULT,
+    };
 
-    ret = configure_resample_filter(&this->http_filter_);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Error initializing resample filter: %s", esp_err_to_name(ret));
-        return;
-    }
+    i2s_stream_cfg_t i2s_cfg = {
+        .type = AUDIO_STREAM_WRITER,
+        .i2s_config = i2s_config,
+        .i2s_port = I2S_NUM_0,
+        .use_alc = use_alc,
+        .volume = 0,
+        .out_rb_size = I2S_STREAM_RINGBUFFER_SIZE,
+        .task_stack = I2S_STREAM_TASK_STACK,
+        .task_core = I2S_STREAM_TASK_CORE,
+        .task_prio = I2S_STREAM_TASK_PRIO,
+        .stack_in_ext = false,
+        .multi_out_num = 0,
+        .uninstall_drv = true,
+        .need_expand = false,
+        .expand_src_bits = I2S_BITS_PER_SAMPLE_16BIT,
+    };
+    return i2s_cfg;
+}
 
-    ret = configure_i2s_stream_writer_http(&this->i2s_stream_writer_http_);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Error initializing I2S stream writer for HTTP: %s", esp_err_to_name(ret));
-        return;
-    }
+PipelineContext ESPADFSpeaker::pipeline_context_(bool use_alc) const {
+    return {
+        .ring_buffer_size = (int) this->plan_.pipeline_buffer_size,
+        .element_buffer_size = (int) this->plan_.ring_buffer_size,
+        .i2s_config = i2s_writer_config(this->plan_, use_alc),
+    };
+}
 
-    ret = configure_i2s_stream_writer_raw(&this->i2s_stream_writer_raw_);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Error initializing I2S stream writer for raw: %s", esp_err_to_name(ret));
-        return;
-    }
+void ESPADFSpeaker::apply_buffer_plan_() {
+    this->plan_ = this->latency_tuner_.get_plan();
+    this->queue_limit_ = std::min(BUFFER_COUNT, std::max<size_t>(2, this->plan_.ring_buffer_size / BUFFER_SIZE));
+}
 
-    ESP_LOGI(TAG, "Audio pipeline and elements initialized successfully");
+uint32_t ESPADFSpeaker::get_output_latency_us() const {
+    // DMA queue, the ring buffer in front of the I2S writer and the chunks play() may queue
+    uint64_t frames = static_cast<uint64_t>(this->plan_.dma_buffer_count) * this->plan_.dma_buffer_length +
+                      (this->plan_.ring_buffer_size + this->queue_limit_ * BUFFER_SIZE) / StreamFormat::FRAME_SIZE;
+    return static_cast<uint32_t>(frames * 1000000 / SAMPLE_RATE);
 }
 
 void ESPADFSpeaker::setup() {
     ESP_LOGCONFIG(TAG, "Setting up ESP ADF Speaker...");
 
-    adc1_config_width(ADC_WIDTH_BIT);
-    adc1_config_channel_atten((adc1_channel_t)ADC1_CHANNEL_3, ADC_ATTEN);
-    
     #ifdef USE_ESP_ADF_BOARD
     gpio_num_t pa_enable_gpio = static_cast<gpio_num_t>(get_pa_enable_gpio());
     //int but_channel = INPUT_BUTOP_ID;
@@ -135,7 +176,15 @@ void ESPADFSpeaker::setup() {
     gpio_config(&io_conf);
     gpio_set_level(PA_ENABLE_GPIO, 0);
 
-    ExternalRAMAllocator<uint8_t> allocator(ExternalRAMAllocator<uint8_t>::ALLOW_FAILURE);
+    this->apply_buffer_plan_();
+
+    if (!this->session_arena_.init(SessionArena::task_size(PLAYER_TASK_STACK_SIZE))) {
+        ESP_LOGE(TAG, "Failed to allocate the session arena!");
+        this->mark_failed();
+        return;
+    }
+
+    TrackedAllocator<uint8_t> allocator(MemoryTag::SPEAKER);
 
      this->buffer_queue_.storage = allocator.allocate(sizeof(StaticQueue_t) + (BUFFER_COUNT * sizeof(DataEvent)));
     if (this->buffer_queue_.storage == nullptr) {
@@ -148,12 +197,7 @@ void ESPADFSpeaker::setup() {
         xQueueCreateStatic(BUFFER_COUNT, sizeof(DataEvent), this->buffer_queue_.storage + sizeof(StaticQueue_t),
                            (StaticQueue_t *) (this->buffer_queue_.storage));
 
-    this->event_queue_ = xQueueCreate(20, sizeof(TaskEvent));
-    if (this->event_queue_ == nullptr) {
-        ESP_LOGW(TAG, "Could not allocate event queue.");
-        this->mark_failed();
-        return;
-    }
+    this->events_.set_handler([this](const audio_utils::AudioEvent &event) { this->handle_event_(event); });
 
     uint32_t volume_sensor_key = 0;
     for (auto *sensor : App.get_sensors()) {
@@ -181,6 +225,15 @@ void ESPADFSpeaker::setup() {
     int initial_volume = this->get_current_volume();
     this->set_volume(initial_volume);
 
+#ifdef USE_ESP_ADF_ADC_LADDER
+    // The ladder is sampled from loop(), no peripheral task. It debounces each key itself and repeats
+    // held keys, so the handler must not drop presses that follow each other closely.
+    adc1_config_width(ADC_WIDTH_BIT_12);
+    adc1_config_channel_atten(this->ladder_channel_, ADC_ATTEN_DB_12);
+    for (int32_t id = 0; id < ButtonHandler::MAX_BUTTONS; id++)
+        this->buttons_.set_debounce_ms(id, 0);
+    this->buttons_.set_action([this](int32_t id) { this->handle_button_(id); });
+#else
     // Initialize the peripheral set with increased queue size
     ESP_LOGI(TAG, "Initializing peripheral set...");
     esp_periph_config_t periph_cfg = {
@@ -219,76 +272,91 @@ void ESPADFSpeaker::setup() {
     };
     periph_service_handle_t input_ser = input_key_service_create(&input_cfg);
     input_key_service_add_key(input_ser, input_key_info, INPUT_KEY_NUM);
-    periph_service_set_callback(input_ser, ESPADFSpeaker::input_key_service_cb, this); 
+    // The callback only queues the press, the action runs from loop()
+    this->buttons_.set_debounce_ms(BUTTON_MODE_ID, 500);
+    this->buttons_.set_action([this](int32_t id) { this->handle_button_(id); });
+    periph_service_set_callback(input_ser, ButtonHandler::input_key_service_cb, &this->buttons_);
+#endif
 
-    this->initialize_audio_pipeline();
+    this->resource_client_.set_grant_callback([this]() {
+        if (this->state_ != speaker::STATE_STARTING)
+            return;
+        if (this->url_pending_) {
+            this->start_url_();
+        } else {
+            this->start_();
+        }
+    });
+    this->resource_client_.set_preempt_callback([this]() {
+        ESP_LOGD(TAG, "Stopping for a higher priority user of the codec");
+        this->stop();
+    });
 }
 
-esp_err_t ESPADFSpeaker::input_key_service_cb(periph_service_handle_t handle, periph_service_event_t *evt, void *ctx) {
-    ESPADFSpeaker *instance = static_cast<ESPADFSpeaker*>(ctx);
-    int32_t id = static_cast<int32_t>(reinterpret_cast<uintptr_t>(evt->data));
-
-    // Read the ADC value
-    int adc_value = adc1_get_raw(ADC1_CHANNEL_3);  // Replace with your ADC channel
-    ESP_LOGI(TAG, "Button event callback received: id=%d, event type=%d, ADC value=%d", id, evt->type, adc_value);
-
-    instance->handle_button_event(id, evt->type);
-    return ESP_OK;
+void ESPADFSpeaker::dump_config() {
+    ESP_LOGCONFIG(TAG, "ESP ADF Speaker:");
+    this->pipeline_.dump_config(TAG);
+    this->url_pipeline_.dump_config(TAG, "URL Pipeline");
+#ifdef USE_ESP_ADF_PIPELINE_HTTP_STREAM
+    ESP_LOGCONFIG(TAG, "  HTTP keep-alive: up to %u idle connections for %u s",
+                  (unsigned) HttpClientPool::MAX_IDLE_CONNECTIONS, (unsigned) (HttpClientPool::IDLE_TIMEOUT_MS / 1000));
+#endif
+#ifdef USE_ESP_ADF_ADC_LADDER
+    ESP_LOGCONFIG(TAG, "  Button ladder: %u keys on ADC1 channel %d", (unsigned) this->ladder_.get_key_count(),
+                  (int) this->ladder_channel_);
+#endif
+    this->buttons_.dump_config(TAG);
 }
 
-void ESPADFSpeaker::handle_button_event(int32_t id, int32_t event_type) {
-    ESP_LOGI(TAG, "Handle Button event received: id=%d", id);
-    if (event_type != 1 && event_type != 3) { // Only process the event if the event_type is 1 click action or 3 long press action
-        ESP_LOGI(TAG, "Ignoring event with type: %d", event_type);
-        return;
-    }
-    uint32_t current_time = millis();
-    static uint32_t last_button_press[7] = {0};
-    uint32_t debounce_time = 200;
-
-    if (id == BUTTON_MODE_ID) {
-        debounce_time = 500;
-    }
-
-    if (current_time - last_button_press[id] > debounce_time) {
-        switch (id) {
-            case 0:
-                ESP_LOGI(TAG, "Unkonw Button detected");
-                //volume_down();
-                break;
-            case 1:
-                ESP_LOGI(TAG, "Record button detected");
-                handle_rec_button();
-                break;
-            case 2:
-                ESP_LOGI(TAG, "Set button detected");
-                handle_set_button();
-                break;
-            case 3:
-                ESP_LOGI(TAG, "Play button detected");
-                handle_play_button();
-                break;
-            case 4:
-                ESP_LOGI(TAG, "Mode button detected");
-                handle_mode_button();
-                break;
-            case 5:
-                ESP_LOGI(TAG, "Volume down detected");
-                volume_down();
-                break;
-            case 6:
-                ESP_LOGI(TAG, "Volume up detected");
-                volume_up();
-                break;
-            default:
-                ESP_LOGW(TAG, "Unhandled button event id: %d", id);
-                break;
-        }
-        last_button_press[id] = current_time;
+void ESPADFSpeaker::handle_button_(int32_t id) {
+    switch (id) {
+        case 0:
+            ESP_LOGI(TAG, "Unkonw Button detected");
+            break;
+        case 1:
+            ESP_LOGI(TAG, "Record button detected");
+            this->handle_rec_button();
+            break;
+        case 2:
+            ESP_LOGI(TAG, "Set button detected");
+            this->handle_set_button();
+            break;
+        case 3:
+            ESP_LOGI(TAG, "Play button detected");
+            this->handle_play_button();
+            break;
+        case 4:
+            ESP_LOGI(TAG, "Mode button detected");
+            this->handle_mode_button();
+            break;
+        case 5:
+            ESP_LOGI(TAG, "Volume down detected");
+            this->volume_down();
+            break;
+        case 6:
+            ESP_LOGI(TAG, "Volume up detected");
+            this->volume_up();
+            break;
+        default:
+            ESP_LOGW(TAG, "Unhandled button event id: %d", id);
+            break;
     }
 }
 
-
+#ifdef USE_ESP_ADF_ADC_LADDER
+void ESPADFSpeaker::sample_buttons_() {
+    uint32_t now = millis();
+    if (now - this->last_ladder_sample_ms_ < this->ladder_.get_sample_interval_ms(now))
+        return;
+    this->last_ladder_sample_ms_ = now;
+    LadderEvent event;
+    if (!this->ladder_.feed(adc1_get_raw(this->ladder_channel_), now, &event))
+        return;
+    // Repeats run the long press action again, as the input key service would for a held key
+    uint8_t type = event.type == LadderEventType::CLICK ? INPUT_KEY_SERVICE_ACTION_CLICK : INPUT_KEY_SERVICE_ACTION_PRESS;
+    this->buttons_.push({event.id, type, esp_timer_get_time()});
+}
+#endif
 
 void ESPADFSpeaker::handle_mode_button() {
     if (this->state_ != speaker::STATE_RUNNING && this->state_ != speaker::STATE_STARTING) {
@@ -325,137 +393,232 @@ void ESPADFSpeaker::play_url(const std::string &url) {
 
     this->cleanup_audio_pipeline();
 
-    #ifdef HTTP_STREAM_RINGBUFFER_SIZE
-    #undef HTTP_STREAM_RINGBUFFER_SIZE
-    #endif
-    #define HTTP_STREAM_RINGBUFFER_SIZE (12 * 1024)
-
-    http_stream_cfg_t http_cfg = {
-        .type = AUDIO_STREAM_READER,
-        .out_rb_size = HTTP_STREAM_RINGBUFFER_SIZE,
-        .task_stack = HTTP_STREAM_TASK_STACK,
-        .task_core = HTTP_STREAM_TASK_CORE,
-        .task_prio = HTTP_STREAM_TASK_PRIO,
-        .stack_in_ext = false,
-        .event_handle = NULL,
-        .user_data = NULL,
-        .auto_connect_next_track = false,
-        .enable_playlist_parser = false,
-        .multi_out_num = 0,
-        .cert_pem = NULL,
-        .crt_bundle_attach = NULL,
-    };
-
-    ESP_LOGI(TAG, "Passed Configure HTTP Stream");
-
-    this->http_stream_reader_ = http_stream_init(&http_cfg);
-    if (this->http_stream_reader_ == NULL) {
-        ESP_LOGE(TAG, "Failed to initialize HTTP stream reader");
-        return;
-    }
-    ESP_LOGI(TAG, "HTTP stream reader init");
-    
-    audio_element_set_uri(this->http_stream_reader_, url.c_str());
-    ESP_LOGI(TAG, "HTTP set URI");
-
-    ESP_LOGI(TAG, "Create MP3 decoder to decode MP3 file");
-    mp3_decoder_cfg_t mp3_cfg = DEFAULT_MP3_DECODER_CONFIG();
-    audio_element_handle_t mp3_decoder = mp3_decoder_init(&mp3_cfg);
-    if (mp3_decoder == NULL) {
-        ESP_LOGE(TAG, "Failed to initialize MP3 decoder");
+    // Decoded streams never pass through play(), so they are ducked by the writer's software ALC
+    if (!this->url_pipeline_.build(this->pipeline_context_(this->has_ducking_()))) {
+        ESP_LOGE(TAG, "Failed to build the URL pipeline");
         return;
     }
+    audio_element_set_uri(this->url_pipeline_.get_source(), url.c_str());
+    if (this->start_pending_) {
+        this->start_pending_ = false;
+        this->url_scheduled_ = true;
+        this->url_start_us_ = this->pending_start_us_;
+    }
+#ifdef USE_ESP_ADF_PIPELINE_HTTP_STREAM
+    // A kept-alive connection to the same server skips DNS and the TCP and TLS handshakes
+    this->url_connection_ = HttpClientPool::get().acquire(url);
+    this->url_fetch_reported_ = false;
+    http_source_set_connection(this->url_pipeline_.get_source(), this->url_connection_);
+#endif
+    ESP_LOGI(TAG, "Linked pipeline elements");
 
-    audio_pipeline_cfg_t pipeline_cfg = {
-        .rb_size = 8 * 1024,
-    };
-    this->pipeline_ = audio_pipeline_init(&pipeline_cfg);
-    if (this->pipeline_ == NULL) {
-        ESP_LOGE(TAG, "Failed to initialize http audio pipeline");
-        return;
+    // The URL pipeline writes to the codec itself, the raw player task is not started
+    this->url_pending_ = true;
+    this->state_ = speaker::STATE_STARTING;
+    if (this->parent_->get_arbiter()->request(&this->resource_client_)) {
+        this->start_url_();
+    } else {
+        ESP_LOGI(TAG, "Waiting for the codec");  // the grant callback runs the pipeline
     }
-    ESP_LOGI(TAG, "HTTP passed initilialize new audio pipeline");
+}
 
-    ESP_LOGI(TAG, "Register all elements to audio pipeline");
+void ESPADFSpeaker::start_url_() {
+    this->url_pending_ = false;
+    gpio_set_level(PA_ENABLE_GPIO, 1);
+    ESP_LOGI(TAG, "PA enabled");
 
-    ESP_LOGI(TAG, "Register HTTP stream reader");
-    if (audio_pipeline_register(this->pipeline_, this->http_stream_reader_, "http") != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to register HTTP stream reader");
-        audio_pipeline_deinit(this->pipeline_);
-        this->pipeline_ = nullptr;
+    ESP_LOGI(TAG, "Starting new audio pipeline for URL");
+    if (!this->url_pipeline_.run()) {
+        ESP_LOGE(TAG, "Failed to run audio pipeline");
+        this->cleanup_audio_pipeline();
+        this->state_ = speaker::STATE_STOPPED;
         return;
     }
+    this->state_ = speaker::STATE_RUNNING;
+
+    if (this->url_scheduled_) {
+        const PipelineElementConfig *resample =
+            this->url_pipeline_.get_element_config(PipelineElementType::RESAMPLE_FILTER);
+        this->url_nominal_rate_ = resample != nullptr ? resample->source_rate : 0;
+        this->url_rate_ = this->url_nominal_rate_;
+        this->url_written_frames_ = 0;
+        this->url_anchored_ = false;
+        this->url_aligned_ = false;
+        this->url_position_us_ = 0.0;
+        this->url_skip_frames_ = 0;
+        this->url_window_valid_ = false;
+        this->url_window_start_us_ = esp_timer_get_time();
+        this->url_last_update_us_ = this->url_window_start_us_;
+        this->url_drift_.reset();
+        this->sync_max_error_us_ = 0;
+        this->sync_realigns_ = 0;
+        // Started from idle, the writer's first frames go to the DMA buffer that plays next
+        int64_t buffer_us = static_cast<int64_t>(this->plan_.dma_buffer_length) * 1000000 / SAMPLE_RATE;
+        this->hold_url_writer_(this->playback_clock_->to_local_us(this->url_start_us_) - buffer_us);
+    }
+}
 
-    ESP_LOGI(TAG, "Register MP3 decoder");
-    if (audio_pipeline_register(this->pipeline_, mp3_decoder, "mp3") != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to register MP3 decoder");
-        audio_pipeline_deinit(this->pipeline_);
-        this->pipeline_ = nullptr;
+void ESPADFSpeaker::play_at(int64_t shared_time_us) {
+    if (this->playback_clock_ == nullptr) {
+        ESP_LOGW(TAG, "Cannot schedule playback without a playback clock");
         return;
     }
-
-    ESP_LOGI(TAG, "Register resample filter");
-    if (audio_pipeline_register(this->pipeline_, this->http_filter_, "filter") != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to register resample filter");
-        audio_pipeline_deinit(this->pipeline_);
-        this->pipeline_ = nullptr;
+    if (!this->playback_clock_->is_synchronized()) {
+        ESP_LOGW(TAG, "Playback clock not synchronized yet, playing unscheduled");
         return;
     }
-
-    ESP_LOGI(TAG, "Register I2S stream writer");
-    if (audio_pipeline_register(this->pipeline_, this->i2s_stream_writer_http_, "i2s") != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to register I2S stream writer");
-        audio_pipeline_deinit(this->pipeline_);
-        this->pipeline_ = nullptr;
+    int64_t lead_us = this->playback_clock_->to_local_us(shared_time_us) - esp_timer_get_time();
+    if (lead_us > MAX_START_LEAD_US) {
+        ESP_LOGW(TAG, "Start time %lld ms ahead, playing unscheduled", (long long) (lead_us / 1000));
         return;
     }
+    this->pending_start_us_ = shared_time_us;
+    this->start_pending_ = true;
+}
 
-    ESP_LOGI(TAG, "Link elements in pipeline");
-    const char *link_tag[4] = {"http", "mp3", "filter", "i2s"};
-    if (audio_pipeline_link(this->pipeline_, &link_tag[0], 4) != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to link pipeline elements");
-        audio_pipeline_deinit(this->pipeline_);
-        this->pipeline_ = nullptr;
+void ESPADFSpeaker::hold_url_writer_(int64_t local_us) {
+    if (local_us <= esp_timer_get_time())
         return;
-    }
-    ESP_LOGI(TAG, "Linked pipeline elements");
+    audio_element_pause(this->url_pipeline_.get_sink());
+    this->url_hold_until_us_ = local_us;
+}
 
-    gpio_set_level(PA_ENABLE_GPIO, 1);
-    ESP_LOGI(TAG, "PA enabled");
+void ESPADFSpeaker::trim_url_rate_(float trim_ppm) {
+    if (this->url_nominal_rate_ <= 0)
+        return;  // no resample filter, the schedule is only kept by realigning
+    // The filter takes whole Hz, about 20 ppm steps at 44.1 kHz, and starts over on each change
+    int rate = this->url_nominal_rate_ + static_cast<int>(lroundf(this->url_nominal_rate_ * trim_ppm * 1e-6f));
+    if (rate == this->url_rate_)
+        return;
+#ifdef USE_ESP_ADF_PIPELINE_RESAMPLE_FILTER
+    audio_element_handle_t filter = this->url_pipeline_.get_element(PipelineElementType::RESAMPLE_FILTER);
+    const PipelineElementConfig *resample =
+        this->url_pipeline_.get_element_config(PipelineElementType::RESAMPLE_FILTER);
+    if (rsp_filter_set_src_info(filter, rate, resample->source_channels) == ESP_OK)
+        this->url_rate_ = rate;
+#endif
+}
 
-    if (this->state_ != speaker::STATE_RUNNING && this->state_ != speaker::STATE_STARTING) {
-        ESP_LOGI(TAG, "State is Not Running");
-        TaskEvent event;
-        event.type = TaskEventType::STARTED;
-        this->start();
-    }
-    if (this->state_ == speaker::STATE_RUNNING) {
-        ESP_LOGI(TAG, "State is now Running after button");
-    }
-    if (this->state_ == speaker::STATE_STARTING) {
-        ESP_LOGI(TAG, "State is starting after button");
+void ESPADFSpeaker::follow_url_schedule_() {
+    if (!this->url_scheduled_ || this->url_paused_ || !this->url_pipeline_.is_built())
+        return;
+    audio_element_handle_t writer = this->url_pipeline_.get_sink();
+    int64_t now = esp_timer_get_time();
+    if (this->url_hold_until_us_ != 0) {
+        if (now < this->url_hold_until_us_)
+            return;
+        audio_element_resume(writer, 0, 0);
+        this->url_hold_until_us_ = 0;
+        this->url_window_valid_ = false;
+        this->url_window_start_us_ = now;
+        this->url_last_update_us_ = now;
+    }
+    // Each output frame carries rate / nominal rate of a frame of the stream
+    double ratio = this->url_nominal_rate_ > 0 ? static_cast<double>(this->url_rate_) / this->url_nominal_rate_ : 1.0;
+    double frame_us = 1000000.0 / SAMPLE_RATE * ratio;
+
+    // Catching up: drop decoded frames before the writer takes them
+    ringbuf_handle_t writer_rb = audio_element_get_input_ringbuf(writer);
+    while (this->url_skip_frames_ > 0 && writer_rb != nullptr) {
+        char scratch[BUFFER_SIZE];
+        size_t wanted = std::min<uint64_t>(this->url_skip_frames_ * StreamFormat::FRAME_SIZE, BUFFER_SIZE);
+        int read = rb_read(writer_rb, scratch, std::min<int>(wanted, rb_bytes_filled(writer_rb)), 0);
+        if (read <= 0)
+            break;
+        uint64_t frames = read / StreamFormat::FRAME_SIZE;
+        this->url_skip_frames_ -= std::min(this->url_skip_frames_, frames);
+        this->url_position_us_ += frames * frame_us;
+    }
+
+    // The writer hands a DMA buffer over whenever one frees up, and the DMA runs on the same crystal
+    // as esp_timer: right after it took them, the frames written so far have played but for the DMA
+    // queue. Seen from here a little late, each hand-over bounds from above when frame 0 played.
+    audio_element_info_t info;
+    audio_element_getinfo(writer, &info);
+    int64_t written = info.byte_pos / StreamFormat::FRAME_SIZE;
+    if (written != this->url_written_frames_) {
+        this->url_position_us_ += (written - this->url_written_frames_) * frame_us;
+        this->url_written_frames_ = written;
+        int64_t dma_frames = static_cast<int64_t>(this->plan_.dma_buffer_count) * this->plan_.dma_buffer_length;
+        int64_t origin_us = now + (dma_frames - written) * 1000000 / SAMPLE_RATE;
+        if (!this->url_window_valid_ || origin_us < this->url_window_origin_us_)
+            this->url_window_origin_us_ = origin_us;
+        this->url_window_valid_ = true;
+        if (this->url_anchored_)
+            this->url_origin_us_ = std::min(this->url_origin_us_, origin_us);
+    }
+    if (now - this->url_window_start_us_ < SYNC_WINDOW_US || this->url_skip_frames_ > 0)
+        return;
+    bool measured = this->url_window_valid_;
+    this->url_window_valid_ = false;
+    this->url_window_start_us_ = now;
+    if (!measured)
+        return;  // the stream has stalled, nothing to steer
+    // Seen late by less than a DMA buffer, a window that never came closer means the output
+    // slipped, e.g. by an underrun
+    int64_t buffer_us = static_cast<int64_t>(this->plan_.dma_buffer_length) * 1000000 / SAMPLE_RATE;
+    if (!this->url_anchored_ || this->url_window_origin_us_ - this->url_origin_us_ > buffer_us) {
+        this->url_origin_us_ = this->url_window_origin_us_;
+        this->url_anchored_ = true;
+    }
+    int64_t playing_us = this->url_origin_us_ + this->url_written_frames_ * 1000000 / SAMPLE_RATE;
+    int64_t error_us = this->playback_clock_->to_shared_us(playing_us) -
+                       (this->url_start_us_ + static_cast<int64_t>(this->url_position_us_));
+
+    if (!this->url_aligned_ || audio_utils::DriftController::needs_jump(error_us)) {
+        if (error_us > 0) {
+            this->url_skip_frames_ = static_cast<uint64_t>(error_us) * SAMPLE_RATE / 1000000;
+        } else {
+            // The DMA queue plays out before the hold becomes silence; the writer then starts afresh
+            int64_t queued_frames =
+                static_cast<int64_t>(this->plan_.dma_buffer_count - 1) * this->plan_.dma_buffer_length;
+            this->hold_url_writer_(now - error_us + queued_frames * 1000000 / SAMPLE_RATE);
+            this->url_anchored_ = false;
+        }
+        // Skipping lines the stream up to the frame; a hold resumes up to a DMA buffer late and is
+        // measured again
+        if (this->url_aligned_)
+            this->sync_realigns_++;
+        this->url_aligned_ = error_us > 0;
+        this->url_drift_.reset(false);
+    } else {
+        float elapsed_s = static_cast<float>(now - this->url_last_update_us_) * 1e-6f;
+        this->trim_url_rate_(this->url_drift_.update(static_cast<float>(error_us), elapsed_s));
+        this->sync_max_error_us_ = std::max(this->sync_max_error_us_, std::abs(error_us));
     }
+    this->url_last_update_us_ = now;
+}
 
-    ESP_LOGI(TAG, "Starting new audio pipeline for URL");
-    if (audio_pipeline_run(this->pipeline_) != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to run audio pipeline");
-        audio_pipeline_deinit(this->pipeline_);
-        this->pipeline_ = nullptr;
+void ESPADFSpeaker::end_url_schedule_() {
+    if (!this->url_scheduled_)
         return;
+    this->url_scheduled_ = false;
+    if (this->url_hold_until_us_ != 0 && this->url_pipeline_.is_built())
+        audio_element_resume(this->url_pipeline_.get_sink(), 0, 0);
+    this->url_hold_until_us_ = 0;
+    if (this->url_pipeline_.is_built())
+        this->trim_url_rate_(0.0f);
+    if (this->sync_max_error_us_ > 0) {
+        ESP_LOGD(TAG, "Held the schedule within %lld us with %u realigns, output drift %.1f ppm",
+                 (long long) this->sync_max_error_us_, (unsigned) this->sync_realigns_,
+                 this->url_drift_.get_drift_ppm());
     }
 }
 
 void ESPADFSpeaker::media_play() {
-    if (this->state_ == speaker::STATE_STOPPED) {
-        audio_pipeline_resume(this->pipeline_);
-        this->state_ = speaker::STATE_RUNNING;
+    if (this->url_paused_ && this->url_pipeline_.is_built()) {
+        audio_pipeline_resume(this->url_pipeline_.get_pipeline());
+        this->url_paused_ = false;
     }
 }
 
 void ESPADFSpeaker::media_pause() {
-    if (this->state_ == speaker::STATE_RUNNING) {
-        audio_pipeline_pause(this->pipeline_);
-        this->state_ = speaker::STATE_STOPPED;
+    // Paused, the URL pipeline keeps the codec and the speaker stays running
+    if (this->state_ == speaker::STATE_RUNNING && this->url_pipeline_.is_built() && !this->url_paused_) {
+        // Resumed, the stream has left its schedule
+        this->end_url_schedule_();
+        audio_pipeline_pause(this->url_pipeline_.get_pipeline());
+        this->url_paused_ = true;
     }
 }
 
@@ -467,175 +630,119 @@ void ESPADFSpeaker::media_stop() {
 }
 
 void ESPADFSpeaker::cleanup_audio_pipeline() {
-    if (this->pipeline_ != nullptr) {
+    this->end_url_schedule_();
+    if (this->url_pipeline_.is_built()) {
         ESP_LOGI(TAG, "Stopping current audio pipeline");
-        audio_pipeline_stop(this->pipeline_);
-        audio_pipeline_wait_for_stop(this->pipeline_);
-        audio_pipeline_terminate(this->pipeline_);
-        audio_pipeline_unregister(this->pipeline_, this->i2s_stream_writer_http_);
-        audio_pipeline_unregister(this->pipeline_, this->http_filter_);
-        audio_pipeline_unregister(this->pipeline_, this->http_stream_reader_);
-        audio_pipeline_deinit(this->pipeline_);
-        this->pipeline_ = nullptr;
-    }
+        this->url_pipeline_.destroy();
+        // Held or waited for by the URL pipeline, which had no player task to release it
+        this->url_pending_ = false;
+        this->url_paused_ = false;
+        this->parent_->get_arbiter()->release(&this->resource_client_);
+    }
+#ifdef USE_ESP_ADF_PIPELINE_HTTP_STREAM
+    this->release_url_connection_();
+#endif
+    this->alc_volume_db_ = 0;
 }
 
+#ifdef USE_ESP_ADF_PIPELINE_HTTP_STREAM
+void ESPADFSpeaker::report_url_fetch_() {
+    if (this->url_connection_ == nullptr || this->url_fetch_reported_)
+        return;
+    uint32_t first_byte_us = this->url_connection_->first_byte_us.load(std::memory_order_acquire);
+    if (first_byte_us == 0)
+        return;
+    this->url_fetch_reported_ = true;
+
+    const HttpConnection *connection = this->url_connection_;
+    const char *kind = connection->stale ? "reopened" : (connection->reused ? "kept-alive" : "new");
+    ESP_LOGI(TAG, "URL time to first byte: %.1f ms (headers after %.1f ms, %s connection)", first_byte_us / 1000.0f,
+             connection->headers_us / 1000.0f, kind);
+    const HttpClientPool &pool = HttpClientPool::get();
+    ESP_LOGD(TAG, "HTTP connections: %u kept-alive, %u new, %u found closed", (unsigned) pool.get_hits(),
+             (unsigned) pool.get_misses(), (unsigned) pool.get_stale());
+}
+
+void ESPADFSpeaker::release_url_connection_() {
+    HttpClientPool::get().release(this->url_connection_);
+    this->url_connection_ = nullptr;
+}
+#endif
+
 void ESPADFSpeaker::start() {
     this->state_ = speaker::STATE_STARTING;
 }
 
 void ESPADFSpeaker::start_() {
-    if (!this->parent_->try_lock()) {
+    if (this->player_task_handle_ != nullptr) {
         return;
     }
-    xTaskCreate(ESPADFSpeaker::player_task, "speaker_task", 8192, (void *) this, 0, &this->player_task_handle_);
+    if (!this->session_arena_.is_task_deleted()) {
+        return;  // The last session's task is still being cleaned up, loop() tries again
+    }
+    if (!this->parent_->get_arbiter()->request(&this->resource_client_)) {
+        return;  // Queued, the arbiter calls back once the codec is free
+    }
+    this->apply_buffer_plan_();
+    ESP_LOGD(TAG, "Latency profile %s: DMA %d x %d frames, output latency %u ms",
+             audio_utils::latency_profile_to_string(this->latency_tuner_.get_profile()), this->plan_.dma_buffer_count,
+             this->plan_.dma_buffer_length, this->get_output_latency_us() / 1000);
+    this->session_arena_.reset();
+    if (!this->session_arena_.create_task(ESPADFSpeaker::player_task, "speaker_task", PLAYER_TASK_STACK_SIZE,
+                                          (void *) this, 0, &this->player_task_handle_)) {
+        ESP_LOGE(TAG, "Failed to start the player task");
+        this->player_task_handle_ = nullptr;
+        xQueueReset(this->buffer_queue_.handle);
+        this->accepted_position_ = 0;
+        this->parent_->get_arbiter()->release(&this->resource_client_);
+        this->state_ = speaker::STATE_STOPPED;
+    }
 }
 
 void ESPADFSpeaker::player_task(void *params) {
     ESPADFSpeaker *this_speaker = (ESPADFSpeaker *) params;
 
-    TaskEvent event;
-    event.type = TaskEventType::STARTING;
-    xQueueSend(this_speaker->event_queue_, &event, portMAX_DELAY);
-
-    i2s_driver_config_t i2s_config = {
-        .mode = (i2s_mode_t) (I2S_MODE_MASTER | I2S_MODE_TX),
-        .sample_rate = 16000,
-        .bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT,
-        .channel_format = I2S_CHANNEL_FMT_ONLY_LEFT,
-        .communication_format = I2S_COMM_FORMAT_STAND_I2S,
-        .intr_alloc_flags = ESP_INTR_FLAG_LEVEL2 | ESP_INTR_FLAG_IRAM,
-        .dma_buf_count = 8,
-        .dma_buf_len = 1024,
-        .use_apll = false,
-        .tx_desc_auto_clear = true,
-        .fixed_mclk = 0,
-        .mclk_multiple = I2S_MCLK_MULTIPLE_256,
-        .bits_per_chan = I2S_BITS_PER_CHAN_DEFAULT,
-    };
+    this_speaker->events_.publish(AudioEvent::of(AudioEventType::STARTING), EventBus::WAIT_FOREVER);
 
-    audio_pipeline_cfg_t pipeline_cfg = {
-        .rb_size = 8 * 1024,
-    };
-    audio_pipeline_handle_t pipeline = audio_pipeline_init(&pipeline_cfg);
+    const audio_utils::BufferPlan plan = this_speaker->plan_;
 
-    i2s_stream_cfg_t i2s_cfg = {
-        .type = AUDIO_STREAM_WRITER,
-        .i2s_config = i2s_config,
-        .i2s_port = I2S_NUM_0,
-        .use_alc = false,
-        .volume = 0,
-        .out_rb_size = I2S_STREAM_RINGBUFFER_SIZE,
-        .task_stack = I2S_STREAM_TASK_STACK,
-        .task_core = I2S_STREAM_TASK_CORE,
-        .task_prio = I2S_STREAM_TASK_PRIO,
-        .stack_in_ext = false,
-        .multi_out_num = 0,
-        .uninstall_drv = true,
-        .need_expand = false,
-        .expand_src_bits = I2S_BITS_PER_SAMPLE_16BIT,
-    };
-    this_speaker->i2s_stream_writer_ = i2s_stream_init(&i2s_cfg);
-    if (this_speaker->i2s_stream_writer_ == nullptr) {
-        ESP_LOGE("ESPADFSpeaker", "Failed to initialize I2S stream writer");
-        event.type = TaskEventType::WARNING;
-        xQueueSend(this_speaker->event_queue_, &event, portMAX_DELAY);
+    if (!this_speaker->pipeline_.build(this_speaker->pipeline_context_(false)) || !this_speaker->pipeline_.run()) {
+        ESP_LOGE(TAG, "Failed to start the pipeline");
+        this_speaker->pipeline_.destroy();
+        this_speaker->events_.publish(AudioEvent::warning(ESP_FAIL), EventBus::WAIT_FOREVER);
+        this_speaker->events_.publish(AudioEvent::of(AudioEventType::STOPPED), EventBus::WAIT_FOREVER);
         return;
     }
-
-    if (this_speaker->is_http_stream_) {
-        http_stream_cfg_t http_cfg = HTTP_STREAM_CFG_DEFAULT();
-        http_cfg.type = AUDIO_STREAM_READER;
-        this_speaker->http_stream_reader_ = http_stream_init(&http_cfg);
-
-        if (this_speaker->http_stream_reader_ == nullptr) {
-            ESP_LOGE("ESPADFSpeaker", "Failed to initialize HTTP stream reader");
-            event.type = TaskEventType::WARNING;
-            xQueueSend(this_speaker->event_queue_, &event, portMAX_DELAY);
-            return;
-        }
-
-        rsp_filter_cfg_t rsp_cfg = {
-            .src_rate = 44100,
-            .src_ch = 2,
-            .dest_rate = 16000,
-            .dest_bits = 16,
-            .dest_ch = 1,
-            .src_bits = 16,
-            .mode = RESAMPLE_DECODE_MODE,
-            .max_indata_bytes = RSP_FILTER_BUFFER_BYTE,
-            .out_len_bytes = RSP_FILTER_BUFFER_BYTE,
-            .type = ESP_RESAMPLE_TYPE_AUTO,
-            .complexity = 2,
-            .down_ch_idx = 0,
-            .prefer_flag = ESP_RSP_PREFER_TYPE_SPEED,
-            .out_rb_size = RSP_FILTER_RINGBUFFER_SIZE,
-            .task_stack = RSP_FILTER_TASK_STACK,
-            .task_core = RSP_FILTER_TASK_CORE,
-            .task_prio = RSP_FILTER_TASK_PRIO,
-            .stack_in_ext = true,
-        };
-        this_speaker->filter_ = rsp_filter_init(&rsp_cfg);
-
-        if (this_speaker->filter_ == nullptr) {
-            ESP_LOGE("ESPADFSpeaker", "Failed to initialize resample filter");
-            event.type = TaskEventType::WARNING;
-            xQueueSend(this_speaker->event_queue_, &event, portMAX_DELAY);
-            return;
-        }
-
-        this_speaker->pipeline_ = audio_pipeline_init(&pipeline_cfg);
-        audio_pipeline_register(this_speaker->pipeline_, this_speaker->http_stream_reader_, "http");
-        audio_pipeline_register(this_speaker->pipeline_, this_speaker->filter_, "filter");
-        audio_pipeline_register(this_speaker->pipeline_, this_speaker->i2s_stream_writer_, "i2s");
-
-        const char *link_tag_http[3] = {"http", "filter", "i2s"};
-        audio_pipeline_link(this_speaker->pipeline_, &link_tag_http[0], 3);
-
-        audio_pipeline_run(this_speaker->pipeline_);
-    } else {
-        raw_stream_cfg_t raw_cfg = {
-            .type = AUDIO_STREAM_WRITER,
-            .out_rb_size = 8 * 1024,
-        };
-        this_speaker->raw_write_ = raw_stream_init(&raw_cfg);
-
-        if (this_speaker->raw_write_ == nullptr) {
-            ESP_LOGE("ESPADFSpeaker", "Failed to initialize raw stream writer");
-            event.type = TaskEventType::WARNING;
-            xQueueSend(this_speaker->event_queue_, &event, portMAX_DELAY);
-            return;
-        }
-
-        this_speaker->pipeline_ = audio_pipeline_init(&pipeline_cfg);
-        audio_pipeline_register(this_speaker->pipeline_, this_speaker->raw_write_, "raw");
-        audio_pipeline_register(this_speaker->pipeline_, this_speaker->i2s_stream_writer_, "i2s");
-
-        const char *link_tag_raw[2] = {"raw", "i2s"};
-        audio_pipeline_link(this_speaker->pipeline_, &link_tag_raw[0], 2);
-
-        audio_pipeline_run(this_speaker->pipeline_);
-    }
+    audio_element_handle_t raw_write = this_speaker->pipeline_.get_source();
     DataEvent data_event;
 
-    event.type = TaskEventType::STARTED;
-    xQueueSend(this_speaker->event_queue_, &event, 0);
+    this_speaker->events_.publish(AudioEvent::of(AudioEventType::STARTED), EventBus::WAIT_FOREVER);
     gpio_set_level(PA_ENABLE_GPIO, 1);
 
     uint32_t last_received = millis();
 
+    // The i2s_stream element owns the driver, so presentation times are extrapolated from what is
+    // queued between the raw writer and the DMA output.
+    uint64_t written_position = 0;
+    ringbuf_handle_t i2s_input_rb = audio_element_get_input_ringbuf(this_speaker->pipeline_.get_sink());
+    this_speaker->sample_clock_.reset(SAMPLE_RATE, esp_timer_get_time());
+    this_speaker->ducking_ramp_.set_sample_rate(SAMPLE_RATE);
+    this_speaker->ducking_ramp_.reset();
+
     while (true) {
         if (xQueueReceive(this_speaker->buffer_queue_.handle, &data_event, 0) != pdTRUE) {
-            if (millis() - last_received > 500) {
+            // Idle: stopping the pipeline drops what it still buffers, so wait until that has played
+            if (millis() - last_received > 500 &&
+                esp_timer_get_time() >= this_speaker->sample_clock_.time_of(written_position)) {
                 break;
             } else {
                 continue;
             }
         }
         if (data_event.stop) {
-            while (xQueueReceive(this_speaker->buffer_queue_.handle, &data_event, 0) == pdTRUE) {
-                break;
-            }
+            // The stop itself carries no audio; take the next chunk in its place, if any
+            if (xQueueReceive(this_speaker->buffer_queue_.handle, &data_event, 0) != pdTRUE || data_event.stop)
+                continue;
         }
 
         size_t remaining = data_event.len;
@@ -643,11 +750,13 @@ void ESPADFSpeaker::player_task(void *params) {
         if (remaining > 0)
             last_received = millis();
 
+        if (!this_speaker->ducking_ramp_.is_unity())
+            this_speaker->ducking_ramp_.process(reinterpret_cast<int16_t *>(data_event.data), data_event.len / StreamFormat::FRAME_SIZE);
+
         while (remaining > 0) {
-            int bytes_written = raw_stream_write(this_speaker->raw_write_, (char *) data_event.data + current, remaining);
+            int bytes_written = raw_stream_write(raw_write, (char *) data_event.data + current, remaining);
             if (bytes_written == ESP_FAIL) {
-                event = {.type = TaskEventType::WARNING, .err = ESP_FAIL};
-                xQueueSend(this_speaker->event_queue_, &event, 0);
+                this_speaker->events_.publish(AudioEvent::warning(ESP_FAIL));
                 continue;
             }
 
@@ -655,89 +764,151 @@ void ESPADFSpeaker::player_task(void *params) {
             current += bytes_written;
         }
 
-        event.type = TaskEventType::RUNNING;
-        xQueueSend(this_speaker->event_queue_, &event, 0);
-    }
+        if (i2s_input_rb != nullptr && current > 0) {
+            int64_t now = esp_timer_get_time();
+            if (written_position > 0 && this_speaker->sample_clock_.time_of(written_position) < now) {
+                // Everything written so far should already have played, so the DMA ran dry
+                this_speaker->latency_tuner_.report_underrun();
+            }
+            written_position += current / StreamFormat::FRAME_SIZE;
+            int64_t queued_frames = rb_bytes_filled(i2s_input_rb) / StreamFormat::FRAME_SIZE +
+                                    plan.dma_buffer_count * plan.dma_buffer_length;
+            this_speaker->sample_clock_.update(written_position,
+                                               now + queued_frames * 1000000 / SAMPLE_RATE);
+        }
 
-    audio_pipeline_stop(this_speaker->pipeline_);
-    audio_pipeline_wait_for_stop(this_speaker->pipeline_);
-    audio_pipeline_terminate(this_speaker->pipeline_);
+        this_speaker->events_.publish(AudioEvent::running(current));
+    }
 
-    event.type = TaskEventType::STOPPING;
-    xQueueSend(this_speaker->event_queue_, &event, portMAX_DELAY);
+    this_speaker->pipeline_.stop();
 
-    audio_pipeline_unregister(this_speaker->pipeline_, this_speaker->i2s_stream_writer_);
-    if (this_speaker->is_http_stream_) {
-        audio_pipeline_unregister(this_speaker->pipeline_, this_speaker->filter_);
-        audio_pipeline_unregister(this_speaker->pipeline_, this_speaker->http_stream_reader_);
-    } else {
-        audio_pipeline_unregister(this_speaker->pipeline_, this_speaker->raw_write_);
-    }
+    this_speaker->events_.publish(AudioEvent::of(AudioEventType::STOPPING), EventBus::WAIT_FOREVER);
 
-    audio_pipeline_deinit(this_speaker->pipeline_);
-    audio_element_deinit(this_speaker->i2s_stream_writer_);
-    if (this_speaker->is_http_stream_) {
-        audio_element_deinit(this_speaker->filter_);
-        audio_element_deinit(this_speaker->http_stream_reader_);
-    } else {
-        audio_element_deinit(this_speaker->raw_write_);
-    }
+    this_speaker->pipeline_.destroy();
 
-    event.type = TaskEventType::STOPPED;
-    xQueueSend(this_speaker->event_queue_, &event, portMAX_DELAY);
+    this_speaker->events_.publish(AudioEvent::of(AudioEventType::STOPPED), EventBus::WAIT_FOREVER);
     gpio_set_level(PA_ENABLE_GPIO, 0);
-
-    while (true) {
-        delay(10);
-    }
 }
 
 void ESPADFSpeaker::stop() {
+    if (this->url_pipeline_.is_built() && this->player_task_handle_ == nullptr) {
+        // URL playback, paused or not, has no player task to wind down
+        this->cleanup_audio_pipeline();
+        this->state_ = speaker::STATE_STOPPED;
+        return;
+    }
     if (this->state_ == speaker::STATE_STOPPED)
         return;
-    if (this->state_ == speaker::STATE_STARTING) {
+    if (this->state_ == speaker::STATE_STARTING && this->player_task_handle_ == nullptr) {
+        // Chunks queued while waiting for the codec never play
+        xQueueReset(this->buffer_queue_.handle);
+        this->accepted_position_ = 0;
         this->cleanup_audio_pipeline();
+        this->parent_->get_arbiter()->release(&this->resource_client_);
         this->state_ = speaker::STATE_STOPPED;
         return;
     }
     this->state_ = speaker::STATE_STOPPING;
-    DataEvent data;
+    DataEvent data{};
     data.stop = true;
     xQueueSendToFront(this->buffer_queue_.handle, &data, portMAX_DELAY);
 }
 
-void ESPADFSpeaker::watch_() {
-    TaskEvent event;
-    if (xQueueReceive(this->event_queue_, &event, 0) == pdTRUE) {
-        switch (event.type) {
-            case TaskEventType::STARTING:
-            case TaskEventType::STOPPING:
-                break;
-            case TaskEventType::STARTED:
-                this->state_ = speaker::STATE_RUNNING;
-                break;
-            case TaskEventType::RUNNING:
-                this->status_clear_warning();
-                break;
-            case TaskEventType::STOPPED:
-                this->parent_->unlock();
-                this->state_ = speaker::STATE_STOPPED;
-                vTaskDelete(this->player_task_handle_);
-                this->player_task_handle_ = nullptr;
-                break;
-            case TaskEventType::WARNING:
-                ESP_LOGW(TAG, "Error writing to pipeline: %s", esp_err_to_name(event.err));
-                this->status_set_warning();
-                break;
+void ESPADFSpeaker::handle_event_(const audio_utils::AudioEvent &event) {
+    switch (event.type) {
+        case AudioEventType::STARTING:
+        case AudioEventType::STOPPING:
+            break;
+        case AudioEventType::STARTED:
+            this->state_ = speaker::STATE_RUNNING;
+            break;
+        case AudioEventType::RUNNING:
+            this->status_clear_warning();
+            break;
+        case AudioEventType::STOPPED:
+            if (this->latency_tuner_.get_session_underruns() > 0)
+                ESP_LOGD(TAG, "%u underruns during playback", (unsigned) this->latency_tuner_.get_session_underruns());
+            if (this->latency_tuner_.end_session()) {
+                ESP_LOGI(TAG, "Growing output buffers to the %s profile",
+                         audio_utils::latency_profile_to_string(this->latency_tuner_.get_profile()));
+            }
+            this->state_ = speaker::STATE_STOPPED;
+            // The task deletes itself on return; start_() reuses its memory once that is done
+            this->player_task_handle_ = nullptr;
+            // Not on start: play() may already have queued the next session's first chunks
+            this->accepted_position_ = 0;
+            this->parent_->get_arbiter()->release(&this->resource_client_);
+            break;
+        case AudioEventType::WARNING:
+            ESP_LOGW(TAG, "Error writing to pipeline: %s", esp_err_to_name(event.error));
+            this->status_set_warning();
+            break;
+    }
+}
+
+bool ESPADFSpeaker::has_ducking_() const {
+#ifdef USE_MICROPHONE
+    return !this->ducking_microphones_.empty();
+#else
+    return false;
+#endif
+}
+
+void ESPADFSpeaker::update_ducking_() {
+#ifdef USE_MICROPHONE
+    if (!this->has_ducking_())
+        return;
+
+    bool ducking = false;
+    for (auto *microphone : this->ducking_microphones_) {
+        if (microphone->is_running()) {
+            ducking = true;
+            break;
+        }
+    }
+    if (ducking != this->ducking_) {
+        ESP_LOGD(TAG, ducking ? "Microphone active, ducking output by %.1f dB" : "Microphone idle, restoring output",
+                 -this->ducking_level_db_);
+        this->ducking_ = ducking;
+        float target = ducking ? this->ducking_level_db_ : 0.0f;
+        this->ducking_ramp_.set_target_db(target);
+        this->alc_ramp_.set_target_db(target);
+    }
+
+    // The ALC only takes whole dB, so the play_url path follows the ramp in 1 dB steps
+    int64_t now = esp_timer_get_time();
+    audio_element_handle_t url_writer = this->url_pipeline_.get_element(PipelineElementType::I2S_STREAM);
+    if (this->last_ducking_update_us_ != 0 && url_writer != nullptr) {
+        this->alc_ramp_.advance((now - this->last_ducking_update_us_) * SAMPLE_RATE / 1000000);
+        int volume_db = static_cast<int>(lroundf(this->alc_ramp_.get_gain_db()));
+        if (volume_db != this->alc_volume_db_) {
+            i2s_alc_volume_set(url_writer, volume_db);
+            this->alc_volume_db_ = volume_db;
         }
     }
+    this->last_ducking_update_us_ = now;
+#endif
 }
 
 void ESPADFSpeaker::loop() {
-    this->watch_();
+    audio_utils::EventBus::get().dispatch();
+    if (uint32_t dropped = this->events_.take_new_drops())
+        ESP_LOGW(TAG, "%u player task events dropped, the event bus was full", (unsigned) dropped);
+#ifdef USE_ESP_ADF_ADC_LADDER
+    this->sample_buttons_();
+#endif
+    this->buttons_.process();
+#ifdef USE_ESP_ADF_PIPELINE_HTTP_STREAM
+    this->report_url_fetch_();
+    HttpClientPool::get().expire();
+#endif
+
+    this->update_ducking_();
+    this->follow_url_schedule_();
     switch (this->state_) {
         case speaker::STATE_STARTING:
-            this->start_();
+            if (!this->url_pending_)
+                this->start_();
             break;
         case speaker::STATE_RUNNING:
         case speaker::STATE_STOPPING:
@@ -751,26 +922,39 @@ size_t ESPADFSpeaker::play(const uint8_t *data, size_t length) {
         ESP_LOGE(TAG, "Failed to play audio, speaker is in failed state.");
         return 0;
     }
+    if (this->url_pipeline_.is_built() && this->player_task_handle_ == nullptr) {
+        // Raw audio takes the codec over from a URL stream, playing or paused
+        this->cleanup_audio_pipeline();
+        this->state_ = speaker::STATE_STOPPED;
+    }
     if (this->state_ != speaker::STATE_RUNNING && this->state_ != speaker::STATE_STARTING) {
         this->start();
     }
     size_t remaining = length;
     size_t index = 0;
-    while (remaining > 0) {
+    while (remaining > 0 && uxQueueMessagesWaiting(this->buffer_queue_.handle) < this->queue_limit_) {
         DataEvent event;
         event.stop = false;
         size_t to_send_length = std::min(remaining, BUFFER_SIZE);
         event.len = to_send_length;
         memcpy(event.data, data + index, to_send_length);
-        if (xQueueSend(this->buffer_queue_.handle, &event, 0) != pdTRUE) {
-            return index;
-        }
+        if (xQueueSend(this->buffer_queue_.handle, &event, 0) != pdTRUE)
+            break;
         remaining -= to_send_length;
         index += to_send_length;
     }
+    this->accepted_position_ += index / StreamFormat::FRAME_SIZE;
     return index;
 }
 
+size_t ESPADFSpeaker::play(const uint8_t *data, size_t length, int64_t *presentation_time_us) {
+    uint64_t position = this->accepted_position_;
+    size_t accepted = this->play(data, length);
+    if (presentation_time_us != nullptr)
+        *presentation_time_us = this->sample_clock_.time_of(position);
+    return accepted;
+}
+
 bool ESPADFSpeaker::has_buffered_data() const { return uxQueueMessagesWaiting(this->buffer_queue_.handle) > 0; }
 
 }  // namespace esp_adf
@@ -3,6 +3,12 @@
 #ifdef USE_ESP_IDF
 
 #include "../esp_adf.h"
+#include "../pipeline_builder.h"
+#ifdef USE_ESP_ADF_PIPELINE_HTTP_STREAM
+#include "../http_client_pool.h"
+#endif
+#include "../include/memory_utils.h"
+#include "../include/session_arena.h"
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/queue.h>
@@ -11,6 +17,16 @@
 #include "esphome/core/component.h"
 #include "esphome/core/helpers.h"
 #include "esphome/components/sensor/sensor.h"
+#ifdef USE_MICROPHONE
+#include "esphome/components/microphone/microphone.h"
+#endif
+#include "esphome/components/audio_utils/drift_controller.h"
+#include "esphome/components/audio_utils/gain_ramp.h"
+#include "esphome/components/audio_utils/latency_tuner.h"
+#include "esphome/components/audio_utils/pcm_format.h"
+#include "esphome/components/audio_utils/resource_arbiter.h"
+#include "esphome/components/audio_utils/sample_clock.h"
+#include "esphome/components/audio_utils/shared_clock.h"
 
 #include <audio_element.h>
 #include <audio_pipeline.h>
@@ -20,9 +36,14 @@
 #include "input_key_service.h"
 #include <board.h>
 
-//#include "button/esp_adf_button.h"
+#include "../button_handler.h"
+#ifdef USE_ESP_ADF_ADC_LADDER
+#include "../adc_ladder.h"
+#include <driver/adc.h>
+#endif
 
 #include <esp_event.h>  
+#include <vector>
 
 namespace esphome {
 namespace esp_adf {
@@ -33,14 +54,60 @@ class ESPADFSpeaker : public ESPADFPipeline, public speaker::Speaker, public Com
 
   void setup() override;
   void loop() override;
+  void dump_config() override;
 
   void start() override;
   void stop() override;
 
   size_t play(const uint8_t *data, size_t length) override;
+  /// Like play(), additionally estimating when the first accepted sample reaches the I2S pins.
+  size_t play(const uint8_t *data, size_t length, int64_t *presentation_time_us);
+
+  const audio_utils::SampleClock &get_sample_clock() const { return this->sample_clock_; }
 
   bool has_buffered_data() const override;
 
+  /// Pipeline behind play(), raw PCM in.
+  PipelineBuilder &get_pipeline() { return this->pipeline_; }
+  /// Pipeline behind play_url(), fetches and decodes the stream itself.
+  PipelineBuilder &get_url_pipeline() { return this->url_pipeline_; }
+
+  /// Clock shared with the other rooms, for play_at(). Requires a resample filter in the URL pipeline.
+  void set_playback_clock(audio_utils::SharedClock *clock) { this->playback_clock_ = clock; }
+  /// Starts the next play_url() stream when the playback clock reaches `shared_time_us` and keeps it
+  /// on that schedule: small errors are steered out by trimming the resample filter's source rate,
+  /// large ones by skipping decoded audio or holding the I2S writer.
+  void play_at(int64_t shared_time_us);
+
+  void set_priority(audio_utils::ResourcePriority priority) { this->resource_client_.set_priority(priority); }
+
+  void set_latency_profile(audio_utils::LatencyProfile profile) { this->latency_tuner_.set_profile(profile); }
+  void set_auto_tune(bool auto_tune) { this->latency_tuner_.set_auto_tune(auto_tune); }
+  const audio_utils::LatencyTuner &get_latency_tuner() const { return this->latency_tuner_; }
+  /// Worst case time from play() until the sample reaches the pins with the current buffer plan.
+  uint32_t get_output_latency_us() const;
+
+#ifdef USE_MICROPHONE
+  /// Duck the output while any of these microphones is running.
+  void add_ducking_microphone(microphone::Microphone *microphone) { this->ducking_microphones_.push_back(microphone); }
+#endif
+  void set_ducking_level(float level_db) { this->ducking_level_db_ = level_db; }
+  void set_ducking_attack(uint32_t attack_ms) {
+    this->ducking_ramp_.set_attack_ms(attack_ms);
+    this->alc_ramp_.set_attack_ms(attack_ms);
+  }
+  void set_ducking_release(uint32_t release_ms) {
+    this->ducking_ramp_.set_release_ms(release_ms);
+    this->alc_ramp_.set_release_ms(release_ms);
+  }
+
+#ifdef USE_ESP_ADF_ADC_LADDER
+  /// Decode the board keys from this ADC1 channel on the main loop instead of starting the ADF
+  /// peripheral set and input key service.
+  void set_button_ladder_channel(adc1_channel_t channel) { this->ladder_channel_ = channel; }
+  AdcLadderDecoder &get_button_ladder() { return this->ladder_; }
+#endif
+
   // Declare methods for volume control
   void set_volume(int volume);
   void volume_up();
@@ -51,12 +118,9 @@ class ESPADFSpeaker : public ESPADFPipeline, public speaker::Speaker, public Com
   // Declare a sensor for volume level
   sensor::Sensor *volume_sensor = nullptr;
 
-  // Method to initialize pipeline and cleanup
-  void initialize_audio_pipeline();
   void cleanup_audio_pipeline();
 
   // Declare methods for media/http streaming
-  static esp_err_t input_key_service_cb(periph_service_handle_t handle, periph_service_event_t *evt, void *ctx);
   void handle_set_button();
   void handle_play_button();
   void handle_mode_button();
@@ -68,30 +132,101 @@ class ESPADFSpeaker : public ESPADFPipeline, public speaker::Speaker, public Com
 
   protected:
    void start_();
-   void watch_();
- 
+   /// Runs the URL pipeline once the codec is ours.
+   void start_url_();
+   void handle_event_(const audio_utils::AudioEvent &event);
+   /// Measures how far a scheduled URL stream is off its start time and steers it back, from loop().
+   void follow_url_schedule_();
+   /// Pauses the URL pipeline's I2S writer until `local_us`; its DMA plays out, then silence.
+   void hold_url_writer_(int64_t local_us);
+   /// Sets the resample filter's source rate `trim_ppm` above the stream's nominal rate.
+   void trim_url_rate_(float trim_ppm);
+   /// Back to the nominal rate, with the schedule's statistics logged.
+   void end_url_schedule_();
+   void apply_buffer_plan_();
+   bool has_ducking_() const;
+   void update_ducking_();
+   /// Element settings sized by the current buffer plan.
+   PipelineContext pipeline_context_(bool use_alc) const;
+
    static void player_task(void *params);
    static void button_event_handler(void *handler_args, esp_event_base_t base, int32_t id, void *event_data);
-   void handle_button_event(int32_t id, int32_t event_type);
+   void handle_button_(int32_t id);
+#ifdef USE_ESP_ADF_ADC_LADDER
+   void sample_buttons_();
+#endif
+#ifdef USE_ESP_ADF_PIPELINE_HTTP_STREAM
+   /// Logs the time to first byte of the current URL fetch once it is known.
+   void report_url_fetch_();
+   /// Hands the URL pipeline's connection back to the pool, after the pipeline is destroyed.
+   void release_url_connection_();
+#endif
    
   TaskHandle_t player_task_handle_{nullptr};
+  SessionArena session_arena_{MemoryTag::SPEAKER};  // player task stack and control block
   struct {
     QueueHandle_t handle;
     uint8_t *storage;
   } buffer_queue_;
-  QueueHandle_t event_queue_;
+  audio_utils::EventSubscriber events_{"esp_adf_speaker"};
+  ButtonHandler buttons_;  // fed by the input key service or the ladder decoder, drained in loop()
+#ifdef USE_ESP_ADF_ADC_LADDER
+  AdcLadderDecoder ladder_;
+  adc1_channel_t ladder_channel_{ADC1_CHANNEL_MAX};
+  uint32_t last_ladder_sample_ms_{0};
+#endif
+
+  audio_utils::SampleClock sample_clock_;
+  uint64_t accepted_position_{0};  // frames accepted by play(), main loop only
+
+  audio_utils::LatencyTuner latency_tuner_;
+  audio_utils::ResourceClient resource_client_{"esp_adf_speaker", audio_utils::ResourcePriority::MEDIA};
+  audio_utils::BufferPlan plan_{audio_utils::get_buffer_plan(audio_utils::LatencyProfile::ROBUST)};
+  size_t queue_limit_{0};  // chunks play() may queue, set per session
+
+#ifdef USE_MICROPHONE
+  std::vector<microphone::Microphone *> ducking_microphones_;
+#endif
+  float ducking_level_db_{-20.0f};
+  bool ducking_{false};
+  audio_utils::GainRamp ducking_ramp_;  // raw path, applied by the player task
+  audio_utils::GainRamp alc_ramp_;      // play_url path, stepped from the main loop into the i2s_stream ALC
+  int alc_volume_db_{0};
+  int64_t last_ducking_update_us_{0};
+
+  PipelineBuilder pipeline_;      // built and destroyed by the player task
+  PipelineBuilder url_pipeline_;  // built by play_url(), destroyed in cleanup_audio_pipeline()
+  bool url_pending_{false};       // the URL pipeline waits for the codec, no player task is started
+  bool url_paused_{false};        // media_pause() holds the URL pipeline, and the codec with it
+
+  audio_utils::SharedClock *playback_clock_{nullptr};
+  bool start_pending_{false};  // the next play_url() stream starts at pending_start_us_
+  int64_t pending_start_us_{0};
+  // Scheduled URL stream, main loop only
+  bool url_scheduled_{false};
+  int64_t url_start_us_{0};        // shared time of the stream's first frame
+  int64_t url_hold_until_us_{0};   // local time the paused I2S writer resumes at, 0 when it runs
+  int64_t url_written_frames_{0};  // frames the I2S writer has handed to the DMA
+  int64_t url_origin_us_{0};       // local time the first of them played, from the earliest hand-over seen
+  bool url_anchored_{false};
+  bool url_aligned_{false};        // the stream has been lined up with its start time
+  double url_position_us_{0.0};    // stream time of the next frame it takes
+  uint64_t url_skip_frames_{0};    // output frames still to drop to catch up
+  int url_nominal_rate_{0};        // the resample filter's configured source rate, 0 without one
+  int url_rate_{0};                // and the rate it runs at now
+  int64_t url_window_start_us_{0};
+  int64_t url_window_origin_us_{0};  // earliest origin seen in the current window
+  bool url_window_valid_{false};
+  int64_t url_last_update_us_{0};
+  audio_utils::DriftController url_drift_;
+  int64_t sync_max_error_us_{0};
+  uint32_t sync_realigns_{0};
+#ifdef USE_ESP_ADF_PIPELINE_HTTP_STREAM
+  HttpConnection *url_connection_{nullptr};  // lent to the URL pipeline's source while it is built
+  bool url_fetch_reported_{false};
+#endif
   private:
    int volume_ = 50;  // Default volume level
-   bool is_http_stream_;
-   audio_pipeline_handle_t pipeline_;
-   audio_element_handle_t i2s_stream_writer_;
-   audio_element_handle_t i2s_stream_writer_http_;
-   audio_element_handle_t i2s_stream_writer_raw_;
-   audio_element_handle_t filter_;
-   audio_element_handle_t http_filter_;
-   audio_element_handle_t raw_write_;
-   audio_element_handle_t http_stream_reader_;
-   
 };
 
 }  // namespace esp_adf
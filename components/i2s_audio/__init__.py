@@ -14,6 +14,7 @@ from esphome.components.esp32.const import (
 
 CODEOWNERS = ["@jesserockz"]
 DEPENDENCIES = ["esp32"]
+AUTO_LOAD = ["audio_utils"]
 MULTI_CONF = True
 
 CONF_I2S_DOUT_PIN = "i2s_dout_pin"
@@ -5,6 +5,7 @@
 #include <driver/i2s.h>
 #include "esphome/core/component.h"
 #include "esphome/core/helpers.h"
+#include "esphome/components/audio_utils/resource_arbiter.h"
 
 namespace esphome {
 namespace i2s_audio {
@@ -33,14 +34,13 @@ class I2SAudioComponent : public Component {
   void set_bclk_pin(int pin) { this->bclk_pin_ = pin; }
   void set_lrclk_pin(int pin) { this->lrclk_pin_ = pin; }
 
-  void lock() { this->lock_.lock(); }
-  bool try_lock() { return this->lock_.try_lock(); }
-  void unlock() { this->lock_.unlock(); }
+  /// Decides which of the speaker, microphone and media player owns the port.
+  audio_utils::ResourceArbiter *get_arbiter() { return &this->arbiter_; }
 
   i2s_port_t get_port() const { return this->port_; }
 
  protected:
-  Mutex lock_;
+  audio_utils::ResourceArbiter arbiter_{"i2s_audio"};
 
   I2SAudioIn *audio_in_{nullptr};
   I2SAudioOut *audio_out_{nullptr};
@@ -1,5 +1,6 @@
 import esphome.codegen as cg
 from esphome.components import media_player, esp32
+from esphome.components.audio_utils import CONF_PRIORITY, resource_priority_schema
 import esphome.config_validation as cv
 
 from esphome import pins
@@ -15,6 +16,7 @@ from .. import (
 )
 
 CODEOWNERS = ["@jesserockz"]
+AUTO_LOAD = ["audio_utils"]
 DEPENDENCIES = ["i2s_audio"]
 
 I2SAudioMediaPlayer = i2s_audio_ns.class_(
@@ -60,7 +62,9 @@ CONFIG_SCHEMA = cv.All(
                     cv.GenerateID(CONF_I2S_AUDIO_ID): cv.use_id(I2SAudioComponent),
                     cv.Required(CONF_MODE): cv.enum(INTERNAL_DAC_OPTIONS, lower=True),
                 }
-            ).extend(cv.COMPONENT_SCHEMA),
+            )
+            .extend(resource_priority_schema("media"))
+            .extend(cv.COMPONENT_SCHEMA),
             "external": media_player.MEDIA_PLAYER_SCHEMA.extend(
                 {
                     cv.GenerateID(): cv.declare_id(I2SAudioMediaPlayer),
@@ -76,7 +80,9 @@ CONFIG_SCHEMA = cv.All(
                         *I2C_COMM_FMT_OPTIONS, lower=True
                     ),
                 }
-            ).extend(cv.COMPONENT_SCHEMA),
+            )
+            .extend(resource_priority_schema("media"))
+            .extend(cv.COMPONENT_SCHEMA),
         },
         key=CONF_DAC_TYPE,
     ),
@@ -91,6 +97,7 @@ async def to_code(config):
     await media_player.register_media_player(var, config)
 
     await cg.register_parented(var, config[CONF_I2S_AUDIO_ID])
+    cg.add(var.set_priority(config[CONF_PRIORITY]))
 
     if config[CONF_DAC_TYPE] == "internal":
         cg.add(var.set_internal_dac_mode(config[CONF_MODE]))
@@ -122,6 +122,14 @@ void I2SAudioMediaPlayer::set_volume_(float volume, bool publish) {
 void I2SAudioMediaPlayer::setup() {
   ESP_LOGCONFIG(TAG, "Setting up Audio...");
   this->state = media_player::MEDIA_PLAYER_STATE_IDLE;
+  this->resource_client_.set_grant_callback([this]() {
+    if (this->i2s_state_ == I2S_STATE_STARTING)
+      this->start_();
+  });
+  this->resource_client_.set_preempt_callback([this]() {
+    ESP_LOGD(TAG, "Stopping for a higher priority user of the I2S port");
+    this->stop();
+  });
 }
 
 void I2SAudioMediaPlayer::loop() {
@@ -151,8 +159,10 @@ void I2SAudioMediaPlayer::play_() {
 
 void I2SAudioMediaPlayer::start() { this->i2s_state_ = I2S_STATE_STARTING; }
 void I2SAudioMediaPlayer::start_() {
-  if (!this->parent_->try_lock()) {
-    return;  // Waiting for another i2s to return lock
+  this->resource_client_.set_priority(this->is_announcement_ ? audio_utils::ResourcePriority::ANNOUNCEMENT
+                                                             : this->priority_);
+  if (!this->parent_->get_arbiter()->request(&this->resource_client_)) {
+    return;  // Queued, the arbiter calls back once the port is free
   }
 
 #if SOC_I2S_SUPPORTS_DAC
@@ -193,6 +203,7 @@ void I2SAudioMediaPlayer::stop() {
     return;
   }
   if (this->i2s_state_ == I2S_STATE_STARTING) {
+    this->parent_->get_arbiter()->release(&this->resource_client_);
     this->i2s_state_ = I2S_STATE_STOPPED;
     return;
   }
@@ -206,13 +217,13 @@ void I2SAudioMediaPlayer::stop_() {
 
   this->audio_ = nullptr;
   this->current_url_ = {};
-  this->parent_->unlock();
   this->i2s_state_ = I2S_STATE_STOPPED;
 
   this->high_freq_.stop();
   this->state = media_player::MEDIA_PLAYER_STATE_IDLE;
   this->publish_state();
   this->is_announcement_ = false;
+  this->parent_->get_arbiter()->release(&this->resource_client_);
 }
 
 media_player::MediaPlayerTraits I2SAudioMediaPlayer::get_traits() {
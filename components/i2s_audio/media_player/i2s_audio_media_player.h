@@ -6,6 +6,7 @@
 
 #include <driver/i2s.h>
 
+#include "esphome/components/audio_utils/resource_arbiter.h"
 #include "esphome/components/media_player/media_player.h"
 #include "esphome/core/component.h"
 #include "esphome/core/gpio.h"
@@ -41,6 +42,9 @@ class I2SAudioMediaPlayer : public Component, public media_player::MediaPlayer,
 
   void set_i2s_comm_fmt_lsb(bool lsb) { this->i2s_comm_fmt_lsb_ = lsb; }
 
+  /// Priority for media; announcements always use ResourcePriority::ANNOUNCEMENT.
+  void set_priority(audio_utils::ResourcePriority priority) { this->priority_ = priority; }
+
   media_player::MediaPlayerTraits get_traits() override;
 
   bool is_muted() const override { return this->muted_; }
@@ -60,6 +64,8 @@ class I2SAudioMediaPlayer : public Component, public media_player::MediaPlayer,
   void play_();
 
   I2SState i2s_state_{I2S_STATE_STOPPED};
+  audio_utils::ResourcePriority priority_{audio_utils::ResourcePriority::MEDIA};
+  audio_utils::ResourceClient resource_client_{"i2s_media_player", audio_utils::ResourcePriority::MEDIA};
   std::unique_ptr<Audio> audio_;
 
   uint8_t dout_pin_{0};
@@ -5,6 +5,7 @@ from esphome import pins
 from esphome.const import CONF_CHANNEL, CONF_ID, CONF_NUMBER
 from esphome.components import microphone, esp32
 from esphome.components.adc import ESP32_VARIANT_ADC1_PIN_TO_CHANNEL, validate_adc_pin
+from esphome.components.audio_utils import CONF_PRIORITY, resource_priority_schema
 
 from .. import (
     i2s_audio_ns,
@@ -15,6 +16,7 @@ from .. import (
 )
 
 CODEOWNERS = ["@jesserockz"]
+AUTO_LOAD = ["audio_utils"]
 DEPENDENCIES = ["i2s_audio"]
 
 CONF_ADC_PIN = "adc_pin"
@@ -59,18 +61,22 @@ def validate_esp32_variant(config):
     raise NotImplementedError
 
 
-BASE_SCHEMA = microphone.MICROPHONE_SCHEMA.extend(
-    {
-        cv.GenerateID(): cv.declare_id(I2SAudioMicrophone),
-        cv.GenerateID(CONF_I2S_AUDIO_ID): cv.use_id(I2SAudioComponent),
-        cv.Optional(CONF_CHANNEL, default="right"): cv.enum(CHANNELS),
-        cv.Optional(CONF_SAMPLE_RATE, default=16000): cv.int_range(min=1),
-        cv.Optional(CONF_BITS_PER_SAMPLE, default="32bit"): cv.All(
-            _validate_bits, cv.enum(BITS_PER_SAMPLE)
-        ),
-        cv.Optional(CONF_USE_APLL, default=False): cv.boolean,
-    }
-).extend(cv.COMPONENT_SCHEMA)
+BASE_SCHEMA = (
+    microphone.MICROPHONE_SCHEMA.extend(
+        {
+            cv.GenerateID(): cv.declare_id(I2SAudioMicrophone),
+            cv.GenerateID(CONF_I2S_AUDIO_ID): cv.use_id(I2SAudioComponent),
+            cv.Optional(CONF_CHANNEL, default="right"): cv.enum(CHANNELS),
+            cv.Optional(CONF_SAMPLE_RATE, default=16000): cv.int_range(min=1),
+            cv.Optional(CONF_BITS_PER_SAMPLE, default="32bit"): cv.All(
+                _validate_bits, cv.enum(BITS_PER_SAMPLE)
+            ),
+            cv.Optional(CONF_USE_APLL, default=False): cv.boolean,
+        }
+    )
+    .extend(resource_priority_schema("voice_capture"))
+    .extend(cv.COMPONENT_SCHEMA)
+)
 
 CONFIG_SCHEMA = cv.All(
     cv.typed_schema(
@@ -111,6 +117,9 @@ async def to_code(config):
     cg.add(var.set_channel(config[CONF_CHANNEL]))
     cg.add(var.set_sample_rate(config[CONF_SAMPLE_RATE]))
     cg.add(var.set_bits_per_sample(config[CONF_BITS_PER_SAMPLE]))
+    if config[CONF_BITS_PER_SAMPLE] == 32:
+        cg.add_define("USE_I2S_AUDIO_MICROPHONE_32BIT")
     cg.add(var.set_use_apll(config[CONF_USE_APLL]))
+    cg.add(var.set_priority(config[CONF_PRIORITY]))
 
     await microphone.register_microphone(var, config)
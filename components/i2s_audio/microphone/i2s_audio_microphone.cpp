@@ -3,6 +3,7 @@
 #ifdef USE_ESP32
 
 #include <driver/i2s.h>
+#include <esp_timer.h>
 
 #include "esphome/core/hal.h"
 #include "esphome/core/log.h"
@@ -11,11 +12,32 @@ namespace esphome {
 namespace i2s_audio {
 
 static const size_t BUFFER_SIZE = 512;
+static const int DMA_BUFFER_COUNT = 4;
+static const int DMA_BUFFER_LENGTH = 256;
 
 static const char *const TAG = "i2s_audio.microphone";
 
 void I2SAudioMicrophone::setup() {
   ESP_LOGCONFIG(TAG, "Setting up I2S Audio Microphone...");
+  if (this->bits_per_sample_ == I2S_BITS_PER_SAMPLE_32BIT) {
+#ifdef USE_I2S_AUDIO_MICROPHONE_32BIT
+    // Samples sit in the upper 30 bits of the slot: 2 bits of gain, converted in place
+    this->convert_ = &audio_utils::FormatConverter<audio_utils::PcmFormat<audio_utils::Pcm32<2>, 1>,
+                                                   audio_utils::S16Mono>::convert;
+#endif
+  } else if (this->bits_per_sample_ != I2S_BITS_PER_SAMPLE_16BIT) {
+    ESP_LOGE(TAG, "Unsupported bits per sample: %d", this->bits_per_sample_);
+    this->mark_failed();
+    return;
+  }
+  this->resource_client_.set_grant_callback([this]() {
+    if (this->state_ == microphone::STATE_STARTING)
+      this->start_();
+  });
+  this->resource_client_.set_preempt_callback([this]() {
+    ESP_LOGD(TAG, "Stopping for a higher priority user of the I2S port");
+    this->stop();
+  });
 #if SOC_I2S_SUPPORTS_ADC
   if (this->adc_) {
     if (this->parent_->get_port() != I2S_NUM_0) {
@@ -42,8 +64,8 @@ void I2SAudioMicrophone::start() {
   this->state_ = microphone::STATE_STARTING;
 }
 void I2SAudioMicrophone::start_() {
-  if (!this->parent_->try_lock()) {
-    return;  // Waiting for another i2s to return lock
+  if (!this->parent_->get_arbiter()->request(&this->resource_client_)) {
+    return;  // Queued, the arbiter calls back once the port is free
   }
   i2s_driver_config_t config = {
       .mode = (i2s_mode_t) (I2S_MODE_MASTER | I2S_MODE_RX),
@@ -52,8 +74,8 @@ void I2SAudioMicrophone::start_() {
       .channel_format = this->channel_,
       .communication_format = I2S_COMM_FORMAT_STAND_I2S,
       .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
-      .dma_buf_count = 4,
-      .dma_buf_len = 256,
+      .dma_buf_count = DMA_BUFFER_COUNT,
+      .dma_buf_len = DMA_BUFFER_LENGTH,
       .use_apll = this->use_apll_,
       .tx_desc_auto_clear = false,
       .fixed_mclk = 0,
@@ -66,7 +88,7 @@ void I2SAudioMicrophone::start_() {
 #if SOC_I2S_SUPPORTS_ADC
   if (this->adc_) {
     config.mode = (i2s_mode_t) (config.mode | I2S_MODE_ADC_BUILT_IN);
-    err = i2s_driver_install(this->parent_->get_port(), &config, 0, nullptr);
+    err = i2s_driver_install(this->parent_->get_port(), &config, DMA_BUFFER_COUNT * 2, &this->i2s_event_queue_);
     if (err != ESP_OK) {
       ESP_LOGW(TAG, "Error installing I2S driver: %s", esp_err_to_name(err));
       this->status_set_error();
@@ -92,7 +114,7 @@ void I2SAudioMicrophone::start_() {
     if (this->pdm_)
       config.mode = (i2s_mode_t) (config.mode | I2S_MODE_PDM);
 
-    err = i2s_driver_install(this->parent_->get_port(), &config, 0, nullptr);
+    err = i2s_driver_install(this->parent_->get_port(), &config, DMA_BUFFER_COUNT * 2, &this->i2s_event_queue_);
     if (err != ESP_OK) {
       ESP_LOGW(TAG, "Error installing I2S driver: %s", esp_err_to_name(err));
       this->status_set_error();
@@ -109,6 +131,9 @@ void I2SAudioMicrophone::start_() {
       return;
     }
   }
+  this->dma_position_ = 0;
+  this->read_position_ = 0;
+  this->sample_clock_.reset(this->sample_rate_, esp_timer_get_time());
   this->state_ = microphone::STATE_RUNNING;
   this->high_freq_.start();
   this->status_clear_error();
@@ -118,6 +143,7 @@ void I2SAudioMicrophone::stop() {
   if (this->state_ == microphone::STATE_STOPPED || this->is_failed())
     return;
   if (this->state_ == microphone::STATE_STARTING) {
+    this->parent_->get_arbiter()->release(&this->resource_client_);
     this->state_ = microphone::STATE_STOPPED;
     return;
   }
@@ -148,15 +174,43 @@ void I2SAudioMicrophone::stop_() {
     this->status_set_error();
     return;
   }
-  this->parent_->unlock();
+  this->i2s_event_queue_ = nullptr;  // deleted together with the driver
   this->state_ = microphone::STATE_STOPPED;
   this->high_freq_.stop();
   this->status_clear_error();
+  this->parent_->get_arbiter()->release(&this->resource_client_);
+}
+
+void I2SAudioMicrophone::process_i2s_events_() {
+  if (this->i2s_event_queue_ == nullptr)
+    return;
+  i2s_event_t event;
+  bool completed = false;
+  while (xQueueReceive(this->i2s_event_queue_, &event, 0) == pdTRUE) {
+    if (event.type == I2S_EVENT_RX_DONE) {
+      this->dma_position_ += DMA_BUFFER_LENGTH;
+      completed = true;
+    }
+  }
+  if (completed) {
+    // The driver does not timestamp its events, so the anchor is taken when they are serviced;
+    // read() blocks on the DMA, which keeps that close to the actual completion.
+    this->sample_clock_.update(this->dma_position_, esp_timer_get_time());
+  }
+}
+
+size_t I2SAudioMicrophone::read(int16_t *buf, size_t len, int64_t *capture_time_us) {
+  uint64_t position = this->read_position_;
+  size_t bytes = this->read(buf, len);
+  if (capture_time_us != nullptr)
+    *capture_time_us = this->sample_clock_.time_of(position);
+  return bytes;
 }
 
 size_t I2SAudioMicrophone::read(int16_t *buf, size_t len) {
   size_t bytes_read = 0;
   esp_err_t err = i2s_read(this->parent_->get_port(), buf, len, &bytes_read, (100 / portTICK_PERIOD_MS));
+  this->process_i2s_events_();
   if (err != ESP_OK) {
     ESP_LOGW(TAG, "Error reading from I2S microphone: %s", esp_err_to_name(err));
     this->status_set_warning();
@@ -167,28 +221,18 @@ size_t I2SAudioMicrophone::read(int16_t *buf, size_t len) {
     return 0;
   }
   this->status_clear_warning();
-  if (this->bits_per_sample_ == I2S_BITS_PER_SAMPLE_16BIT) {
-    return bytes_read;
-  } else if (this->bits_per_sample_ == I2S_BITS_PER_SAMPLE_32BIT) {
-    std::vector<int16_t> samples;
-    size_t samples_read = bytes_read / sizeof(int32_t);
-    samples.resize(samples_read);
-    for (size_t i = 0; i < samples_read; i++) {
-      int32_t temp = reinterpret_cast<int32_t *>(buf)[i] >> 14;
-      samples[i] = clamp<int16_t>(temp, INT16_MIN, INT16_MAX);
-    }
-    memcpy(buf, samples.data(), samples_read * sizeof(int16_t));
-    return samples_read * sizeof(int16_t);
-  } else {
-    ESP_LOGE(TAG, "Unsupported bits per sample: %d", this->bits_per_sample_);
-    return 0;
-  }
+  size_t samples_read = bytes_read / (this->bits_per_sample_ / 8);
+  this->read_position_ += samples_read;
+  if (this->convert_ == nullptr)
+    return bytes_read;  // 16-bit slots are already the output format
+  uint8_t *data = reinterpret_cast<uint8_t *>(buf);
+  return this->convert_(data, data, samples_read);
 }
 
 void I2SAudioMicrophone::read_() {
   std::vector<int16_t> samples;
   samples.resize(BUFFER_SIZE);
-  size_t bytes_read = this->read(samples.data(), BUFFER_SIZE / sizeof(int16_t));
+  size_t bytes_read = this->read(samples.data(), BUFFER_SIZE / sizeof(int16_t), &this->last_capture_time_us_);
   samples.resize(bytes_read / sizeof(int16_t));
   this->data_callbacks_.call(samples);
 }
@@ -4,9 +4,15 @@
 
 #include "../i2s_audio.h"
 
+#include "esphome/components/audio_utils/pcm_format.h"
+#include "esphome/components/audio_utils/resource_arbiter.h"
+#include "esphome/components/audio_utils/sample_clock.h"
 #include "esphome/components/microphone/microphone.h"
 #include "esphome/core/component.h"
 
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
 namespace esphome {
 namespace i2s_audio {
 
@@ -22,6 +28,12 @@ class I2SAudioMicrophone : public I2SAudioIn, public microphone::Microphone, pub
   void set_pdm(bool pdm) { this->pdm_ = pdm; }
 
   size_t read(int16_t *buf, size_t len) override;
+  /// Like read(), additionally reporting when the first returned sample was captured.
+  size_t read(int16_t *buf, size_t len, int64_t *capture_time_us);
+
+  /// Capture time of the first sample of the block most recently handed to the data callbacks.
+  int64_t get_last_capture_time_us() const { return this->last_capture_time_us_; }
+  const audio_utils::SampleClock &get_sample_clock() const { return this->sample_clock_; }
 
 #if SOC_I2S_SUPPORTS_ADC
   void set_adc_channel(adc1_channel_t channel) {
@@ -34,11 +46,15 @@ class I2SAudioMicrophone : public I2SAudioIn, public microphone::Microphone, pub
   void set_sample_rate(uint32_t sample_rate) { this->sample_rate_ = sample_rate; }
   void set_bits_per_sample(i2s_bits_per_sample_t bits_per_sample) { this->bits_per_sample_ = bits_per_sample; }
   void set_use_apll(uint32_t use_apll) { this->use_apll_ = use_apll; }
+  void set_priority(audio_utils::ResourcePriority priority) { this->resource_client_.set_priority(priority); }
 
  protected:
   void start_();
   void stop_();
   void read_();
+  void process_i2s_events_();
+
+  audio_utils::ResourceClient resource_client_{"i2s_microphone", audio_utils::ResourcePriority::VOICE_CAPTURE};
 
   int8_t din_pin_{I2S_PIN_NO_CHANGE};
 #if SOC_I2S_SUPPORTS_ADC
@@ -49,8 +65,15 @@ class I2SAudioMicrophone : public I2SAudioIn, public microphone::Microphone, pub
   i2s_channel_fmt_t channel_;
   uint32_t sample_rate_;
   i2s_bits_per_sample_t bits_per_sample_;
+  audio_utils::FormatConvertFn convert_{nullptr};  // slots to 16-bit samples, nullptr for 16-bit slots
   bool use_apll_;
 
+  QueueHandle_t i2s_event_queue_{nullptr};
+  audio_utils::SampleClock sample_clock_;
+  uint64_t dma_position_{0};   // frames completed by the DMA
+  uint64_t read_position_{0};  // frames handed out by read()
+  int64_t last_capture_time_us_{0};
+
   HighFrequencyLoopRequester high_freq_;
 };
 
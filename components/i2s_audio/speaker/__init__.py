@@ -3,6 +3,23 @@ import esphome.config_validation as cv
 from esphome import pins
 from esphome.const import CONF_ID, CONF_MODE
 from esphome.components import esp32, speaker
+from esphome.components.audio_utils import (
+    CONF_AUTO_TUNE,
+    CONF_LATENCY_PROFILE,
+    DUCKING_SCHEMA,
+    CONF_PLAYBACK_CLOCK,
+    CONF_PRIORITY,
+    CONF_RESAMPLE_QUALITY,
+    CONF_STREAM_FORMATS,
+    LATENCY_SCHEMA,
+    PLAYBACK_CLOCK_SCHEMA,
+    RESAMPLE_SCHEMA,
+    STREAM_FORMATS_SCHEMA,
+    add_stream_format_defines,
+    ducking_to_code,
+    resource_priority_schema,
+    validate_playback_clock,
+)
 
 from .. import (
     CONF_I2S_AUDIO_ID,
@@ -13,6 +30,7 @@ from .. import (
 )
 
 CODEOWNERS = ["@jesserockz"]
+AUTO_LOAD = ["audio_utils"]
 DEPENDENCIES = ["i2s_audio"]
 
 I2SAudioSpeaker = i2s_audio_ns.class_(
@@ -23,6 +41,8 @@ i2s_dac_mode_t = cg.global_ns.enum("i2s_dac_mode_t")
 
 CONF_MUTE_PIN = "mute_pin"
 CONF_DAC_TYPE = "dac_type"
+CONF_SAMPLE_RATE = "sample_rate"
+CONF_BITS_PER_SAMPLE = "bits_per_sample"
 
 INTERNAL_DAC_OPTIONS = {
     "left": i2s_dac_mode_t.I2S_DAC_CHANNEL_LEFT_EN,
@@ -34,6 +54,8 @@ EXTERNAL_DAC_OPTIONS = ["mono", "stereo"]
 
 NO_INTERNAL_DAC_VARIANTS = [esp32.const.VARIANT_ESP32S2]
 
+_validate_bits = cv.float_with_unit("bits", "bit")
+
 
 def validate_esp32_variant(config):
     if config[CONF_DAC_TYPE] != "internal":
@@ -52,8 +74,18 @@ CONFIG_SCHEMA = cv.All(
                     cv.GenerateID(): cv.declare_id(I2SAudioSpeaker),
                     cv.GenerateID(CONF_I2S_AUDIO_ID): cv.use_id(I2SAudioComponent),
                     cv.Required(CONF_MODE): cv.enum(INTERNAL_DAC_OPTIONS, lower=True),
+                    cv.Optional(CONF_SAMPLE_RATE, default=16000): cv.int_range(
+                        min=8000, max=48000
+                    ),
                 }
-            ).extend(cv.COMPONENT_SCHEMA),
+            )
+            .extend(LATENCY_SCHEMA)
+            .extend(RESAMPLE_SCHEMA)
+            .extend(STREAM_FORMATS_SCHEMA)
+            .extend(PLAYBACK_CLOCK_SCHEMA)
+            .extend(DUCKING_SCHEMA)
+            .extend(resource_priority_schema("media"))
+            .extend(cv.COMPONENT_SCHEMA),
             "external": speaker.SPEAKER_SCHEMA.extend(
                 {
                     cv.GenerateID(): cv.declare_id(I2SAudioSpeaker),
@@ -64,12 +96,26 @@ CONFIG_SCHEMA = cv.All(
                     cv.Optional(CONF_MODE, default="mono"): cv.one_of(
                         *EXTERNAL_DAC_OPTIONS, lower=True
                     ),
+                    cv.Optional(CONF_SAMPLE_RATE, default=16000): cv.int_range(
+                        min=8000, max=192000
+                    ),
+                    cv.Optional(CONF_BITS_PER_SAMPLE, default="16bit"): cv.All(
+                        _validate_bits, cv.int_, cv.one_of(16, 24, 32)
+                    ),
                 }
-            ).extend(cv.COMPONENT_SCHEMA),
+            )
+            .extend(LATENCY_SCHEMA)
+            .extend(RESAMPLE_SCHEMA)
+            .extend(STREAM_FORMATS_SCHEMA)
+            .extend(PLAYBACK_CLOCK_SCHEMA)
+            .extend(DUCKING_SCHEMA)
+            .extend(resource_priority_schema("media"))
+            .extend(cv.COMPONENT_SCHEMA),
         },
         key=CONF_DAC_TYPE,
     ),
     validate_esp32_variant,
+    validate_playback_clock,
 )
 
 
@@ -80,8 +126,33 @@ async def to_code(config):
 
     await cg.register_parented(var, config[CONF_I2S_AUDIO_ID])
 
+    cg.add(var.set_sample_rate(config[CONF_SAMPLE_RATE]))
+    cg.add(var.set_latency_profile(config[CONF_LATENCY_PROFILE]))
+    cg.add(var.set_auto_tune(config[CONF_AUTO_TUNE]))
+    cg.add(var.set_priority(config[CONF_PRIORITY]))
+    if CONF_RESAMPLE_QUALITY in config:
+        cg.add(var.set_resample_quality(config[CONF_RESAMPLE_QUALITY]))
+    if CONF_PLAYBACK_CLOCK in config:
+        clock = await cg.get_variable(config[CONF_PLAYBACK_CLOCK])
+        cg.add(var.set_playback_clock(clock))
+    await ducking_to_code(var, config)
+
     if config[CONF_DAC_TYPE] == "internal":
         cg.add(var.set_internal_dac_mode(config[CONF_MODE]))
+        slot_bits, slot_channels = 16, 2
     else:
         cg.add(var.set_dout_pin(config[CONF_I2S_DOUT_PIN]))
         cg.add(var.set_external_dac_channels(2 if config[CONF_MODE] == "stereo" else 1))
+        cg.add(var.set_bits_per_sample(config[CONF_BITS_PER_SAMPLE]))
+        slot_bits = 16 if config[CONF_BITS_PER_SAMPLE] == 16 else 32
+        slot_channels = 2 if config[CONF_MODE] == "stereo" else 1
+
+    # Only the sample format converters for this port's slots get compiled in
+    layout = "STEREO" if slot_channels == 2 else "MONO"
+    cg.add_define(f"USE_I2S_AUDIO_SPEAKER_S{slot_bits}_{layout}")
+    add_stream_format_defines(config[CONF_STREAM_FORMATS])
+    if CONF_RESAMPLE_QUALITY in config:
+        cg.add_define("USE_I2S_AUDIO_SPEAKER_RESAMPLE")
+        cg.add_define(f"USE_I2S_AUDIO_SPEAKER_S16_{layout}")
+        # The resampler's 16-bit output goes through the stream converters to the slots
+        add_stream_format_defines(["s16"])
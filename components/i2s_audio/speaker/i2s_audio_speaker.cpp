@@ -3,6 +3,7 @@
 #ifdef USE_ESP32
 
 #include <driver/i2s.h>
+#include <esp_timer.h>
 
 #include "esphome/core/application.h"
 #include "esphome/core/hal.h"
@@ -12,9 +13,51 @@ namespace esphome {
 namespace i2s_audio {
 
 static const size_t BUFFER_COUNT = 20;
+static const int64_t MAX_START_LEAD_US = 10000000;  // how far ahead play_at() may schedule
 
 static const char *const TAG = "i2s_audio.speaker";
 
+using audio_utils::AudioEvent;
+using audio_utils::AudioEventType;
+using audio_utils::EventBus;
+
+/// Converter from `in` to the port's slots, right channel first. Only the slot formats the
+/// configuration uses are compiled in (USE_I2S_AUDIO_SPEAKER_S16_MONO and friends, from
+/// __init__.py), each carrying one inlined converter per supported stream format. Returns nullptr
+/// when none applies.
+static audio_utils::FormatConvertFn select_slot_converter(const audio_utils::AudioStreamInfo &in, uint8_t out_bits,
+                                                          uint8_t out_channels) {
+#ifdef USE_I2S_AUDIO_SPEAKER_S16_MONO
+  if (out_bits == 16 && out_channels == 1)
+    return audio_utils::select_format_converter<audio_utils::S16Mono>(in);
+#endif
+#ifdef USE_I2S_AUDIO_SPEAKER_S16_STEREO
+  if (out_bits == 16 && out_channels == 2)
+    return audio_utils::select_format_converter<audio_utils::S16StereoRightFirst>(in);
+#endif
+#ifdef USE_I2S_AUDIO_SPEAKER_S32_MONO
+  if (out_bits == 32 && out_channels == 1)
+    return audio_utils::select_format_converter<audio_utils::S32Mono>(in);
+#endif
+#ifdef USE_I2S_AUDIO_SPEAKER_S32_STEREO
+  if (out_bits == 32 && out_channels == 2)
+    return audio_utils::select_format_converter<audio_utils::S32StereoRightFirst>(in);
+#endif
+  return nullptr;
+}
+
+/// Converter from `in` to the resampler's 16-bit input, channels in stream order.
+static audio_utils::FormatConvertFn select_stage_converter(const audio_utils::AudioStreamInfo &in,
+                                                           uint8_t out_channels) {
+#ifdef USE_I2S_AUDIO_SPEAKER_RESAMPLE
+  if (out_channels == 1)
+    return audio_utils::select_format_converter<audio_utils::S16Mono>(in);
+  return audio_utils::select_format_converter<audio_utils::S16Stereo>(in);
+#else
+  return nullptr;
+#endif
+}
+
 void I2SAudioSpeaker::setup() {
   ESP_LOGCONFIG(TAG, "Setting up I2S Audio Speaker...");
 
@@ -25,12 +68,23 @@ void I2SAudioSpeaker::setup() {
     return;
   }
 
-  this->event_queue_ = xQueueCreate(BUFFER_COUNT, sizeof(TaskEvent));
-  if (this->event_queue_ == nullptr) {
-    ESP_LOGE(TAG, "Failed to create event queue");
-    this->mark_failed();
-    return;
-  }
+  this->events_.set_handler([this](const audio_utils::AudioEvent &event) { this->handle_event_(event); });
+
+  this->resource_client_.set_grant_callback([this]() {
+    if (this->state_ == speaker::STATE_STARTING)
+      this->start_();
+  });
+  this->resource_client_.set_preempt_callback([this]() {
+    ESP_LOGD(TAG, "Stopping for a higher priority user of the I2S port");
+    this->stop();
+  });
+
+  this->apply_buffer_plan_();
+}
+
+void I2SAudioSpeaker::apply_buffer_plan_() {
+  this->plan_ = this->latency_tuner_.get_plan();
+  this->queue_limit_ = std::min(BUFFER_COUNT, std::max<size_t>(2, this->plan_.ring_buffer_size / BUFFER_SIZE));
 }
 
 void I2SAudioSpeaker::start() {
@@ -48,10 +102,14 @@ void I2SAudioSpeaker::start_() {
   if (this->task_created_) {
     return;
   }
-  if (!this->parent_->try_lock()) {
-    return;  // Waiting for another i2s component to return lock
+  if (!this->parent_->get_arbiter()->request(&this->resource_client_)) {
+    return;  // Queued, the arbiter calls back once the port is free
   }
 
+  this->apply_buffer_plan_();
+  ESP_LOGD(TAG, "Latency profile %s: DMA %d x %d frames, output latency %u ms",
+           audio_utils::latency_profile_to_string(this->latency_tuner_.get_profile()), this->plan_.dma_buffer_count,
+           this->plan_.dma_buffer_length, this->get_output_latency_us() / 1000);
   xTaskCreate(I2SAudioSpeaker::player_task, "speaker_task", 8192, (void *) this, 1, &this->player_task_handle_);
   this->task_created_ = true;
 }
@@ -59,38 +117,38 @@ void I2SAudioSpeaker::start_() {
 void I2SAudioSpeaker::player_task(void *params) {
   I2SAudioSpeaker *this_speaker = (I2SAudioSpeaker *) params;
 
-  TaskEvent event;
-  event.type = TaskEventType::STARTING;
-  xQueueSend(this_speaker->event_queue_, &event, portMAX_DELAY);
+  this_speaker->events_.publish(AudioEvent::of(AudioEventType::STARTING), EventBus::WAIT_FOREVER);
+
+  // Output slots are 16 or 32 bits wide; 24-bit DACs read the upper bits of a 32-bit slot
+  const uint8_t out_bits = this_speaker->bits_per_sample_ == 16 ? 16 : 32;
+  const uint8_t out_channels = this_speaker->get_output_channels_();
 
   i2s_driver_config_t config = {
       .mode = (i2s_mode_t) (I2S_MODE_MASTER | I2S_MODE_TX),
-      .sample_rate = 16000,
-      .bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT,
-      .channel_format = I2S_CHANNEL_FMT_ONLY_LEFT,
+      .sample_rate = this_speaker->sample_rate_,
+      .bits_per_sample = (i2s_bits_per_sample_t) out_bits,
+      .channel_format = out_channels == 2 ? I2S_CHANNEL_FMT_RIGHT_LEFT : I2S_CHANNEL_FMT_ONLY_LEFT,
       .communication_format = I2S_COMM_FORMAT_STAND_I2S,
       .intr_alloc_flags = ESP_INTR_FLAG_LEVEL2 | ESP_INTR_FLAG_IRAM,
-      .dma_buf_count = 8,
-      .dma_buf_len = 1024,
+      .dma_buf_count = this_speaker->plan_.dma_buffer_count,
+      .dma_buf_len = this_speaker->plan_.dma_buffer_length,
       .use_apll = false,
       .tx_desc_auto_clear = true,
       .fixed_mclk = 0,
       .mclk_multiple = I2S_MCLK_MULTIPLE_256,
       .bits_per_chan = I2S_BITS_PER_CHAN_DEFAULT,
   };
-//#if SOC_I2S_SUPPORTS_DAC
-  //if (this_speaker->internal_dac_mode_ != I2S_DAC_CHANNEL_DISABLE) {
+#if SOC_I2S_SUPPORTS_DAC
+  if (this_speaker->internal_dac_mode_ != I2S_DAC_CHANNEL_DISABLE) {
     config.mode = (i2s_mode_t) (config.mode | I2S_MODE_DAC_BUILT_IN);
-  //}
-//#endif
+  }
+#endif
 
-  esp_err_t err = i2s_driver_install(this_speaker->parent_->get_port(), &config, 0, nullptr);
+  esp_err_t err = i2s_driver_install(this_speaker->parent_->get_port(), &config, this_speaker->plan_.dma_buffer_count * 2,
+                                     &this_speaker->i2s_event_queue_);
   if (err != ESP_OK) {
-    event.type = TaskEventType::WARNING;
-    event.err = err;
-    xQueueSend(this_speaker->event_queue_, &event, 0);
-    event.type = TaskEventType::STOPPED;
-    xQueueSend(this_speaker->event_queue_, &event, 0);
+    this_speaker->events_.publish(AudioEvent::warning(err));
+    this_speaker->events_.publish(AudioEvent::of(AudioEventType::STOPPED), EventBus::WAIT_FOREVER);
     while (true) {
       delay(10);
     }
@@ -109,137 +167,414 @@ void I2SAudioSpeaker::player_task(void *params) {
   }
 #endif
 
+  // Worst case expansion is 16-bit mono in, 32-bit stereo out
+  const size_t out_buffer_size = BUFFER_SIZE * 4;
+  ExternalRAMAllocator<uint8_t> allocator(ExternalRAMAllocator<uint8_t>::ALLOW_FAILURE);
+  uint8_t *out_buffer = allocator.allocate(out_buffer_size);
+
+  // While resampling, input is staged as 16-bit at the port's channel count and the resampler
+  // writes chunks that fill out_buffer once widened to the slot size
+  const size_t out_frame_size = out_bits / 8 * out_channels;
+  const size_t resample_chunk_frames = out_buffer_size / out_frame_size;
+  const size_t stage_size = BUFFER_SIZE * 2;
+  const size_t resampled_size = resample_chunk_frames * out_channels * sizeof(int16_t);
+  audio_utils::PolyphaseResampler<int16_t> resampler;
+  uint32_t resampler_rate = 0;
+  uint8_t *stage_buffer = nullptr;
+  uint8_t *resampled_buffer = nullptr;
+  if (this_speaker->resample_) {
+    stage_buffer = allocator.allocate(stage_size);
+    resampled_buffer = allocator.allocate(resampled_size);
+    if (stage_buffer == nullptr || resampled_buffer == nullptr) {
+      allocator.deallocate(out_buffer, out_buffer_size);
+      out_buffer = nullptr;
+    }
+  }
+  audio_utils::AudioStreamInfo resampled_info;
+  resampled_info.sample_rate = config.sample_rate;
+  resampled_info.channels = out_channels;
+  audio_utils::FormatConvertFn convert = nullptr;        // stream to slots
+  audio_utils::FormatConvertFn stage_convert = nullptr;  // stream to the resampler's input
+  audio_utils::FormatConvertFn resampled_convert =
+      this_speaker->resample_ ? select_slot_converter(resampled_info, out_bits, out_channels) : nullptr;
+
   DataEvent data_event;
+  audio_utils::AudioStreamInfo current_info;
+  current_info.sample_rate = config.sample_rate;
+
+  // Scheduled playback: stream frame n is due at sync_start_us + n / rate on the playback clock
+  const audio_utils::SharedClock *clock = this_speaker->playback_clock_;
+  audio_utils::DriftController drift;
+  bool synced = false;
+  bool aligned = false;         // the first frame has been lined up with its start time
+  int64_t sync_start_us = 0;
+  uint64_t sync_consumed = 0;   // stream frames taken since the start, skipped ones included
+  uint64_t skip_frames = 0;     // stream frames to drop to catch up
+  int64_t last_update_us = 0;
+  this_speaker->sync_max_error_us_ = 0;
+  this_speaker->sync_realigns_ = 0;
+
+  this_speaker->playout_.reset(this_speaker->plan_.dma_buffer_length, config.sample_rate, esp_timer_get_time());
+  if (out_buffer != nullptr)
+    this_speaker->sync_dma_();
+  this_speaker->ducking_ramp_.set_sample_rate(config.sample_rate);
+  this_speaker->ducking_ramp_.reset();
+
+  if (out_buffer != nullptr) {
+    this_speaker->events_.publish(AudioEvent::of(AudioEventType::STARTED), EventBus::WAIT_FOREVER);
+  } else {
+    this_speaker->events_.publish(AudioEvent::warning(ESP_ERR_NO_MEM), EventBus::WAIT_FOREVER);
+  }
 
-  event.type = TaskEventType::STARTED;
-  xQueueSend(this_speaker->event_queue_, &event, portMAX_DELAY);
+  // Ducks and writes frames already in the output format
+  auto write_frames = [&](size_t frames) {
+    if (!this_speaker->ducking_ramp_.is_unity()) {
+      if (out_bits == 16) {
+        this_speaker->ducking_ramp_.process(reinterpret_cast<int16_t *>(out_buffer), frames, out_channels);
+      } else {
+        this_speaker->ducking_ramp_.process(reinterpret_cast<int32_t *>(out_buffer), frames, out_channels);
+      }
+    }
 
-  int16_t buffer[BUFFER_SIZE / 2];
+    // Events still queued belong in front of these frames
+    this_speaker->process_i2s_events_(false);
 
-  while (true) {
-    if (xQueueReceive(this_speaker->buffer_queue_, &data_event, 100 / portTICK_PERIOD_MS) != pdTRUE) {
-      break;  // End of audio from main thread
+    const uint8_t *data = out_buffer;
+    size_t remaining = frames * out_frame_size;
+    size_t total_written = 0;
+    esp_err_t write_err = ESP_OK;
+    while (remaining > 0) {
+      // Never blocks in the driver: waiting for room happens on the event queue, where it times the DMA
+      size_t bytes_written = 0;
+      write_err = i2s_write(this_speaker->parent_->get_port(), data, remaining, &bytes_written, 0);
+      if (this_speaker->playout_.add_written(bytes_written / out_frame_size))
+        this_speaker->latency_tuner_.report_underrun();
+      data += bytes_written;
+      remaining -= bytes_written;
+      total_written += bytes_written;
+      if (remaining == 0 || (write_err != ESP_OK && write_err != ESP_ERR_TIMEOUT))
+        break;
+      if (!this_speaker->process_i2s_events_(true)) {
+        write_err = ESP_ERR_TIMEOUT;
+        break;
+      }
+    }
+    if (remaining > 0) {
+      this_speaker->events_.publish(AudioEvent::warning(write_err != ESP_OK ? write_err : ESP_FAIL), 10);
+    }
+
+    this_speaker->events_.publish(AudioEvent::running(total_written));
+  };
+
+  auto write_silence = [&](uint64_t frames) {
+    while (frames > 0) {
+      size_t chunk = std::min<uint64_t>(frames, resample_chunk_frames);
+      memset(out_buffer, 0, chunk * out_frame_size);
+      write_frames(chunk);
+      frames -= chunk;
+    }
+  };
+
+  // How late the next output frame plays against its schedule; the resampler's buffered input has
+  // been taken but not played yet
+  auto schedule_error_us = [&]() -> int64_t {
+    double position = static_cast<double>(sync_consumed) - resampler.get_buffered_frames();
+    int64_t due_us = sync_start_us + static_cast<int64_t>(position * 1000000.0 / current_info.sample_rate);
+    return clock->to_shared_us(this_speaker->sample_clock_.time_of(this_speaker->playout_.get_written())) - due_us;
+  };
+
+  // Lines the stream up with its schedule: far off by skipping input or padding with silence, close
+  // by trimming the resampling ratio
+  auto follow_schedule = [&]() {
+    int64_t error_us = schedule_error_us();
+    int64_t now_us = esp_timer_get_time();
+    if (!aligned || audio_utils::DriftController::needs_jump(error_us)) {
+      if (error_us > 0) {
+        skip_frames += static_cast<uint64_t>(error_us) * current_info.sample_rate / 1000000;
+      } else {
+        write_silence(static_cast<uint64_t>(-error_us) * config.sample_rate / 1000000);
+      }
+      if (aligned)
+        this_speaker->sync_realigns_++;
+      aligned = true;
+      drift.reset(false);
+    } else {
+      float elapsed_s = static_cast<float>(now_us - last_update_us) * 1e-6f;
+      resampler.set_trim_ppm(drift.update(static_cast<float>(error_us), elapsed_s));
+      this_speaker->sync_max_error_us_ = std::max(this_speaker->sync_max_error_us_, std::abs(error_us));
+    }
+    last_update_us = now_us;
+  };
+
+  uint32_t idle_ms = 0;
+  while (out_buffer != nullptr) {
+    // Waits in slices shorter than the event queue holds, so no DMA event gets dropped meanwhile
+    uint32_t ring_ms = this_speaker->plan_.dma_buffer_count * this_speaker->playout_.get_buffer_time_us() / 1000;
+    TickType_t slice = std::max<TickType_t>(1, pdMS_TO_TICKS(ring_ms / 2));
+    if (xQueueReceive(this_speaker->buffer_queue_, &data_event, slice) != pdTRUE) {
+      this_speaker->process_i2s_events_(false);
+      idle_ms += slice * portTICK_PERIOD_MS;
+      if (idle_ms >= 100)
+        break;  // End of audio from main thread
+      continue;
     }
+    idle_ms = 0;
     if (data_event.stop) {
       // Stop signal from main thread
       xQueueReset(this_speaker->buffer_queue_);  // Flush queue
       break;
     }
-    size_t bytes_written;
-
-    memmove(buffer, data_event.data, data_event.len);
-    size_t remaining = data_event.len / 2;
-    size_t current = 0;
-
-    while (remaining > 0) {
-      uint32_t sample = (buffer[current] << 16) | (buffer[current] & 0xFFFF);
+    if (data_event.scheduled && clock != nullptr) {
+      synced = true;
+      aligned = false;
+      sync_start_us = data_event.start_time_us;
+      sync_consumed = 0;
+      skip_frames = 0;
+      resampler_rate = 0;  // start from clean history, the position counts from here
+    }
 
-      esp_err_t err = i2s_write(this_speaker->parent_->get_port(), &sample, sizeof(sample), &bytes_written,
-                                (10 / portTICK_PERIOD_MS));
+    if (!this_speaker->resample_ && data_event.info.sample_rate != current_info.sample_rate) {
+      // Follow the stream's native rate instead of resampling it
+      err = i2s_set_clk(this_speaker->parent_->get_port(), data_event.info.sample_rate, out_bits,
+                        out_channels == 2 ? I2S_CHANNEL_STEREO : I2S_CHANNEL_MONO);
       if (err != ESP_OK) {
-        event = {.type = TaskEventType::WARNING, .err = err};
-        if (xQueueSend(this_speaker->event_queue_, &event, 10 / portTICK_PERIOD_MS) != pdTRUE) {
-          ESP_LOGW(TAG, "Failed to send WARNING event");
-        }
-        continue;
+        this_speaker->events_.publish(AudioEvent::warning(err), 10);
       }
-      if (bytes_written != sizeof(sample)) {
-        event = {.type = TaskEventType::WARNING, .err = ESP_FAIL};
-        if (xQueueSend(this_speaker->event_queue_, &event, 10 / portTICK_PERIOD_MS) != pdTRUE) {
-          ESP_LOGW(TAG, "Failed to send WARNING event");
-        }
+      this_speaker->playout_.reset(this_speaker->plan_.dma_buffer_length, data_event.info.sample_rate,
+                                   esp_timer_get_time());
+      this_speaker->sync_dma_();
+      this_speaker->ducking_ramp_.set_sample_rate(data_event.info.sample_rate);
+    }
+    if (convert == nullptr || data_event.info != current_info) {
+      convert = select_slot_converter(data_event.info, out_bits, out_channels);
+      if (this_speaker->resample_)
+        stage_convert = select_stage_converter(data_event.info, out_channels);
+    }
+    current_info = data_event.info;
+    size_t frames = current_info.bytes_to_frames(data_event.len);
+    if (convert == nullptr) {
+      this_speaker->events_.publish(AudioEvent::warning(ESP_ERR_NOT_SUPPORTED), 10);
+      continue;
+    }
+
+    if (!synced && (!this_speaker->resample_ || current_info.sample_rate == config.sample_rate)) {
+      convert(data_event.data, out_buffer, frames);
+      write_frames(frames);
+      resampler_rate = 0;  // a later resampled stretch starts from clean history
+      continue;
+    }
+
+    if (stage_convert == nullptr || resampled_convert == nullptr) {
+      this_speaker->events_.publish(AudioEvent::warning(ESP_ERR_NOT_SUPPORTED), 10);
+      continue;
+    }
+    if (current_info.sample_rate != resampler_rate) {
+      if (!resampler.configure(current_info.sample_rate, config.sample_rate, out_channels,
+                               this_speaker->resample_quality_)) {
+        this_speaker->events_.publish(AudioEvent::warning(ESP_ERR_NOT_SUPPORTED), 10);
         continue;
       }
-      remaining--;
-      current++;
+      resampler_rate = current_info.sample_rate;
+      resampler.set_trim_ppm(synced ? drift.get_drift_ppm() : 0.0f);
     }
-
-    event.type = TaskEventType::PLAYING;
-    event.err = current;
-    if (xQueueSend(this_speaker->event_queue_, &event, 10 / portTICK_PERIOD_MS) != pdTRUE) {
-      ESP_LOGW(TAG, "Failed to send PLAYING event");
+    if (synced && !aligned)
+      follow_schedule();
+    stage_convert(data_event.data, stage_buffer, frames);
+    const int16_t *in = reinterpret_cast<const int16_t *>(stage_buffer);
+    int16_t *resampled = reinterpret_cast<int16_t *>(resampled_buffer);
+    if (skip_frames > 0) {
+      size_t skipped = std::min<uint64_t>(skip_frames, frames);
+      in += skipped * out_channels;
+      frames -= skipped;
+      skip_frames -= skipped;
+      sync_consumed += skipped;
+    }
+    while (true) {
+      size_t consumed;
+      size_t produced = resampler.process(in, frames, &consumed, resampled, resample_chunk_frames);
+      in += consumed * out_channels;
+      frames -= consumed;
+      sync_consumed += consumed;
+      if (produced == 0)
+        break;
+      resampled_convert(resampled_buffer, out_buffer, produced);
+      write_frames(produced);
     }
+    if (synced)
+      follow_schedule();
   }
+  this_speaker->sync_drift_ppm_ = drift.get_drift_ppm();
 
-  event.type = TaskEventType::STOPPING;
-  if (xQueueSend(this_speaker->event_queue_, &event, 10 / portTICK_PERIOD_MS) != pdTRUE) {
-    ESP_LOGW(TAG, "Failed to send STOPPING event");
-  }
+  if (stage_buffer != nullptr)
+    allocator.deallocate(stage_buffer, stage_size);
+  if (resampled_buffer != nullptr)
+    allocator.deallocate(resampled_buffer, resampled_size);
+  if (out_buffer != nullptr)
+    allocator.deallocate(out_buffer, out_buffer_size);
+
+  this_speaker->events_.publish(AudioEvent::of(AudioEventType::STOPPING), 10);
 
   i2s_zero_dma_buffer(this_speaker->parent_->get_port());
 
   i2s_driver_uninstall(this_speaker->parent_->get_port());
+  this_speaker->i2s_event_queue_ = nullptr;
 
-  event.type = TaskEventType::STOPPED;
-  if (xQueueSend(this_speaker->event_queue_, &event, 10 / portTICK_PERIOD_MS) != pdTRUE) {
-    ESP_LOGW(TAG, "Failed to send STOPPED event");
-  }
+  // The main loop deletes this task once it sees STOPPED, so it must not get lost
+  this_speaker->events_.publish(AudioEvent::of(AudioEventType::STOPPED), EventBus::WAIT_FOREVER);
 
   while (true) {
     delay(10);
   }
 }
 
+uint8_t I2SAudioSpeaker::get_output_channels_() const {
+#if SOC_I2S_SUPPORTS_DAC
+  if (this->internal_dac_mode_ != I2S_DAC_CHANNEL_DISABLE)
+    return 2;  // the built-in DAC is always fed interleaved frames
+#endif
+  return this->external_dac_channels_;
+}
+
+void I2SAudioSpeaker::sync_dma_() {
+  // An overflow from a cleared queue, timed as it happens, shows the ring running idle
+  xQueueReset(this->i2s_event_queue_);
+  const TickType_t timeout =
+      pdMS_TO_TICKS((this->plan_.dma_buffer_count + 2) * this->playout_.get_buffer_time_us() / 1000) + 1;
+  i2s_event_t event;
+  while (xQueueReceive(this->i2s_event_queue_, &event, timeout) == pdTRUE) {
+    if (event.type == I2S_EVENT_TX_Q_OVF) {
+      int64_t now_us = esp_timer_get_time();
+      xQueueReset(this->i2s_event_queue_);  // the TX_DONE posted with it
+      this->playout_.sync(now_us);
+      return;
+    }
+  }
+  this->playout_.sync(esp_timer_get_time());
+}
+
+bool I2SAudioSpeaker::process_i2s_events_(bool wait_for_room) {
+  // Events already queued happened at unknown times
+  i2s_event_t event;
+  while (xQueueReceive(this->i2s_event_queue_, &event, 0) == pdTRUE)
+    this->handle_i2s_event_(event, 0);
+  if (!wait_for_room)
+    return true;
+
+  // The next completion frees a buffer
+  const TickType_t timeout = pdMS_TO_TICKS(2 * this->playout_.get_buffer_time_us() / 1000) + 1;
+  if (xQueueReceive(this->i2s_event_queue_, &event, timeout) != pdTRUE)
+    return false;
+  this->handle_i2s_event_(event, esp_timer_get_time());
+  return true;
+}
+
+void I2SAudioSpeaker::handle_i2s_event_(const i2s_event_t &event, int64_t timestamp_us) {
+  if (event.type == I2S_EVENT_TX_DONE) {
+    this->playout_.on_buffer_done(timestamp_us);
+  } else if (event.type == I2S_EVENT_TX_Q_OVF) {
+    // Only an underrun if the stream goes on, which the next write tells
+    this->playout_.on_overflow();
+  }
+}
+
+void I2SAudioSpeaker::set_audio_stream_info(const audio_utils::AudioStreamInfo &info) {
+  if (!this->resample_ && info.sample_rate != this->stream_info_.sample_rate)
+    this->accepted_position_ = 0;  // the player task restarts its clock on a rate change
+  this->stream_info_ = info;
+}
+
 void I2SAudioSpeaker::stop() {
   if (this->is_failed())
     return;
   if (this->state_ == speaker::STATE_STOPPED)
     return;
-  if (this->state_ == speaker::STATE_STARTING) {
+  if (this->state_ == speaker::STATE_STARTING && !this->task_created_) {
+    // Chunks queued while waiting for the port never play
+    xQueueReset(this->buffer_queue_);
+    this->accepted_position_ = 0;
+    this->accepted_remainder_ = 0;
+    this->parent_->get_arbiter()->release(&this->resource_client_);
     this->state_ = speaker::STATE_STOPPED;
     return;
   }
   this->state_ = speaker::STATE_STOPPING;
+  this->start_pending_ = false;
   DataEvent data;
   data.stop = true;
+  data.scheduled = false;
   xQueueSendToFront(this->buffer_queue_, &data, portMAX_DELAY);
 }
 
-void I2SAudioSpeaker::watch_() {
-  TaskEvent event;
-  if (xQueueReceive(this->event_queue_, &event, 0) == pdTRUE) {
-    switch (event.type) {
-      case TaskEventType::STARTING:
-        ESP_LOGD(TAG, "Starting I2S Audio Speaker");
-        break;
-      case TaskEventType::STARTED:
-        ESP_LOGD(TAG, "Started I2S Audio Speaker");
-        this->state_ = speaker::STATE_RUNNING;
-        break;
-      case TaskEventType::STOPPING:
-        ESP_LOGD(TAG, "Stopping I2S Audio Speaker");
-        break;
-      case TaskEventType::PLAYING:
-        this->status_clear_warning();
-        break;
-      case TaskEventType::STOPPED:
-        this->state_ = speaker::STATE_STOPPED;
-        vTaskDelete(this->player_task_handle_);
-        this->task_created_ = false;
-        this->player_task_handle_ = nullptr;
-        this->parent_->unlock();
-        xQueueReset(this->buffer_queue_);
-        ESP_LOGD(TAG, "Stopped I2S Audio Speaker");
-        break;
-      case TaskEventType::WARNING:
-        ESP_LOGW(TAG, "Error writing to I2S: %s", esp_err_to_name(event.err));
-        this->status_set_warning();
-        break;
-    }
+void I2SAudioSpeaker::handle_event_(const audio_utils::AudioEvent &event) {
+  switch (event.type) {
+    case AudioEventType::STARTING:
+      ESP_LOGD(TAG, "Starting I2S Audio Speaker");
+      break;
+    case AudioEventType::STARTED:
+      ESP_LOGD(TAG, "Started I2S Audio Speaker");
+      this->state_ = speaker::STATE_RUNNING;
+      break;
+    case AudioEventType::STOPPING:
+      ESP_LOGD(TAG, "Stopping I2S Audio Speaker");
+      break;
+    case AudioEventType::RUNNING:
+      this->status_clear_warning();
+      break;
+    case AudioEventType::STOPPED:
+      if (this->playback_clock_ != nullptr && this->sync_max_error_us_ > 0) {
+        ESP_LOGD(TAG, "Held the schedule within %lld us with %u realigns, output drift %.1f ppm",
+                 (long long) this->sync_max_error_us_, (unsigned) this->sync_realigns_, this->sync_drift_ppm_);
+      }
+      if (this->latency_tuner_.get_session_underruns() > 0)
+        ESP_LOGD(TAG, "%u underruns during playback", (unsigned) this->latency_tuner_.get_session_underruns());
+      if (this->latency_tuner_.end_session()) {
+        ESP_LOGI(TAG, "Growing output buffers to the %s profile",
+                 audio_utils::latency_profile_to_string(this->latency_tuner_.get_profile()));
+      }
+      this->state_ = speaker::STATE_STOPPED;
+      vTaskDelete(this->player_task_handle_);
+      this->task_created_ = false;
+      this->player_task_handle_ = nullptr;
+      xQueueReset(this->buffer_queue_);
+      // Not on start: play() may already have queued the next session's first chunks
+      this->accepted_position_ = 0;
+      this->accepted_remainder_ = 0;
+      this->parent_->get_arbiter()->release(&this->resource_client_);
+      ESP_LOGD(TAG, "Stopped I2S Audio Speaker");
+      break;
+    case AudioEventType::WARNING:
+      ESP_LOGW(TAG, "Error writing to I2S: %s", esp_err_to_name(event.error));
+      this->status_set_warning();
+      break;
   }
 }
 
-void I2SAudioSpeaker::loop() {
-  switch (this->state_) {
-    case speaker::STATE_STARTING:
-      this->start_();
-    case speaker::STATE_RUNNING:
-    case speaker::STATE_STOPPING:
-      this->watch_();
-      break;
-    case speaker::STATE_STOPPED:
+void I2SAudioSpeaker::update_ducking_() {
+#ifdef USE_MICROPHONE
+  bool ducking = false;
+  for (auto *microphone : this->ducking_microphones_) {
+    if (microphone->is_running()) {
+      ducking = true;
       break;
+    }
   }
+  if (ducking != this->ducking_) {
+    ESP_LOGD(TAG, ducking ? "Microphone active, ducking output by %.1f dB" : "Microphone idle, restoring output",
+             -this->ducking_level_db_);
+    this->ducking_ = ducking;
+    this->ducking_ramp_.set_target_db(ducking ? this->ducking_level_db_ : 0.0f);
+  }
+#endif
+}
+
+void I2SAudioSpeaker::loop() {
+  audio_utils::EventBus::get().dispatch();
+  if (uint32_t dropped = this->events_.take_new_drops())
+    ESP_LOGW(TAG, "%u player task events dropped, the event bus was full", (unsigned) dropped);
+
+  this->update_ducking_();
+  if (this->state_ == speaker::STATE_STARTING)
+    this->start_();
 }
 
 size_t I2SAudioSpeaker::play(const uint8_t *data, size_t length) {
@@ -250,23 +585,73 @@ size_t I2SAudioSpeaker::play(const uint8_t *data, size_t length) {
   if (this->state_ != speaker::STATE_RUNNING && this->state_ != speaker::STATE_STARTING) {
     this->start();
   }
-  size_t remaining = length;
+  // Keep every chunk frame aligned
+  const size_t frame_size = this->stream_info_.frame_size();
+  const size_t max_chunk = BUFFER_SIZE - BUFFER_SIZE % frame_size;
+  size_t remaining = length - length % frame_size;
   size_t index = 0;
-  while (remaining > 0) {
+  while (remaining > 0 && uxQueueMessagesWaiting(this->buffer_queue_) < this->queue_limit_) {
     DataEvent event;
     event.stop = false;
-    size_t to_send_length = std::min(remaining, BUFFER_SIZE);
+    event.scheduled = this->start_pending_;
+    event.start_time_us = this->pending_start_us_;
+    event.info = this->stream_info_;
+    size_t to_send_length = std::min(remaining, max_chunk);
     event.len = to_send_length;
     memcpy(event.data, data + index, to_send_length);
-    if (xQueueSend(this->buffer_queue_, &event, 0) != pdTRUE) {
-      return index;
-    }
+    if (xQueueSend(this->buffer_queue_, &event, 0) != pdTRUE)
+      break;
+    this->start_pending_ = false;
     remaining -= to_send_length;
     index += to_send_length;
   }
+  size_t frames = this->stream_info_.bytes_to_frames(index);
+  if (this->resample_ && this->stream_info_.sample_rate != this->sample_rate_) {
+    // Positions stay in frames at the port's rate, like the sample clock
+    uint64_t scaled = static_cast<uint64_t>(frames) * this->sample_rate_ + this->accepted_remainder_;
+    this->accepted_position_ += scaled / this->stream_info_.sample_rate;
+    this->accepted_remainder_ = scaled % this->stream_info_.sample_rate;
+  } else {
+    this->accepted_position_ += frames;
+  }
   return index;
 }
 
+size_t I2SAudioSpeaker::play(const uint8_t *data, size_t length, int64_t *presentation_time_us) {
+  uint64_t position = this->accepted_position_;
+  size_t accepted = this->play(data, length);
+  if (presentation_time_us != nullptr)
+    *presentation_time_us = this->sample_clock_.time_of(position);
+  return accepted;
+}
+
+void I2SAudioSpeaker::play_at(int64_t shared_time_us) {
+  if (this->playback_clock_ == nullptr) {
+    ESP_LOGW(TAG, "Cannot schedule playback without a playback clock");
+    return;
+  }
+  if (!this->playback_clock_->is_synchronized()) {
+    ESP_LOGW(TAG, "Playback clock not synchronized yet, playing unscheduled");
+    return;
+  }
+  int64_t lead_us = this->playback_clock_->to_local_us(shared_time_us) - esp_timer_get_time();
+  if (lead_us > MAX_START_LEAD_US) {
+    ESP_LOGW(TAG, "Start time %lld ms ahead, playing unscheduled", (long long) (lead_us / 1000));
+    return;
+  }
+  this->pending_start_us_ = shared_time_us;
+  this->start_pending_ = true;
+}
+
+uint32_t I2SAudioSpeaker::get_output_latency_us() const {
+  // The DMA runs at the port's rate, which only follows the stream when it is not resampled
+  uint32_t port_rate = this->resample_ ? this->sample_rate_ : this->stream_info_.sample_rate;
+  uint64_t dma_frames = static_cast<uint64_t>(this->plan_.dma_buffer_count) * this->plan_.dma_buffer_length;
+  uint64_t queued_frames = this->stream_info_.bytes_to_frames(this->queue_limit_ * BUFFER_SIZE);
+  return static_cast<uint32_t>(dma_frames * 1000000 / port_rate) +
+         this->stream_info_.frames_to_microseconds(queued_frames);
+}
+
 bool I2SAudioSpeaker::has_buffered_data() const { return uxQueueMessagesWaiting(this->buffer_queue_) > 0; }
 
 }  // namespace i2s_audio
@@ -8,32 +8,38 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/queue.h>
 
+#include "esphome/components/audio_utils/audio_stream_info.h"
+#include "esphome/components/audio_utils/dma_playout.h"
+#include "esphome/components/audio_utils/drift_controller.h"
+#include "esphome/components/audio_utils/event_bus.h"
+#include "esphome/components/audio_utils/gain_ramp.h"
+#include "esphome/components/audio_utils/latency_tuner.h"
+#include "esphome/components/audio_utils/pcm_format.h"
+#include "esphome/components/audio_utils/resampler.h"
+#include "esphome/components/audio_utils/resource_arbiter.h"
+#include "esphome/components/audio_utils/sample_clock.h"
+#include "esphome/components/audio_utils/shared_clock.h"
 #include "esphome/components/speaker/speaker.h"
 #include "esphome/core/component.h"
 #include "esphome/core/gpio.h"
 #include "esphome/core/helpers.h"
 
+#ifdef USE_MICROPHONE
+#include "esphome/components/microphone/microphone.h"
+#endif
+
+#include <vector>
+
 namespace esphome {
 namespace i2s_audio {
 
 static const size_t BUFFER_SIZE = 1024;
 
-enum class TaskEventType : uint8_t {
-  STARTING = 0,
-  STARTED,
-  PLAYING,
-  STOPPING,
-  STOPPED,
-  WARNING = 255,
-};
-
-struct TaskEvent {
-  TaskEventType type;
-  esp_err_t err;
-};
-
 struct DataEvent {
   bool stop;
+  bool scheduled;         // the first frame is due at start_time_us on the playback clock
+  int64_t start_time_us;
+  audio_utils::AudioStreamInfo info;
   size_t len;
   uint8_t data[BUFFER_SIZE];
 };
@@ -50,23 +56,92 @@ class I2SAudioSpeaker : public Component, public speaker::Speaker, public I2SAud
   void set_internal_dac_mode(i2s_dac_mode_t mode) { this->internal_dac_mode_ = mode; }
 #endif
   void set_external_dac_channels(uint8_t channels) { this->external_dac_channels_ = channels; }
+  void set_sample_rate(uint32_t sample_rate) {
+    this->sample_rate_ = sample_rate;
+    this->stream_info_.sample_rate = sample_rate;
+  }
+  void set_bits_per_sample(uint8_t bits_per_sample) { this->bits_per_sample_ = bits_per_sample; }
+
+  /// Format of the data passed to play(). Defaults to 16-bit mono at the configured sample rate;
+  /// the output is converted to the configured bit depth and channel layout, and the I2S clock
+  /// follows the stream's sample rate unless a resample quality is set. Stream formats left out of
+  /// stream_formats are dropped with an ESP_ERR_NOT_SUPPORTED warning.
+  void set_audio_stream_info(const audio_utils::AudioStreamInfo &info);
+  /// Keep the port at the configured sample rate and resample streams at other rates in the
+  /// player task, for DACs or codecs that cannot follow the stream.
+  void set_resample_quality(audio_utils::ResampleQuality quality) {
+    this->resample_ = true;
+    this->resample_quality_ = quality;
+  }
+  const audio_utils::AudioStreamInfo &get_audio_stream_info() const { return this->stream_info_; }
+
+  /// Clock shared with the other rooms, for play_at(). Requires a resample quality.
+  void set_playback_clock(audio_utils::SharedClock *clock) { this->playback_clock_ = clock; }
+  /// Plays the next frame passed to play() when the playback clock reaches `shared_time_us` and
+  /// keeps the frames after it on that schedule: small errors are steered out by trimming the
+  /// resampling ratio, large ones by skipping input or inserting silence.
+  void play_at(int64_t shared_time_us);
+
+  void set_priority(audio_utils::ResourcePriority priority) { this->resource_client_.set_priority(priority); }
+
+  void set_latency_profile(audio_utils::LatencyProfile profile) { this->latency_tuner_.set_profile(profile); }
+  void set_auto_tune(bool auto_tune) { this->latency_tuner_.set_auto_tune(auto_tune); }
+  const audio_utils::LatencyTuner &get_latency_tuner() const { return this->latency_tuner_; }
+  /// Worst case time from play() until the sample reaches the pins with the current buffer plan.
+  uint32_t get_output_latency_us() const;
+
+#ifdef USE_MICROPHONE
+  /// Duck the output while any of these microphones is running.
+  void add_ducking_microphone(microphone::Microphone *microphone) { this->ducking_microphones_.push_back(microphone); }
+#endif
+  void set_ducking_level(float level_db) { this->ducking_level_db_ = level_db; }
+  void set_ducking_attack(uint32_t attack_ms) { this->ducking_ramp_.set_attack_ms(attack_ms); }
+  void set_ducking_release(uint32_t release_ms) { this->ducking_ramp_.set_release_ms(release_ms); }
 
   void start() override;
   void stop() override;
 
   size_t play(const uint8_t *data, size_t length) override;
+  /// Like play(), additionally estimating when the first accepted sample reaches the I2S pins.
+  size_t play(const uint8_t *data, size_t length, int64_t *presentation_time_us);
+
+  const audio_utils::SampleClock &get_sample_clock() const { return this->sample_clock_; }
 
   bool has_buffered_data() const override;
 
  protected:
   void start_();
-  void watch_();
+  void handle_event_(const audio_utils::AudioEvent &event);
 
   static void player_task(void *params);
+  void sync_dma_();
+  bool process_i2s_events_(bool wait_for_room);
+  void handle_i2s_event_(const i2s_event_t &event, int64_t timestamp_us);
+  uint8_t get_output_channels_() const;
+  void apply_buffer_plan_();
+  void update_ducking_();
 
   TaskHandle_t player_task_handle_{nullptr};
   QueueHandle_t buffer_queue_;
-  QueueHandle_t event_queue_;
+  QueueHandle_t i2s_event_queue_{nullptr};
+
+  audio_utils::SampleClock sample_clock_;
+  uint64_t accepted_position_{0};  // frames accepted by play() at the port's rate, main loop only
+  uint64_t accepted_remainder_{0};  // rounding carried between play() calls while resampling
+  audio_utils::DmaPlayout playout_{&this->sample_clock_};  // player task only
+
+  audio_utils::EventSubscriber events_{"i2s_speaker"};
+  audio_utils::LatencyTuner latency_tuner_;
+  audio_utils::ResourceClient resource_client_{"i2s_speaker", audio_utils::ResourcePriority::MEDIA};
+  audio_utils::BufferPlan plan_{audio_utils::get_buffer_plan(audio_utils::LatencyProfile::ROBUST)};
+  size_t queue_limit_{0};  // chunks play() may queue, set per session
+
+#ifdef USE_MICROPHONE
+  std::vector<microphone::Microphone *> ducking_microphones_;
+#endif
+  float ducking_level_db_{-20.0f};
+  bool ducking_{false};
+  audio_utils::GainRamp ducking_ramp_;  // target set by the main loop, applied by the player task
 
   uint8_t dout_pin_{0};
   bool task_created_{false};
@@ -74,7 +149,20 @@ class I2SAudioSpeaker : public Component, public speaker::Speaker, public I2SAud
 #if SOC_I2S_SUPPORTS_DAC
   i2s_dac_mode_t internal_dac_mode_{I2S_DAC_CHANNEL_DISABLE};
 #endif
-  uint8_t external_dac_channels_;
+  uint8_t external_dac_channels_{1};
+  uint32_t sample_rate_{16000};
+  uint8_t bits_per_sample_{16};
+  bool resample_{false};
+  audio_utils::ResampleQuality resample_quality_{audio_utils::ResampleQuality::MEDIUM};
+
+  audio_utils::SharedClock *playback_clock_{nullptr};
+  bool start_pending_{false};  // the next chunk play() queues carries pending_start_us_
+  int64_t pending_start_us_{0};
+  // Written by the player task before it reports STOPPED
+  int64_t sync_max_error_us_{0};
+  uint32_t sync_realigns_{0};
+  float sync_drift_ppm_{0.0f};
+  audio_utils::AudioStreamInfo stream_info_;
 };
 
 }  // namespace i2s_audio
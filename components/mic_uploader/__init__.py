@@ -0,0 +1,131 @@
+from urllib.parse import urlparse
+
+import esphome.codegen as cg
+import esphome.config_validation as cv
+from esphome.components import microphone, sensor
+from esphome.const import (
+    CONF_ID,
+    CONF_MICROPHONE,
+    CONF_SAMPLE_RATE,
+    CONF_URL,
+    ENTITY_CATEGORY_DIAGNOSTIC,
+    STATE_CLASS_MEASUREMENT,
+)
+
+CODEOWNERS = ["@dwitgen"]
+DEPENDENCIES = ["esp32", "network", "microphone"]
+AUTO_LOAD = ["sensor"]
+
+CONF_PACKET_SIZE = "packet_size"
+CONF_CONTENT_TYPE = "content_type"
+CONF_MIN_RECONNECT_DELAY = "min_reconnect_delay"
+CONF_MAX_RECONNECT_DELAY = "max_reconnect_delay"
+CONF_THROUGHPUT = "throughput"
+
+UNIT_KILOBYTES_PER_SECOND = "kB/s"
+ICON_UPLOAD = "mdi:upload-network"
+
+mic_uploader_ns = cg.esphome_ns.namespace("mic_uploader")
+MicUploader = mic_uploader_ns.class_("MicUploader", cg.Component)
+UploadTransport = mic_uploader_ns.enum("UploadTransport", is_class=True)
+
+TRANSPORTS = {
+    "http": (UploadTransport.HTTP_CHUNKED, 80),
+    "ws": (UploadTransport.WEBSOCKET, 80),
+}
+
+
+def validate_url(value):
+    value = cv.url(value)
+    parsed = urlparse(value)
+    if parsed.scheme in ("https", "wss"):
+        raise cv.Invalid("TLS is not supported, use an http:// or ws:// URL")
+    if parsed.scheme not in TRANSPORTS:
+        raise cv.Invalid("The URL must start with http:// or ws://")
+    if not parsed.hostname:
+        raise cv.Invalid("The URL has no host")
+    return value
+
+
+def validate_packet_size(value):
+    value = cv.int_range(min=64, max=16384)(value)
+    if value % 2 != 0:
+        raise cv.Invalid("packet_size must hold whole 16-bit samples")
+    return value
+
+
+def validate_reconnect_delays(config):
+    if config[CONF_MIN_RECONNECT_DELAY] > config[CONF_MAX_RECONNECT_DELAY]:
+        raise cv.Invalid(
+            f"{CONF_MIN_RECONNECT_DELAY} must not be larger than {CONF_MAX_RECONNECT_DELAY}"
+        )
+    return config
+
+
+# Streams 16-bit mono microphone audio to a server over a chunked HTTP POST (one request per
+# capture session) or a WebSocket (one binary frame per packet), batching it into packet_size bytes.
+CONFIG_SCHEMA = cv.All(
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.declare_id(MicUploader),
+            cv.GenerateID(CONF_MICROPHONE): cv.use_id(microphone.Microphone),
+            cv.Required(CONF_URL): validate_url,
+            cv.Optional(CONF_PACKET_SIZE, default=1024): validate_packet_size,
+            # Only describes the stream to the server, the microphone sets the rate
+            cv.Optional(CONF_SAMPLE_RATE, default=16000): cv.int_range(
+                min=8000, max=48000
+            ),
+            cv.Optional(CONF_CONTENT_TYPE): cv.string_strict,
+            cv.Optional(
+                CONF_MIN_RECONNECT_DELAY, default="500ms"
+            ): cv.positive_time_period_milliseconds,
+            cv.Optional(
+                CONF_MAX_RECONNECT_DELAY, default="30s"
+            ): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_THROUGHPUT): sensor.sensor_schema(
+                unit_of_measurement=UNIT_KILOBYTES_PER_SECOND,
+                icon=ICON_UPLOAD,
+                accuracy_decimals=1,
+                state_class=STATE_CLASS_MEASUREMENT,
+                entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+            ),
+        }
+    ).extend(cv.COMPONENT_SCHEMA),
+    validate_reconnect_delays,
+)
+
+
+async def to_code(config):
+    var = cg.new_Pvariable(config[CONF_ID])
+    await cg.register_component(var, config)
+
+    mic = await cg.get_variable(config[CONF_MICROPHONE])
+    cg.add(var.set_microphone(mic))
+
+    url = urlparse(config[CONF_URL])
+    transport, default_port = TRANSPORTS[url.scheme]
+    cg.add(var.set_transport(transport))
+    cg.add(var.set_host(url.hostname))
+    cg.add(var.set_port(url.port or default_port))
+    path = url.path or "/"
+    if url.query:
+        path += "?" + url.query
+    cg.add(var.set_path(path))
+
+    sample_rate = config[CONF_SAMPLE_RATE]
+    cg.add(var.set_sample_rate(sample_rate))
+    # Raw little-endian samples as the microphone captures them; audio/L16 would be big-endian
+    content_type = config.get(
+        CONF_CONTENT_TYPE, f"audio/x-raw;format=S16LE;rate={sample_rate};channels=1"
+    )
+    cg.add(var.set_content_type(content_type))
+    cg.add(var.set_packet_size(config[CONF_PACKET_SIZE]))
+    cg.add(
+        var.set_reconnect_delay(
+            config[CONF_MIN_RECONNECT_DELAY], config[CONF_MAX_RECONNECT_DELAY]
+        )
+    )
+
+    if throughput_config := config.get(CONF_THROUGHPUT):
+        sens = await sensor.new_sensor(throughput_config)
+        cg.add(var.set_throughput_sensor(sens))
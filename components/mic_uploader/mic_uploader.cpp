@@ -0,0 +1,208 @@
+#include "mic_uploader.h"
+
+#ifdef USE_ESP32
+
+#include <cinttypes>
+#include <cstring>
+
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace mic_uploader {
+
+static const char *const TAG = "mic_uploader";
+
+static const size_t EVENT_QUEUE_SIZE = 8;
+static const uint32_t BUFFER_DURATION_MS = 1000;  // audio held while a packet is on its way
+static const uint32_t READ_TIMEOUT_MS = 20;
+static const uint32_t STATS_INTERVAL_MS = 10000;
+
+void MicUploader::setup() {
+  ESP_LOGCONFIG(TAG, "Setting up microphone uploader...");
+
+  this->ring_buffer_ = RingBuffer::create(this->sample_rate_ * sizeof(int16_t) * BUFFER_DURATION_MS / 1000);
+  if (this->ring_buffer_ == nullptr) {
+    ESP_LOGE(TAG, "Could not allocate ring buffer");
+    this->mark_failed();
+    return;
+  }
+  this->packet_.resize(this->packet_size_);
+  this->event_queue_ = xQueueCreate(EVENT_QUEUE_SIZE, sizeof(UploadEvent));
+  if (this->event_queue_ == nullptr) {
+    ESP_LOGE(TAG, "Failed to create event queue");
+    this->mark_failed();
+    return;
+  }
+  this->client_.set_endpoint(this->endpoint_);
+
+  this->microphone_->add_data_callback([this](const std::vector<int16_t> &data) {
+    const size_t size = data.size() * sizeof(int16_t);
+    size_t written = this->ring_buffer_->write((void *) data.data(), size);
+    this->overflow_bytes_ += size - written;
+  });
+  // Below the speakers' player tasks, audio going out of the room waits for audio coming in
+  xTaskCreate(MicUploader::upload_task, "upload_task", 4096, (void *) this, 1, &this->upload_task_handle_);
+}
+
+void MicUploader::upload_task(void *params) {
+  MicUploader *this_uploader = (MicUploader *) params;
+  UploadClient &client = this_uploader->client_;
+  uint8_t *packet = this_uploader->packet_.data();
+  const size_t packet_size = this_uploader->packet_size_;
+  size_t filled = 0;
+  uint32_t retry_at_ms = 0;
+
+  while (true) {
+    filled += this_uploader->ring_buffer_->read(packet + filled, packet_size - filled, pdMS_TO_TICKS(READ_TIMEOUT_MS));
+    // Whatever the session captured was written before the flag was set
+    const bool ending =
+        this_uploader->end_requested_.load(std::memory_order_acquire) && this_uploader->ring_buffer_->available() == 0;
+    if (filled < packet_size && !ending) {
+      // Notice an idle connection being closed by the server, and answer WebSocket pings
+      if (filled == 0 && client.is_connected())
+        client.poll();
+      continue;
+    }
+
+    if (filled > 0 && !client.is_streaming()) {
+      if (static_cast<int32_t>(millis() - retry_at_ms) < 0) {
+        this_uploader->bytes_dropped_.fetch_add(filled, std::memory_order_relaxed);
+        filled = 0;
+      } else {
+        // A kept-alive connection may have been closed while idle, that needs no backoff
+        if (!client.poll()) {
+          if (client.connect(random_uint32())) {
+            UploadEvent event = {};
+            event.type = UploadEventType::CONNECTED;
+            this_uploader->send_event_(event);
+          }
+        }
+        if (!client.is_connected() || !client.begin_stream()) {
+          this_uploader->bytes_dropped_.fetch_add(filled, std::memory_order_relaxed);
+          filled = 0;
+          this_uploader->fail_(&retry_at_ms);
+        }
+      }
+    }
+    if (filled > 0) {
+      if (client.poll() && client.send(packet, filled)) {
+        this_uploader->bytes_sent_.fetch_add(filled, std::memory_order_relaxed);
+        this_uploader->packets_sent_.fetch_add(1, std::memory_order_relaxed);
+        this_uploader->backoff_.reset();
+      } else {
+        this_uploader->bytes_dropped_.fetch_add(filled, std::memory_order_relaxed);
+        this_uploader->fail_(&retry_at_ms);
+      }
+      filled = 0;
+    }
+
+    if (ending) {
+      this_uploader->end_requested_.store(false, std::memory_order_relaxed);
+      if (client.is_streaming()) {
+        if (!client.end_stream()) {
+          this_uploader->fail_(&retry_at_ms);
+        } else if (client.get_endpoint().transport == UploadTransport::HTTP_CHUNKED) {
+          UploadEvent event = {};
+          event.type = UploadEventType::STREAM_ENDED;
+          event.status = client.get_last_status();
+          strncpy(event.response, client.get_response().c_str(), sizeof(event.response) - 1);
+          this_uploader->send_event_(event);
+        }
+      }
+    }
+  }
+}
+
+void MicUploader::fail_(uint32_t *retry_at_ms) {
+  this->client_.close();
+  this->failures_.fetch_add(1, std::memory_order_relaxed);
+  const uint32_t delay_ms = this->backoff_.next_delay_ms(random_uint32());
+  *retry_at_ms = millis() + delay_ms;
+
+  UploadEvent event = {};
+  event.type = UploadEventType::FAILED;
+  event.error = this->client_.get_error();
+  event.error_number = this->client_.get_error_number();
+  event.status = this->client_.get_last_status();
+  event.retry_ms = delay_ms;
+  this->send_event_(event);
+}
+
+void MicUploader::send_event_(const UploadEvent &event) { xQueueSend(this->event_queue_, &event, 0); }
+
+void MicUploader::loop() {
+  UploadEvent event;
+  while (xQueueReceive(this->event_queue_, &event, 0) == pdTRUE)
+    this->handle_event_(event);
+
+  const bool capturing = this->microphone_->is_running();
+  if (this->capturing_ && !capturing)
+    this->end_requested_.store(true, std::memory_order_release);
+  this->capturing_ = capturing;
+
+  const uint32_t now = millis();
+  if (now - this->last_stats_ms_ >= STATS_INTERVAL_MS) {
+    this->log_stats_();
+    this->last_stats_ms_ = now;
+  }
+}
+
+void MicUploader::handle_event_(const UploadEvent &event) {
+  switch (event.type) {
+    case UploadEventType::CONNECTED:
+      this->connected_ = true;
+      this->status_clear_warning();
+      ESP_LOGD(TAG, "Connected to %s:%u", this->endpoint_.host.c_str(), this->endpoint_.port);
+      break;
+    case UploadEventType::FAILED:
+      this->connected_ = false;
+      this->status_set_warning();
+      if (event.status != 0 && event.status != 101 && (event.status < 200 || event.status > 299)) {
+        ESP_LOGW(TAG, "Upload failed: %s, HTTP status %d; retrying in %" PRIu32 " ms", event.error, event.status,
+                 event.retry_ms);
+      } else {
+        ESP_LOGW(TAG, "Upload failed: %s (errno %d); retrying in %" PRIu32 " ms", event.error, event.error_number,
+                 event.retry_ms);
+      }
+      break;
+    case UploadEventType::STREAM_ENDED:
+      ESP_LOGD(TAG, "Stream ended, HTTP status %d%s%s", event.status, event.response[0] != '\0' ? ": " : "",
+               event.response);
+      break;
+  }
+}
+
+void MicUploader::log_stats_() {
+  const uint32_t bytes_sent = this->bytes_sent_.load(std::memory_order_relaxed);
+  const float throughput = static_cast<float>(bytes_sent - this->last_bytes_sent_) / STATS_INTERVAL_MS;  // kB/s
+  const bool moved = bytes_sent != this->last_bytes_sent_;
+  this->last_bytes_sent_ = bytes_sent;
+  if (this->throughput_sensor_ != nullptr)
+    this->throughput_sensor_->publish_state(throughput);
+  if (moved) {
+    ESP_LOGD(TAG, "Uploading %.1f kB/s; %" PRIu32 " packets, %" PRIu32 " kB sent, %" PRIu32 " kB dropped, %" PRIu32
+             " kB overflowed, %" PRIu32 " failures",
+             throughput, this->packets_sent_.load(std::memory_order_relaxed), bytes_sent / 1000,
+             this->bytes_dropped_.load(std::memory_order_relaxed) / 1000, this->overflow_bytes_ / 1000,
+             this->failures_.load(std::memory_order_relaxed));
+  }
+}
+
+void MicUploader::dump_config() {
+  ESP_LOGCONFIG(TAG, "Microphone Uploader:");
+  ESP_LOGCONFIG(TAG, "  Transport: %s",
+                this->endpoint_.transport == UploadTransport::WEBSOCKET ? "WebSocket" : "HTTP chunked POST");
+  ESP_LOGCONFIG(TAG, "  Endpoint: %s:%u%s", this->endpoint_.host.c_str(), this->endpoint_.port,
+                this->endpoint_.path.c_str());
+  ESP_LOGCONFIG(TAG, "  Content Type: %s", this->endpoint_.content_type.c_str());
+  ESP_LOGCONFIG(TAG, "  Packet Size: %u bytes (%" PRIu32 " ms)", (unsigned) this->packet_size_,
+                (uint32_t) (this->packet_size_ * 1000 / (this->sample_rate_ * sizeof(int16_t))));
+  LOG_SENSOR("  ", "Throughput", this->throughput_sensor_);
+}
+
+}  // namespace mic_uploader
+}  // namespace esphome
+
+#endif  // USE_ESP32
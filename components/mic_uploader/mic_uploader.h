@@ -0,0 +1,114 @@
+#pragma once
+
+#ifdef USE_ESP32
+
+#include "upload_client.h"
+#include "upload_protocol.h"
+
+#include "esphome/components/microphone/microphone.h"
+#include "esphome/components/sensor/sensor.h"
+#include "esphome/core/component.h"
+#include "esphome/core/ring_buffer.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace esphome {
+namespace mic_uploader {
+
+enum class UploadEventType : uint8_t {
+  CONNECTED,
+  FAILED,
+  STREAM_ENDED,
+};
+
+/// What the upload task reports to the main loop, which does the logging.
+struct UploadEvent {
+  UploadEventType type;
+  const char *error;  // a string literal from UploadClient
+  int error_number;
+  int status;
+  uint32_t retry_ms;
+  char response[96];
+};
+
+/// Streams what a microphone captures straight to a server, as a chunked HTTP POST or over a
+/// WebSocket, instead of relaying it through Home Assistant.
+///
+/// The data callback only copies samples into a ring buffer. An upload task batches them into
+/// packets of packet_size bytes, so every chunk or frame carries a useful amount of audio, and owns
+/// the connection: it connects when audio arrives, keeps the connection between capture sessions
+/// and reconnects with exponential backoff when it fails. Audio captured while it waits to
+/// reconnect is dropped rather than queued, so the stream resumes with current audio. Each capture
+/// session is one HTTP request, ended when the microphone stops; a WebSocket carries every session
+/// over the same connection.
+class MicUploader : public Component {
+ public:
+  void setup() override;
+  void loop() override;
+  void dump_config() override;
+  float get_setup_priority() const override { return setup_priority::AFTER_WIFI; }
+
+  void set_microphone(microphone::Microphone *microphone) { this->microphone_ = microphone; }
+  void set_transport(UploadTransport transport) { this->endpoint_.transport = transport; }
+  void set_host(const std::string &host) { this->endpoint_.host = host; }
+  void set_port(uint16_t port) { this->endpoint_.port = port; }
+  void set_path(const std::string &path) { this->endpoint_.path = path; }
+  void set_content_type(const std::string &content_type) { this->endpoint_.content_type = content_type; }
+  void set_sample_rate(uint32_t sample_rate) { this->sample_rate_ = sample_rate; }
+  void set_packet_size(size_t packet_size) { this->packet_size_ = packet_size; }
+  void set_reconnect_delay(uint32_t initial_ms, uint32_t max_ms) {
+    this->backoff_.set_delay_range_ms(initial_ms, max_ms);
+  }
+  void set_throughput_sensor(sensor::Sensor *throughput_sensor) { this->throughput_sensor_ = throughput_sensor; }
+
+  bool is_connected() const { return this->connected_; }
+
+ protected:
+  static void upload_task(void *params);
+  /// Closes the connection after a failure and schedules the next attempt, upload task only.
+  void fail_(uint32_t *retry_at_ms);
+  void send_event_(const UploadEvent &event);
+  void handle_event_(const UploadEvent &event);
+  void log_stats_();
+
+  microphone::Microphone *microphone_{nullptr};
+  UploadEndpoint endpoint_;
+  uint32_t sample_rate_{16000};
+  size_t packet_size_{1024};
+
+  std::unique_ptr<RingBuffer> ring_buffer_;
+  TaskHandle_t upload_task_handle_{nullptr};
+  QueueHandle_t event_queue_{nullptr};
+  std::atomic<bool> end_requested_{false};  // set by the main loop when a capture session ends
+
+  // Upload task only once it runs
+  UploadClient client_;
+  ReconnectBackoff backoff_;
+  std::vector<uint8_t> packet_;
+
+  // Written by the upload task, read by the main loop
+  std::atomic<uint32_t> bytes_sent_{0};
+  std::atomic<uint32_t> packets_sent_{0};
+  std::atomic<uint32_t> bytes_dropped_{0};  // captured while disconnected, or lost with a failed send
+  std::atomic<uint32_t> failures_{0};
+
+  // Main loop only
+  bool capturing_{false};
+  bool connected_{false};
+  uint32_t overflow_bytes_{0};  // the ring buffer was full, the upload task fell behind
+  uint32_t last_stats_ms_{0};
+  uint32_t last_bytes_sent_{0};
+  sensor::Sensor *throughput_sensor_{nullptr};
+};
+
+}  // namespace mic_uploader
+}  // namespace esphome
+
+#endif  // USE_ESP32
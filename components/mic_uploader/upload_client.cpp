@@ -0,0 +1,353 @@
+#include "upload_client.h"
+
+#ifdef USE_ESP32
+#include <lwip/netdb.h>
+#include <lwip/sockets.h>
+#else
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#endif
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+namespace esphome {
+namespace mic_uploader {
+
+static const size_t MAX_HEAD_SIZE = 2048;
+static const size_t RECEIVE_BLOCK_SIZE = 256;
+
+bool UploadClient::connect(uint32_t random) {
+  this->close();
+  this->mask_state_ = random != 0 ? random : 1;
+  this->last_status_ = 0;
+  this->response_.clear();
+  if (!this->open_socket_())
+    return false;
+  if (this->endpoint_.transport == UploadTransport::WEBSOCKET && !this->websocket_handshake_())
+    return false;
+  return true;
+}
+
+bool UploadClient::open_socket_() {
+  struct addrinfo hints = {};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  struct addrinfo *result = nullptr;
+  const std::string port = std::to_string(this->endpoint_.port);
+  int err = getaddrinfo(this->endpoint_.host.c_str(), port.c_str(), &hints, &result);
+  if (err != 0 || result == nullptr)
+    return this->fail_("host lookup failed", err);
+
+  this->socket_ = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+  if (this->socket_ < 0) {
+    freeaddrinfo(result);
+    return this->fail_("socket creation failed", errno);
+  }
+  // Non-blocking only while connecting, so an unreachable host fails after the timeout instead of
+  // after the TCP stack's SYN retries
+  const int flags = fcntl(this->socket_, F_GETFL, 0);
+  fcntl(this->socket_, F_SETFL, flags | O_NONBLOCK);
+  err = ::connect(this->socket_, result->ai_addr, result->ai_addrlen);
+  const int connect_errno = errno;
+  freeaddrinfo(result);
+  if (err != 0) {
+    if (connect_errno != EINPROGRESS)
+      return this->fail_("connect failed", connect_errno);
+    fd_set writable;
+    FD_ZERO(&writable);
+    FD_SET(this->socket_, &writable);
+    struct timeval timeout = {};
+    timeout.tv_sec = this->timeout_ms_ / 1000;
+    timeout.tv_usec = (this->timeout_ms_ % 1000) * 1000;
+    err = select(this->socket_ + 1, nullptr, &writable, nullptr, &timeout);
+    if (err <= 0)
+      return this->fail_("connect timed out", err == 0 ? ETIMEDOUT : errno);
+    int socket_error = 0;
+    socklen_t socket_error_size = sizeof(socket_error);
+    getsockopt(this->socket_, SOL_SOCKET, SO_ERROR, &socket_error, &socket_error_size);
+    if (socket_error != 0)
+      return this->fail_("connect failed", socket_error);
+  }
+  fcntl(this->socket_, F_SETFL, flags);
+
+  struct timeval timeout = {};
+  timeout.tv_sec = this->timeout_ms_ / 1000;
+  timeout.tv_usec = (this->timeout_ms_ % 1000) * 1000;
+  setsockopt(this->socket_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  setsockopt(this->socket_, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+  // Packets are batched before they get here, Nagle would only hold them back
+  int enable = 1;
+  setsockopt(this->socket_, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+  setsockopt(this->socket_, SOL_SOCKET, SO_KEEPALIVE, &enable, sizeof(enable));
+  return true;
+}
+
+bool UploadClient::websocket_handshake_() {
+  uint8_t nonce[16];
+  for (size_t i = 0; i < sizeof(nonce); i += 4)
+    this->next_mask_(nonce + i);
+  const std::string key = base64_encode(nonce, sizeof(nonce));
+  const std::string request = build_websocket_request(this->endpoint_, key);
+  if (!this->send_all_(request.data(), request.size()))
+    return false;
+
+  std::string head;
+  if (!this->read_head_(&head))
+    return false;
+  HttpResponseHead response;
+  if (!parse_http_response_head(head, &response))
+    return this->fail_("malformed handshake response");
+  this->last_status_ = response.status;
+  if (response.status != 101 || response.accept_key != websocket_accept_key(key))
+    return this->fail_("handshake rejected");
+  return true;
+}
+
+void UploadClient::close() {
+  if (this->socket_ >= 0)
+    ::close(this->socket_);
+  this->socket_ = -1;
+  this->streaming_ = false;
+  this->received_.clear();
+}
+
+bool UploadClient::begin_stream() {
+  if (!this->is_connected())
+    return this->fail_("not connected");
+  if (this->endpoint_.transport == UploadTransport::HTTP_CHUNKED) {
+    const std::string request = build_http_request(this->endpoint_);
+    if (!this->send_all_(request.data(), request.size()))
+      return false;
+  }
+  this->streaming_ = true;
+  return true;
+}
+
+bool UploadClient::send(const uint8_t *data, size_t size) {
+  if (!this->streaming_)
+    return this->fail_("no stream");
+  if (size == 0)
+    return true;  // an empty chunk would end the HTTP stream
+
+  this->frame_.clear();
+  if (this->endpoint_.transport == UploadTransport::HTTP_CHUNKED) {
+    char header[MAX_CHUNK_HEADER_SIZE + 1];
+    size_t header_size = build_chunk_header(size, header);
+    this->frame_.insert(this->frame_.end(), header, header + header_size);
+    this->frame_.insert(this->frame_.end(), data, data + size);
+    this->frame_.insert(this->frame_.end(), CHUNK_TRAILER, CHUNK_TRAILER + strlen(CHUNK_TRAILER));
+  } else {
+    uint8_t mask[4];
+    this->next_mask_(mask);
+    uint8_t header[MAX_WEBSOCKET_HEADER_SIZE];
+    size_t header_size = build_websocket_frame_header(WS_OPCODE_BINARY, size, mask, header);
+    this->frame_.insert(this->frame_.end(), header, header + header_size);
+    this->frame_.insert(this->frame_.end(), data, data + size);
+    apply_websocket_mask(this->frame_.data() + header_size, size, mask);
+  }
+  return this->send_all_(this->frame_.data(), this->frame_.size());
+}
+
+bool UploadClient::end_stream() {
+  if (!this->streaming_)
+    return true;
+  this->streaming_ = false;
+  if (this->endpoint_.transport == UploadTransport::WEBSOCKET)
+    return true;
+
+  if (!this->send_all_(LAST_CHUNK, strlen(LAST_CHUNK)))
+    return false;
+  std::string head;
+  if (!this->read_head_(&head))
+    return false;
+  HttpResponseHead response;
+  if (!parse_http_response_head(head, &response))
+    return this->fail_("malformed response");
+  this->last_status_ = response.status;
+  if (!this->read_body_(response))
+    return false;
+  if (response.status < 200 || response.status > 299)
+    return this->fail_("stream rejected");
+  // Without a length the body only ends when the server closes
+  if (!response.keep_alive || response.chunked || response.content_length < 0)
+    this->close();
+  return true;
+}
+
+bool UploadClient::poll() {
+  if (!this->is_connected())
+    return false;
+  uint8_t block[RECEIVE_BLOCK_SIZE];
+  size_t received = 0;
+  bool any = false;
+  do {
+    if (!this->receive_(block, sizeof(block), &received, false))
+      return false;
+    this->received_.insert(this->received_.end(), block, block + received);
+    any = any || received > 0;
+  } while (received == sizeof(block));
+  // The handshake response may have brought frames along
+  if (!any && this->received_.empty())
+    return true;
+
+  if (this->endpoint_.transport == UploadTransport::WEBSOCKET)
+    return this->handle_frames_();
+  // An HTTP server only speaks once the stream has ended, anything earlier is an error response
+  HttpResponseHead response;
+  const std::string head(this->received_.begin(), this->received_.end());
+  if (parse_http_response_head(head, &response))
+    this->last_status_ = response.status;
+  return this->fail_("server answered early");
+}
+
+bool UploadClient::handle_frames_() {
+  while (!this->received_.empty()) {
+    WebSocketFrameHeader header;
+    if (!parse_websocket_frame_header(this->received_.data(), this->received_.size(), &header))
+      return true;
+    if (header.payload_size > MAX_RESPONSE_SIZE)
+      return this->fail_("server frame too large");
+    const size_t frame_size = header.header_size + header.payload_size;
+    if (this->received_.size() < frame_size)
+      return true;  // the rest is still on its way
+
+    uint8_t *payload = this->received_.data() + header.header_size;
+    const size_t payload_size = header.payload_size;
+    if (header.masked)
+      apply_websocket_mask(payload, payload_size, header.mask);
+    switch (header.opcode) {
+      case WS_OPCODE_PING:
+        if (!this->send_control_frame_(WS_OPCODE_PONG, payload, payload_size))
+          return false;
+        break;
+      case WS_OPCODE_CLOSE:
+        // Echo the status code back before closing our side
+        this->send_control_frame_(WS_OPCODE_CLOSE, payload, payload_size < 2 ? payload_size : 2);
+        return this->fail_("closed by server");
+      case WS_OPCODE_TEXT:
+        this->response_.assign(reinterpret_cast<const char *>(payload), payload_size);
+        break;
+      default:
+        break;
+    }
+    this->received_.erase(this->received_.begin(), this->received_.begin() + frame_size);
+  }
+  return true;
+}
+
+bool UploadClient::send_control_frame_(uint8_t opcode, const uint8_t *payload, size_t size) {
+  uint8_t frame[MAX_WEBSOCKET_HEADER_SIZE + 125];
+  if (size > 125)
+    size = 125;
+  uint8_t mask[4];
+  this->next_mask_(mask);
+  size_t header_size = build_websocket_frame_header(opcode, size, mask, frame);
+  memcpy(frame + header_size, payload, size);
+  apply_websocket_mask(frame + header_size, size, mask);
+  return this->send_all_(frame, header_size + size);
+}
+
+bool UploadClient::send_all_(const void *data, size_t size) {
+  const uint8_t *position = static_cast<const uint8_t *>(data);
+  while (size > 0) {
+    ssize_t sent = ::send(this->socket_, position, size, MSG_NOSIGNAL);
+    if (sent < 0) {
+      if (errno == EINTR)
+        continue;
+      return this->fail_(errno == EAGAIN || errno == EWOULDBLOCK ? "send timed out" : "send failed", errno);
+    }
+    position += sent;
+    size -= sent;
+  }
+  return true;
+}
+
+bool UploadClient::receive_(void *data, size_t size, size_t *received, bool wait) {
+  *received = 0;
+  ssize_t result = recv(this->socket_, data, size, wait ? 0 : MSG_DONTWAIT);
+  if (result > 0) {
+    *received = result;
+    return true;
+  }
+  if (result == 0)
+    return this->fail_("connection closed by server");
+  if (errno == EAGAIN || errno == EWOULDBLOCK) {
+    if (!wait)
+      return true;
+    return this->fail_("receive timed out", errno);
+  }
+  return this->fail_("receive failed", errno);
+}
+
+bool UploadClient::read_head_(std::string *head) {
+  uint8_t block[RECEIVE_BLOCK_SIZE];
+  while (true) {
+    const std::string buffered(this->received_.begin(), this->received_.end());
+    size_t end = buffered.find("\r\n\r\n");
+    if (end != std::string::npos) {
+      *head = buffered.substr(0, end + 4);
+      this->received_.erase(this->received_.begin(), this->received_.begin() + end + 4);
+      return true;
+    }
+    if (this->received_.size() > MAX_HEAD_SIZE)
+      return this->fail_("response head too long");
+    size_t received = 0;
+    if (!this->receive_(block, sizeof(block), &received, true))
+      return false;
+    this->received_.insert(this->received_.end(), block, block + received);
+  }
+}
+
+bool UploadClient::read_body_(const HttpResponseHead &response) {
+  this->response_.clear();
+  if (response.chunked || response.content_length < 0) {
+    // Keep what already arrived for the log, the connection is closed after this response
+    size_t size = this->received_.size() < MAX_RESPONSE_SIZE ? this->received_.size() : MAX_RESPONSE_SIZE;
+    this->response_.assign(this->received_.begin(), this->received_.begin() + size);
+    this->received_.clear();
+    return true;
+  }
+  uint8_t block[RECEIVE_BLOCK_SIZE];
+  uint64_t remaining = response.content_length;
+  while (remaining > 0) {
+    if (this->received_.empty()) {
+      size_t received = 0;
+      if (!this->receive_(block, sizeof(block), &received, true))
+        return false;
+      this->received_.insert(this->received_.end(), block, block + received);
+    }
+    size_t take = this->received_.size() < remaining ? this->received_.size() : remaining;
+    size_t keep = MAX_RESPONSE_SIZE - this->response_.size();
+    if (keep > take)
+      keep = take;
+    this->response_.append(this->received_.begin(), this->received_.begin() + keep);
+    this->received_.erase(this->received_.begin(), this->received_.begin() + take);
+    remaining -= take;
+  }
+  return true;
+}
+
+void UploadClient::next_mask_(uint8_t *mask) {
+  uint32_t x = this->mask_state_;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  this->mask_state_ = x;
+  memcpy(mask, &x, 4);
+}
+
+bool UploadClient::fail_(const char *error, int error_number) {
+  this->error_ = error;
+  this->error_number_ = error_number;
+  this->close();
+  return false;
+}
+
+}  // namespace mic_uploader
+}  // namespace esphome
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "upload_protocol.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace esphome {
+namespace mic_uploader {
+
+/// A blocking client for one upload connection, either transport.
+///
+/// HTTP streams are chunked POSTs: begin_stream() sends the request head, every send() is one
+/// chunk and end_stream() sends the last chunk and waits for the response, keeping the connection
+/// for the next stream if the server allows it. WebSocket connections complete the handshake in
+/// connect() and every send() is one masked binary frame; they stay open across streams, so
+/// begin_stream() and end_stream() only mark them. Server pings are answered from poll().
+///
+/// Only BSD socket calls, so the same code runs over lwIP on the device and on the host.
+class UploadClient {
+ public:
+  static const size_t MAX_RESPONSE_SIZE = 512;  // response bodies and text frames kept for the log
+
+  void set_endpoint(const UploadEndpoint &endpoint) { this->endpoint_ = endpoint; }
+  const UploadEndpoint &get_endpoint() const { return this->endpoint_; }
+  void set_timeout_ms(uint32_t timeout_ms) { this->timeout_ms_ = timeout_ms; }
+
+  /// Resolves the host and connects, then completes the WebSocket handshake. `random` seeds the
+  /// handshake key and the frame masks.
+  bool connect(uint32_t random);
+  void close();
+  bool is_connected() const { return this->socket_ >= 0; }
+
+  bool begin_stream();
+  /// Sends one chunk or frame. Holds a copy of the packet with its framing, so a send is one
+  /// write to the socket.
+  bool send(const uint8_t *data, size_t size);
+  bool end_stream();
+  bool is_streaming() const { return this->streaming_; }
+
+  /// Handles whatever the server sent without blocking. Returns false, and closes, if the server
+  /// closed the connection or answered a stream early.
+  bool poll();
+
+  /// Why the last call failed, and errno if a socket call did.
+  const char *get_error() const { return this->error_; }
+  int get_error_number() const { return this->error_number_; }
+  /// Status of the last HTTP response, 0 before the first.
+  int get_last_status() const { return this->last_status_; }
+  /// Body of the last HTTP response, or the last text frame; truncated to MAX_RESPONSE_SIZE.
+  const std::string &get_response() const { return this->response_; }
+
+ protected:
+  bool open_socket_();
+  bool websocket_handshake_();
+  bool send_all_(const void *data, size_t size);
+  bool receive_(void *data, size_t size, size_t *received, bool wait);
+  bool read_head_(std::string *head);
+  bool read_body_(const HttpResponseHead &response);
+  bool handle_frames_();
+  bool send_control_frame_(uint8_t opcode, const uint8_t *payload, size_t size);
+  void next_mask_(uint8_t *mask);
+  bool fail_(const char *error, int error_number = 0);
+
+  UploadEndpoint endpoint_;
+  uint32_t timeout_ms_{5000};
+
+  int socket_{-1};
+  bool streaming_{false};
+  uint32_t mask_state_{1};         // xorshift state for the WebSocket frame masks
+  std::vector<uint8_t> frame_;     // the packet being sent, with its framing
+  std::vector<uint8_t> received_;  // unparsed bytes from the server
+  std::string response_;
+  int last_status_{0};
+  const char *error_{""};
+  int error_number_{0};
+};
+
+}  // namespace mic_uploader
+}  // namespace esphome
@@ -0,0 +1,198 @@
+#include "upload_protocol.h"
+
+#include <mbedtls/sha1.h>
+#include <mbedtls/version.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+
+namespace esphome {
+namespace mic_uploader {
+
+static const char *const WEBSOCKET_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+static std::string host_header(const UploadEndpoint &endpoint) {
+  std::string host = endpoint.host;
+  if (endpoint.port != 80)
+    host += ":" + std::to_string(endpoint.port);
+  return host;
+}
+
+std::string build_http_request(const UploadEndpoint &endpoint) {
+  std::string request = "POST " + endpoint.path + " HTTP/1.1\r\n";
+  request += "Host: " + host_header(endpoint) + "\r\n";
+  request += "Content-Type: " + endpoint.content_type + "\r\n";
+  request += "Transfer-Encoding: chunked\r\n";
+  request += "Connection: keep-alive\r\n\r\n";
+  return request;
+}
+
+size_t build_chunk_header(size_t size, char *header) {
+  int length = snprintf(header, MAX_CHUNK_HEADER_SIZE + 1, "%zx\r\n", size);
+  return length < 0 ? 0 : static_cast<size_t>(length);
+}
+
+std::string build_websocket_request(const UploadEndpoint &endpoint, const std::string &key) {
+  std::string request = "GET " + endpoint.path + " HTTP/1.1\r\n";
+  request += "Host: " + host_header(endpoint) + "\r\n";
+  request += "Upgrade: websocket\r\n";
+  request += "Connection: Upgrade\r\n";
+  request += "Sec-WebSocket-Key: " + key + "\r\n";
+  request += "Sec-WebSocket-Version: 13\r\n";
+  // Not part of the handshake, tells the server what the binary frames carry
+  request += "Content-Type: " + endpoint.content_type + "\r\n\r\n";
+  return request;
+}
+
+std::string websocket_accept_key(const std::string &key) {
+  std::string input = key + WEBSOCKET_GUID;
+  uint8_t digest[20];
+#if MBEDTLS_VERSION_MAJOR < 3
+  mbedtls_sha1_ret(reinterpret_cast<const unsigned char *>(input.data()), input.size(), digest);
+#else
+  mbedtls_sha1(reinterpret_cast<const unsigned char *>(input.data()), input.size(), digest);
+#endif
+  return base64_encode(digest, sizeof(digest));
+}
+
+size_t build_websocket_frame_header(uint8_t opcode, size_t size, const uint8_t *mask, uint8_t *header) {
+  size_t length = 0;
+  header[length++] = 0x80 | (opcode & 0x0F);  // FIN, no fragmentation
+  const uint8_t mask_bit = mask != nullptr ? 0x80 : 0x00;
+  if (size < 126) {
+    header[length++] = mask_bit | static_cast<uint8_t>(size);
+  } else if (size <= 0xFFFF) {
+    header[length++] = mask_bit | 126;
+    header[length++] = static_cast<uint8_t>(size >> 8);
+    header[length++] = static_cast<uint8_t>(size);
+  } else {
+    header[length++] = mask_bit | 127;
+    for (int shift = 56; shift >= 0; shift -= 8)
+      header[length++] = static_cast<uint8_t>(static_cast<uint64_t>(size) >> shift);
+  }
+  if (mask != nullptr) {
+    memcpy(header + length, mask, 4);
+    length += 4;
+  }
+  return length;
+}
+
+void apply_websocket_mask(uint8_t *data, size_t size, const uint8_t *mask, size_t offset) {
+  for (size_t i = 0; i < size; i++)
+    data[i] ^= mask[(offset + i) & 3];
+}
+
+bool parse_websocket_frame_header(const uint8_t *data, size_t size, WebSocketFrameHeader *header) {
+  if (size < 2)
+    return false;
+  header->fin = (data[0] & 0x80) != 0;
+  header->opcode = data[0] & 0x0F;
+  header->masked = (data[1] & 0x80) != 0;
+  size_t length = 2;
+  uint64_t payload_size = data[1] & 0x7F;
+  if (payload_size == 126) {
+    if (size < length + 2)
+      return false;
+    payload_size = (static_cast<uint64_t>(data[2]) << 8) | data[3];
+    length += 2;
+  } else if (payload_size == 127) {
+    if (size < length + 8)
+      return false;
+    payload_size = 0;
+    for (size_t i = 0; i < 8; i++)
+      payload_size = (payload_size << 8) | data[2 + i];
+    length += 8;
+  }
+  if (header->masked) {
+    if (size < length + 4)
+      return false;
+    memcpy(header->mask, data + length, 4);
+    length += 4;
+  }
+  header->payload_size = payload_size;
+  header->header_size = length;
+  return true;
+}
+
+std::string base64_encode(const uint8_t *data, size_t size) {
+  static const char *const ALPHABET = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string encoded;
+  encoded.reserve((size + 2) / 3 * 4);
+  for (size_t i = 0; i < size; i += 3) {
+    uint32_t group = static_cast<uint32_t>(data[i]) << 16;
+    if (i + 1 < size)
+      group |= static_cast<uint32_t>(data[i + 1]) << 8;
+    if (i + 2 < size)
+      group |= data[i + 2];
+    encoded += ALPHABET[(group >> 18) & 0x3F];
+    encoded += ALPHABET[(group >> 12) & 0x3F];
+    encoded += i + 1 < size ? ALPHABET[(group >> 6) & 0x3F] : '=';
+    encoded += i + 2 < size ? ALPHABET[group & 0x3F] : '=';
+  }
+  return encoded;
+}
+
+static bool header_name_is(const std::string &line, size_t colon, const char *name) {
+  return colon == strlen(name) && strncasecmp(line.c_str(), name, colon) == 0;
+}
+
+static bool contains_token(const std::string &value, const char *token) {
+  const size_t token_length = strlen(token);
+  for (size_t i = 0; i + token_length <= value.size(); i++) {
+    if (strncasecmp(value.c_str() + i, token, token_length) == 0)
+      return true;
+  }
+  return false;
+}
+
+bool parse_http_response_head(const std::string &head, HttpResponseHead *response) {
+  *response = HttpResponseHead();
+  size_t end = head.find("\r\n");
+  if (end == std::string::npos || head.compare(0, 5, "HTTP/") != 0)
+    return false;
+  size_t space = head.find(' ');
+  if (space == std::string::npos || space > end)
+    return false;
+  response->status = atoi(head.c_str() + space + 1);
+  if (response->status < 100 || response->status > 599)
+    return false;
+  if (head.compare(0, 8, "HTTP/1.0") == 0)
+    response->keep_alive = false;
+
+  size_t start = end + 2;
+  while ((end = head.find("\r\n", start)) != std::string::npos && end > start) {
+    const std::string line = head.substr(start, end - start);
+    start = end + 2;
+    size_t colon = line.find(':');
+    if (colon == std::string::npos)
+      return false;
+    size_t value_start = line.find_first_not_of(" \t", colon + 1);
+    const std::string value = value_start == std::string::npos ? "" : line.substr(value_start);
+    if (header_name_is(line, colon, "Content-Length")) {
+      response->content_length = strtoll(value.c_str(), nullptr, 10);
+    } else if (header_name_is(line, colon, "Transfer-Encoding")) {
+      response->chunked = contains_token(value, "chunked");
+    } else if (header_name_is(line, colon, "Connection")) {
+      if (contains_token(value, "close"))
+        response->keep_alive = false;
+      else if (contains_token(value, "keep-alive"))
+        response->keep_alive = true;
+    } else if (header_name_is(line, colon, "Sec-WebSocket-Accept")) {
+      response->accept_key = value;
+    }
+  }
+  return true;
+}
+
+uint32_t ReconnectBackoff::next_delay_ms(uint32_t random) {
+  const uint32_t base = this->base_ms_;
+  this->failures_++;
+  this->base_ms_ = base > this->max_ms_ / 2 ? this->max_ms_ : base * 2;
+  const uint32_t half = base / 2;
+  return base - half + random % (half + 1);
+}
+
+}  // namespace mic_uploader
+}  // namespace esphome
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace esphome {
+namespace mic_uploader {
+
+enum class UploadTransport : uint8_t {
+  HTTP_CHUNKED,  // one chunked POST per capture session, the connection kept alive between them
+  WEBSOCKET,     // one binary frame per packet over a connection that stays open
+};
+
+struct UploadEndpoint {
+  UploadTransport transport{UploadTransport::HTTP_CHUNKED};
+  std::string host;
+  uint16_t port{80};
+  std::string path{"/"};
+  std::string content_type{"audio/x-raw;format=S16LE;rate=16000;channels=1"};
+};
+
+/// Longest header build_websocket_frame_header() writes: 2 bytes, 8 of extended length, 4 of mask.
+static const size_t MAX_WEBSOCKET_HEADER_SIZE = 14;
+/// Longest header build_chunk_header() writes: 16 hex digits and CRLF.
+static const size_t MAX_CHUNK_HEADER_SIZE = 18;
+static const char *const CHUNK_TRAILER = "\r\n";
+static const char *const LAST_CHUNK = "0\r\n\r\n";
+
+enum WebSocketOpcode : uint8_t {
+  WS_OPCODE_CONTINUATION = 0x0,
+  WS_OPCODE_TEXT = 0x1,
+  WS_OPCODE_BINARY = 0x2,
+  WS_OPCODE_CLOSE = 0x8,
+  WS_OPCODE_PING = 0x9,
+  WS_OPCODE_PONG = 0xA,
+};
+
+/// Request head opening a chunked POST of the endpoint's content type.
+std::string build_http_request(const UploadEndpoint &endpoint);
+/// Writes the size line in front of a chunk of `size` bytes; returns its length.
+size_t build_chunk_header(size_t size, char *header);
+
+/// Request head of the WebSocket opening handshake (RFC 6455), `key` being the base64 nonce.
+std::string build_websocket_request(const UploadEndpoint &endpoint, const std::string &key);
+/// The Sec-WebSocket-Accept value a server must answer `key` with.
+std::string websocket_accept_key(const std::string &key);
+/// Header of a single final frame of `size` bytes. Client frames are masked with `mask`, server
+/// frames are not; returns the header length.
+size_t build_websocket_frame_header(uint8_t opcode, size_t size, const uint8_t *mask, uint8_t *header);
+/// XORs `data` with the mask, `offset` being the position of `data` within the frame payload.
+void apply_websocket_mask(uint8_t *data, size_t size, const uint8_t *mask, size_t offset = 0);
+
+struct WebSocketFrameHeader {
+  uint8_t opcode;
+  bool fin;
+  bool masked;
+  uint8_t mask[4];
+  uint64_t payload_size;
+  size_t header_size;
+};
+/// Parses a frame header at the start of `data`; false until `size` holds all of it.
+bool parse_websocket_frame_header(const uint8_t *data, size_t size, WebSocketFrameHeader *header);
+
+std::string base64_encode(const uint8_t *data, size_t size);
+
+struct HttpResponseHead {
+  int status{0};
+  int64_t content_length{-1};  // -1 when the response does not say
+  bool chunked{false};
+  bool keep_alive{true};       // HTTP/1.1 default, "Connection: close" clears it
+  std::string accept_key;      // Sec-WebSocket-Accept
+};
+/// Parses a response head up to and including the empty line. Returns false if it is malformed.
+bool parse_http_response_head(const std::string &head, HttpResponseHead *response);
+
+/// Exponential reconnect delay with equal jitter: each failure doubles the base delay up to the
+/// maximum, and the delay is drawn from the upper half of it so that devices that dropped together
+/// do not all come back together.
+class ReconnectBackoff {
+ public:
+  void set_delay_range_ms(uint32_t initial_ms, uint32_t max_ms) {
+    this->initial_ms_ = initial_ms;
+    this->max_ms_ = max_ms;
+    this->reset();
+  }
+  void reset() {
+    this->base_ms_ = this->initial_ms_;
+    this->failures_ = 0;
+  }
+  /// Delay before the next attempt after a failure; `random` is any uniformly distributed value.
+  uint32_t next_delay_ms(uint32_t random);
+  uint32_t get_failures() const { return this->failures_; }
+
+ protected:
+  uint32_t initial_ms_{500};
+  uint32_t max_ms_{30000};
+  uint32_t base_ms_{500};
+  uint32_t failures_{0};
+};
+
+}  // namespace mic_uploader
+}  // namespace esphome
@@ -0,0 +1,36 @@
+import esphome.codegen as cg
+import esphome.config_validation as cv
+from esphome.components.audio_utils import SharedClock
+from esphome.const import CONF_ID, CONF_PORT, CONF_UPDATE_INTERVAL
+
+CODEOWNERS = ["@dwitgen"]
+DEPENDENCIES = ["esp32", "network"]
+AUTO_LOAD = ["audio_utils"]
+
+CONF_SERVER = "server"
+
+playback_clock_ns = cg.esphome_ns.namespace("playback_clock")
+PlaybackClock = playback_clock_ns.class_("PlaybackClock", cg.Component, SharedClock)
+
+# A LAN wide clock for starting speakers together. Without a server address this device serves
+# its own clock to the others.
+CONFIG_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.declare_id(PlaybackClock),
+        cv.Optional(CONF_SERVER): cv.ipv4,
+        cv.Optional(CONF_PORT, default=5011): cv.port,
+        cv.Optional(
+            CONF_UPDATE_INTERVAL, default="1s"
+        ): cv.positive_time_period_milliseconds,
+    }
+).extend(cv.COMPONENT_SCHEMA)
+
+
+async def to_code(config):
+    var = cg.new_Pvariable(config[CONF_ID])
+    await cg.register_component(var, config)
+
+    if CONF_SERVER in config:
+        cg.add(var.set_server_address(str(config[CONF_SERVER])))
+    cg.add(var.set_port(config[CONF_PORT]))
+    cg.add(var.set_update_interval(config[CONF_UPDATE_INTERVAL]))
@@ -0,0 +1,170 @@
+#include "clock_sync.h"
+
+#include <algorithm>
+
+namespace esphome {
+namespace playback_clock {
+
+static inline void write_be32(uint8_t *data, uint32_t value) {
+  data[0] = static_cast<uint8_t>(value >> 24);
+  data[1] = static_cast<uint8_t>(value >> 16);
+  data[2] = static_cast<uint8_t>(value >> 8);
+  data[3] = static_cast<uint8_t>(value);
+}
+
+static inline uint32_t read_be32(const uint8_t *data) {
+  return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) |
+         (static_cast<uint32_t>(data[2]) << 8) | data[3];
+}
+
+static inline void write_be64(uint8_t *data, int64_t value) {
+  write_be32(data, static_cast<uint32_t>(static_cast<uint64_t>(value) >> 32));
+  write_be32(data + 4, static_cast<uint32_t>(value));
+}
+
+static inline int64_t read_be64(const uint8_t *data) {
+  return static_cast<int64_t>((static_cast<uint64_t>(read_be32(data)) << 32) | read_be32(data + 4));
+}
+
+void encode_sync_message(const SyncMessage &message, uint8_t *data) {
+  write_be32(data, SYNC_MAGIC);
+  data[4] = static_cast<uint8_t>(message.type);
+  data[5] = data[6] = data[7] = 0;
+  write_be64(data + 8, message.t0);
+  write_be64(data + 16, message.t1);
+  write_be64(data + 24, message.t2);
+}
+
+bool decode_sync_message(const uint8_t *data, size_t size, SyncMessage *message) {
+  if (size < SYNC_MESSAGE_SIZE || read_be32(data) != SYNC_MAGIC)
+    return false;
+  if (data[4] != static_cast<uint8_t>(SyncMessageType::REQUEST) &&
+      data[4] != static_cast<uint8_t>(SyncMessageType::RESPONSE))
+    return false;
+  message->type = static_cast<SyncMessageType>(data[4]);
+  message->t0 = read_be64(data + 8);
+  message->t1 = read_be64(data + 16);
+  message->t2 = read_be64(data + 24);
+  return true;
+}
+
+void ClockSync::reset() {
+  this->rtt_count_ = 0;
+  this->rtt_next_ = 0;
+  this->fit_count_ = 0;
+  this->fit_next_ = 0;
+  this->kept_ = 0;
+  this->last_used_local_us_ = 0;
+  this->skew_ppm_ = 0.0f;
+  this->last_residual_us_ = 0;
+  this->stats_ = ClockSyncStats();
+}
+
+int64_t ClockSync::get_min_rtt_us() const {
+  if (this->rtt_count_ == 0)
+    return 0;
+  return *std::min_element(this->rtts_, this->rtts_ + this->rtt_count_);
+}
+
+int64_t ClockSync::to_server_us(int64_t local_us) const {
+  int64_t elapsed = local_us - this->anchor_local_us_;
+  int64_t drift = static_cast<int64_t>(static_cast<float>(elapsed) * this->skew_ppm_ * 1e-6f);
+  return local_us + this->anchor_offset_us_ + drift;
+}
+
+bool ClockSync::add_exchange(int64_t t0, int64_t t1, int64_t t2, int64_t t3) {
+  int64_t rtt = (t3 - t0) - (t2 - t1);
+  if (rtt < 0 || t3 < t0) {
+    this->stats_.rejected++;
+    return false;
+  }
+  this->stats_.samples++;
+  this->rtts_[this->rtt_next_] = rtt;
+  this->window_local_us_[this->rtt_next_] = t0 + (t3 - t0) / 2;
+  this->window_offset_us_[this->rtt_next_] = ((t1 - t0) + (t2 - t3)) / 2;
+  this->rtt_next_ = (this->rtt_next_ + 1) % RTT_WINDOW;
+  if (this->rtt_count_ < RTT_WINDOW)
+    this->rtt_count_++;
+
+  // Clock filter: only the fastest exchange of the window is used, and each one only once
+  size_t best = 0;
+  for (size_t i = 1; i < this->rtt_count_; i++) {
+    if (this->rtts_[i] < this->rtts_[best])
+      best = i;
+  }
+  const int64_t local_us = this->window_local_us_[best];
+  const int64_t offset_us = this->window_offset_us_[best];
+  if (this->kept_ > 0 && local_us <= this->last_used_local_us_) {
+    this->stats_.rejected++;
+    return false;
+  }
+  this->last_used_local_us_ = local_us;
+  if (this->kept_ == 0) {
+    this->restart_(local_us, offset_us);
+    return true;
+  }
+
+  int64_t residual = offset_us - (this->to_server_us(local_us) - local_us);
+  if (residual > STEP_US || residual < -STEP_US) {
+    this->stats_.steps++;
+    this->restart_(local_us, offset_us);
+    return true;
+  }
+  this->last_residual_us_ = residual;
+  // The chosen exchange can be older than the anchor, which then stays put and only shifts
+  const int64_t anchor = std::max(this->anchor_local_us_, local_us);
+  const int64_t correction = static_cast<int64_t>(static_cast<float>(residual) * OFFSET_GAIN);
+  this->anchor_offset_us_ = this->to_server_us(anchor) - anchor + correction;
+  this->anchor_local_us_ = anchor;
+  this->kept_++;
+
+  this->fit_local_us_[this->fit_next_] = local_us;
+  this->fit_offset_us_[this->fit_next_] = offset_us;
+  this->fit_next_ = (this->fit_next_ + 1) % FIT_WINDOW;
+  if (this->fit_count_ < FIT_WINDOW)
+    this->fit_count_++;
+  this->fit_skew_();
+  return true;
+}
+
+void ClockSync::restart_(int64_t local_us, int64_t offset_us) {
+  this->anchor_local_us_ = local_us;
+  this->anchor_offset_us_ = offset_us;
+  this->skew_ppm_ = 0.0f;
+  this->last_residual_us_ = 0;
+  this->kept_ = 1;
+  this->fit_local_us_[0] = local_us;
+  this->fit_offset_us_[0] = offset_us;
+  this->fit_count_ = 1;
+  this->fit_next_ = 1;
+}
+
+void ClockSync::fit_skew_() {
+  // Oldest entry is the reference point, the sums stay small enough for float
+  const size_t oldest = this->fit_count_ < FIT_WINDOW ? 0 : this->fit_next_;
+  const int64_t local_ref = this->fit_local_us_[oldest];
+  const int64_t offset_ref = this->fit_offset_us_[oldest];
+  int64_t span = 0;
+  float sum_x = 0.0f, sum_y = 0.0f, sum_xx = 0.0f, sum_xy = 0.0f;
+  for (size_t i = 0; i < this->fit_count_; i++) {
+    int64_t dx = this->fit_local_us_[i] - local_ref;
+    span = std::max(span, dx);
+    float x = static_cast<float>(dx) * 1e-6f;  // seconds
+    float y = static_cast<float>(this->fit_offset_us_[i] - offset_ref);
+    sum_x += x;
+    sum_y += y;
+    sum_xx += x * x;
+    sum_xy += x * y;
+  }
+  if (span < MIN_FIT_SPAN_US)
+    return;
+  const float n = static_cast<float>(this->fit_count_);
+  const float denominator = n * sum_xx - sum_x * sum_x;
+  if (denominator <= 0.0f)
+    return;
+  const float limit = MAX_SKEW_PPM;
+  this->skew_ppm_ = std::max(-limit, std::min(limit, (n * sum_xy - sum_x * sum_y) / denominator));
+}
+
+}  // namespace playback_clock
+}  // namespace esphome
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace playback_clock {
+
+static const uint32_t SYNC_MAGIC = 0x50424B31;  // "PBK1"
+static const size_t SYNC_MESSAGE_SIZE = 32;
+
+enum class SyncMessageType : uint8_t {
+  REQUEST = 1,
+  RESPONSE = 2,
+};
+
+/// One NTP style exchange. The client sends its transmit time `t0`; the server fills in when it
+/// received the request (`t1`) and sent the response (`t2`), on its own clock. Times are in
+/// microseconds.
+struct SyncMessage {
+  SyncMessageType type;
+  int64_t t0;
+  int64_t t1;
+  int64_t t2;
+};
+
+/// Big-endian wire format, SYNC_MESSAGE_SIZE bytes.
+void encode_sync_message(const SyncMessage &message, uint8_t *data);
+/// Returns false for anything that is not a sync message.
+bool decode_sync_message(const uint8_t *data, size_t size, SyncMessage *message);
+
+struct ClockSyncStats {
+  uint32_t samples{0};
+  uint32_t rejected{0};  // round trips too slow to trust, or already used
+  uint32_t steps{0};     // offset jumps too large to slew, e.g. a restarted server
+};
+
+/// Estimates the offset and rate of a server's clock from request/response exchanges.
+///
+/// Each exchange gives the offset at the middle of its round trip, off by at most half the
+/// difference between the two legs. Like NTP's clock filter only the fastest of the last
+/// RTT_WINDOW exchanges is used, and each at most once, so queueing on a busy network does not
+/// pull the estimate. The rate (skew) is a least squares fit over the last FIT_WINDOW kept
+/// offsets; the offset follows each kept exchange with OFFSET_GAIN, which smooths the leftover
+/// network noise. Offsets that jump by more than STEP_US restart the estimate.
+///
+/// Pure logic with no socket or timer access, so it runs unchanged on the host.
+class ClockSync {
+ public:
+  static const size_t RTT_WINDOW = 8;
+  static const size_t FIT_WINDOW = 16;
+  static const uint32_t MIN_SAMPLES = 4;  // kept exchanges before the estimate is used
+  static const int64_t STEP_US = 50000;
+  static const int64_t MIN_FIT_SPAN_US = 4000000;
+  static constexpr float OFFSET_GAIN = 0.5f;
+  static constexpr float MAX_SKEW_PPM = 500.0f;
+
+  void reset();
+
+  /// Adds one exchange: `t0` and `t3` on the local clock, `t1` and `t2` on the server's. Returns
+  /// true if it was kept.
+  bool add_exchange(int64_t t0, int64_t t1, int64_t t2, int64_t t3);
+
+  bool is_synchronized() const { return this->kept_ >= MIN_SAMPLES; }
+  /// Server time at local time `local_us`.
+  int64_t to_server_us(int64_t local_us) const;
+
+  /// The local time the offset was last updated and the offset (server less local) there.
+  int64_t get_anchor_local_us() const { return this->anchor_local_us_; }
+  int64_t get_anchor_offset_us() const { return this->anchor_offset_us_; }
+  /// How much faster the server's clock runs than the local one.
+  float get_skew_ppm() const { return this->skew_ppm_; }
+  int64_t get_min_rtt_us() const;
+  /// Measured less predicted offset of the last kept exchange.
+  int64_t get_last_residual_us() const { return this->last_residual_us_; }
+  const ClockSyncStats &get_stats() const { return this->stats_; }
+
+ protected:
+  void restart_(int64_t local_us, int64_t offset_us);
+  void fit_skew_();
+
+  // The last RTT_WINDOW exchanges: round trip, mid point and offset
+  int64_t rtts_[RTT_WINDOW]{};
+  int64_t window_local_us_[RTT_WINDOW]{};
+  int64_t window_offset_us_[RTT_WINDOW]{};
+  size_t rtt_count_{0};
+  size_t rtt_next_{0};
+  int64_t last_used_local_us_{0};
+
+  // Kept offsets for the rate fit, relative to the first one to stay precise in float math
+  int64_t fit_local_us_[FIT_WINDOW]{};
+  int64_t fit_offset_us_[FIT_WINDOW]{};
+  size_t fit_count_{0};
+  size_t fit_next_{0};
+
+  uint32_t kept_{0};
+  int64_t anchor_local_us_{0};
+  int64_t anchor_offset_us_{0};
+  float skew_ppm_{0.0f};
+  int64_t last_residual_us_{0};
+  ClockSyncStats stats_;
+};
+
+}  // namespace playback_clock
+}  // namespace esphome
@@ -0,0 +1,163 @@
+#include "playback_clock.h"
+
+#ifdef USE_ESP32
+
+#include <esp_timer.h>
+#include <lwip/sockets.h>
+
+#include <cinttypes>
+
+#include "esphome/core/hal.h"
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace playback_clock {
+
+static const char *const TAG = "playback_clock";
+
+static const size_t EXCHANGE_QUEUE_SIZE = 4;
+static const uint32_t LOCK_INTERVAL_MS = 250;  // request interval until the first lock
+static const uint32_t STATS_INTERVAL_MS = 60000;
+
+void PlaybackClock::setup() {
+  ESP_LOGCONFIG(TAG, "Setting up playback clock...");
+
+  this->exchange_queue_ = xQueueCreate(EXCHANGE_QUEUE_SIZE, sizeof(ExchangeEvent));
+  if (this->exchange_queue_ == nullptr) {
+    ESP_LOGE(TAG, "Failed to create exchange queue");
+    this->mark_failed();
+    return;
+  }
+  if (!this->open_socket_()) {
+    this->mark_failed();
+    return;
+  }
+  if (this->is_server()) {
+    // The server's own clock is the shared one
+    this->publish(0, 0, 0.0f);
+  }
+  // Above the speakers' player tasks so both ends stamp promptly
+  xTaskCreate(PlaybackClock::socket_task, "clock_task", 3072, (void *) this, 2, &this->socket_task_handle_);
+}
+
+bool PlaybackClock::open_socket_() {
+  this->socket_ = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (this->socket_ < 0) {
+    ESP_LOGE(TAG, "Failed to create socket: errno %d", errno);
+    return false;
+  }
+  struct sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  // Clients answer from any port, the server listens on the configured one
+  address.sin_port = this->is_server() ? htons(this->port_) : 0;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (bind(this->socket_, (struct sockaddr *) &address, sizeof(address)) != 0) {
+    ESP_LOGE(TAG, "Failed to bind port %u: errno %d", this->port_, errno);
+    close(this->socket_);
+    this->socket_ = -1;
+    return false;
+  }
+  return true;
+}
+
+void PlaybackClock::socket_task(void *params) {
+  PlaybackClock *this_clock = (PlaybackClock *) params;
+  uint8_t data[SYNC_MESSAGE_SIZE];
+  SyncMessage message;
+  while (true) {
+    struct sockaddr_in from = {};
+    socklen_t from_size = sizeof(from);
+    ssize_t received = recvfrom(this_clock->socket_, data, sizeof(data), 0, (struct sockaddr *) &from, &from_size);
+    int64_t now = esp_timer_get_time();
+    if (received <= 0 || !decode_sync_message(data, received, &message))
+      continue;
+
+    if (this_clock->is_server() && message.type == SyncMessageType::REQUEST) {
+      message.type = SyncMessageType::RESPONSE;
+      message.t1 = now;
+      message.t2 = esp_timer_get_time();
+      encode_sync_message(message, data);
+      sendto(this_clock->socket_, data, SYNC_MESSAGE_SIZE, 0, (struct sockaddr *) &from, from_size);
+    } else if (!this_clock->is_server() && message.type == SyncMessageType::RESPONSE) {
+      ExchangeEvent event = {message.t0, message.t1, message.t2, now};
+      xQueueSend(this_clock->exchange_queue_, &event, 0);
+    }
+  }
+}
+
+void PlaybackClock::send_request_() {
+  struct sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(this->port_);
+  address.sin_addr.s_addr = inet_addr(this->server_address_.c_str());
+
+  uint8_t data[SYNC_MESSAGE_SIZE];
+  SyncMessage message = {SyncMessageType::REQUEST, esp_timer_get_time(), 0, 0};
+  encode_sync_message(message, data);
+  ssize_t sent = sendto(this->socket_, data, sizeof(data), 0, (struct sockaddr *) &address, sizeof(address));
+  if (sent == static_cast<ssize_t>(SYNC_MESSAGE_SIZE))
+    this->request_t0_ = message.t0;
+}
+
+void PlaybackClock::loop() {
+  if (this->is_server())
+    return;
+
+  ExchangeEvent event;
+  while (xQueueReceive(this->exchange_queue_, &event, 0) == pdTRUE)
+    this->handle_exchange_(event);
+
+  const uint32_t now = millis();
+  const uint32_t interval = this->was_synchronized_ ? this->update_interval_ms_ : LOCK_INTERVAL_MS;
+  if (now - this->last_request_ms_ >= interval) {
+    this->last_request_ms_ = now;
+    this->send_request_();
+  }
+  if (this->was_synchronized_ && now - this->last_stats_ms_ > STATS_INTERVAL_MS) {
+    this->last_stats_ms_ = now;
+    const ClockSyncStats &stats = this->clock_sync_.get_stats();
+    ESP_LOGD(TAG, "Offset %" PRId64 " us, skew %.1f ppm, rtt %" PRId64 " us, %" PRIu32 "/%" PRIu32 " kept",
+             this->clock_sync_.get_anchor_offset_us(), this->clock_sync_.get_skew_ppm(),
+             this->clock_sync_.get_min_rtt_us(), stats.samples - stats.rejected, stats.samples);
+  }
+}
+
+void PlaybackClock::handle_exchange_(const ExchangeEvent &event) {
+  // Only the latest request counts, a late answer to an earlier one has an unknown round trip
+  if (event.t0 != this->request_t0_)
+    return;
+  this->request_t0_ = 0;
+
+  uint32_t steps = this->clock_sync_.get_stats().steps;
+  if (!this->clock_sync_.add_exchange(event.t0, event.t1, event.t2, event.t3))
+    return;
+  if (this->clock_sync_.get_stats().steps != steps)
+    ESP_LOGW(TAG, "Server clock jumped, resynchronizing");
+  if (!this->clock_sync_.is_synchronized())
+    return;
+
+  const int64_t anchor = this->clock_sync_.get_anchor_local_us();
+  this->publish(anchor, anchor + this->clock_sync_.get_anchor_offset_us(), this->clock_sync_.get_skew_ppm());
+  if (!this->was_synchronized_) {
+    this->was_synchronized_ = true;
+    this->last_stats_ms_ = millis();
+    ESP_LOGI(TAG, "Synchronized to %s, rtt %" PRId64 " us", this->server_address_.c_str(),
+             this->clock_sync_.get_min_rtt_us());
+  }
+}
+
+void PlaybackClock::dump_config() {
+  ESP_LOGCONFIG(TAG, "Playback Clock:");
+  if (this->is_server()) {
+    ESP_LOGCONFIG(TAG, "  Role: server");
+  } else {
+    ESP_LOGCONFIG(TAG, "  Role: client of %s", this->server_address_.c_str());
+    ESP_LOGCONFIG(TAG, "  Update Interval: %" PRIu32 " ms", this->update_interval_ms_);
+  }
+  ESP_LOGCONFIG(TAG, "  Port: %u", this->port_);
+}
+
+}  // namespace playback_clock
+}  // namespace esphome
+
+#endif  // USE_ESP32
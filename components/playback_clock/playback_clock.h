@@ -0,0 +1,74 @@
+#pragma once
+
+#ifdef USE_ESP32
+
+#include "clock_sync.h"
+
+#include "esphome/components/audio_utils/shared_clock.h"
+#include "esphome/core/component.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+#include <string>
+
+namespace esphome {
+namespace playback_clock {
+
+/// One finished exchange, stamped on arrival by the socket task.
+struct ExchangeEvent {
+  int64_t t0;
+  int64_t t1;
+  int64_t t2;
+  int64_t t3;
+};
+
+/// A clock shared by the devices on the LAN, for speakers that start and stay in step.
+///
+/// One device runs as the server: its esp_timer is the shared clock and a socket task answers
+/// every request at once, stamping its receive and transmit times. The others are clients that
+/// query it every update interval (faster until they first lock) and estimate the server's offset
+/// and rate with ClockSync; the estimate is published through the SharedClock the speakers read.
+/// Any host speaking the same 32 byte protocol can stand in for the server, see host_sim's
+/// esp_adf_sync.
+class PlaybackClock : public Component, public audio_utils::SharedClock {
+ public:
+  void setup() override;
+  void loop() override;
+  void dump_config() override;
+  float get_setup_priority() const override { return setup_priority::AFTER_WIFI; }
+
+  /// Without a server address this device is the server.
+  void set_server_address(const std::string &address) { this->server_address_ = address; }
+  void set_port(uint16_t port) { this->port_ = port; }
+  void set_update_interval(uint32_t update_interval_ms) { this->update_interval_ms_ = update_interval_ms; }
+
+  bool is_server() const { return this->server_address_.empty(); }
+  const ClockSync &get_clock_sync() const { return this->clock_sync_; }
+
+ protected:
+  static void socket_task(void *params);
+  bool open_socket_();
+  void send_request_();
+  void handle_exchange_(const ExchangeEvent &event);
+
+  std::string server_address_;
+  uint16_t port_{5011};
+  uint32_t update_interval_ms_{1000};
+
+  int socket_{-1};
+  TaskHandle_t socket_task_handle_{nullptr};
+  QueueHandle_t exchange_queue_{nullptr};
+
+  ClockSync clock_sync_;
+  int64_t request_t0_{0};  // transmit time of the outstanding request, main loop only
+  uint32_t last_request_ms_{0};
+  uint32_t last_stats_ms_{0};
+  bool was_synchronized_{false};
+};
+
+}  // namespace playback_clock
+}  // namespace esphome
+
+#endif  // USE_ESP32
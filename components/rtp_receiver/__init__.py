@@ -0,0 +1,94 @@
+import esphome.codegen as cg
+import esphome.config_validation as cv
+from esphome.components import esp32, speaker
+from esphome.const import CONF_ID, CONF_PORT, CONF_SAMPLE_RATE, CONF_SPEAKER
+
+CODEOWNERS = ["@dwitgen"]
+DEPENDENCIES = ["esp32", "network"]
+
+CONF_MULTICAST_ADDRESS = "multicast_address"
+CONF_CODEC = "codec"
+CONF_PAYLOAD_TYPE = "payload_type"
+CONF_CHANNELS = "channels"
+CONF_MIN_DELAY = "min_delay"
+CONF_MAX_DELAY = "max_delay"
+
+rtp_receiver_ns = cg.esphome_ns.namespace("rtp_receiver")
+RTPReceiver = rtp_receiver_ns.class_("RTPReceiver", cg.Component)
+RTPCodec = rtp_receiver_ns.enum("RTPCodec", is_class=True)
+
+CODECS = {
+    "l16": RTPCodec.L16,
+    "opus": RTPCodec.OPUS,
+}
+
+# Rates the Opus decoder outputs
+OPUS_SAMPLE_RATES = [8000, 12000, 16000, 24000, 48000]
+
+
+def validate_delays(config):
+    if config[CONF_MIN_DELAY] > config[CONF_MAX_DELAY]:
+        raise cv.Invalid(f"{CONF_MIN_DELAY} must not be larger than {CONF_MAX_DELAY}")
+    return config
+
+
+def validate_opus(config):
+    if config[CONF_CODEC] == "opus":
+        if config[CONF_SAMPLE_RATE] not in OPUS_SAMPLE_RATES:
+            raise cv.Invalid(
+                f"Opus decodes at {', '.join(str(rate) for rate in OPUS_SAMPLE_RATES)} Hz",
+                path=[CONF_SAMPLE_RATE],
+            )
+        cv.only_with_esp_idf(config)
+    return config
+
+
+# Plays L16 (RFC 3551) or Opus (RFC 7587) audio pushed over RTP/UDP, with an adaptive jitter buffer
+# and packet loss concealment. The speaker must be configured for the stream's rate and channel
+# count; Opus is decoded at that rate and channel count.
+CONFIG_SCHEMA = cv.All(
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.declare_id(RTPReceiver),
+            cv.Required(CONF_SPEAKER): cv.use_id(speaker.Speaker),
+            cv.Optional(CONF_PORT, default=5004): cv.port,
+            cv.Optional(CONF_MULTICAST_ADDRESS): cv.ipv4,
+            cv.Optional(CONF_CODEC, default="l16"): cv.enum(CODECS, lower=True),
+            # Dynamic types are the norm; 10 and 11 are the static L16 44.1 kHz stereo and mono types
+            cv.Optional(CONF_PAYLOAD_TYPE, default=96): cv.int_range(min=0, max=127),
+            cv.Optional(CONF_SAMPLE_RATE, default=16000): cv.int_range(
+                min=8000, max=48000
+            ),
+            cv.Optional(CONF_CHANNELS, default=1): cv.int_range(min=1, max=2),
+            cv.Optional(
+                CONF_MIN_DELAY, default="20ms"
+            ): cv.positive_time_period_milliseconds,
+            cv.Optional(
+                CONF_MAX_DELAY, default="200ms"
+            ): cv.positive_time_period_milliseconds,
+        }
+    ).extend(cv.COMPONENT_SCHEMA),
+    validate_delays,
+    validate_opus,
+)
+
+
+async def to_code(config):
+    var = cg.new_Pvariable(config[CONF_ID])
+    await cg.register_component(var, config)
+
+    spk = await cg.get_variable(config[CONF_SPEAKER])
+    cg.add(var.set_speaker(spk))
+    cg.add(var.set_port(config[CONF_PORT]))
+    if CONF_MULTICAST_ADDRESS in config:
+        cg.add(var.set_multicast_address(str(config[CONF_MULTICAST_ADDRESS])))
+    cg.add(var.set_codec(config[CONF_CODEC]))
+    if config[CONF_CODEC] == "opus":
+        cg.add_define("USE_RTP_RECEIVER_OPUS")
+        # The frame decoder from esp-adf-libs; ADF's own Opus element only takes Ogg streams
+        esp32.add_idf_component(name="espressif/esp_audio_codec", ref="2.0.0")
+    cg.add(var.set_payload_type(config[CONF_PAYLOAD_TYPE]))
+    cg.add(var.set_sample_rate(config[CONF_SAMPLE_RATE]))
+    cg.add(var.set_channels(config[CONF_CHANNELS]))
+    cg.add(var.set_min_delay(config[CONF_MIN_DELAY]))
+    cg.add(var.set_max_delay(config[CONF_MAX_DELAY]))
@@ -0,0 +1,176 @@
+#include "jitter_buffer.h"
+#include "rtp_packet.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace esphome {
+namespace rtp_receiver {
+
+static const int32_t UNITY_GAIN = 1 << 15;
+
+void JitterBuffer::configure(uint32_t sample_rate, uint8_t channels, size_t packet_frames) {
+  this->sample_rate_ = sample_rate;
+  this->clock_rate_ = sample_rate;
+  this->packet_frames_ = packet_frames;
+  this->packet_samples_ = packet_frames * channels;
+  this->packet_us_ = static_cast<uint32_t>(static_cast<uint64_t>(packet_frames) * 1000000 / sample_rate);
+  this->storage_.assign(CAPACITY * this->packet_samples_, 0);
+  this->last_.assign(this->packet_samples_, 0);
+  this->reset();
+}
+
+void JitterBuffer::set_delay_range_ms(uint32_t min_delay_ms, uint32_t max_delay_ms) {
+  const uint64_t packet_us = std::max<uint32_t>(1, this->packet_us_);
+  size_t min_packets = static_cast<size_t>((min_delay_ms * 1000ULL + packet_us - 1) / packet_us);
+  size_t max_packets = static_cast<size_t>(max_delay_ms * 1000ULL / packet_us);
+  this->min_delay_packets_ = std::max<size_t>(1, std::min(min_packets, CAPACITY - 1));
+  this->max_delay_packets_ = std::max(this->min_delay_packets_, std::min(max_packets, CAPACITY - 1));
+  this->update_target_();
+}
+
+void JitterBuffer::reset() {
+  for (auto &slot : this->slots_)
+    slot.filled = false;
+  std::fill(this->last_.begin(), this->last_.end(), 0);
+  this->started_ = false;
+  this->buffering_ = true;
+  this->consecutive_losses_ = 0;
+  this->over_target_ticks_ = 0;
+  this->has_transit_ = false;
+  this->jitter_us_ = 0.0f;
+  this->stats_ = JitterBufferStats();
+  this->update_target_();
+}
+
+size_t JitterBuffer::get_depth() const {
+  if (!this->started_)
+    return 0;
+  int16_t distance = sequence_distance(this->next_sequence_, this->newest_sequence_);
+  return distance < 0 ? 0 : distance + 1;
+}
+
+void JitterBuffer::update_target_() {
+  size_t target = 1;
+  if (this->packet_us_ > 0)
+    target += static_cast<size_t>(std::ceil(3.0f * this->jitter_us_ / this->packet_us_));
+  this->target_packets_ = std::max(this->min_delay_packets_, std::min(this->max_delay_packets_, target));
+}
+
+bool JitterBuffer::insert(uint16_t sequence, uint32_t timestamp, const int16_t *samples, int64_t arrival_us) {
+  if (!this->started_) {
+    this->next_sequence_ = sequence;
+    this->newest_sequence_ = sequence;
+    this->started_ = true;
+  }
+  int16_t distance = sequence_distance(this->next_sequence_, sequence);
+  if (distance < 0) {
+    this->stats_.late++;
+    return false;
+  }
+  if (distance >= static_cast<int16_t>(CAPACITY)) {
+    // Too far ahead to hold the gap: the sender restarted or this side stalled, start over here
+    for (auto &slot : this->slots_)
+      slot.filled = false;
+    this->next_sequence_ = sequence;
+    this->newest_sequence_ = sequence;
+    this->buffering_ = true;
+    this->has_transit_ = false;
+    this->stats_.resyncs++;
+  }
+
+  Slot &slot = this->slots_[sequence % CAPACITY];
+  if (slot.filled && slot.sequence == sequence) {
+    this->stats_.duplicates++;
+    return false;
+  }
+  std::memcpy(this->slot_samples_(sequence), samples, this->packet_samples_ * sizeof(int16_t));
+  slot.filled = true;
+  slot.sequence = sequence;
+  if (sequence_distance(this->newest_sequence_, sequence) > 0)
+    this->newest_sequence_ = sequence;
+  this->stats_.received++;
+
+  // RFC 3550 interarrival jitter: the change in transit time between consecutive arrivals
+  if (this->has_transit_) {
+    int32_t media_delta = static_cast<int32_t>(timestamp - this->last_timestamp_);
+    double expected_us = static_cast<double>(media_delta) * 1000000.0 / this->clock_rate_;
+    float deviation = std::fabs(static_cast<float>(arrival_us - this->last_arrival_us_ - expected_us));
+    this->jitter_us_ += (deviation - this->jitter_us_) / 16.0f;
+    this->update_target_();
+  }
+  this->has_transit_ = true;
+  this->last_arrival_us_ = arrival_us;
+  this->last_timestamp_ = timestamp;
+  return true;
+}
+
+void JitterBuffer::advance_() {
+  this->slots_[this->next_sequence_ % CAPACITY].filled = false;
+  this->next_sequence_++;
+}
+
+void JitterBuffer::ramp_(const int16_t *src, int16_t *out, int32_t from, int32_t to) const {
+  const size_t channels = this->packet_samples_ / this->packet_frames_;
+  const int64_t frames = static_cast<int64_t>(this->packet_frames_);  // signed, the ramp can go down
+  for (int64_t f = 0; f < frames; f++) {
+    int32_t gain = from + static_cast<int32_t>((to - from) * f / frames);
+    for (size_t c = 0; c < channels; c++) {
+      size_t i = f * channels + c;
+      out[i] = static_cast<int16_t>((static_cast<int32_t>(src[i]) * gain) >> 15);
+    }
+  }
+}
+
+PlayoutResult JitterBuffer::pop(int16_t *out) {
+  if (this->buffering_) {
+    if (this->get_depth() < this->target_packets_)
+      return PlayoutResult::BUFFERING;
+    this->buffering_ = false;
+    this->over_target_ticks_ = 0;
+  }
+
+  const Slot &slot = this->slots_[this->next_sequence_ % CAPACITY];
+  if (slot.filled && slot.sequence == this->next_sequence_) {
+    const int16_t *samples = this->slot_samples_(this->next_sequence_);
+    if (this->consecutive_losses_ > 0) {
+      // Ramp back up from where the concealment left off
+      int32_t from = UNITY_GAIN >> std::min<uint32_t>(this->consecutive_losses_, 15);
+      this->ramp_(samples, out, from, UNITY_GAIN);
+    } else {
+      std::memcpy(out, samples, this->packet_samples_ * sizeof(int16_t));
+    }
+    std::memcpy(this->last_.data(), samples, this->packet_samples_ * sizeof(int16_t));
+    this->consecutive_losses_ = 0;
+    this->advance_();
+
+    if (this->get_depth() > this->target_packets_ + 1) {
+      if (++this->over_target_ticks_ >= ADAPT_PACKETS) {
+        this->advance_();
+        this->stats_.dropped++;
+        this->over_target_ticks_ = 0;
+      }
+    } else {
+      this->over_target_ticks_ = 0;
+    }
+    return PlayoutResult::PLAYED;
+  }
+
+  // Missing: fade the last packet out, halving the gain per consecutive loss
+  int32_t from = UNITY_GAIN >> std::min<uint32_t>(this->consecutive_losses_, 15);
+  this->ramp_(this->last_.data(), out, from, from >> 1);
+  this->consecutive_losses_++;
+  this->stats_.concealed++;
+  if (this->get_depth() > 0) {
+    this->advance_();  // later packets are here, this one is lost or too late to wait for
+  }
+  if (this->consecutive_losses_ >= MAX_CONCEALED) {
+    this->buffering_ = true;
+    this->started_ = this->get_depth() > 0;
+  }
+  return PlayoutResult::CONCEALED;
+}
+
+}  // namespace rtp_receiver
+}  // namespace esphome
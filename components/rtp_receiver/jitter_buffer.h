@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace esphome {
+namespace rtp_receiver {
+
+enum class PlayoutResult : uint8_t {
+  BUFFERING = 0,  // nothing to play yet, the caller outputs nothing
+  PLAYED,         // a received packet
+  CONCEALED,      // a missing packet, filled in from the last one
+};
+
+struct JitterBufferStats {
+  uint32_t received{0};
+  uint32_t late{0};        // arrived after their slot was played or concealed
+  uint32_t duplicates{0};
+  uint32_t concealed{0};
+  uint32_t dropped{0};     // played out of order to shrink the delay
+  uint32_t resyncs{0};     // sequence jumps too far to buffer, e.g. a restarted sender
+};
+
+/// Reorders fixed-size PCM packets by RTP sequence number and plays them out one per tick.
+///
+/// The delay it holds adapts to the interarrival jitter (RFC 3550 estimate): the target is enough
+/// packets to cover three times the jitter, within the configured bounds. When the next packet is
+/// missing but later ones have arrived, it is counted lost and concealed; when nothing has arrived
+/// the tick is concealed without advancing, which grows the delay by one packet. A depth that
+/// stays above the target for ADAPT_PACKETS ticks is trimmed by dropping a packet.
+///
+/// Concealment repeats the last packet with a gain that halves every consecutive loss, ramped
+/// across the packet; the first packet after a loss ramps back up. After MAX_CONCEALED losses in a
+/// row the buffer goes back to buffering until the target depth is reached again.
+///
+/// Pure logic with no socket or timer access, so it runs unchanged on the host.
+class JitterBuffer {
+ public:
+  static const size_t CAPACITY = 32;  // packets
+  static const uint32_t ADAPT_PACKETS = 50;
+  static const uint32_t MAX_CONCEALED = 5;
+
+  /// Sizes the storage for packets of `packet_frames` frames and starts over.
+  void configure(uint32_t sample_rate, uint8_t channels, size_t packet_frames);
+  /// Rate of the RTP timestamps, the sample rate unless set after configure(). Opus streams always
+  /// count at 48 kHz (RFC 7587), whatever rate they are decoded at.
+  void set_clock_rate(uint32_t clock_rate) { this->clock_rate_ = clock_rate; }
+  /// Bounds for the adaptive delay, rounded to whole packets of at least one; call after configure().
+  void set_delay_range_ms(uint32_t min_delay_ms, uint32_t max_delay_ms);
+  /// Forgets all packets and statistics, e.g. for a new stream.
+  void reset();
+
+  /// Stores one packet of `packet_frames` interleaved frames. `arrival_us` is any monotonic clock.
+  /// Returns false if the packet was late or a duplicate.
+  bool insert(uint16_t sequence, uint32_t timestamp, const int16_t *samples, int64_t arrival_us);
+  /// Writes the next packet's worth of frames into `out` unless buffering.
+  PlayoutResult pop(int16_t *out);
+
+  bool is_buffering() const { return this->buffering_; }
+  /// Sequence number the next pop() plays or conceals.
+  uint16_t get_next_sequence() const { return this->next_sequence_; }
+  size_t get_packet_frames() const { return this->packet_frames_; }
+  uint32_t get_packet_us() const { return this->packet_us_; }
+  /// Packets from the next one to play up to the newest received, holes included.
+  size_t get_depth() const;
+  size_t get_target_packets() const { return this->target_packets_; }
+  uint32_t get_jitter_us() const { return static_cast<uint32_t>(this->jitter_us_); }
+  const JitterBufferStats &get_stats() const { return this->stats_; }
+
+ protected:
+  struct Slot {
+    bool filled;
+    uint16_t sequence;
+  };
+
+  int16_t *slot_samples_(uint16_t sequence) {
+    return this->storage_.data() + (sequence % CAPACITY) * this->packet_samples_;
+  }
+  void advance_();
+  void update_target_();
+  /// Copies `src` to `out` with a gain ramped from `from` to `to` (Q15).
+  void ramp_(const int16_t *src, int16_t *out, int32_t from, int32_t to) const;
+
+  uint32_t sample_rate_{16000};
+  uint32_t clock_rate_{16000};
+  size_t packet_frames_{0};
+  size_t packet_samples_{0};
+  uint32_t packet_us_{0};
+  size_t min_delay_packets_{2};
+  size_t max_delay_packets_{10};
+  size_t target_packets_{2};
+
+  std::vector<int16_t> storage_;  // CAPACITY packets, indexed by sequence % CAPACITY
+  std::vector<int16_t> last_;     // last packet played, the concealment source
+  Slot slots_[CAPACITY]{};
+
+  bool started_{false};    // next_sequence_ and newest_sequence_ are valid
+  bool buffering_{true};
+  uint16_t next_sequence_{0};
+  uint16_t newest_sequence_{0};
+  uint32_t consecutive_losses_{0};
+  uint32_t over_target_ticks_{0};
+
+  bool has_transit_{false};
+  int64_t last_arrival_us_{0};
+  uint32_t last_timestamp_{0};
+  float jitter_us_{0.0f};
+
+  JitterBufferStats stats_;
+};
+
+}  // namespace rtp_receiver
+}  // namespace esphome
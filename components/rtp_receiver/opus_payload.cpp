@@ -0,0 +1,62 @@
+#include "opus_payload.h"
+
+#ifdef USE_RTP_RECEIVER_OPUS
+
+#include "esphome/core/log.h"
+
+#include <esp_opus_dec.h>
+
+namespace esphome {
+namespace rtp_receiver {
+
+static const char *const TAG = "rtp_receiver.opus";
+
+bool OpusPayloadDecoder::open(uint32_t sample_rate, uint8_t channels) {
+  this->close();
+  esp_opus_dec_cfg_t cfg = ESP_OPUS_DEC_CONFIG_DEFAULT();
+  cfg.sample_rate = sample_rate;
+  cfg.channel = channels;
+  cfg.self_delimited = false;
+  esp_audio_err_t err = esp_opus_dec_open(&cfg, sizeof(cfg), &this->decoder_);
+  if (err != ESP_AUDIO_ERR_OK) {
+    ESP_LOGE(TAG, "Failed to open the Opus decoder: %d", (int) err);
+    this->decoder_ = nullptr;
+    return false;
+  }
+  this->sample_rate_ = sample_rate;
+  this->channels_ = channels;
+  return true;
+}
+
+void OpusPayloadDecoder::close() {
+  if (this->decoder_ != nullptr) {
+    esp_opus_dec_close(this->decoder_);
+    this->decoder_ = nullptr;
+  }
+}
+
+bool OpusPayloadDecoder::reset() {
+  return this->open(this->sample_rate_, this->channels_);
+}
+
+size_t OpusPayloadDecoder::decode(const uint8_t *payload, size_t size, int16_t *out, size_t max_frames) {
+  if (this->decoder_ == nullptr)
+    return 0;
+  const size_t frame_size = this->channels_ * sizeof(int16_t);
+  esp_audio_dec_in_raw_t raw = {};
+  raw.buffer = const_cast<uint8_t *>(payload);
+  raw.len = size;
+  esp_audio_dec_out_frame_t frame = {};
+  frame.buffer = reinterpret_cast<uint8_t *>(out);
+  frame.len = max_frames * frame_size;
+  esp_audio_dec_info_t info = {};
+  esp_audio_err_t err = esp_opus_dec_decode(this->decoder_, &raw, &frame, &info);
+  if (err != ESP_AUDIO_ERR_OK || frame.decoded_size % frame_size != 0)
+    return 0;
+  return frame.decoded_size / frame_size;
+}
+
+}  // namespace rtp_receiver
+}  // namespace esphome
+
+#endif  // USE_RTP_RECEIVER_OPUS
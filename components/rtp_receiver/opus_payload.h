@@ -0,0 +1,41 @@
+#pragma once
+
+#ifdef USE_RTP_RECEIVER_OPUS
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace rtp_receiver {
+
+/// Opus RTP timestamps count at 48 kHz whatever the decoded rate (RFC 7587).
+static const uint32_t OPUS_CLOCK_RATE = 48000;
+/// Longest packet decoded; Opus allows 120 ms, but senders aiming for low latency stay at 20 ms.
+static const uint32_t OPUS_MAX_PACKET_MS = 60;
+
+/// Decodes Opus RTP payloads, one packet at a time, with esp_audio_codec, the frame decoder from
+/// esp-adf-libs. Packets are plain Opus frames, not self-delimited and not in Ogg pages.
+class OpusPayloadDecoder {
+ public:
+  ~OpusPayloadDecoder() { this->close(); }
+
+  /// Opus decodes at 8, 12, 16, 24 or 48 kHz with one or two channels.
+  bool open(uint32_t sample_rate, uint8_t channels);
+  void close();
+  /// Starts over for a new stream, dropping the decoder's prediction state.
+  bool reset();
+
+  /// Decodes one payload into `out`, which holds `max_frames` frames. Returns the frames decoded,
+  /// 0 for a payload that does not decode.
+  size_t decode(const uint8_t *payload, size_t size, int16_t *out, size_t max_frames);
+
+ protected:
+  void *decoder_{nullptr};
+  uint32_t sample_rate_{0};
+  uint8_t channels_{0};
+};
+
+}  // namespace rtp_receiver
+}  // namespace esphome
+
+#endif  // USE_RTP_RECEIVER_OPUS
@@ -0,0 +1,74 @@
+#include "rtp_packet.h"
+
+namespace esphome {
+namespace rtp_receiver {
+
+static inline uint16_t read_be16(const uint8_t *data) { return static_cast<uint16_t>((data[0] << 8) | data[1]); }
+
+static inline uint32_t read_be32(const uint8_t *data) {
+  return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) |
+         (static_cast<uint32_t>(data[2]) << 8) | data[3];
+}
+
+static inline void write_be16(uint8_t *data, uint16_t value) {
+  data[0] = static_cast<uint8_t>(value >> 8);
+  data[1] = static_cast<uint8_t>(value);
+}
+
+static inline void write_be32(uint8_t *data, uint32_t value) {
+  write_be16(data, static_cast<uint16_t>(value >> 16));
+  write_be16(data + 2, static_cast<uint16_t>(value));
+}
+
+bool parse_rtp_packet(const uint8_t *data, size_t size, RTPPacket *packet) {
+  if (size < RTP_HEADER_SIZE || (data[0] >> 6) != RTP_VERSION)
+    return false;
+  bool padding = data[0] & 0x20;
+  bool extension = data[0] & 0x10;
+  size_t offset = RTP_HEADER_SIZE + (data[0] & 0x0F) * 4;  // CSRC list
+  if (extension) {
+    if (size < offset + 4)
+      return false;
+    offset += 4 + read_be16(data + offset + 2) * 4;
+  }
+  if (size < offset)
+    return false;
+  size_t end = size;
+  if (padding) {
+    size_t padding_size = data[size - 1];
+    if (padding_size == 0 || end - offset < padding_size)
+      return false;
+    end -= padding_size;
+  }
+
+  packet->marker = data[1] & 0x80;
+  packet->payload_type = data[1] & 0x7F;
+  packet->sequence = read_be16(data + 2);
+  packet->timestamp = read_be32(data + 4);
+  packet->ssrc = read_be32(data + 8);
+  packet->payload = data + offset;
+  packet->payload_size = end - offset;
+  return true;
+}
+
+size_t write_rtp_header(uint8_t *data, const RTPPacket &packet) {
+  data[0] = RTP_VERSION << 6;
+  data[1] = (packet.marker ? 0x80 : 0) | (packet.payload_type & 0x7F);
+  write_be16(data + 2, packet.sequence);
+  write_be32(data + 4, packet.timestamp);
+  write_be32(data + 8, packet.ssrc);
+  return RTP_HEADER_SIZE;
+}
+
+void l16_to_host(const uint8_t *src, int16_t *dst, size_t count) {
+  for (size_t i = 0; i < count; i++)
+    dst[i] = static_cast<int16_t>(read_be16(src + i * 2));
+}
+
+void host_to_l16(const int16_t *src, uint8_t *dst, size_t count) {
+  for (size_t i = 0; i < count; i++)
+    write_be16(dst + i * 2, static_cast<uint16_t>(src[i]));
+}
+
+}  // namespace rtp_receiver
+}  // namespace esphome
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace rtp_receiver {
+
+static const size_t RTP_HEADER_SIZE = 12;
+static const uint8_t RTP_VERSION = 2;
+
+/// Fixed RTP header fields (RFC 3550) and the payload they frame. `payload` points into the
+/// buffer that was parsed.
+struct RTPPacket {
+  bool marker;
+  uint8_t payload_type;
+  uint16_t sequence;
+  uint32_t timestamp;
+  uint32_t ssrc;
+  const uint8_t *payload;
+  size_t payload_size;
+};
+
+/// Parses one datagram, skipping CSRCs, the header extension and padding. Returns false for
+/// anything that is not a well formed version 2 packet.
+bool parse_rtp_packet(const uint8_t *data, size_t size, RTPPacket *packet);
+
+/// Writes a 12 byte header without CSRCs or extension, for senders and tests. Returns the bytes
+/// written.
+size_t write_rtp_header(uint8_t *data, const RTPPacket &packet);
+
+/// L16 (RFC 3551) payloads are big-endian 16-bit samples; converts `count` of them to host order.
+void l16_to_host(const uint8_t *src, int16_t *dst, size_t count);
+void host_to_l16(const int16_t *src, uint8_t *dst, size_t count);
+
+/// Signed distance from sequence number `from` to `to`, across the 16-bit wrap.
+inline int16_t sequence_distance(uint16_t from, uint16_t to) { return static_cast<int16_t>(to - from); }
+
+}  // namespace rtp_receiver
+}  // namespace esphome
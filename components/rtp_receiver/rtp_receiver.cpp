@@ -0,0 +1,258 @@
+#include "rtp_receiver.h"
+
+#ifdef USE_ESP32
+
+#include <esp_timer.h>
+#include <lwip/sockets.h>
+
+#include <cinttypes>
+
+#include "esphome/core/hal.h"
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace rtp_receiver {
+
+static const char *const TAG = "rtp_receiver";
+
+static const size_t PACKET_QUEUE_SIZE = 8;
+static const uint32_t STREAM_TIMEOUT_MS = 1000;
+static const uint32_t STATS_INTERVAL_MS = 10000;
+static const uint32_t RECEIVE_ERROR_DELAY_MS = 100;
+
+static const char *codec_to_string(RTPCodec codec) {
+  switch (codec) {
+    case RTPCodec::L16:
+      return "L16";
+    case RTPCodec::OPUS:
+      return "Opus";
+    default:
+      return "unknown";
+  }
+}
+
+void RTPReceiver::setup() {
+  ESP_LOGCONFIG(TAG, "Setting up RTP receiver...");
+
+  this->packet_queue_ = xQueueCreate(PACKET_QUEUE_SIZE, sizeof(PacketEvent));
+  if (this->packet_queue_ == nullptr) {
+    ESP_LOGE(TAG, "Failed to create packet queue");
+    this->mark_failed();
+    return;
+  }
+  size_t max_frames = (MAX_PACKET_SIZE - RTP_HEADER_SIZE) / (this->channels_ * sizeof(int16_t));
+#ifdef USE_RTP_RECEIVER_OPUS
+  if (this->codec_ == RTPCodec::OPUS) {
+    if (!this->opus_.open(this->sample_rate_, this->channels_)) {
+      this->mark_failed();
+      return;
+    }
+    max_frames = this->sample_rate_ * OPUS_MAX_PACKET_MS / 1000;
+  }
+#endif
+  this->samples_.assign(max_frames * this->channels_, 0);
+  if (!this->open_socket_()) {
+    this->mark_failed();
+    return;
+  }
+  // Above the speakers' player tasks so arrivals are stamped promptly
+  xTaskCreate(RTPReceiver::receive_task, "rtp_task", 4096, (void *) this, 2, &this->receive_task_handle_);
+}
+
+bool RTPReceiver::open_socket_() {
+  this->socket_ = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (this->socket_ < 0) {
+    ESP_LOGE(TAG, "Failed to create socket: errno %d", errno);
+    return false;
+  }
+  struct sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(this->port_);
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (bind(this->socket_, (struct sockaddr *) &address, sizeof(address)) != 0) {
+    ESP_LOGE(TAG, "Failed to bind port %u: errno %d", this->port_, errno);
+    close(this->socket_);
+    this->socket_ = -1;
+    return false;
+  }
+  if (!this->multicast_address_.empty()) {
+    struct ip_mreq request = {};
+    request.imr_multiaddr.s_addr = inet_addr(this->multicast_address_.c_str());
+    request.imr_interface.s_addr = htonl(INADDR_ANY);
+    if (setsockopt(this->socket_, IPPROTO_IP, IP_ADD_MEMBERSHIP, &request, sizeof(request)) != 0) {
+      ESP_LOGE(TAG, "Failed to join %s: errno %d", this->multicast_address_.c_str(), errno);
+      close(this->socket_);
+      this->socket_ = -1;
+      return false;
+    }
+  }
+  return true;
+}
+
+void RTPReceiver::receive_task(void *params) {
+  RTPReceiver *this_receiver = (RTPReceiver *) params;
+  PacketEvent event;
+  while (true) {
+    ssize_t received = recv(this_receiver->socket_, event.data, sizeof(event.data), 0);
+    if (received <= 0) {
+      // Errors, e.g. while the interface is down, return at once; do not spin on them
+      vTaskDelay(pdMS_TO_TICKS(RECEIVE_ERROR_DELAY_MS));
+      continue;
+    }
+    event.arrival_us = esp_timer_get_time();
+    event.len = received;
+    if (xQueueSend(this_receiver->packet_queue_, &event, 0) != pdTRUE)
+      this_receiver->queue_overflows_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void RTPReceiver::loop() {
+  while (xQueueReceive(this->packet_queue_, &this->event_, 0) == pdTRUE)
+    this->handle_packet_(this->event_);
+
+  if (!this->active_)
+    return;
+  this->play_();
+
+  const uint32_t now = millis();
+  if (!this->playing_ && now - this->last_packet_ms_ > STREAM_TIMEOUT_MS) {
+    this->end_stream_();
+  } else if (now - this->last_stats_ms_ > STATS_INTERVAL_MS) {
+    this->last_stats_ms_ = now;
+    this->log_stats_("receiving");
+  }
+}
+
+void RTPReceiver::handle_packet_(const PacketEvent &event) {
+  RTPPacket packet;
+  if (!parse_rtp_packet(event.data, event.len, &packet) || packet.payload_type != this->payload_type_) {
+    this->malformed_++;
+    return;
+  }
+  const bool new_stream = !this->active_ || packet.ssrc != this->ssrc_;
+  const size_t frames = this->decode_payload_(packet, new_stream);
+  if (frames == 0) {
+    this->malformed_++;
+    return;
+  }
+  if (new_stream) {
+    if (this->active_)
+      this->end_stream_();
+    this->start_stream_(packet.ssrc, frames);
+  }
+  if (frames != this->jitter_buffer_.get_packet_frames()) {
+    this->malformed_++;  // the packet duration is fixed by the first packet of the stream
+    return;
+  }
+
+  this->jitter_buffer_.insert(packet.sequence, packet.timestamp, this->samples_.data(), event.arrival_us);
+  this->last_packet_ms_ = millis();
+}
+
+size_t RTPReceiver::decode_payload_(const RTPPacket &packet, [[maybe_unused]] bool new_stream) {
+  const size_t frame_size = this->channels_ * sizeof(int16_t);
+#ifdef USE_RTP_RECEIVER_OPUS
+  if (this->codec_ == RTPCodec::OPUS) {
+    // Each stream starts from a fresh decoder state, the last stream's would only add a glitch
+    if (new_stream && !this->opus_.reset())
+      return 0;
+    return this->opus_.decode(packet.payload, packet.payload_size, this->samples_.data(),
+                              this->samples_.size() / this->channels_);
+  }
+#endif
+  if (packet.payload_size == 0 || packet.payload_size % frame_size != 0)
+    return 0;
+  const size_t frames = packet.payload_size / frame_size;
+  l16_to_host(packet.payload, this->samples_.data(), frames * this->channels_);
+  return frames;
+}
+
+void RTPReceiver::start_stream_(uint32_t ssrc, size_t packet_frames) {
+  this->ssrc_ = ssrc;
+  this->jitter_buffer_.configure(this->sample_rate_, this->channels_, packet_frames);
+#ifdef USE_RTP_RECEIVER_OPUS
+  if (this->codec_ == RTPCodec::OPUS)
+    this->jitter_buffer_.set_clock_rate(OPUS_CLOCK_RATE);
+#endif
+  this->jitter_buffer_.set_delay_range_ms(this->min_delay_ms_, this->max_delay_ms_);
+  this->playout_.assign(packet_frames * this->channels_, 0);
+  this->pending_size_ = 0;
+  this->malformed_ = 0;
+  this->speaker_overruns_ = 0;
+  this->active_ = true;
+  this->playing_ = false;
+  this->last_stats_ms_ = millis();
+  this->high_freq_.start();
+  ESP_LOGI(TAG, "Receiving stream %08" PRIx32 ", %u ms packets", ssrc,
+           (unsigned) (this->jitter_buffer_.get_packet_us() / 1000));
+}
+
+void RTPReceiver::end_stream_() {
+  this->log_stats_("ended");
+  this->active_ = false;
+  this->playing_ = false;
+  this->high_freq_.stop();
+}
+
+void RTPReceiver::play_() {
+  const int64_t now = esp_timer_get_time();
+  while (this->flush_playout_()) {
+    if (this->playing_ && now < this->next_tick_us_)
+      return;
+
+    PlayoutResult result = this->jitter_buffer_.pop(this->playout_.data());
+    if (result == PlayoutResult::BUFFERING) {
+      this->playing_ = false;
+      return;
+    }
+    if (!this->playing_) {
+      this->playing_ = true;
+      this->next_tick_us_ = now;
+    }
+    this->next_tick_us_ += this->jitter_buffer_.get_packet_us();
+    this->pending_offset_ = 0;
+    this->pending_size_ = this->playout_.size() * sizeof(int16_t);
+    if (!this->flush_playout_()) {
+      this->speaker_overruns_++;
+      return;
+    }
+  }
+}
+
+bool RTPReceiver::flush_playout_() {
+  if (this->pending_size_ == 0)
+    return true;
+  const uint8_t *data = reinterpret_cast<const uint8_t *>(this->playout_.data()) + this->pending_offset_;
+  size_t written = this->speaker_->play(data, this->pending_size_);
+  this->pending_offset_ += written;
+  this->pending_size_ -= written;
+  return this->pending_size_ == 0;  // otherwise the speaker's queue is full, retry on the next loop
+}
+
+void RTPReceiver::log_stats_(const char *reason) {
+  [[maybe_unused]] const JitterBufferStats &stats = this->jitter_buffer_.get_stats();
+  [[maybe_unused]] const uint32_t packet_us = this->jitter_buffer_.get_packet_us();
+  ESP_LOGD(TAG, "Stream %08" PRIx32 " %s: %" PRIu32 " received, %" PRIu32 " concealed, %" PRIu32 " late, %" PRIu32
+           " duplicate, %" PRIu32 " dropped, %" PRIu32 " malformed, %" PRIu32 " queue overflows",
+           this->ssrc_, reason, stats.received, stats.concealed, stats.late, stats.duplicates, stats.dropped,
+           this->malformed_, this->queue_overflows_.load(std::memory_order_relaxed));
+  ESP_LOGD(TAG, "  Jitter %" PRIu32 " us, buffer %u/%u packets (%" PRIu32 " ms), %" PRIu32 " speaker overruns",
+           this->jitter_buffer_.get_jitter_us(), (unsigned) this->jitter_buffer_.get_depth(),
+           (unsigned) this->jitter_buffer_.get_target_packets(),
+           (uint32_t) (this->jitter_buffer_.get_target_packets() * packet_us / 1000), this->speaker_overruns_);
+}
+
+void RTPReceiver::dump_config() {
+  ESP_LOGCONFIG(TAG, "RTP Receiver:");
+  ESP_LOGCONFIG(TAG, "  Port: %u", this->port_);
+  if (!this->multicast_address_.empty())
+    ESP_LOGCONFIG(TAG, "  Multicast address: %s", this->multicast_address_.c_str());
+  ESP_LOGCONFIG(TAG, "  Payload: %s, type %u, %" PRIu32 " Hz, %u channel(s)", codec_to_string(this->codec_),
+                this->payload_type_, this->sample_rate_, this->channels_);
+  ESP_LOGCONFIG(TAG, "  Delay: %" PRIu32 "-%" PRIu32 " ms", this->min_delay_ms_, this->max_delay_ms_);
+}
+
+}  // namespace rtp_receiver
+}  // namespace esphome
+
+#endif  // USE_ESP32
@@ -0,0 +1,122 @@
+#pragma once
+
+#ifdef USE_ESP32
+
+#include "jitter_buffer.h"
+#include "opus_payload.h"
+#include "rtp_packet.h"
+
+#include "esphome/components/speaker/speaker.h"
+#include "esphome/core/component.h"
+#include "esphome/core/helpers.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace esphome {
+namespace rtp_receiver {
+
+static const size_t MAX_PACKET_SIZE = 1472;  // Ethernet MTU less the IPv4 and UDP headers
+
+enum class RTPCodec : uint8_t {
+  L16 = 0,  // RFC 3551 big-endian 16-bit PCM
+  OPUS,     // RFC 7587, decoded as it arrives
+};
+
+struct PacketEvent {
+  int64_t arrival_us;
+  size_t len;
+  uint8_t data[MAX_PACKET_SIZE];
+};
+
+/// Receives L16 or Opus audio over RTP/UDP, unicast or multicast, and plays it on a speaker.
+///
+/// A task blocks on the socket and hands datagrams to the main loop through a queue, stamped with
+/// their arrival time. The main loop parses them, tracks the stream by SSRC, decodes Opus payloads
+/// and feeds the PCM to the jitter buffer, then plays one packet per packet duration from it; lost
+/// packets are concealed there for both codecs. The playout clock is esp_timer,
+/// which runs from the same crystal as the I2S clock, so the speaker's queue holds steady without
+/// a drift loop; the sender's drift shows up as buffer depth and is handled by the jitter buffer.
+///
+/// The speaker must be configured for the stream's format: 16-bit samples at the stream's rate and
+/// channel count (16 kHz mono for the ESP-ADF speaker). Opus is decoded at that rate and channel
+/// count whatever the sender encoded.
+class RTPReceiver : public Component {
+ public:
+  void setup() override;
+  void loop() override;
+  void dump_config() override;
+  float get_setup_priority() const override { return setup_priority::AFTER_WIFI; }
+
+  void set_speaker(speaker::Speaker *speaker) { this->speaker_ = speaker; }
+  void set_port(uint16_t port) { this->port_ = port; }
+  void set_multicast_address(const std::string &address) { this->multicast_address_ = address; }
+  void set_codec(RTPCodec codec) { this->codec_ = codec; }
+  void set_payload_type(uint8_t payload_type) { this->payload_type_ = payload_type; }
+  void set_sample_rate(uint32_t sample_rate) { this->sample_rate_ = sample_rate; }
+  void set_channels(uint8_t channels) { this->channels_ = channels; }
+  void set_min_delay(uint32_t min_delay_ms) { this->min_delay_ms_ = min_delay_ms; }
+  void set_max_delay(uint32_t max_delay_ms) { this->max_delay_ms_ = max_delay_ms; }
+
+  const JitterBuffer &get_jitter_buffer() const { return this->jitter_buffer_; }
+  bool is_receiving() const { return this->active_; }
+
+ protected:
+  static void receive_task(void *params);
+  bool open_socket_();
+  void handle_packet_(const PacketEvent &event);
+  /// Fills samples_ from the packet's payload and returns the frames it holds, 0 if it is malformed.
+  size_t decode_payload_(const RTPPacket &packet, bool new_stream);
+  void start_stream_(uint32_t ssrc, size_t packet_frames);
+  void end_stream_();
+  void play_();
+  /// Hands the rest of playout_ to the speaker; false while the speaker's queue is full.
+  bool flush_playout_();
+  void log_stats_(const char *reason);
+
+  speaker::Speaker *speaker_{nullptr};
+  uint16_t port_{5004};
+  std::string multicast_address_;
+  RTPCodec codec_{RTPCodec::L16};
+  uint8_t payload_type_{96};
+  uint32_t sample_rate_{16000};
+  uint8_t channels_{1};
+  uint32_t min_delay_ms_{20};
+  uint32_t max_delay_ms_{200};
+
+  int socket_{-1};
+  TaskHandle_t receive_task_handle_{nullptr};
+  QueueHandle_t packet_queue_{nullptr};
+  std::atomic<uint32_t> queue_overflows_{0};  // written by the receive task
+  PacketEvent event_;                          // main loop's copy of the packet being handled
+
+  JitterBuffer jitter_buffer_;
+  std::vector<int16_t> samples_;  // one packet in host order, sized for the longest one
+#ifdef USE_RTP_RECEIVER_OPUS
+  OpusPayloadDecoder opus_;
+#endif
+  std::vector<int16_t> playout_;  // one packet on its way to the speaker
+  size_t pending_offset_{0};      // bytes of playout_ the speaker has taken
+  size_t pending_size_{0};        // bytes of playout_ still to hand over
+
+  bool active_{false};  // a stream is being received
+  bool playing_{false};
+  uint32_t ssrc_{0};
+  int64_t next_tick_us_{0};
+  uint32_t last_packet_ms_{0};
+  uint32_t last_stats_ms_{0};
+  uint32_t malformed_{0};
+  uint32_t speaker_overruns_{0};
+
+  HighFrequencyLoopRequester high_freq_;
+};
+
+}  // namespace rtp_receiver
+}  // namespace esphome
+
+#endif  // USE_ESP32
@@ -0,0 +1,47 @@
+#pragma once
+
+// Host stand-in for ESP-ADF audio elements. Elements with work of their own (I2S, resample) run
+// on a pthread between their input and output ring buffers; raw streams are passive.
+
+#include "esp_err.h"
+#include "ringbuf.h"
+
+#include <cstdint>
+
+typedef enum {
+  AUDIO_STREAM_NONE = 0,
+  AUDIO_STREAM_READER,
+  AUDIO_STREAM_WRITER,
+} audio_stream_type_t;
+
+#define AEL_IO_OK ESP_OK
+#define AEL_IO_FAIL ESP_FAIL
+#define AEL_IO_DONE RB_DONE
+#define AEL_IO_ABORT RB_ABORT
+#define AEL_IO_TIMEOUT RB_TIMEOUT
+
+struct HostElement;
+typedef HostElement *audio_element_handle_t;
+
+/// What an element knows about the stream passing through it. byte_pos counts what the I2S writer
+/// has handed to the DMA.
+typedef struct {
+  int sample_rates;
+  int channels;
+  int bits;
+  int bps;
+  int64_t byte_pos;
+  int64_t total_bytes;
+  int duration;
+  char *uri;
+} audio_element_info_t;
+
+esp_err_t audio_element_deinit(audio_element_handle_t el);
+esp_err_t audio_element_set_uri(audio_element_handle_t el, const char *uri);
+const char *audio_element_get_tag(audio_element_handle_t el);
+ringbuf_handle_t audio_element_get_input_ringbuf(audio_element_handle_t el);
+ringbuf_handle_t audio_element_get_output_ringbuf(audio_element_handle_t el);
+esp_err_t audio_element_getinfo(audio_element_handle_t el, audio_element_info_t *info);
+/// A paused I2S writer takes nothing new; its DMA plays out what it holds, then silence.
+esp_err_t audio_element_pause(audio_element_handle_t el);
+esp_err_t audio_element_resume(audio_element_handle_t el, float wait_for_rb_threshold, TickType_t timeout);
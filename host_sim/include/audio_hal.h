@@ -0,0 +1,24 @@
+#pragma once
+
+// Host stand-in for the ADF codec HAL: the codec is not simulated, the HAL only keeps the volume.
+
+#include "esp_err.h"
+
+typedef enum {
+  AUDIO_HAL_CODEC_MODE_ENCODE = 1,
+  AUDIO_HAL_CODEC_MODE_DECODE,
+  AUDIO_HAL_CODEC_MODE_BOTH,
+  AUDIO_HAL_CODEC_MODE_LINE_IN,
+} audio_hal_codec_mode_t;
+
+typedef enum {
+  AUDIO_HAL_CTRL_STOP = 0,
+  AUDIO_HAL_CTRL_START,
+} audio_hal_ctrl_t;
+
+struct audio_hal;
+typedef struct audio_hal *audio_hal_handle_t;
+
+esp_err_t audio_hal_ctrl_codec(audio_hal_handle_t audio_hal, audio_hal_codec_mode_t mode, audio_hal_ctrl_t audio_hal_ctrl);
+esp_err_t audio_hal_set_volume(audio_hal_handle_t audio_hal, int volume);
+esp_err_t audio_hal_get_volume(audio_hal_handle_t audio_hal, int *volume);
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "audio_element.h"
+
+#define DEFAULT_PIPELINE_RINGBUF_SIZE (8 * 1024)
+
+typedef struct {
+  int rb_size;
+} audio_pipeline_cfg_t;
+
+struct HostPipeline;
+typedef HostPipeline *audio_pipeline_handle_t;
+
+audio_pipeline_handle_t audio_pipeline_init(audio_pipeline_cfg_t *config);
+esp_err_t audio_pipeline_deinit(audio_pipeline_handle_t pipeline);
+esp_err_t audio_pipeline_register(audio_pipeline_handle_t pipeline, audio_element_handle_t el, const char *name);
+esp_err_t audio_pipeline_unregister(audio_pipeline_handle_t pipeline, audio_element_handle_t el);
+esp_err_t audio_pipeline_link(audio_pipeline_handle_t pipeline, const char *link_tag[], int link_num);
+esp_err_t audio_pipeline_run(audio_pipeline_handle_t pipeline);
+esp_err_t audio_pipeline_stop(audio_pipeline_handle_t pipeline);
+esp_err_t audio_pipeline_wait_for_stop(audio_pipeline_handle_t pipeline);
+esp_err_t audio_pipeline_terminate(audio_pipeline_handle_t pipeline);
+esp_err_t audio_pipeline_pause(audio_pipeline_handle_t pipeline);
+esp_err_t audio_pipeline_resume(audio_pipeline_handle_t pipeline);
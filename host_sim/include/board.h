@@ -0,0 +1,35 @@
+#pragma once
+
+// Host stand-in for the ADF audio board: one board with the fake codec of board.cpp and no keys.
+
+#include "audio_hal.h"
+#include "esp_peripherals.h"
+#include "input_key_service.h"
+
+#include "driver/gpio.h"
+
+#define PA_ENABLE_GPIO GPIO_NUM_21
+#define CODEC_ADC_I2S_PORT 0
+
+#define BUTTON_REC_ID 1
+#define BUTTON_SET_ID 2
+#define BUTTON_PLAY_ID 3
+#define BUTTON_MODE_ID 4
+#define BUTTON_VOLDOWN_ID 5
+#define BUTTON_VOLUP_ID 6
+
+#define ADC_BUTTON_STACK_SIZE 2560
+#define ADC_BUTTON_TASK_PRIORITY 10
+#define ADC_BUTTON_TASK_CORE_ID 1
+
+#define INPUT_KEY_NUM 0
+#define INPUT_KEY_DEFAULT_INFO() {}
+
+struct audio_board_handle {
+  audio_hal_handle_t audio_hal;
+};
+typedef struct audio_board_handle *audio_board_handle_t;
+
+audio_board_handle_t audio_board_init();
+esp_err_t audio_board_key_init(esp_periph_set_handle_t set);
+int8_t get_pa_enable_gpio();
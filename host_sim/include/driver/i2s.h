@@ -0,0 +1,52 @@
+#pragma once
+
+// Host stand-in for the legacy I2S driver configuration. Only the fields the simulated port
+// interprets matter: mode, sample_rate, channel_format, dma_buf_count and dma_buf_len.
+
+#include "esp_err.h"
+
+typedef enum { I2S_NUM_0 = 0, I2S_NUM_1, I2S_NUM_MAX } i2s_port_t;
+
+typedef enum {
+  I2S_MODE_MASTER = 1 << 0,
+  I2S_MODE_SLAVE = 1 << 1,
+  I2S_MODE_TX = 1 << 2,
+  I2S_MODE_RX = 1 << 3,
+} i2s_mode_t;
+
+typedef enum {
+  I2S_BITS_PER_SAMPLE_16BIT = 16,
+  I2S_BITS_PER_SAMPLE_24BIT = 24,
+  I2S_BITS_PER_SAMPLE_32BIT = 32,
+} i2s_bits_per_sample_t;
+
+typedef enum {
+  I2S_CHANNEL_FMT_RIGHT_LEFT = 0,
+  I2S_CHANNEL_FMT_ALL_RIGHT,
+  I2S_CHANNEL_FMT_ALL_LEFT,
+  I2S_CHANNEL_FMT_ONLY_RIGHT,
+  I2S_CHANNEL_FMT_ONLY_LEFT,
+} i2s_channel_fmt_t;
+
+typedef enum { I2S_COMM_FORMAT_STAND_I2S = 1 } i2s_comm_format_t;
+typedef enum { I2S_MCLK_MULTIPLE_256 = 256 } i2s_mclk_multiple_t;
+typedef enum { I2S_BITS_PER_CHAN_DEFAULT = 0 } i2s_bits_per_chan_t;
+
+#define ESP_INTR_FLAG_LEVEL2 (1 << 2)
+#define ESP_INTR_FLAG_IRAM (1 << 10)
+
+typedef struct {
+  i2s_mode_t mode;
+  uint32_t sample_rate;
+  i2s_bits_per_sample_t bits_per_sample;
+  i2s_channel_fmt_t channel_format;
+  i2s_comm_format_t communication_format;
+  int intr_alloc_flags;
+  int dma_buf_count;
+  int dma_buf_len;
+  bool use_apll;
+  bool tx_desc_auto_clear;
+  int fixed_mclk;
+  i2s_mclk_multiple_t mclk_multiple;
+  i2s_bits_per_chan_t bits_per_chan;
+} i2s_driver_config_t;
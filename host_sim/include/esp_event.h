@@ -0,0 +1,10 @@
+#pragma once
+
+// Host stand-in for the ESP-IDF event loop types.
+
+#include <cstddef>
+
+typedef const char *esp_event_base_t;
+
+#define ESP_EVENT_ANY_BASE NULL
+#define ESP_EVENT_ANY_ID -1
@@ -0,0 +1,17 @@
+#pragma once
+
+// Host stand-in: every capability maps to the C heap, which is reported as one large internal region
+// with no PSRAM fitted.
+
+#include <cstddef>
+#include <cstdint>
+
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+
+void *heap_caps_malloc(size_t size, uint32_t caps);
+void heap_caps_free(void *ptr);
+size_t heap_caps_get_free_size(uint32_t caps);
+size_t heap_caps_get_minimum_free_size(uint32_t caps);
+size_t heap_caps_get_largest_free_block(uint32_t caps);
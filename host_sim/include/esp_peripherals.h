@@ -0,0 +1,18 @@
+#pragma once
+
+// Host stand-in for the ADF peripheral set. There are no peripherals on the host; the set exists
+// so the components can start their key services.
+
+#include "esp_err.h"
+
+typedef struct {
+  int task_stack;
+  int task_prio;
+  int task_core;
+  bool extern_stack;
+} esp_periph_config_t;
+
+struct esp_periph_set;
+typedef struct esp_periph_set *esp_periph_set_handle_t;
+
+esp_periph_set_handle_t esp_periph_set_init(esp_periph_config_t *config);
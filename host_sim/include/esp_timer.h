@@ -0,0 +1,6 @@
+#pragma once
+
+#include <cstdint>
+
+/// Simulated microseconds since start, see host_sim/src/sim_clock.h.
+int64_t esp_timer_get_time();
@@ -0,0 +1,58 @@
+#pragma once
+
+// Host stand-in for an ESPHome I2C device: a register file behind a bus that records every
+// transaction, so tools can count what a driver sends. Registers read back what was last written.
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace esphome {
+namespace i2c {
+
+struct I2CTransaction {
+  bool read;
+  uint8_t reg;  // first register of the burst
+  uint8_t len;
+};
+
+class I2CDevice {
+ public:
+  void set_i2c_address(uint8_t address) { this->address_ = address; }
+
+  bool write_byte(uint8_t a_register, uint8_t data) { return this->write_bytes(a_register, &data, 1); }
+  bool write_bytes(uint8_t a_register, const uint8_t *data, uint8_t len) {
+    this->transactions_.push_back({false, a_register, len});
+    if (this->fail_next_) {
+      this->fail_next_ = false;
+      return false;
+    }
+    memcpy(&this->registers_[a_register], data, len);
+    return true;
+  }
+  bool read_bytes(uint8_t a_register, uint8_t *data, uint8_t len) {
+    this->transactions_.push_back({true, a_register, len});
+    if (this->fail_next_) {
+      this->fail_next_ = false;
+      return false;
+    }
+    memcpy(data, &this->registers_[a_register], len);
+    return true;
+  }
+
+  // Bus side, for the host tools
+  uint8_t get_bus_register(uint8_t reg) const { return this->registers_[reg]; }
+  const std::vector<I2CTransaction> &get_bus_transactions() const { return this->transactions_; }
+  void clear_bus_transactions() { this->transactions_.clear(); }
+  /// Fails the next transaction, as a NACK would.
+  void fail_next_bus_transaction() { this->fail_next_ = true; }
+
+ protected:
+  uint8_t address_{0};
+  uint8_t registers_[256 + 255]{};  // room for a burst starting at the last register
+  std::vector<I2CTransaction> transactions_;
+  bool fail_next_{false};
+};
+
+}  // namespace i2c
+}  // namespace esphome
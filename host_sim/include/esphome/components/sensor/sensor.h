@@ -0,0 +1,28 @@
+#pragma once
+
+// Host stand-in for ESPHome's Sensor: a name and the last published state.
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace esphome {
+namespace sensor {
+
+class Sensor {
+ public:
+  explicit Sensor(const std::string &name = "") : name_(name) {}
+
+  void publish_state(float state) { this->state = state; }
+
+  const std::string &get_name() const { return this->name_; }
+  uint32_t get_object_id_hash() const { return static_cast<uint32_t>(std::hash<std::string>()(this->name_)); }
+
+  float state{0.0f};
+
+ protected:
+  std::string name_;
+};
+
+}  // namespace sensor
+}  // namespace esphome
@@ -0,0 +1,36 @@
+#pragma once
+
+// Host stand-in for ESPHome's Speaker: the state machine the components drive, nothing else.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace speaker {
+
+enum State : uint8_t {
+  STATE_STOPPED = 0,
+  STATE_STARTING,
+  STATE_RUNNING,
+  STATE_STOPPING,
+};
+
+class Speaker {
+ public:
+  virtual ~Speaker() = default;
+
+  virtual size_t play(const uint8_t *data, size_t length) = 0;
+  virtual void start() = 0;
+  virtual void stop() = 0;
+  virtual bool has_buffered_data() const = 0;
+
+  bool is_running() const { return this->state_ == STATE_RUNNING; }
+  bool is_stopped() const { return this->state_ == STATE_STOPPED; }
+  State get_state() const { return this->state_; }
+
+ protected:
+  State state_{STATE_STOPPED};
+};
+
+}  // namespace speaker
+}  // namespace esphome
@@ -0,0 +1,29 @@
+#pragma once
+
+// Host stand-in for ESPHome's Application: only the sensor registry the speaker searches.
+
+#include "esphome/components/sensor/sensor.h"
+
+#include <vector>
+
+namespace esphome {
+
+class Application {
+ public:
+  void register_sensor(sensor::Sensor *sensor) { this->sensors_.push_back(sensor); }
+  const std::vector<sensor::Sensor *> &get_sensors() const { return this->sensors_; }
+  sensor::Sensor *get_sensor_by_key(uint32_t key, bool include_internal = false) {
+    for (auto *sensor : this->sensors_) {
+      if (sensor->get_object_id_hash() == key)
+        return sensor;
+    }
+    return nullptr;
+  }
+
+ protected:
+  std::vector<sensor::Sensor *> sensors_;
+};
+
+extern Application App;  // NOLINT
+
+}  // namespace esphome
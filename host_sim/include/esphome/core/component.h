@@ -0,0 +1,44 @@
+#pragma once
+
+// Host stand-in for ESPHome's Component: failure and warning flags only. There is no scheduler,
+// set_interval() callbacks never run.
+
+#include "esphome/core/helpers.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace esphome {
+
+namespace setup_priority {
+static const float HARDWARE = 800.0f;
+static const float DATA = 600.0f;
+static const float LATE = -100.0f;
+}  // namespace setup_priority
+
+static const uint32_t SCHEDULER_DONT_RUN = 4294967295UL;
+
+class Component {
+ public:
+  virtual ~Component() = default;
+
+  virtual void setup() {}
+  virtual void loop() {}
+  virtual void dump_config() {}
+  virtual float get_setup_priority() const { return setup_priority::DATA; }
+
+  void mark_failed() { this->failed_ = true; }
+  bool is_failed() const { return this->failed_; }
+  void status_set_warning() { this->warning_ = true; }
+  void status_clear_warning() { this->warning_ = false; }
+  bool status_has_warning() const { return this->warning_; }
+
+ protected:
+  void set_interval(const std::string &name, uint32_t interval, std::function<void()> &&f) {}
+
+  bool failed_{false};
+  bool warning_{false};
+};
+
+}  // namespace esphome
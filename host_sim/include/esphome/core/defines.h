@@ -0,0 +1,3 @@
+#pragma once
+
+// The host build passes its USE_* defines on the command line, see host_sim/CMakeLists.txt.
@@ -0,0 +1,14 @@
+#pragma once
+
+// Host stand-in for the ESPHome HAL, on simulated time.
+
+#include <cstdint>
+
+namespace esphome {
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+}  // namespace esphome
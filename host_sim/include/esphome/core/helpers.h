@@ -0,0 +1,52 @@
+#pragma once
+
+// Host stand-in for the ESPHome helpers the components use.
+
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+// ESP-IDF's esp_bit_defs.h, which the core headers bring in on the device
+#ifndef BIT
+#define BIT(nr) (1UL << (nr))
+#endif
+
+namespace esphome {
+
+template<typename T> constexpr const T &clamp(const T &v, const T &lo, const T &hi) {
+  return v < lo ? lo : (hi < v ? hi : v);
+}
+
+template<typename T, typename U> T remap(U value, U min, U max, T min_out, T max_out) {
+  return (value - min) * (max_out - min_out) / (max - min) + min_out;
+}
+
+template<typename T> class Parented {
+ public:
+  Parented() = default;
+  Parented(T *parent) : parent_(parent) {}
+
+  T *get_parent() const { return this->parent_; }
+  void set_parent(T *parent) { this->parent_ = parent; }
+
+ protected:
+  T *parent_{nullptr};
+};
+
+template<typename... X> class CallbackManager;
+
+template<typename... Ts> class CallbackManager<void(Ts...)> {
+ public:
+  void add(std::function<void(Ts...)> &&callback) { this->callbacks_.push_back(std::move(callback)); }
+  void call(Ts... args) {
+    for (auto &cb : this->callbacks_)
+      cb(args...);
+  }
+  size_t size() const { return this->callbacks_.size(); }
+
+ protected:
+  std::vector<std::function<void(Ts...)>> callbacks_;
+};
+
+}  // namespace esphome
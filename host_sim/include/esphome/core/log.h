@@ -0,0 +1,22 @@
+#pragma once
+
+// Host stand-in for the ESPHome logger, prints to stderr.
+
+#include <cstdio>
+
+#define ESP_HOST_LOG_(level, tag, format, ...) fprintf(stderr, "[" level "][%s] " format "\n", tag, ##__VA_ARGS__)
+
+#define ESP_LOGE(tag, format, ...) ESP_HOST_LOG_("E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) ESP_HOST_LOG_("W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) ESP_HOST_LOG_("I", tag, format, ##__VA_ARGS__)
+#define ESP_LOGCONFIG(tag, format, ...) ESP_HOST_LOG_("C", tag, format, ##__VA_ARGS__)
+#ifdef HOST_SIM_VERBOSE
+#define ESP_LOGD(tag, format, ...) ESP_HOST_LOG_("D", tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) ESP_HOST_LOG_("V", tag, format, ##__VA_ARGS__)
+#else
+#define ESP_LOGD(tag, format, ...) ((void) 0)
+#define ESP_LOGV(tag, format, ...) ((void) 0)
+#endif
+
+#define YESNO(b) ((b) ? "YES" : "NO")
+#define ONOFF(b) ((b) ? "ON" : "OFF")
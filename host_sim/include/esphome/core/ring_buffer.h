@@ -0,0 +1,69 @@
+#pragma once
+
+// Host stand-in for ESPHome's RingBuffer, a byte FIFO behind a mutex.
+
+#include "freertos/FreeRTOS.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace esphome {
+
+class RingBuffer {
+ public:
+  /// Never waits: `ticks_to_wait` is accepted for the device signature.
+  size_t read(void *data, size_t len, TickType_t ticks_to_wait = 0) {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    len = std::min(len, this->used_);
+    auto *out = static_cast<uint8_t *>(data);
+    for (size_t i = 0; i < len; i++)
+      out[i] = this->storage_[(this->head_ + i) % this->storage_.size()];
+    this->head_ = (this->head_ + len) % this->storage_.size();
+    this->used_ -= len;
+    return len;
+  }
+
+  size_t write(const void *data, size_t len) {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    len = std::min(len, this->storage_.size() - this->used_);
+    const auto *in = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < len; i++)
+      this->storage_[(this->head_ + this->used_ + i) % this->storage_.size()] = in[i];
+    this->used_ += len;
+    return len;
+  }
+
+  size_t available() const {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    return this->used_;
+  }
+  size_t free() const {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    return this->storage_.size() - this->used_;
+  }
+  BaseType_t reset() {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->head_ = 0;
+    this->used_ = 0;
+    return pdPASS;
+  }
+
+  static std::unique_ptr<RingBuffer> create(size_t len) {
+    std::unique_ptr<RingBuffer> rb(new RingBuffer());
+    rb->storage_.resize(len);
+    return rb;
+  }
+
+ protected:
+  mutable std::mutex mutex_;
+  std::vector<uint8_t> storage_;
+  size_t head_{0};
+  size_t used_{0};
+};
+
+}  // namespace esphome
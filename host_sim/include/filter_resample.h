@@ -0,0 +1,52 @@
+#pragma once
+
+// Host stand-in for the ESP-ADF resample filter: linear interpolation and channel mixing, good
+// enough to check timing and buffer behaviour, not audio quality.
+
+#include "audio_element.h"
+
+#define RSP_FILTER_BUFFER_BYTE (512)
+#define RSP_FILTER_TASK_STACK (4 * 1024)
+#define RSP_FILTER_TASK_CORE (0)
+#define RSP_FILTER_TASK_PRIO (5)
+#define RSP_FILTER_RINGBUFFER_SIZE (2 * 1024)
+
+typedef enum { RESAMPLE_DECODE_MODE = 0, RESAMPLE_ENCODE_MODE, RESAMPLE_UNCROSS_MODE } resample_mode_t;
+typedef enum { ESP_RESAMPLE_TYPE_AUTO = -1, ESP_RESAMPLE_TYPE_DECIMATE = 0 } esp_resample_type_t;
+typedef enum { ESP_RSP_PREFER_TYPE_SPEED = 0, ESP_RSP_PREFER_TYPE_MEMORY = 1 } esp_rsp_prefer_type_t;
+
+typedef struct {
+  int src_rate;
+  int src_ch;
+  int dest_rate;
+  int dest_bits;
+  int dest_ch;
+  int src_bits;
+  resample_mode_t mode;
+  int max_indata_bytes;
+  int out_len_bytes;
+  esp_resample_type_t type;
+  int complexity;
+  int down_ch_idx;
+  esp_rsp_prefer_type_t prefer_flag;
+  int out_rb_size;
+  int task_stack;
+  int task_core;
+  int task_prio;
+  bool stack_in_ext;
+} rsp_filter_cfg_t;
+
+#define DEFAULT_RESAMPLE_FILTER_CONFIG() \
+  { \
+    .src_rate = 44100, .src_ch = 2, .dest_rate = 48000, .dest_bits = 16, .dest_ch = 2, .src_bits = 16, \
+    .mode = RESAMPLE_DECODE_MODE, .max_indata_bytes = RSP_FILTER_BUFFER_BYTE, \
+    .out_len_bytes = RSP_FILTER_BUFFER_BYTE, .type = ESP_RESAMPLE_TYPE_AUTO, .complexity = 2, \
+    .down_ch_idx = 0, .prefer_flag = ESP_RSP_PREFER_TYPE_SPEED, \
+    .out_rb_size = RSP_FILTER_RINGBUFFER_SIZE, .task_stack = RSP_FILTER_TASK_STACK, \
+    .task_core = RSP_FILTER_TASK_CORE, .task_prio = RSP_FILTER_TASK_PRIO, .stack_in_ext = true, \
+  }
+
+audio_element_handle_t rsp_filter_init(rsp_filter_cfg_t *config);
+/// Changes the rate the input is taken to run at, from the next block on. The channel count is
+/// fixed on the host.
+esp_err_t rsp_filter_set_src_info(audio_element_handle_t self, int src_rate, int src_ch);
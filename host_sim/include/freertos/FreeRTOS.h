@@ -0,0 +1,31 @@
+#pragma once
+
+// Host stand-in for the FreeRTOS types the audio components use. Tasks are pthreads and one tick is
+// one millisecond of simulated time.
+
+#include <cstddef>
+#include <cstdint>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint8_t StackType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+#define portMAX_DELAY ((TickType_t) 0xffffffffUL)
+#define portTICK_PERIOD_MS 1
+#define portTICK_RATE_MS portTICK_PERIOD_MS
+#define pdMS_TO_TICKS(ms) ((TickType_t) (ms))
+#define configNUM_THREAD_LOCAL_STORAGE_POINTERS 1
+#define CONFIG_FREERTOS_THREAD_LOCAL_STORAGE_POINTERS configNUM_THREAD_LOCAL_STORAGE_POINTERS
+
+// Static allocation only needs the sizes to be plausible, the host keeps its own state
+typedef struct {
+  uint8_t opaque[96];
+} StaticTask_t;
+typedef struct {
+  uint8_t opaque[80];
+} StaticQueue_t;
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+struct HostTask;
+typedef HostTask *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+typedef void (*TlsDeleteCallbackFunction_t)(int, void *);
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char *name, uint32_t stack_size, void *params,
+                       UBaseType_t priority, TaskHandle_t *handle);
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stack_size, void *params,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core);
+TaskHandle_t xTaskCreateStatic(TaskFunction_t function, const char *name, uint32_t stack_size, void *params,
+                               UBaseType_t priority, StackType_t *stack, StaticTask_t *tcb);
+/// Cancels the task at its next delay or blocking call and waits for it to exit.
+void vTaskDelete(TaskHandle_t handle);
+/// The callback runs once the task is gone: after it returned or deleted itself, or was deleted.
+void vTaskSetThreadLocalStoragePointerAndDelCallback(TaskHandle_t handle, BaseType_t index, void *value,
+                                                     TlsDeleteCallbackFunction_t callback);
+void vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount();
@@ -0,0 +1,34 @@
+#pragma once
+
+// Host stand-in for the ESP-ADF I2S stream. The element drives a simulated I2S port instead of the
+// driver, see host_sim/src/i2s_port.h.
+
+#include "audio_element.h"
+#include "driver/i2s.h"
+
+#define I2S_STREAM_TASK_STACK (3584)
+#define I2S_STREAM_BUF_SIZE (3600)
+#define I2S_STREAM_TASK_PRIO (23)
+#define I2S_STREAM_TASK_CORE (1)
+#define I2S_STREAM_RINGBUFFER_SIZE (8 * 1024)
+
+typedef struct {
+  audio_stream_type_t type;
+  i2s_driver_config_t i2s_config;
+  i2s_port_t i2s_port;
+  bool use_alc;
+  int volume;
+  int out_rb_size;
+  int task_stack;
+  int task_core;
+  int task_prio;
+  bool stack_in_ext;
+  int multi_out_num;
+  bool uninstall_drv;
+  bool need_expand;
+  i2s_bits_per_sample_t expand_src_bits;
+} i2s_stream_cfg_t;
+
+audio_element_handle_t i2s_stream_init(i2s_stream_cfg_t *config);
+esp_err_t i2s_alc_volume_set(audio_element_handle_t i2s_stream, int volume);
+esp_err_t i2s_alc_volume_get(audio_element_handle_t i2s_stream, int *volume);
@@ -0,0 +1,29 @@
+#pragma once
+
+// Host stand-in for the ADF input key service.
+
+#include "esp_peripherals.h"
+#include "periph_service.h"
+
+typedef enum {
+  INPUT_KEY_SERVICE_ACTION_UNKNOWN = 0,
+  INPUT_KEY_SERVICE_ACTION_CLICK,
+  INPUT_KEY_SERVICE_ACTION_CLICK_RELEASE,
+  INPUT_KEY_SERVICE_ACTION_PRESS,
+  INPUT_KEY_SERVICE_ACTION_PRESS_RELEASE,
+} input_key_service_action_id_t;
+
+typedef struct {
+  int type;
+  int user_id;
+  int act_id;
+} input_key_service_info_t;
+
+typedef struct {
+  periph_service_config_t based_cfg;
+  esp_periph_set_handle_t handle;
+} input_key_service_cfg_t;
+
+periph_service_handle_t input_key_service_create(input_key_service_cfg_t *input_key_config);
+esp_err_t input_key_service_add_key(periph_service_handle_t input_key_handle, input_key_service_info_t *input_key_info,
+                                    int add_key_num);
@@ -0,0 +1,71 @@
+#pragma once
+
+// Host stand-in for mbedTLS's one-shot SHA-1 (FIPS 180-4), used for the WebSocket handshake.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+static inline uint32_t host_sha1_rotl(uint32_t value, int bits) { return (value << bits) | (value >> (32 - bits)); }
+
+static inline void host_sha1_block(uint32_t *state, const unsigned char *block) {
+  uint32_t w[80];
+  for (int i = 0; i < 16; i++) {
+    w[i] = (static_cast<uint32_t>(block[4 * i]) << 24) | (static_cast<uint32_t>(block[4 * i + 1]) << 16) |
+           (static_cast<uint32_t>(block[4 * i + 2]) << 8) | block[4 * i + 3];
+  }
+  for (int i = 16; i < 80; i++)
+    w[i] = host_sha1_rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+  uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+  for (int i = 0; i < 80; i++) {
+    uint32_t f, k;
+    if (i < 20) {
+      f = (b & c) | (~b & d);
+      k = 0x5A827999;
+    } else if (i < 40) {
+      f = b ^ c ^ d;
+      k = 0x6ED9EBA1;
+    } else if (i < 60) {
+      f = (b & c) | (b & d) | (c & d);
+      k = 0x8F1BBCDC;
+    } else {
+      f = b ^ c ^ d;
+      k = 0xCA62C1D6;
+    }
+    uint32_t t = host_sha1_rotl(a, 5) + f + e + k + w[i];
+    e = d;
+    d = c;
+    c = host_sha1_rotl(b, 30);
+    b = a;
+    a = t;
+  }
+  state[0] += a;
+  state[1] += b;
+  state[2] += c;
+  state[3] += d;
+  state[4] += e;
+}
+
+static inline int mbedtls_sha1(const unsigned char *input, size_t ilen, unsigned char output[20]) {
+  uint32_t state[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+  size_t offset = 0;
+  for (; offset + 64 <= ilen; offset += 64)
+    host_sha1_block(state, input + offset);
+  unsigned char tail[128] = {};
+  size_t rest = ilen - offset;
+  memcpy(tail, input + offset, rest);
+  tail[rest] = 0x80;
+  size_t tail_size = rest + 9 <= 64 ? 64 : 128;
+  uint64_t bits = static_cast<uint64_t>(ilen) * 8;
+  for (int i = 0; i < 8; i++)
+    tail[tail_size - 1 - i] = static_cast<unsigned char>(bits >> (8 * i));
+  for (size_t block = 0; block < tail_size; block += 64)
+    host_sha1_block(state, tail + block);
+  for (int i = 0; i < 5; i++) {
+    output[4 * i] = static_cast<unsigned char>(state[i] >> 24);
+    output[4 * i + 1] = static_cast<unsigned char>(state[i] >> 16);
+    output[4 * i + 2] = static_cast<unsigned char>(state[i] >> 8);
+    output[4 * i + 3] = static_cast<unsigned char>(state[i]);
+  }
+  return 0;
+}
@@ -0,0 +1,4 @@
+#pragma once
+
+// Host stand-in for mbedTLS, just enough for the components built here. See sha1.h.
+#define MBEDTLS_VERSION_MAJOR 3
@@ -0,0 +1,5 @@
+#pragma once
+
+// Host stand-in for the ADF ADC button peripheral, which the host has no ADC for.
+
+#include "esp_peripherals.h"
@@ -0,0 +1,36 @@
+#pragma once
+
+// Host stand-in for the ADF peripheral service: services are created but never post events.
+
+#include "esp_err.h"
+
+struct periph_service_impl;
+typedef struct periph_service_impl *periph_service_handle_t;
+
+typedef struct {
+  int type;
+  void *source;
+  void *data;
+  int len;
+} periph_service_event_t;
+
+typedef esp_err_t (*periph_service_cb)(periph_service_handle_t handle, periph_service_event_t *evt, void *ctx);
+typedef void (*TaskFunc)(void *);
+typedef esp_err_t (*periph_service_ctrl)(periph_service_handle_t handle);
+typedef esp_err_t (*periph_service_io)(void *ioctl_handle, int cmd, int value);
+
+typedef struct {
+  int task_stack;
+  int task_prio;
+  int task_core;
+  TaskFunc task_func;
+  bool extern_stack;
+  periph_service_ctrl service_start;
+  periph_service_ctrl service_stop;
+  periph_service_ctrl service_destroy;
+  periph_service_io service_ioctl;
+  char *service_name;
+  void *user_data;
+} periph_service_config_t;
+
+esp_err_t periph_service_set_callback(periph_service_handle_t handle, periph_service_cb cb, void *ctx);
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "audio_element.h"
+
+#define RAW_STREAM_RINGBUFFER_SIZE (8 * 1024)
+
+typedef struct {
+  audio_stream_type_t type;
+  int out_rb_size;
+} raw_stream_cfg_t;
+
+#define RAW_STREAM_CFG_DEFAULT() \
+  { .type = AUDIO_STREAM_READER, .out_rb_size = RAW_STREAM_RINGBUFFER_SIZE, }
+
+audio_element_handle_t raw_stream_init(raw_stream_cfg_t *config);
+int raw_stream_read(audio_element_handle_t pipeline, char *buffer, int buf_size);
+int raw_stream_write(audio_element_handle_t pipeline, char *buffer, int buf_size);
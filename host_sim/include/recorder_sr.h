@@ -0,0 +1,3 @@
+#pragma once
+
+// Host stand-in: the microphone includes this ADF header but uses nothing from it.
@@ -0,0 +1,27 @@
+#pragma once
+
+// Host stand-in for the ESP-ADF byte ring buffer.
+
+#include "freertos/FreeRTOS.h"
+
+#define RB_OK 0
+#define RB_FAIL -1
+#define RB_DONE -2
+#define RB_ABORT -3
+#define RB_TIMEOUT -4
+
+struct HostRingbuf;
+typedef HostRingbuf *ringbuf_handle_t;
+
+ringbuf_handle_t rb_create(int block_size, int n_blocks);
+int rb_destroy(ringbuf_handle_t rb);
+/// Blocks until at least one byte is available, the writer is done or the buffer is aborted.
+int rb_read(ringbuf_handle_t rb, char *buf, int len, TickType_t ticks_to_wait);
+/// Blocks until all of buf is written, or returns what fit once the timeout expires.
+int rb_write(ringbuf_handle_t rb, char *buf, int len, TickType_t ticks_to_wait);
+int rb_bytes_filled(ringbuf_handle_t rb);
+int rb_bytes_available(ringbuf_handle_t rb);
+int rb_get_size(ringbuf_handle_t rb);
+int rb_done_write(ringbuf_handle_t rb);
+int rb_abort(ringbuf_handle_t rb);
+int rb_reset(ringbuf_handle_t rb);
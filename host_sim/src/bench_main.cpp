@@ -0,0 +1,382 @@
+// Host runner for the audio kernel benchmarks in components/audio_bench.
+//
+// Prints one JSON line per case and block size and, given a baseline in the same format, fails
+// with exit code 2 when a case got slower than the threshold allows. The kernel checks run first
+// and fail the run the same way. A log captured from the
+// audio_bench firmware component can be checked the same way with --results.
+//
+//   esp_adf_bench --baseline bench/baseline-x86_64.jsonl
+//   esp_adf_bench --write-baseline bench/baseline-x86_64.jsonl
+//   esp_adf_bench --results device.log --baseline bench/baseline-esp32s3.jsonl
+//
+// --resampler-quality measures the PolyphaseResampler instead: passband ripple, the worst
+// signal-to-residual ratio across the passband and how far aliases are pushed down, for each
+// quality and the linear interpolation the host simulation uses in place of ADF's rsp_filter.
+
+#include "esphome/components/audio_bench/bench_cases.h"
+#include "esphome/components/audio_utils/resampler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace esphome::audio_bench;
+
+struct Entry {
+  std::string name;
+  unsigned block{0};
+  std::string unit;
+  double per_sample{0.0};
+};
+
+using Key = std::pair<std::string, unsigned>;
+
+static const int RETRIES = 2;
+
+static uint64_t nanoseconds() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+static bool parse_string(const std::string &line, const char *field, std::string *value) {
+  std::string key = std::string("\"") + field + "\":\"";
+  size_t start = line.find(key);
+  if (start == std::string::npos)
+    return false;
+  start += key.size();
+  size_t end = line.find('"', start);
+  if (end == std::string::npos)
+    return false;
+  *value = line.substr(start, end - start);
+  return true;
+}
+
+static bool parse_number(const std::string &line, const char *field, double *value) {
+  std::string key = std::string("\"") + field + "\":";
+  size_t start = line.find(key);
+  if (start == std::string::npos)
+    return false;
+  *value = atof(line.c_str() + start + key.size());
+  return true;
+}
+
+/// Reads every result line of a file, ignoring whatever surrounds them (log prefixes, other lines).
+static bool read_results(const std::string &path, std::map<Key, Entry> *entries) {
+  std::ifstream file(path);
+  if (!file)
+    return false;
+  std::string line;
+  while (std::getline(file, line)) {
+    size_t start = line.find("{\"case\":");
+    if (start == std::string::npos)
+      continue;
+    line = line.substr(start);
+    Entry entry;
+    double block;
+    if (!parse_string(line, "case", &entry.name) || !parse_number(line, "block", &block) ||
+        !parse_string(line, "unit", &entry.unit) || !parse_number(line, "per_sample", &entry.per_sample))
+      continue;
+    entry.block = static_cast<unsigned>(block);
+    (*entries)[{entry.name, entry.block}] = entry;
+  }
+  return true;
+}
+
+/// Prints the failed kernel checks of a captured log. Returns how many there were.
+static int report_failed_checks(const std::string &path) {
+  std::ifstream file(path);
+  std::string line;
+  int failed = 0;
+  while (std::getline(file, line)) {
+    size_t start = line.find("{\"check\":");
+    if (start == std::string::npos || line.find("\"ok\":false", start) == std::string::npos)
+      continue;
+    fprintf(stderr, "Failed on the device: %s\n", line.substr(start).c_str());
+    failed++;
+  }
+  return failed;
+}
+
+static void usage() {
+  fprintf(stderr,
+          "usage: esp_adf_bench [options]\n"
+          "  --blocks <n,n,...>       block sizes in frames (default 32,256,1024)\n"
+          "  --runs <n>               timed runs per case, the best counts (default 21)\n"
+          "  --filter <text>          only cases whose name contains the text\n"
+          "  --results <file>         compare results from a file instead of running\n"
+          "  --baseline <file>        fail if a case is slower than this baseline\n"
+          "  --threshold <pct>        allowed slowdown (default 25)\n"
+          "  --write-baseline <file>  store the results as the new baseline\n"
+          "  --resampler-quality      report resampler frequency response instead of timing\n");
+}
+
+using esphome::audio_utils::PolyphaseResampler;
+using esphome::audio_utils::ResampleQuality;
+
+static const double TONE_AMPLITUDE = 16384.0;
+
+static std::vector<int16_t> tone(uint32_t rate, double frequency, size_t frames) {
+  std::vector<int16_t> samples(frames);
+  for (size_t i = 0; i < frames; i++)
+    samples[i] = static_cast<int16_t>(std::lround(TONE_AMPLITUDE * std::sin(2.0 * M_PI * frequency * i / rate)));
+  return samples;
+}
+
+/// Resamples one block with kernel -1 (linear interpolation), 0 to 2 (16-bit at each quality) or
+/// 3 to 5 (float at each quality).
+static std::vector<int16_t> resample_tone(const std::vector<int16_t> &in, uint32_t source_rate, uint32_t dest_rate,
+                                          int kernel) {
+  std::vector<int16_t> out;
+  size_t consumed;
+  if (kernel < 0) {
+    double step = static_cast<double>(source_rate) / dest_rate;
+    for (double phase = 0.0; phase + 1 < in.size(); phase += step) {
+      size_t index = static_cast<size_t>(phase);
+      double fraction = phase - index;
+      out.push_back(static_cast<int16_t>(in[index] + (in[index + 1] - in[index]) * fraction));
+    }
+  } else if (kernel < 3) {
+    PolyphaseResampler<int16_t> resampler;
+    resampler.configure(source_rate, dest_rate, 1, static_cast<ResampleQuality>(kernel));
+    out.resize(resampler.max_output_frames(in.size()));
+    out.resize(resampler.process(in.data(), in.size(), &consumed, out.data(), out.size()));
+  } else {
+    PolyphaseResampler<float> resampler;
+    resampler.configure(source_rate, dest_rate, 1, static_cast<ResampleQuality>(kernel - 3));
+    std::vector<float> in_float(in.begin(), in.end());
+    std::vector<float> out_float(resampler.max_output_frames(in.size()));
+    out_float.resize(resampler.process(in_float.data(), in_float.size(), &consumed, out_float.data(), out_float.size()));
+    for (float sample : out_float)
+      out.push_back(static_cast<int16_t>(std::lround(std::max(-32768.0f, std::min(32767.0f, sample)))));
+  }
+  return out;
+}
+
+struct ToneMeasurement {
+  double gain_db;
+  double snr_db;   // tone against everything else in the output
+  double level_db; // output RMS against the input tone's
+};
+
+/// Tone closest to `frequency` with a whole number of periods in the measured part of the output.
+static double snap(double frequency, uint32_t dest_rate) {
+  size_t count = dest_rate / 4;
+  return std::max(1.0, std::round(frequency * count / dest_rate)) * dest_rate / count;
+}
+
+/// Fit of a sine at `frequency` to a quarter second of output, skipping the filter's settling time.
+static ToneMeasurement measure(const std::vector<int16_t> &out, uint32_t rate, double frequency) {
+  size_t start = rate / 10;
+  size_t count = rate / 4;
+  double s = 0.0, c = 0.0, power = 0.0;
+  for (size_t i = start; i < start + count; i++) {
+    double angle = 2.0 * M_PI * frequency * i / rate;
+    s += out[i] * std::sin(angle);
+    c += out[i] * std::cos(angle);
+    power += static_cast<double>(out[i]) * out[i];
+  }
+  double amplitude = 2.0 * std::sqrt(s * s + c * c) / count;
+  power /= count;
+  double residual = std::max(power - amplitude * amplitude / 2.0, 1e-9);
+  double reference = TONE_AMPLITUDE * TONE_AMPLITUDE / 2.0;
+  return {20.0 * std::log10(std::max(amplitude, 1e-9) / TONE_AMPLITUDE),
+          10.0 * std::log10(amplitude * amplitude / 2.0 / residual), 10.0 * std::log10(std::max(power, 1e-9) / reference)};
+}
+
+static int report_resampler_quality() {
+  static const uint32_t PAIRS[][2] = {{44100, 16000}, {48000, 16000}, {22050, 48000}};
+  static const char *const KERNELS[] = {"linear", "low", "medium", "high", "low_float", "medium_float", "high_float"};
+  static const size_t TONES = 24;
+  for (const auto &pair : PAIRS) {
+    uint32_t source_rate = pair[0], dest_rate = pair[1];
+    double nyquist = std::min(source_rate, dest_rate) / 2.0;
+    size_t frames = source_rate / 2;
+    for (int kernel = -1; kernel < 6; kernel++) {
+      double min_gain = 1e9, max_gain = -1e9, min_snr = 1e9, alias = -1e9;
+      for (size_t t = 0; t < TONES; t++) {
+        double frequency = snap(100.0 + (0.7 * nyquist - 100.0) * t / (TONES - 1), dest_rate);
+        ToneMeasurement m = measure(resample_tone(tone(source_rate, frequency, frames), source_rate, dest_rate, kernel),
+                                    dest_rate, frequency);
+        min_gain = std::min(min_gain, m.gain_db);
+        max_gain = std::max(max_gain, m.gain_db);
+        min_snr = std::min(min_snr, m.snr_db);
+      }
+      // Tones the output cannot represent, anything left of them is aliasing
+      for (size_t t = 0; source_rate > dest_rate && t < TONES; t++) {
+        double frequency = 1.15 * dest_rate / 2.0 + (0.95 * source_rate / 2.0 - 1.15 * dest_rate / 2.0) * t / (TONES - 1);
+        frequency = std::round(frequency);
+        ToneMeasurement m = measure(resample_tone(tone(source_rate, frequency, frames), source_rate, dest_rate, kernel),
+                                    dest_rate, frequency);
+        alias = std::max(alias, m.level_db);
+      }
+      size_t taps = 2, phases = 0;
+      if (kernel >= 0) {
+        PolyphaseResampler<int16_t> resampler;
+        resampler.configure(source_rate, dest_rate, 1, static_cast<ResampleQuality>(kernel % 3));
+        taps = resampler.get_taps();
+        phases = resampler.get_phases();
+      }
+      printf("{\"resampler\":\"%u->%u\",\"kernel\":\"%s\",\"taps\":%u,\"phases\":%u,"
+             "\"passband_ripple_db\":%.3f,\"min_snr_db\":%.1f",
+             (unsigned) source_rate, (unsigned) dest_rate, KERNELS[kernel + 1], (unsigned) taps, (unsigned) phases,
+             max_gain - min_gain, min_snr);
+      if (source_rate > dest_rate)
+        printf(",\"alias_db\":%.1f", alias);
+      printf("}\n");
+    }
+  }
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  std::vector<size_t> blocks = {32, 256, 1024};
+  uint32_t runs = 21;
+  std::string filter, results_path, baseline_path, write_path;
+  double threshold = 25.0;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--resampler-quality")
+      return report_resampler_quality();
+    if (i + 1 >= argc) {
+      usage();
+      return 1;
+    }
+    std::string value = argv[++i];
+    if (arg == "--blocks") {
+      blocks.clear();
+      std::stringstream stream(value);
+      std::string item;
+      while (std::getline(stream, item, ','))
+        blocks.push_back(std::max(1, atoi(item.c_str())));
+    } else if (arg == "--runs") {
+      runs = std::max(1, atoi(value.c_str()));
+    } else if (arg == "--filter") {
+      filter = value;
+    } else if (arg == "--results") {
+      results_path = value;
+    } else if (arg == "--baseline") {
+      baseline_path = value;
+    } else if (arg == "--threshold") {
+      threshold = atof(value.c_str());
+    } else if (arg == "--write-baseline") {
+      write_path = value;
+    } else {
+      usage();
+      return 1;
+    }
+  }
+
+  std::map<Key, Entry> results;
+  std::vector<std::string> lines;
+  if (!results_path.empty()) {
+    if (!read_results(results_path, &results)) {
+      fprintf(stderr, "Cannot read %s\n", results_path.c_str());
+      return 1;
+    }
+    if (report_failed_checks(results_path) > 0)
+      return 2;
+    for (auto &it : results) {
+      char line[160];
+      snprintf(line, sizeof(line), "{\"case\":\"%s\",\"block\":%u,\"unit\":\"%s\",\"per_sample\":%.4f}",
+               it.second.name.c_str(), it.second.block, it.second.unit.c_str(), it.second.per_sample);
+      lines.push_back(line);
+    }
+  } else {
+    bool checked = true;
+    for (size_t index = 0; index < get_check_count(); index++) {
+      char line[160];
+      checked &= run_check(index, line, sizeof(line));
+      printf("%s\n", line);
+    }
+    if (!checked) {
+      fprintf(stderr, "A kernel differs from its portable loop\n");
+      return 2;
+    }
+    for (size_t index = 0; index < get_case_count(); index++) {
+      if (!filter.empty() && strstr(get_case_name(index), filter.c_str()) == nullptr)
+        continue;
+      for (size_t block : blocks) {
+        BenchResult result = run_case(index, block, nanoseconds, runs, 65536);
+        char line[160];
+        format_result(line, sizeof(line), result, "ns");
+        lines.push_back(line);
+        results[{result.name, static_cast<unsigned>(block)}] = {result.name, static_cast<unsigned>(block), "ns",
+                                                                result.per_sample};
+      }
+    }
+  }
+  for (const auto &line : lines)
+    printf("%s\n", line.c_str());
+
+  if (!write_path.empty()) {
+    std::ofstream file(write_path);
+    for (const auto &line : lines)
+      file << line << "\n";
+    if (!file) {
+      fprintf(stderr, "Cannot write %s\n", write_path.c_str());
+      return 1;
+    }
+  }
+
+  if (baseline_path.empty())
+    return 0;
+  std::map<Key, Entry> baseline;
+  if (!read_results(baseline_path, &baseline)) {
+    fprintf(stderr, "Cannot read %s\n", baseline_path.c_str());
+    return 1;
+  }
+
+  // A slow case is measured again before it counts, a busy host should not fail the run
+  if (results_path.empty()) {
+    for (auto &it : results) {
+      auto base = baseline.find(it.first);
+      if (base == baseline.end())
+        continue;
+      for (int retry = 0; retry < RETRIES && it.second.per_sample > base->second.per_sample * (1.0 + threshold / 100.0);
+           retry++) {
+        for (size_t index = 0; index < get_case_count(); index++) {
+          if (it.first.first == get_case_name(index))
+            it.second.per_sample = std::min(it.second.per_sample, run_case(index, it.first.second, nanoseconds, runs,
+                                                                           65536).per_sample);
+        }
+      }
+    }
+  }
+
+  int regressions = 0;
+  fprintf(stderr, "%-28s %6s %12s %12s %8s\n", "case", "block", "baseline", "current", "change");
+  for (const auto &it : results) {
+    const Entry &current = it.second;
+    auto base = baseline.find(it.first);
+    if (base == baseline.end()) {
+      fprintf(stderr, "%-28s %6u %12s %12.4f %8s\n", current.name.c_str(), current.block, "-", current.per_sample,
+              "new");
+      continue;
+    }
+    if (base->second.unit != current.unit) {
+      fprintf(stderr, "%s: baseline is in %s, results in %s\n", current.name.c_str(), base->second.unit.c_str(),
+              current.unit.c_str());
+      return 1;
+    }
+    double change = 100.0 * (current.per_sample / base->second.per_sample - 1.0);
+    bool regressed = change > threshold;
+    regressions += regressed;
+    fprintf(stderr, "%-28s %6u %12.4f %12.4f %+7.1f%%%s\n", current.name.c_str(), current.block,
+            base->second.per_sample, current.per_sample, change, regressed ? "  REGRESSION" : "");
+  }
+  if (regressions > 0) {
+    fprintf(stderr, "%d case(s) slower than the baseline by more than %.0f%%\n", regressions, threshold);
+    return 2;
+  }
+  return 0;
+}
@@ -0,0 +1,55 @@
+// The ADF audio board on the host: a codec that only remembers its volume, and a peripheral set
+// and key service that exist but never see a key press.
+
+#include "board.h"
+#include "driver/gpio.h"
+#include "esp_peripherals.h"
+#include "input_key_service.h"
+#include "periph_service.h"
+
+struct audio_hal {
+  int volume;
+};
+
+struct esp_periph_set {};
+struct periph_service_impl {};
+
+static audio_hal codec{0};
+static audio_board_handle board{&codec};
+static esp_periph_set periph_set;
+static periph_service_impl key_service;
+
+audio_board_handle_t audio_board_init() { return &board; }
+
+esp_err_t audio_board_key_init(esp_periph_set_handle_t set) { return ESP_OK; }
+
+int8_t get_pa_enable_gpio() { return PA_ENABLE_GPIO; }
+
+esp_err_t audio_hal_ctrl_codec(audio_hal_handle_t audio_hal, audio_hal_codec_mode_t mode, audio_hal_ctrl_t audio_hal_ctrl) {
+  return ESP_OK;
+}
+
+esp_err_t audio_hal_set_volume(audio_hal_handle_t audio_hal, int volume) {
+  audio_hal->volume = volume;
+  return ESP_OK;
+}
+
+esp_err_t audio_hal_get_volume(audio_hal_handle_t audio_hal, int *volume) {
+  *volume = audio_hal->volume;
+  return ESP_OK;
+}
+
+esp_periph_set_handle_t esp_periph_set_init(esp_periph_config_t *config) { return &periph_set; }
+
+periph_service_handle_t input_key_service_create(input_key_service_cfg_t *input_key_config) { return &key_service; }
+
+esp_err_t input_key_service_add_key(periph_service_handle_t input_key_handle, input_key_service_info_t *input_key_info,
+                                    int add_key_num) {
+  return ESP_OK;
+}
+
+esp_err_t periph_service_set_callback(periph_service_handle_t handle, periph_service_cb cb, void *ctx) { return ESP_OK; }
+
+esp_err_t gpio_config(const gpio_config_t *config) { return ESP_OK; }
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level) { return ESP_OK; }
@@ -0,0 +1,416 @@
+// ESP-ADF pipelines and the raw, I2S and resample elements on the host.
+
+#include "i2s_port.h"
+#include "sim_clock.h"
+
+#include "audio_pipeline.h"
+#include "filter_resample.h"
+#include "i2s_stream.h"
+#include "raw_stream.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct HostElement {
+  enum class Kind { RAW, I2S, RESAMPLE } kind;
+  audio_stream_type_t type;
+  int out_rb_size;
+  std::string tag;
+  std::string uri;
+  ringbuf_handle_t input{nullptr};
+  ringbuf_handle_t output{nullptr};
+
+  i2s_stream_cfg_t i2s{};
+  std::atomic<int> alc_volume{0};
+  std::atomic<int64_t> byte_pos{0};  // I2S writer: bytes handed to the DMA
+  rsp_filter_cfg_t rsp{};
+  std::atomic<int> src_rate{0};      // resample: may change while the element runs
+
+  std::thread worker;
+  std::atomic<bool> running{false};
+  std::atomic<bool> paused{false};
+};
+
+struct HostPipeline {
+  int rb_size;
+  std::vector<HostElement *> registered;
+  std::vector<HostElement *> linked;
+  std::vector<ringbuf_handle_t> ringbufs;
+};
+
+static const int16_t *as_samples(const std::vector<char> &bytes) {
+  return reinterpret_cast<const int16_t *>(bytes.data());
+}
+
+static int i2s_channels(const i2s_driver_config_t &config) {
+  return config.channel_format == I2S_CHANNEL_FMT_RIGHT_LEFT ? 2 : 1;
+}
+
+/// TX: every DMA period the port plays one buffer, then the task tops the DMA queue up from the
+/// input ring buffer. Like the driver's descriptors, the queue holds the buffer playing and the
+/// ones behind it. A period that finds the queue empty after audio has started is an underrun,
+/// counted once more audio arrives so that the silence after the end of a stream is not. Paused,
+/// the queue plays out and nothing new is taken.
+static void i2s_writer_loop(HostElement *el) {
+  const i2s_driver_config_t &config = el->i2s.i2s_config;
+  const int channels = i2s_channels(config);
+  const size_t period = config.dma_buf_len;
+  const size_t depth = static_cast<size_t>(config.dma_buf_count) * config.dma_buf_len;
+  const int64_t period_us = static_cast<int64_t>(period) * 1000000 / config.sample_rate;
+  host_sim::I2SPort &port = host_sim::I2SPort::get(el->i2s.i2s_port);
+
+  std::deque<int16_t> dma;
+  std::vector<int16_t> out(period * channels);
+  std::vector<char> bytes(depth * channels * sizeof(int16_t));
+  bool started = false;
+  uint64_t starved_frames = 0;
+  int64_t deadline = host_sim::now_us();
+
+  while (el->running) {
+    deadline += period_us;
+    host_sim::sleep_until_us(deadline);
+    int64_t now = host_sim::now_us();
+    port.report_lateness(now - deadline);
+    bool paused = el->paused;
+
+    size_t frames = std::min(period, dma.size() / channels);
+    if (frames > 0 && starved_frames > 0) {
+      port.add_underrun(starved_frames);
+      std::vector<int16_t> silence(starved_frames * channels, 0);
+      port.play(silence.data(), starved_frames, channels, config.sample_rate, now);
+      starved_frames = 0;
+    }
+    if (frames > 0) {
+      float gain = el->i2s.use_alc ? std::pow(10.0f, el->alc_volume / 20.0f) : 1.0f;
+      for (size_t i = 0; i < frames * channels; i++) {
+        float sample = dma.front() * gain;
+        dma.pop_front();
+        out[i] = static_cast<int16_t>(std::max(-32768.0f, std::min(32767.0f, sample)));
+      }
+      port.play(out.data(), frames, channels, config.sample_rate, now);
+    }
+    if (paused) {
+      if (dma.empty())
+        started = false;  // drained, what comes after the pause starts afresh
+      port.set_queued_frames(dma.size() / channels);
+      continue;
+    }
+    if (started && frames < period)
+      starved_frames += period - frames;
+
+    while (dma.size() < (depth - period) * channels) {
+      int wanted = static_cast<int>(((depth - period) * channels - dma.size()) * sizeof(int16_t));
+      int read = rb_read(el->input, bytes.data(), wanted, 0);
+      if (read <= 0)
+        break;
+      const int16_t *samples = as_samples(bytes);
+      dma.insert(dma.end(), samples, samples + read / sizeof(int16_t));
+      el->byte_pos += read;
+      started = true;
+    }
+    port.set_queued_frames(dma.size() / channels);
+  }
+}
+
+/// RX: every DMA period one buffer comes in from the port and is pushed to the pipeline without
+/// waiting; what does not fit is dropped, as the driver would.
+static void i2s_reader_loop(HostElement *el) {
+  const i2s_driver_config_t &config = el->i2s.i2s_config;
+  const int channels = i2s_channels(config);
+  const size_t period = config.dma_buf_len;
+  const int64_t period_us = static_cast<int64_t>(period) * 1000000 / config.sample_rate;
+  host_sim::I2SPort &port = host_sim::I2SPort::get(el->i2s.i2s_port);
+
+  std::vector<int16_t> samples(period * channels);
+  int64_t deadline = host_sim::now_us();
+  while (el->running) {
+    deadline += period_us;
+    host_sim::sleep_until_us(deadline);
+    int64_t now = host_sim::now_us();
+    port.report_lateness(now - deadline);
+    if (el->paused)
+      continue;
+
+    if (!port.capture(samples.data(), period, channels, now)) {
+      rb_done_write(el->output);  // the input file is exhausted
+      break;
+    }
+    int bytes = static_cast<int>(samples.size() * sizeof(int16_t));
+    int written = rb_write(el->output, reinterpret_cast<char *>(samples.data()), bytes, 0);
+    if (written < bytes)
+      port.add_overrun((bytes - std::max(written, 0)) / (channels * sizeof(int16_t)));
+  }
+}
+
+/// Linear interpolation between consecutive frames, with channels averaged or duplicated.
+static void resample_loop(HostElement *el) {
+  const rsp_filter_cfg_t &cfg = el->rsp;
+  const int in_channels = cfg.src_ch;
+  const int out_channels = cfg.dest_ch;
+  const size_t frame_bytes = in_channels * sizeof(int16_t);
+
+  std::vector<char> bytes(std::max<int>(cfg.max_indata_bytes, frame_bytes));
+  std::vector<char> pending;
+  std::vector<float> mono;
+  std::vector<int16_t> out;
+  std::vector<float> previous(out_channels, 0.0f);
+  double phase = 0.0;
+
+  while (el->running) {
+    int read = rb_read(el->input, bytes.data(), bytes.size(), 10);
+    if (read == RB_DONE) {
+      rb_done_write(el->output);
+      break;
+    }
+    if (read <= 0)
+      continue;
+    pending.insert(pending.end(), bytes.begin(), bytes.begin() + read);
+    size_t frames = pending.size() / frame_bytes;
+    if (frames == 0)
+      continue;
+
+    // Channel conversion first, frame 0 is the last frame of the previous block
+    mono.assign((frames + 1) * out_channels, 0.0f);
+    std::copy(previous.begin(), previous.end(), mono.begin());
+    const int16_t *in = as_samples(pending);
+    for (size_t f = 0; f < frames; f++) {
+      for (int c = 0; c < out_channels; c++) {
+        float sample;
+        if (in_channels == out_channels) {
+          sample = in[f * in_channels + c];
+        } else if (out_channels == 1) {
+          sample = 0.0f;
+          for (int i = 0; i < in_channels; i++)
+            sample += in[f * in_channels + i];
+          sample /= in_channels;
+        } else {
+          sample = in[f * in_channels];
+        }
+        mono[(f + 1) * out_channels + c] = sample;
+      }
+    }
+    pending.erase(pending.begin(), pending.begin() + frames * frame_bytes);
+
+    out.clear();
+    const double step = static_cast<double>(el->src_rate.load()) / cfg.dest_rate;
+    while (phase < frames) {
+      size_t index = static_cast<size_t>(phase);
+      float fraction = static_cast<float>(phase - index);
+      for (int c = 0; c < out_channels; c++) {
+        float a = mono[index * out_channels + c];
+        float b = mono[(index + 1) * out_channels + c];
+        out.push_back(static_cast<int16_t>(std::lround(a + (b - a) * fraction)));
+      }
+      phase += step;
+    }
+    phase -= frames;
+    std::copy(mono.end() - out_channels, mono.end(), previous.begin());
+
+    if (!out.empty() && rb_write(el->output, reinterpret_cast<char *>(out.data()),
+                                 static_cast<int>(out.size() * sizeof(int16_t)), portMAX_DELAY) < 0)
+      break;
+  }
+}
+
+static HostElement *new_element(HostElement::Kind kind, audio_stream_type_t type, int out_rb_size) {
+  auto *el = new HostElement();
+  el->kind = kind;
+  el->type = type;
+  el->out_rb_size = out_rb_size;
+  return el;
+}
+
+audio_element_handle_t raw_stream_init(raw_stream_cfg_t *config) {
+  return new_element(HostElement::Kind::RAW, config->type, config->out_rb_size);
+}
+
+int raw_stream_write(audio_element_handle_t el, char *buffer, int buf_size) {
+  if (el->output == nullptr)
+    return ESP_FAIL;
+  int written = rb_write(el->output, buffer, buf_size, portMAX_DELAY);
+  return written < 0 ? ESP_FAIL : written;
+}
+
+int raw_stream_read(audio_element_handle_t el, char *buffer, int buf_size) {
+  if (el->input == nullptr)
+    return ESP_FAIL;
+  return rb_read(el->input, buffer, buf_size, portMAX_DELAY);
+}
+
+audio_element_handle_t i2s_stream_init(i2s_stream_cfg_t *config) {
+  auto *el = new_element(HostElement::Kind::I2S, config->type, config->out_rb_size);
+  el->i2s = *config;
+  el->alc_volume = config->volume;
+  return el;
+}
+
+esp_err_t i2s_alc_volume_set(audio_element_handle_t el, int volume) {
+  el->alc_volume = volume;
+  return ESP_OK;
+}
+
+esp_err_t i2s_alc_volume_get(audio_element_handle_t el, int *volume) {
+  *volume = el->alc_volume;
+  return ESP_OK;
+}
+
+audio_element_handle_t rsp_filter_init(rsp_filter_cfg_t *config) {
+  if (config->src_rate <= 0 || config->dest_rate <= 0 || config->src_ch < 1 || config->dest_ch < 1)
+    return nullptr;
+  auto *el = new_element(HostElement::Kind::RESAMPLE, AUDIO_STREAM_NONE, config->out_rb_size);
+  el->rsp = *config;
+  el->src_rate = config->src_rate;
+  return el;
+}
+
+esp_err_t rsp_filter_set_src_info(audio_element_handle_t el, int src_rate, int src_ch) {
+  if (src_rate <= 0 || src_ch != el->rsp.src_ch)
+    return ESP_FAIL;
+  el->src_rate = src_rate;
+  return ESP_OK;
+}
+
+esp_err_t audio_element_deinit(audio_element_handle_t el) {
+  if (el->worker.joinable()) {
+    el->running = false;
+    el->worker.join();
+  }
+  delete el;
+  return ESP_OK;
+}
+
+esp_err_t audio_element_set_uri(audio_element_handle_t el, const char *uri) {
+  el->uri = uri;
+  return ESP_OK;
+}
+
+const char *audio_element_get_tag(audio_element_handle_t el) { return el->tag.c_str(); }
+
+esp_err_t audio_element_getinfo(audio_element_handle_t el, audio_element_info_t *info) {
+  *info = audio_element_info_t{};
+  info->bits = 16;
+  if (el->kind == HostElement::Kind::I2S) {
+    info->sample_rates = el->i2s.i2s_config.sample_rate;
+    info->channels = i2s_channels(el->i2s.i2s_config);
+  } else if (el->kind == HostElement::Kind::RESAMPLE) {
+    info->sample_rates = el->src_rate;
+    info->channels = el->rsp.src_ch;
+  }
+  info->byte_pos = el->byte_pos;
+  info->uri = const_cast<char *>(el->uri.c_str());
+  return ESP_OK;
+}
+
+esp_err_t audio_element_pause(audio_element_handle_t el) {
+  el->paused = true;
+  return ESP_OK;
+}
+
+esp_err_t audio_element_resume(audio_element_handle_t el, float wait_for_rb_threshold, TickType_t timeout) {
+  el->paused = false;
+  return ESP_OK;
+}
+ringbuf_handle_t audio_element_get_input_ringbuf(audio_element_handle_t el) { return el->input; }
+ringbuf_handle_t audio_element_get_output_ringbuf(audio_element_handle_t el) { return el->output; }
+
+audio_pipeline_handle_t audio_pipeline_init(audio_pipeline_cfg_t *config) {
+  auto *pipeline = new HostPipeline();
+  pipeline->rb_size = config->rb_size > 0 ? config->rb_size : DEFAULT_PIPELINE_RINGBUF_SIZE;
+  return pipeline;
+}
+
+esp_err_t audio_pipeline_register(audio_pipeline_handle_t pipeline, audio_element_handle_t el, const char *name) {
+  el->tag = name;
+  pipeline->registered.push_back(el);
+  return ESP_OK;
+}
+
+esp_err_t audio_pipeline_unregister(audio_pipeline_handle_t pipeline, audio_element_handle_t el) {
+  auto &registered = pipeline->registered;
+  registered.erase(std::remove(registered.begin(), registered.end(), el), registered.end());
+  auto &linked = pipeline->linked;
+  linked.erase(std::remove(linked.begin(), linked.end(), el), linked.end());
+  el->input = nullptr;
+  el->output = nullptr;
+  return ESP_OK;
+}
+
+esp_err_t audio_pipeline_link(audio_pipeline_handle_t pipeline, const char *link_tag[], int link_num) {
+  pipeline->linked.clear();
+  for (int i = 0; i < link_num; i++) {
+    auto it = std::find_if(pipeline->registered.begin(), pipeline->registered.end(),
+                           [&](HostElement *el) { return el->tag == link_tag[i]; });
+    if (it == pipeline->registered.end())
+      return ESP_FAIL;
+    pipeline->linked.push_back(*it);
+  }
+  for (size_t i = 0; i + 1 < pipeline->linked.size(); i++) {
+    HostElement *upstream = pipeline->linked[i];
+    ringbuf_handle_t rb = rb_create(upstream->out_rb_size > 0 ? upstream->out_rb_size : pipeline->rb_size, 1);
+    pipeline->ringbufs.push_back(rb);
+    upstream->output = rb;
+    pipeline->linked[i + 1]->input = rb;
+  }
+  return ESP_OK;
+}
+
+esp_err_t audio_pipeline_run(audio_pipeline_handle_t pipeline) {
+  for (auto *el : pipeline->linked) {
+    void (*loop)(HostElement *) = nullptr;
+    if (el->kind == HostElement::Kind::I2S) {
+      loop = el->type == AUDIO_STREAM_WRITER ? i2s_writer_loop : i2s_reader_loop;
+    } else if (el->kind == HostElement::Kind::RESAMPLE) {
+      loop = resample_loop;
+    }
+    if (loop == nullptr || el->worker.joinable())
+      continue;
+    el->running = true;
+    el->paused = false;
+    el->worker = std::thread(loop, el);
+  }
+  return ESP_OK;
+}
+
+esp_err_t audio_pipeline_stop(audio_pipeline_handle_t pipeline) {
+  for (auto *el : pipeline->linked)
+    el->running = false;
+  for (auto rb : pipeline->ringbufs)
+    rb_abort(rb);
+  for (auto *el : pipeline->linked) {
+    if (el->worker.joinable())
+      el->worker.join();
+  }
+  return ESP_OK;
+}
+
+esp_err_t audio_pipeline_wait_for_stop(audio_pipeline_handle_t pipeline) { return ESP_OK; }
+
+esp_err_t audio_pipeline_terminate(audio_pipeline_handle_t pipeline) { return audio_pipeline_stop(pipeline); }
+
+esp_err_t audio_pipeline_pause(audio_pipeline_handle_t pipeline) {
+  for (auto *el : pipeline->linked)
+    el->paused = true;
+  return ESP_OK;
+}
+
+esp_err_t audio_pipeline_resume(audio_pipeline_handle_t pipeline) {
+  for (auto *el : pipeline->linked)
+    el->paused = false;
+  return ESP_OK;
+}
+
+esp_err_t audio_pipeline_deinit(audio_pipeline_handle_t pipeline) {
+  audio_pipeline_stop(pipeline);
+  // Like ESP-ADF, elements still registered go with the pipeline
+  for (auto *el : std::vector<HostElement *>(pipeline->registered))
+    audio_element_deinit(el);
+  for (auto rb : pipeline->ringbufs)
+    rb_destroy(rb);
+  delete pipeline;
+  return ESP_OK;
+}
@@ -0,0 +1,114 @@
+// Host test for the ES8311 driver in components/es8311 against a fake I2C bus.
+//
+// Runs setup() and then volume, mute and format changes, counting the I2C transactions each one
+// sends and the registers they reach. Writes go through the driver's register shadow, so a change
+// must only send the registers whose value differs, one burst per run of neighbouring registers.
+// Prints one JSON line per step and exits with 2 if a count or register value is off, so runs can
+// be scripted.
+//
+//   esp_adf_es8311
+
+#include "esphome/components/es8311/es8311.h"
+#include "esphome/components/es8311/es8311_const.h"
+
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace esphome::es8311;
+
+/// The driver with its bus side opened up.
+class TestES8311 : public ES8311Component {
+ public:
+  uint8_t shadow(uint8_t reg) const { return this->read_register_(reg); }
+};
+
+struct Step {
+  const char *name;
+  std::function<bool(TestES8311 &)> run;  // false if the driver reported a failure
+  int bursts;                              // writes expected on the bus
+  int reads;
+  std::function<bool(const TestES8311 &)> check;  // register values afterwards, may be empty
+};
+
+static std::string describe(const std::vector<esphome::i2c::I2CTransaction> &transactions) {
+  std::string out;
+  for (const auto &t : transactions) {
+    char item[24];
+    snprintf(item, sizeof(item), "%s\"%c%02x+%u\"", out.empty() ? "" : ",", t.read ? 'r' : 'w', t.reg,
+             (unsigned) t.len);
+    out += item;
+  }
+  return out;
+}
+
+int main() {
+  TestES8311 codec;
+  codec.set_sample_rate(48000);
+  codec.set_bits_per_sample(16);
+
+  auto word_length = [](const TestES8311 &c, uint8_t bits) {
+    return (c.get_bus_register(ES8311_REG09_SDPIN) & 0x1C) == bits &&
+           (c.get_bus_register(ES8311_REG0A_SDPOUT) & 0x1C) == bits;
+  };
+  auto bus_matches_shadow = [](const TestES8311 &c) {
+    for (uint8_t reg = 0; reg < ES8311_REGISTER_COUNT; reg++) {
+      if (c.get_bus_register(reg) != c.shadow(reg))
+        return false;
+    }
+    return true;
+  };
+
+  const std::vector<Step> steps = {
+      // Two reset writes, one read of the whole register file, then the configuration in bursts;
+      // the fake codec reads back 0 after reset
+      {"setup", [](TestES8311 &c) { c.setup(); return !c.is_failed(); }, 12, 1,
+       [&](const TestES8311 &c) { return bus_matches_shadow(c) && word_length(c, 3 << 2); }},
+      {"set_volume", [](TestES8311 &c) { c.set_volume(0.5f); return !c.is_failed(); }, 1, 0,
+       [](const TestES8311 &c) { return c.get_bus_register(ES8311_REG32_DAC) == 127; }},
+      {"set_volume_unchanged", [](TestES8311 &c) { c.set_volume(0.5f); return !c.is_failed(); }, 0, 0, nullptr},
+      {"set_mute", [](TestES8311 &c) { c.set_mute(true); return !c.is_failed(); }, 1, 0,
+       [](const TestES8311 &c) { return (c.get_bus_register(ES8311_REG31_DAC) & 0x60) == 0x60; }},
+      {"set_mute_unchanged", [](TestES8311 &c) { c.set_mute(true); return !c.is_failed(); }, 0, 0, nullptr},
+      {"unmute", [](TestES8311 &c) { c.set_mute(false); return !c.is_failed(); }, 1, 0,
+       [](const TestES8311 &c) { return (c.get_bus_register(ES8311_REG31_DAC) & 0x60) == 0; }},
+      // The word length (REG09-0A) and the SCLK pre-multiplier (REG02) change, in two bursts
+      {"set_format_48k_16_to_24", [](TestES8311 &c) { return c.set_format(48000, 24); }, 2, 0,
+       [&](const TestES8311 &c) { return bus_matches_shadow(c) && word_length(c, 0); }},
+      {"set_format_unchanged", [](TestES8311 &c) { return c.set_format(48000, 24); }, 0, 0, nullptr},
+      // Of the clock manager only the DAC oversampling differs between 48 and 16 kHz
+      {"set_format_16k", [](TestES8311 &c) { return c.set_format(16000, 24); }, 1, 0,
+       [&](const TestES8311 &c) { return bus_matches_shadow(c) && c.get_sample_rate() == 16000; }},
+      {"set_format_unsupported", [](TestES8311 &c) { return !c.set_format(96000, 16); }, 0, 0,
+       [](const TestES8311 &c) { return c.get_sample_rate() == 16000; }},
+      // A NACK fails the driver and leaves the codec at its previous volume
+      {"set_volume_nack",
+       [](TestES8311 &c) {
+         c.fail_next_bus_transaction();
+         c.set_volume(0.25f);
+         return c.is_failed();
+       },
+       1, 0, [](const TestES8311 &c) { return c.get_bus_register(ES8311_REG32_DAC) == 127; }},
+  };
+
+  bool failed = false;
+  for (const auto &step : steps) {
+    codec.clear_bus_transactions();
+    uint32_t before = codec.get_transaction_count();
+    bool ran = step.run(codec);
+
+    int bursts = 0;
+    int reads = 0;
+    for (const auto &t : codec.get_bus_transactions())
+      (t.read ? reads : bursts)++;
+    // The driver's own counter must agree with the bus
+    uint32_t counted = codec.get_transaction_count() - before;
+    bool ok = ran && counted == codec.get_bus_transactions().size() && bursts == step.bursts &&
+              reads == step.reads && (!step.check || step.check(codec));
+    failed |= !ok;
+    printf("{\"step\":\"%s\",\"bursts\":%d,\"reads\":%d,\"transactions\":[%s],\"ok\":%s}\n", step.name, bursts, reads,
+           describe(codec.get_bus_transactions()).c_str(), ok ? "true" : "false");
+  }
+  return failed ? 2 : 0;
+}
@@ -0,0 +1,163 @@
+// FreeRTOS tasks and queues on pthreads. Priorities and cores are accepted and ignored.
+
+#include "sim_clock.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#include <pthread.h>
+
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct HostTask {
+  pthread_t thread;
+  TaskFunction_t function;
+  void *params;
+  std::string name;
+  void *tls[configNUM_THREAD_LOCAL_STORAGE_POINTERS];
+  TlsDeleteCallbackFunction_t tls_delete[configNUM_THREAD_LOCAL_STORAGE_POINTERS];
+};
+
+struct HostQueue {
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::deque<std::vector<uint8_t>> items;
+  size_t length;
+  size_t item_size;
+};
+
+static thread_local HostTask *current_task = nullptr;
+
+static void run_tls_delete_callbacks(HostTask *task) {
+  for (int i = 0; i < configNUM_THREAD_LOCAL_STORAGE_POINTERS; i++) {
+    if (task->tls_delete[i] != nullptr)
+      task->tls_delete[i](i, task->tls[i]);
+  }
+}
+
+// A task that returns or deletes itself is cleaned up on its own thread, which nobody joins
+static void delete_current_task() {
+  HostTask *task = current_task;
+  run_tls_delete_callbacks(task);
+  pthread_detach(pthread_self());
+  delete task;
+  pthread_exit(nullptr);
+}
+
+static void *task_entry(void *arg) {
+  current_task = static_cast<HostTask *>(arg);
+  pthread_setname_np(pthread_self(), current_task->name.substr(0, 15).c_str());
+  pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED, nullptr);
+  current_task->function(current_task->params);
+  delete_current_task();
+  return nullptr;
+}
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t function, const char *name, uint32_t stack_size, void *params,
+                               UBaseType_t priority, StackType_t *stack, StaticTask_t *tcb) {
+  auto *task = new HostTask{{}, function, params, name, {}, {}};
+  if (pthread_create(&task->thread, nullptr, task_entry, task) != 0) {
+    delete task;
+    return nullptr;
+  }
+  return task;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char *name, uint32_t stack_size, void *params,
+                       UBaseType_t priority, TaskHandle_t *handle) {
+  TaskHandle_t task = xTaskCreateStatic(function, name, stack_size, params, priority, nullptr, nullptr);
+  if (handle != nullptr)
+    *handle = task;
+  return task != nullptr ? pdPASS : pdFAIL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stack_size, void *params,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core) {
+  return xTaskCreate(function, name, stack_size, params, priority, handle);
+}
+
+void vTaskDelete(TaskHandle_t handle) {
+  if (handle == nullptr || handle == current_task)
+    delete_current_task();
+  pthread_cancel(handle->thread);
+  pthread_join(handle->thread, nullptr);
+  run_tls_delete_callbacks(handle);
+  delete handle;
+}
+
+void vTaskSetThreadLocalStoragePointerAndDelCallback(TaskHandle_t handle, BaseType_t index, void *value,
+                                                     TlsDeleteCallbackFunction_t callback) {
+  HostTask *task = handle != nullptr ? handle : current_task;
+  if (task == nullptr || index < 0 || index >= configNUM_THREAD_LOCAL_STORAGE_POINTERS)
+    return;
+  task->tls[index] = value;
+  task->tls_delete[index] = callback;
+}
+
+void vTaskDelay(TickType_t ticks) { host_sim::sleep_us(static_cast<int64_t>(ticks) * 1000); }
+
+TickType_t xTaskGetTickCount() { return static_cast<TickType_t>(host_sim::now_us() / 1000); }
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+  auto *queue = new HostQueue();
+  queue->length = length;
+  queue->item_size = item_size;
+  return queue;
+}
+
+QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t item_size, uint8_t *storage, StaticQueue_t *) {
+  return xQueueCreate(length, item_size);
+}
+
+void vQueueDelete(QueueHandle_t queue) { delete queue; }
+
+static BaseType_t queue_send(QueueHandle_t queue, const void *item, TickType_t ticks, bool front) {
+  std::unique_lock<std::mutex> lock(queue->mutex);
+  if (!host_sim::wait_ticks(lock, queue->changed, ticks, [queue] { return queue->items.size() < queue->length; }))
+    return pdFAIL;
+  const auto *bytes = static_cast<const uint8_t *>(item);
+  std::vector<uint8_t> copy(bytes, bytes + queue->item_size);
+  if (front) {
+    queue->items.push_front(std::move(copy));
+  } else {
+    queue->items.push_back(std::move(copy));
+  }
+  queue->changed.notify_all();
+  return pdPASS;
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t queue, const void *item, TickType_t ticks) {
+  return queue_send(queue, item, ticks, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void *item, TickType_t ticks) {
+  return queue_send(queue, item, ticks, true);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks) {
+  std::unique_lock<std::mutex> lock(queue->mutex);
+  if (!host_sim::wait_ticks(lock, queue->changed, ticks, [queue] { return !queue->items.empty(); }))
+    return pdFAIL;
+  memcpy(item, queue->items.front().data(), queue->item_size);
+  queue->items.pop_front();
+  queue->changed.notify_all();
+  return pdPASS;
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue) {
+  std::lock_guard<std::mutex> lock(queue->mutex);
+  queue->items.clear();
+  queue->changed.notify_all();
+  return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+  std::lock_guard<std::mutex> lock(queue->mutex);
+  return queue->items.size();
+}
@@ -0,0 +1,80 @@
+#include "i2s_port.h"
+
+#include "driver/i2s.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace host_sim {
+
+I2SPort &I2SPort::get(int port) {
+  static I2SPort ports[I2S_NUM_MAX];
+  return ports[port];
+}
+
+void I2SPort::play(const int16_t *samples, size_t frames, int channels, uint32_t sample_rate, int64_t now_us) {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  if (this->output_ != nullptr) {
+    if (channels == 1) {
+      this->output_->write(samples, frames);
+    } else {
+      // The output file is mono, keep the left channel like ONLY_LEFT on the codec
+      std::vector<int16_t> left(frames);
+      for (size_t i = 0; i < frames; i++)
+        left[i] = samples[i * channels];
+      this->output_->write(left.data(), frames);
+    }
+  }
+  if (this->stats_.frames == 0)
+    this->stats_.first_frame_us = now_us;
+  this->stats_.frames += frames;
+  this->stats_.last_frame_us = now_us + static_cast<int64_t>(frames - 1) * 1000000 / sample_rate;
+}
+
+bool I2SPort::capture(int16_t *samples, size_t frames, int channels, int64_t now_us) {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  size_t read = 0;
+  if (this->input_ != nullptr) {
+    int input_channels = this->input_->get_channels();
+    std::vector<int16_t> buffer(frames * input_channels);
+    read = this->input_->read(buffer.data(), frames);
+    for (size_t i = 0; i < read; i++) {
+      for (int c = 0; c < channels; c++)
+        samples[i * channels + c] = buffer[i * input_channels + std::min(c, input_channels - 1)];
+    }
+  }
+  std::fill(samples + read * channels, samples + frames * channels, 0);
+  this->stats_.frames += read;
+  this->stats_.last_frame_us = now_us;
+  return read > 0;
+}
+
+void I2SPort::add_underrun(uint64_t silence_frames) {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  this->stats_.underruns++;
+  this->stats_.silence_frames += silence_frames;
+}
+
+void I2SPort::add_overrun(uint64_t dropped_frames) {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  this->stats_.overruns++;
+  this->stats_.dropped_frames += dropped_frames;
+}
+
+void I2SPort::report_lateness(int64_t late_us) {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  this->stats_.max_late_us = std::max(this->stats_.max_late_us, late_us);
+}
+
+I2SStats I2SPort::get_stats() {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  return this->stats_;
+}
+
+void I2SPort::reset() {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  this->stats_ = I2SStats();
+  this->queued_frames_ = 0;
+}
+
+}  // namespace host_sim
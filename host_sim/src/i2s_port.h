@@ -0,0 +1,55 @@
+#pragma once
+
+#include "wav.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace host_sim {
+
+struct I2SStats {
+  uint64_t frames{0};          // played or captured
+  uint32_t underruns{0};       // TX: DMA ran dry in the middle of a stream
+  uint64_t silence_frames{0};  // TX: zeros inserted by those underruns
+  uint32_t overruns{0};        // RX: frames dropped because the pipeline was full
+  uint64_t dropped_frames{0};
+  int64_t max_late_us{0};      // worst wake-up of the I2S task past its DMA interrupt
+  int64_t first_frame_us{0};   // TX: when the first frame left the pins
+  int64_t last_frame_us{0};    // when the latest frame left or entered the pins
+};
+
+/// The far side of a simulated I2S port: a WAV file the TX side plays into and one the RX side
+/// captures from. The i2s_stream stand-in clocks frames through it in simulated time.
+class I2SPort {
+ public:
+  static I2SPort &get(int port);
+
+  void set_output(WavWriter *output) { this->output_ = output; }
+  void set_input(WavReader *input) { this->input_ = input; }
+
+  /// TX: frames leave the pins, interleaved with `channels` per frame, the first at `now_us`.
+  void play(const int16_t *samples, size_t frames, int channels, uint32_t sample_rate, int64_t now_us);
+  /// RX: fills `frames` frames, zeros once the input is exhausted. Returns false at the end.
+  bool capture(int16_t *samples, size_t frames, int channels, int64_t now_us);
+
+  void add_underrun(uint64_t silence_frames);
+  void add_overrun(uint64_t dropped_frames);
+  void report_lateness(int64_t late_us);
+  void set_queued_frames(size_t frames) { this->queued_frames_ = frames; }
+
+  /// Frames waiting in the simulated DMA buffers.
+  size_t get_queued_frames() const { return this->queued_frames_; }
+  I2SStats get_stats();
+  void reset();
+
+ protected:
+  std::mutex mutex_;
+  WavWriter *output_{nullptr};
+  WavReader *input_{nullptr};
+  I2SStats stats_;
+  std::atomic<size_t> queued_frames_{0};
+};
+
+}  // namespace host_sim
@@ -0,0 +1,165 @@
+// Host runner for the ADC button ladder decoder in components/esp_adf/adc_ladder.
+//
+// Replays a trace of raw readings, one "<time ms> <raw>" pair per line where each value holds
+// until the next line, sampling it the way the speaker does: at the decoder's adaptive interval.
+// Prints every debounced press and release and every event as a JSON line and, at the end, how
+// many readings were taken compared to sampling at the active rate throughout. With --expect the
+// lines must match the given file, or the run fails with exit code 2.
+//
+//   esp_adf_ladder trace.txt --key 1:300 --key 2:900:80 --key 3:1500 --repeat 200
+
+#include "esphome/components/esp_adf/adc_ladder.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace esphome::esp_adf;
+
+static void usage() {
+  fprintf(stderr,
+          "usage: esp_adf_ladder <trace> --key id:raw[:debounce ms] [--key ...] [options]\n"
+          "  --tolerance raw     window half width around each key (default 150)\n"
+          "  --hysteresis raw    extra width while the key is held (default 30)\n"
+          "  --debounce ms       for keys without their own (default 30)\n"
+          "  --long-press ms     (default 800)\n"
+          "  --repeat ms         repeat interval after a long press, 0 for none (default 0)\n"
+          "  --idle ms           sample interval while idle (default 100)\n"
+          "  --active ms         sample interval around activity (default 20)\n"
+          "  --expect file       JSON lines the run must print\n");
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    usage();
+    return 1;
+  }
+  AdcLadderDecoder decoder;
+  uint32_t active_interval_ms = 20;
+  uint32_t debounce_ms = AdcLadderDecoder::DEFAULT_DEBOUNCE_MS;
+  const char *expect_path = nullptr;
+  std::vector<std::pair<unsigned, unsigned>> keys;
+  std::vector<int> key_debounce_ms;  // -1 for the --debounce value
+  for (int i = 2; i < argc; i++) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc) {
+      usage();
+      return 1;
+    }
+    const char *value = argv[++i];
+    if (arg == "--key") {
+      unsigned id, raw, key_debounce;
+      int fields = sscanf(value, "%u:%u:%u", &id, &raw, &key_debounce);
+      if (fields < 2) {
+        usage();
+        return 1;
+      }
+      keys.emplace_back(id, raw);
+      key_debounce_ms.push_back(fields == 3 ? int(key_debounce) : -1);
+    } else if (arg == "--tolerance") {
+      decoder.set_tolerance(atoi(value));
+    } else if (arg == "--hysteresis") {
+      decoder.set_hysteresis(atoi(value));
+    } else if (arg == "--debounce") {
+      debounce_ms = atoi(value);
+    } else if (arg == "--long-press") {
+      decoder.set_long_press_ms(atoi(value));
+    } else if (arg == "--repeat") {
+      decoder.set_repeat_ms(atoi(value));
+    } else if (arg == "--idle") {
+      decoder.set_idle_interval_ms(atoi(value));
+    } else if (arg == "--active") {
+      active_interval_ms = atoi(value);
+      decoder.set_active_interval_ms(active_interval_ms);
+    } else if (arg == "--expect") {
+      expect_path = value;
+    } else {
+      usage();
+      return 1;
+    }
+  }
+  if (keys.empty()) {
+    usage();
+    return 1;
+  }
+  for (size_t i = 0; i < keys.size(); i++)
+    decoder.add_key(keys[i].first, keys[i].second, key_debounce_ms[i] < 0 ? debounce_ms : key_debounce_ms[i]);
+
+  std::ifstream file(argv[1]);
+  if (!file) {
+    fprintf(stderr, "Cannot open %s\n", argv[1]);
+    return 1;
+  }
+  std::vector<std::pair<uint32_t, uint16_t>> trace;
+  std::string line;
+  while (std::getline(file, line)) {
+    unsigned time_ms, raw;
+    if (line.empty() || line[0] == '#' || sscanf(line.c_str(), "%u %u", &time_ms, &raw) != 2)
+      continue;
+    trace.emplace_back(time_ms, raw);
+  }
+  if (trace.empty()) {
+    fprintf(stderr, "%s has no readings\n", argv[1]);
+    return 1;
+  }
+
+  std::vector<std::string> expected;
+  if (expect_path != nullptr) {
+    std::ifstream expect_file(expect_path);
+    if (!expect_file) {
+      fprintf(stderr, "Cannot open %s\n", expect_path);
+      return 1;
+    }
+    while (std::getline(expect_file, line)) {
+      if (!line.empty() && line[0] != '#')
+        expected.push_back(line);
+    }
+  }
+
+  std::vector<std::string> printed;
+  auto print = [&printed](uint32_t time_ms, uint8_t id, const char *event) {
+    char buffer[96];
+    snprintf(buffer, sizeof(buffer), "{\"time_ms\":%u,\"id\":%u,\"event\":\"%s\"}", (unsigned) time_ms,
+             (unsigned) id, event);
+    printf("%s\n", buffer);
+    printed.emplace_back(buffer);
+  };
+
+  size_t index = 0;
+  unsigned readings = 0;
+  uint8_t held = AdcLadderDecoder::NO_KEY;
+  uint32_t end_ms = trace.back().first;
+  for (uint32_t now_ms = trace.front().first; now_ms <= end_ms; now_ms += decoder.get_sample_interval_ms(now_ms)) {
+    while (index + 1 < trace.size() && trace[index + 1].first <= now_ms)
+      index++;
+    readings++;
+    LadderEvent event;
+    bool fired = decoder.feed(trace[index].second, now_ms, &event);
+    if (decoder.get_held_id() != held) {
+      if (held != AdcLadderDecoder::NO_KEY)
+        print(now_ms, held, "release");
+      held = decoder.get_held_id();
+      if (held != AdcLadderDecoder::NO_KEY)
+        print(now_ms, held, "press");
+    }
+    if (fired)
+      print(event.time_ms, event.id, ladder_event_type_to_string(event.type));
+  }
+  unsigned fixed_readings = (end_ms - trace.front().first) / active_interval_ms + 1;
+  fprintf(stderr, "%u readings, %u at a fixed %u ms interval\n", readings, fixed_readings,
+          (unsigned) active_interval_ms);
+
+  if (expect_path != nullptr && printed != expected) {
+    size_t i = 0;
+    while (i < printed.size() && i < expected.size() && printed[i] == expected[i])
+      i++;
+    fprintf(stderr, "Line %u differs from %s: got %s, expected %s\n", (unsigned) (i + 1), expect_path,
+            i < printed.size() ? printed[i].c_str() : "nothing", i < expected.size() ? expected[i].c_str() : "nothing");
+    return 2;
+  }
+  return 0;
+}
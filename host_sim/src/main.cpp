@@ -0,0 +1,491 @@
+// Runs the ESP-ADF speaker and microphone components on Linux, from a WAV file to a WAV file.
+//
+// The real ESPADFSpeaker and ESPADFMicrophone are set up and driven from a simulated main loop:
+// play() is fed the way a media player feeds it and the data callbacks receive the capture, while
+// their player and read tasks run the pipelines against a simulated I2S clock. Exits with 2 when
+// the port saw underruns or overruns, so runs can be scripted.
+//
+// The url mode plays through the speaker's URL pipeline instead, started with play_at() on a
+// playback clock that runs --skew-ppm faster than the local one; the input stands in for the
+// decoded stream, "-" for a 44.1 kHz stereo tone of --seconds. Exits with 2 when the end of the
+// stream is off its schedule by more than MAX_SCHEDULE_ERROR_US.
+//
+//   esp_adf_host_sim speaker music16k.wav out.wav --speed 20 --profile ultra_low --stall 500:80
+//   esp_adf_host_sim microphone speech16k.wav out.wav --noise-suppression 70
+//   esp_adf_host_sim url - out.wav --seconds 30 --skew-ppm 300 --speed 40
+
+#include "i2s_port.h"
+#include "sim_clock.h"
+#include "wav.h"
+
+#include "esphome/components/audio_utils/latency_tuner.h"
+#include "esphome/components/audio_utils/noise_suppressor.h"
+#include "esphome/components/audio_utils/shared_clock.h"
+#include "esphome/components/sensor/sensor.h"
+#include "esphome/core/application.h"
+#include "esphome/core/log.h"
+#include "esp_adf.h"
+#include "microphone/esp_adf_microphone.h"
+#include "pipeline_builder.h"
+#include "speaker/esp_adf_speaker.h"
+
+#include <raw_stream.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace esphome;
+using esp_adf::PipelineElementConfig;
+using esp_adf::PipelineElementType;
+
+static const char *const TAG = "host_sim";
+
+// Same as the components
+static const uint32_t SAMPLE_RATE = 16000;
+static const size_t BUFFER_SIZE = esp_adf::BUFFER_SIZE;
+
+// One pass of the ESPHome main loop
+static const int64_t LOOP_INTERVAL_US = 16000;
+// The stream is over once the port has made no progress for this long
+static const int64_t IDLE_TIMEOUT_US = 1000000;
+// url: how far the last frame may play off its schedule
+static const int64_t MAX_SCHEDULE_ERROR_US = 2000;
+// url: the playback clock's epoch, far from the local one so that a missed conversion shows
+static const int64_t SHARED_OFFSET_US = 1000000000;
+
+struct Options {
+  std::string mode;
+  std::string input;
+  std::string output;
+  double speed{1.0};
+  audio_utils::LatencyProfile profile{audio_utils::LatencyProfile::ROBUST};
+  int stall_every_ms{0};
+  int stall_ms{0};
+  float noise_suppression{-1.0f};
+  float skew_ppm{0.0f};
+  int start_ms{500};
+  int seconds{20};
+};
+
+static void usage() {
+  fprintf(stderr,
+          "usage: esp_adf_host_sim speaker|microphone|url <in.wav> <out.wav> [options]\n"
+          "  --speed <x>                  simulated time runs x times faster than real time\n"
+          "  --profile ultra_low|balanced|robust\n"
+          "                               speaker buffer plan (default robust)\n"
+          "  --stall <every_ms>:<ms>      speaker: the main loop stalls periodically\n"
+          "  --noise-suppression <pct>    microphone: run the noise suppressor at this strength\n"
+          "  --skew-ppm <ppm>             url: the playback clock runs this much faster\n"
+          "  --start-ms <ms>              url: play_at() this far ahead (default 500)\n"
+          "  --seconds <s>                url: length of the tone played for input \"-\" (default 20)\n");
+}
+
+static bool parse_options(int argc, char **argv, Options *options) {
+  if (argc < 4)
+    return false;
+  options->mode = argv[1];
+  options->input = argv[2];
+  options->output = argv[3];
+  if (options->mode != "speaker" && options->mode != "microphone" && options->mode != "url")
+    return false;
+  for (int i = 4; i < argc; i++) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc)
+      return false;
+    const char *value = argv[++i];
+    if (arg == "--speed") {
+      options->speed = atof(value);
+      if (options->speed <= 0.0)
+        return false;
+    } else if (arg == "--profile") {
+      if (strcmp(value, "ultra_low") == 0) {
+        options->profile = audio_utils::LatencyProfile::ULTRA_LOW;
+      } else if (strcmp(value, "balanced") == 0) {
+        options->profile = audio_utils::LatencyProfile::BALANCED;
+      } else if (strcmp(value, "robust") == 0) {
+        options->profile = audio_utils::LatencyProfile::ROBUST;
+      } else {
+        return false;
+      }
+    } else if (arg == "--stall") {
+      if (sscanf(value, "%d:%d", &options->stall_every_ms, &options->stall_ms) != 2 ||
+          options->stall_every_ms <= 0 || options->stall_ms < 0)
+        return false;
+    } else if (arg == "--noise-suppression") {
+      options->noise_suppression = atof(value) / 100.0f;
+    } else if (arg == "--skew-ppm") {
+      options->skew_ppm = atof(value);
+    } else if (arg == "--start-ms") {
+      options->start_ms = atoi(value);
+      if (options->start_ms < 0)
+        return false;
+    } else if (arg == "--seconds") {
+      options->seconds = atoi(value);
+      if (options->seconds <= 0)
+        return false;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+static PipelineElementConfig element(PipelineElementType type) { return {type, 0, -1, -1, 0, 0, 0, 0, 0}; }
+
+static PipelineElementConfig resampler(int source_rate, int source_channels, int dest_rate, int dest_channels) {
+  return {PipelineElementType::RESAMPLE_FILTER, 0, -1, -1, source_rate, source_channels, dest_rate, dest_channels, 2};
+}
+
+static void report_timing(int64_t sim_us, std::chrono::steady_clock::duration wall) {
+  double wall_ms = std::chrono::duration<double, std::milli>(wall).count();
+  ESP_LOGI(TAG, "Simulated %.1f ms in %.1f ms wall time (%.1fx real time)", sim_us / 1000.0, wall_ms,
+           wall_ms > 0 ? sim_us / 1000.0 / wall_ms : 0.0);
+}
+
+/// Feeds the WAV file to ESPADFSpeaker::play() from the main loop until the port has played it.
+static int run_speaker(const Options &options, esp_adf::ESPADF &adf, host_sim::WavReader &input) {
+  // What the speaker's config accepts for play(); its pipeline has no room for a resampler
+  if (input.get_sample_rate() != SAMPLE_RATE || input.get_channels() != 1) {
+    ESP_LOGE(TAG, "The speaker plays %u Hz mono, resample the input first", (unsigned) SAMPLE_RATE);
+    return 1;
+  }
+  host_sim::WavWriter output;
+  if (!output.open(options.output, SAMPLE_RATE, 1)) {
+    ESP_LOGE(TAG, "Cannot write %s", options.output.c_str());
+    return 1;
+  }
+  host_sim::I2SPort &port = host_sim::I2SPort::get(I2S_NUM_0);
+  port.set_output(&output);
+
+  // The speaker publishes its volume to this sensor
+  sensor::Sensor volume_sensor("generic_volume_sensor");
+  App.register_sensor(&volume_sensor);
+
+  esp_adf::ESPADFSpeaker speaker;
+  speaker.set_parent(&adf);
+  speaker.set_latency_profile(options.profile);
+  speaker.set_auto_tune(false);
+  speaker.get_pipeline().add_element(element(PipelineElementType::RAW_STREAM));
+  speaker.get_pipeline().add_element(element(PipelineElementType::I2S_STREAM));
+  speaker.setup();
+  if (speaker.is_failed())
+    return 1;
+  audio_utils::BufferPlan plan = speaker.get_latency_tuner().get_plan();
+  ESP_LOGCONFIG(TAG, "Speaker: profile %s, DMA %dx%d, ring buffer %u bytes",
+                audio_utils::latency_profile_to_string(options.profile),
+                plan.dma_buffer_count, plan.dma_buffer_length, (unsigned) plan.ring_buffer_size);
+  speaker.dump_config();
+
+  auto wall_start = std::chrono::steady_clock::now();
+  const size_t frame_bytes = sizeof(int16_t);
+  std::vector<int16_t> chunk(BUFFER_SIZE / sizeof(int16_t));
+  size_t pending = 0;  // bytes of `chunk` play() has not taken yet
+  size_t offset = 0;
+  bool input_done = false;
+  int64_t next_stall_us = options.stall_ms > 0 ? options.stall_every_ms * 1000LL : -1;
+
+  // Feed until the input is exhausted, then until the port has played it or stops making progress
+  uint64_t expected = 0;  // frames play() was given
+  uint64_t last_frames = 0;
+  int64_t last_progress = host_sim::now_us();
+  while (true) {
+    speaker.loop();
+    while (!input_done) {
+      if (pending == 0) {
+        size_t frames = input.read(chunk.data(), BUFFER_SIZE / frame_bytes);
+        if (frames == 0) {
+          input_done = true;
+          break;
+        }
+        expected += frames;
+        pending = frames * frame_bytes;
+        offset = 0;
+      }
+      size_t accepted = speaker.play(reinterpret_cast<const uint8_t *>(chunk.data()) + offset, pending);
+      pending -= accepted;
+      offset += accepted;
+      if (pending > 0)
+        break;  // the queue is full, the rest waits for the next loop
+    }
+
+    host_sim::I2SStats progress = port.get_stats();
+    uint64_t played = progress.frames - progress.silence_frames;  // from the input
+    if (input_done && played >= expected)
+      break;
+    if (played != last_frames) {
+      last_frames = played;
+      last_progress = host_sim::now_us();
+    } else if (input_done && host_sim::now_us() - last_progress > IDLE_TIMEOUT_US) {
+      break;
+    }
+
+    if (next_stall_us >= 0 && host_sim::now_us() >= next_stall_us) {
+      host_sim::sleep_us(options.stall_ms * 1000LL);
+      next_stall_us += options.stall_every_ms * 1000LL;
+    }
+    host_sim::sleep_us(LOOP_INTERVAL_US);
+  }
+  auto wall = std::chrono::steady_clock::now() - wall_start;
+  int64_t sim_us = host_sim::now_us();
+  host_sim::I2SStats stats = port.get_stats();
+  uint32_t seen_underruns = speaker.get_latency_tuner().get_session_underruns();
+  // The clock the player task kept, read before the next session resets it
+  int64_t predicted = expected > 0 ? speaker.get_sample_clock().time_of(expected - 1) : 0;
+
+  // The player task winds down once play() has had nothing for it a while
+  speaker.stop();
+  int64_t stop_deadline = host_sim::now_us() + 2 * IDLE_TIMEOUT_US;
+  while (!speaker.is_stopped() && host_sim::now_us() < stop_deadline) {
+    speaker.loop();
+    host_sim::sleep_us(LOOP_INTERVAL_US);
+  }
+  if (!speaker.is_stopped())
+    ESP_LOGW(TAG, "The speaker did not stop");
+  port.set_output(nullptr);
+  output.close();
+
+  report_timing(sim_us, wall);
+  ESP_LOGI(TAG, "Played %llu frames including silence, %llu from the input", (unsigned long long) stats.frames,
+           (unsigned long long) expected);
+  ESP_LOGI(TAG, "Underruns: %u on the port (%llu frames of silence), %u seen by the player task", stats.underruns,
+           (unsigned long long) stats.silence_frames, (unsigned) seen_underruns);
+  ESP_LOGI(TAG, "I2S task woke up at most %.2f ms late", stats.max_late_us / 1000.0);
+  ESP_LOGI(TAG, "Output latency (DMA, I2S ring buffer and play() queue): %.1f ms",
+           speaker.get_output_latency_us() / 1000.0);
+  if (stats.frames - stats.silence_frames >= expected && expected > 0) {
+    ESP_LOGI(TAG, "Presentation clock error at the last frame: %+.2f ms", (predicted - stats.last_frame_us) / 1000.0);
+  }
+  return stats.underruns > 0 ? 2 : 0;
+}
+
+/// Plays a stream through ESPADFSpeaker::play_url() on a schedule and checks where its last frame
+/// lands. A feeder thread stands in for the HTTP source and decoder, writing as fast as the
+/// pipeline takes it; `input` is null for the tone.
+static int run_url(const Options &options, esp_adf::ESPADF &adf, host_sim::WavReader *input) {
+  const uint32_t rate = input != nullptr ? input->get_sample_rate() : 44100;
+  const int channels = input != nullptr ? input->get_channels() : 2;
+  const uint64_t total_frames = input != nullptr ? input->get_frames() : static_cast<uint64_t>(options.seconds) * rate;
+  host_sim::WavWriter output;
+  if (!output.open(options.output, SAMPLE_RATE, 1)) {
+    ESP_LOGE(TAG, "Cannot write %s", options.output.c_str());
+    return 1;
+  }
+  host_sim::I2SPort &port = host_sim::I2SPort::get(I2S_NUM_0);
+  port.set_output(&output);
+
+  sensor::Sensor volume_sensor("generic_volume_sensor");
+  App.register_sensor(&volume_sensor);
+
+  audio_utils::SharedClock clock;
+  clock.publish(host_sim::now_us(), host_sim::now_us() + SHARED_OFFSET_US, options.skew_ppm);
+
+  esp_adf::ESPADFSpeaker speaker;
+  speaker.set_parent(&adf);
+  speaker.set_latency_profile(options.profile);
+  speaker.set_auto_tune(false);
+  speaker.set_playback_clock(&clock);
+  speaker.get_pipeline().add_element(element(PipelineElementType::RAW_STREAM));
+  speaker.get_pipeline().add_element(element(PipelineElementType::I2S_STREAM));
+  speaker.get_url_pipeline().add_element(element(PipelineElementType::RAW_STREAM));
+  speaker.get_url_pipeline().add_element(resampler(rate, channels, SAMPLE_RATE, 1));
+  speaker.get_url_pipeline().add_element(element(PipelineElementType::I2S_STREAM));
+  speaker.setup();
+  if (speaker.is_failed())
+    return 1;
+  ESP_LOGCONFIG(TAG, "URL stream: %u Hz, %d channel(s), %.1f s, playback clock %+.1f ppm",
+                (unsigned) rate, channels, total_frames / static_cast<double>(rate), options.skew_ppm);
+  speaker.dump_config();
+
+  auto wall_start = std::chrono::steady_clock::now();
+  int64_t start_us = clock.to_shared_us(host_sim::now_us()) + options.start_ms * 1000LL;
+  speaker.play_at(start_us);
+  speaker.play_url(input != nullptr ? options.input : "tone");
+  if (!speaker.is_running()) {
+    ESP_LOGE(TAG, "The URL pipeline did not start");
+    return 1;
+  }
+
+  std::thread feeder([&, source = speaker.get_url_pipeline().get_source()]() {
+    std::vector<int16_t> chunk(1024 * channels);
+    uint64_t position = 0;
+    while (position < total_frames) {
+      size_t frames = std::min<uint64_t>(1024, total_frames - position);
+      if (input != nullptr) {
+        frames = input->read(chunk.data(), frames);
+        if (frames == 0)
+          break;
+      } else {
+        for (size_t f = 0; f < frames; f++) {
+          auto sample = static_cast<int16_t>(8000.0 * std::sin(2.0 * M_PI * 440.0 * (position + f) / rate));
+          for (int c = 0; c < channels; c++)
+            chunk[f * channels + c] = sample;
+        }
+      }
+      int bytes = static_cast<int>(frames * channels * sizeof(int16_t));
+      if (raw_stream_write(source, reinterpret_cast<char *>(chunk.data()), bytes) != bytes)
+        break;  // the pipeline was stopped
+      position += frames;
+    }
+  });
+
+  // Until the port has played about the whole stream, then until it stops making progress
+  const uint64_t expected = total_frames * SAMPLE_RATE / rate;
+  uint64_t last_frames = 0;
+  int64_t last_progress = host_sim::now_us();
+  while (true) {
+    speaker.loop();
+    uint64_t played = port.get_stats().frames;
+    if (played != last_frames) {
+      last_frames = played;
+      last_progress = host_sim::now_us();
+    } else if (played > expected / 2 && host_sim::now_us() - last_progress > IDLE_TIMEOUT_US) {
+      break;
+    } else if (played == 0 && host_sim::now_us() - last_progress > options.start_ms * 1000LL + IDLE_TIMEOUT_US) {
+      break;
+    }
+    host_sim::sleep_us(LOOP_INTERVAL_US);
+  }
+  auto wall = std::chrono::steady_clock::now() - wall_start;
+  int64_t sim_us = host_sim::now_us();
+  host_sim::I2SStats stats = port.get_stats();
+
+  // Aborting the ring buffers releases the feeder before the pipeline goes
+  audio_pipeline_stop(speaker.get_url_pipeline().get_pipeline());
+  feeder.join();
+  speaker.media_stop();
+  port.set_output(nullptr);
+  output.close();
+
+  report_timing(sim_us, wall);
+  if (stats.frames == 0) {
+    ESP_LOGE(TAG, "Nothing was played");
+    return 2;
+  }
+  // The last frame of the stream is due one frame before its end
+  int64_t end_due_us = start_us + static_cast<int64_t>((total_frames - 1) * 1000000 / rate);
+  int64_t start_error_us = clock.to_shared_us(stats.first_frame_us) - start_us;
+  int64_t end_error_us = clock.to_shared_us(stats.last_frame_us) - end_due_us;
+  ESP_LOGI(TAG, "Played %llu frames for %llu at the nominal rate", (unsigned long long) stats.frames,
+           (unsigned long long) expected);
+  ESP_LOGI(TAG, "Underruns: %u on the port", stats.underruns);
+  ESP_LOGI(TAG, "Schedule error: %+.2f ms at the first frame, %+.2f ms at the last", start_error_us / 1000.0,
+           end_error_us / 1000.0);
+  return std::abs(end_error_us) > MAX_SCHEDULE_ERROR_US || stats.underruns > 0 ? 2 : 0;
+}
+
+/// Captures the WAV file through ESPADFMicrophone and writes what its data callbacks receive.
+static int run_microphone(const Options &options, esp_adf::ESPADF &adf, host_sim::WavReader &input) {
+  if (input.get_sample_rate() != SAMPLE_RATE) {
+    ESP_LOGE(TAG, "The microphone captures at %u Hz, resample the input first", (unsigned) SAMPLE_RATE);
+    return 1;
+  }
+  host_sim::WavWriter output;
+  if (!output.open(options.output, SAMPLE_RATE, 1)) {
+    ESP_LOGE(TAG, "Cannot write %s", options.output.c_str());
+    return 1;
+  }
+  host_sim::I2SPort &port = host_sim::I2SPort::get(I2S_NUM_0);
+  port.set_input(&input);
+
+  esp_adf::ESPADFMicrophone microphone;
+  microphone.set_parent(&adf);
+  microphone.get_pipeline().add_element(element(PipelineElementType::I2S_STREAM));
+  microphone.get_pipeline().add_element(resampler(SAMPLE_RATE, 2, SAMPLE_RATE, 1));
+  microphone.get_pipeline().add_element(element(PipelineElementType::RAW_STREAM));
+  audio_utils::NoiseSuppressor suppressor;
+  bool suppress = options.noise_suppression >= 0.0f;
+  if (suppress) {
+    suppressor.set_strength(options.noise_suppression);
+    microphone.set_noise_suppressor(&suppressor);
+  }
+
+  uint64_t frames = 0;
+  int64_t max_latency_us = 0;
+  microphone.add_data_callback([&](const std::vector<int16_t> &samples) {
+    if (samples.empty())
+      return;
+    frames += samples.size();
+    // Age of the newest sample when the callback gets it, by the microphone's own capture clock
+    int64_t captured = microphone.get_last_capture_time_us() + samples.size() * 1000000LL / SAMPLE_RATE;
+    max_latency_us = std::max(max_latency_us, host_sim::now_us() - captured);
+    output.write(samples.data(), samples.size());
+  });
+  microphone.setup();
+  if (microphone.is_failed())
+    return 1;
+  ESP_LOGCONFIG(TAG, "Microphone: %u Hz, %d channel(s), noise suppression %s", (unsigned) SAMPLE_RATE,
+                input.get_channels(), suppress ? "on" : "off");
+  microphone.dump_config();
+
+  auto wall_start = std::chrono::steady_clock::now();
+  microphone.start();
+  // Runs until the input is exhausted and everything captured has reached the callbacks
+  uint64_t last_frames = 0;
+  int64_t last_progress = host_sim::now_us();
+  while (true) {
+    microphone.loop();
+    if (frames != last_frames) {
+      last_frames = frames;
+      last_progress = host_sim::now_us();
+    } else if (host_sim::now_us() - last_progress > IDLE_TIMEOUT_US) {
+      break;
+    }
+    host_sim::sleep_us(LOOP_INTERVAL_US);
+  }
+  auto wall = std::chrono::steady_clock::now() - wall_start;
+  int64_t sim_us = host_sim::now_us();
+
+  microphone.stop();
+  int64_t stop_deadline = host_sim::now_us() + IDLE_TIMEOUT_US;
+  while (!microphone.is_stopped() && host_sim::now_us() < stop_deadline) {
+    microphone.loop();
+    host_sim::sleep_us(LOOP_INTERVAL_US);
+  }
+  if (!microphone.is_stopped())
+    ESP_LOGW(TAG, "The microphone did not stop");
+  host_sim::I2SStats stats = port.get_stats();
+  port.set_input(nullptr);
+  output.close();
+
+  report_timing(sim_us, wall);
+  ESP_LOGI(TAG, "Captured %llu frames, delivered %llu", (unsigned long long) stats.frames,
+           (unsigned long long) frames);
+  ESP_LOGI(TAG, "Overruns: %u (%llu frames dropped)", stats.overruns, (unsigned long long) stats.dropped_frames);
+  ESP_LOGI(TAG, "I2S task woke up at most %.2f ms late", stats.max_late_us / 1000.0);
+  ESP_LOGI(TAG, "Worst capture latency: %.2f ms", max_latency_us / 1000.0);
+  if (suppress) {
+    ESP_LOGI(TAG, "Noise suppressor: %u frames, %.1f us average, %u us max", suppressor.get_frames_processed(),
+             suppressor.get_average_frame_us(), suppressor.get_max_frame_us());
+  }
+  return stats.overruns > 0 ? 2 : 0;
+}
+
+int main(int argc, char **argv) {
+  Options options;
+  if (!parse_options(argc, argv, &options)) {
+    usage();
+    return 1;
+  }
+  host_sim::set_speed(options.speed);
+
+  host_sim::WavReader input;
+  std::string error;
+  bool tone = options.mode == "url" && options.input == "-";
+  if (!tone && !input.open(options.input, &error)) {
+    ESP_LOGE(TAG, "%s: %s", options.input.c_str(), error.c_str());
+    return 1;
+  }
+  esp_adf::ESPADF adf;
+  adf.setup();
+  if (options.mode == "speaker")
+    return run_speaker(options, adf, input);
+  if (options.mode == "url")
+    return run_url(options, adf, tone ? nullptr : &input);
+  return run_microphone(options, adf, input);
+}
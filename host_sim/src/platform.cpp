@@ -0,0 +1,56 @@
+// Host stand-ins for the ESP-IDF and ESPHome platform functions.
+
+#include "sim_clock.h"
+
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "esphome/core/application.h"
+#include "esphome/core/hal.h"
+
+#include <cstdlib>
+
+// The host heap is reported as one region that is never short of memory
+static const size_t HOST_FREE_HEAP = 4 * 1024 * 1024;
+
+const char *esp_err_to_name(esp_err_t code) {
+  switch (code) {
+    case ESP_OK:
+      return "ESP_OK";
+    case ESP_FAIL:
+      return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:
+      return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:
+      return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:
+      return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_TIMEOUT:
+      return "ESP_ERR_TIMEOUT";
+    default:
+      return "UNKNOWN ERROR";
+  }
+}
+
+void *heap_caps_malloc(size_t size, uint32_t caps) {
+  if (caps & MALLOC_CAP_SPIRAM)
+    return nullptr;  // no PSRAM fitted
+  return malloc(size);
+}
+void heap_caps_free(void *ptr) { free(ptr); }
+size_t heap_caps_get_free_size(uint32_t caps) { return (caps & MALLOC_CAP_SPIRAM) ? 0 : HOST_FREE_HEAP; }
+size_t heap_caps_get_minimum_free_size(uint32_t caps) { return heap_caps_get_free_size(caps); }
+size_t heap_caps_get_largest_free_block(uint32_t caps) { return heap_caps_get_free_size(caps); }
+
+int64_t esp_timer_get_time() { return host_sim::now_us(); }
+
+namespace esphome {
+
+Application App;  // NOLINT
+
+uint32_t millis() { return static_cast<uint32_t>(host_sim::now_us() / 1000); }
+uint32_t micros() { return static_cast<uint32_t>(host_sim::now_us()); }
+void delay(uint32_t ms) { host_sim::sleep_us(static_cast<int64_t>(ms) * 1000); }
+void delayMicroseconds(uint32_t us) { host_sim::sleep_us(us); }
+
+}  // namespace esphome
@@ -0,0 +1,300 @@
+// Host test for the DMA playout tracking of the I2S speaker (audio_utils/dma_playout.h) and the
+// underrun counting the latency tuner relies on.
+//
+// Models the legacy ESP-IDF I2S driver in simulated time: a ring of DMA buffers played without
+// pause, the free-buffer queue i2s_write() takes from, the overflow that clears the next buffer
+// when every buffer is free, and an event queue that drops its oldest event when full. A writer
+// feeds it the way I2SAudioSpeaker's player task does. Each scenario checks the underruns counted,
+// whether auto tuning would grow the buffers, and how far the sample clock's presentation times
+// were from when the frames actually started. Prints one JSON line per scenario and exits with 2
+// if any check failed, so runs can be scripted.
+//
+//   esp_adf_playout
+
+#include "esphome/components/audio_utils/dma_playout.h"
+#include "esphome/components/audio_utils/latency_tuner.h"
+#include "esphome/components/audio_utils/sample_clock.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace esphome::audio_utils;
+
+enum class DmaEvent { TX_DONE, TX_Q_OVF };
+
+/// The driver's side: ring, free queue and event queue, advanced to a point in time on demand.
+class LegacyI2sModel {
+ public:
+  LegacyI2sModel(int count, int length, uint32_t rate)
+      : count_(count), length_(length), rate_(rate), buffers_(count), event_limit_(count * 2) {
+    this->period_us_ = static_cast<double>(length) * 1e6 / rate;
+  }
+
+  /// Plays the ring up to `now_us`.
+  void run_until(int64_t now_us) {
+    while (this->next_done_us() <= now_us)
+      this->complete_();
+  }
+  int64_t next_done_us() const { return static_cast<int64_t>((this->completed_ + 1) * this->period_us_); }
+
+  /// i2s_write() with no timeout: frames taken until no buffer is free.
+  size_t write(size_t frames) {
+    size_t taken = 0;
+    while (taken < frames) {
+      if (this->current_ < 0 || this->fill_ == this->length_) {
+        if (this->free_.empty())
+          break;
+        this->current_ = this->free_.front();
+        this->free_.pop_front();
+        this->fill_ = 0;
+        this->buffers_[this->current_].start = this->written_;
+        this->buffers_[this->current_].frames = 0;
+      }
+      size_t n = std::min<size_t>(frames - taken, this->length_ - this->fill_);
+      this->fill_ += n;
+      this->buffers_[this->current_].frames += n;
+      this->written_ += n;
+      taken += n;
+    }
+    return taken;
+  }
+
+  bool pop_event(DmaEvent *event) {
+    if (this->events_.empty())
+      return false;
+    *event = this->events_.front();
+    this->events_.pop_front();
+    return true;
+  }
+  bool has_event() const { return !this->events_.empty(); }
+  void clear_events() { this->events_.clear(); }
+
+  /// When the frame at `position` started playing, -1 if it has not or was lost.
+  int64_t start_of(uint64_t position) const {
+    return position < this->started_us_.size() ? this->started_us_[position] : -1;
+  }
+  uint64_t get_written() const { return this->written_; }
+  uint32_t get_dropped_events() const { return this->dropped_events_; }
+
+ protected:
+  struct Buffer {
+    uint64_t start{0};
+    size_t frames{0};  // 0 for a cleared buffer
+  };
+
+  void post_(DmaEvent event) {
+    if (this->events_.size() == this->event_limit_) {
+      this->events_.pop_front();
+      this->dropped_events_++;
+    }
+    this->events_.push_back(event);
+  }
+
+  void complete_() {
+    this->completed_++;
+    int finished = this->playing_;
+    if (static_cast<int>(this->free_.size()) == this->count_ - 1) {
+      int cleared = this->free_.front();
+      this->free_.pop_front();
+      this->buffers_[cleared].frames = 0;
+      this->post_(DmaEvent::TX_Q_OVF);
+    }
+    this->free_.push_back(finished);
+    this->post_(DmaEvent::TX_DONE);
+
+    this->playing_ = (this->playing_ + 1) % this->count_;
+    const Buffer &next = this->buffers_[this->playing_];
+    int64_t start_us = static_cast<int64_t>(this->completed_ * this->period_us_);
+    for (size_t i = 0; i < next.frames; i++) {
+      uint64_t position = next.start + i;
+      if (position >= this->started_us_.size())
+        this->started_us_.resize(position + 1, -1);
+      if (this->started_us_[position] < 0)
+        this->started_us_[position] = start_us + static_cast<int64_t>(i * 1e6 / this->rate_);
+    }
+    this->buffers_[finished].frames = 0;  // played, only i2s_write() refills it
+  }
+
+  int count_;
+  size_t length_;
+  uint32_t rate_;
+  double period_us_;
+  std::vector<Buffer> buffers_;
+  std::deque<int> free_;  // starts empty, the ring fills it as it plays
+  int playing_{0};
+  uint64_t completed_{0};
+  int current_{-1};  // the buffer i2s_write() fills
+  size_t fill_{0};
+  uint64_t written_{0};
+  std::deque<DmaEvent> events_;
+  size_t event_limit_;
+  uint32_t dropped_events_{0};
+  std::vector<int64_t> started_us_;
+};
+
+struct Scenario {
+  const char *name;
+  int64_t first_chunk_us;        // when play() hands over the first chunk
+  std::vector<int64_t> gaps_us;  // stalls of the producer, spread over the stream
+  uint32_t expected_underruns;
+  bool expect_grow;
+};
+
+struct Result {
+  uint32_t underruns;
+  uint32_t overflows;  // what counting every overflow as an underrun would have reported
+  bool grew;
+  int64_t max_error_us;
+  uint32_t dropped_events;
+  uint64_t unplayed;
+};
+
+static const uint32_t SAMPLE_RATE = 16000;
+static const size_t BUFFER_SIZE = 1024;              // bytes of a DataEvent
+static const size_t CHUNK_FRAMES = BUFFER_SIZE / 2;  // 16-bit mono
+static const size_t STREAM_CHUNKS = 250;             // 8 s
+static const int64_t WAKE_LATENCY_US = 300;          // most a task takes to run once an event is posted
+static const int64_t MAX_PRESENTATION_ERROR_US = 1000;
+
+/// One session of the player task on the model, mirroring I2SAudioSpeaker::player_task.
+static Result run_session(const Scenario &scenario) {
+  LatencyTuner tuner;
+  tuner.set_profile(LatencyProfile::ROBUST);
+  tuner.set_auto_tune(true);
+  const BufferPlan plan = tuner.get_plan();
+
+  LegacyI2sModel model(plan.dma_buffer_count, plan.dma_buffer_length, SAMPLE_RATE);
+  SampleClock clock;
+  DmaPlayout playout(&clock);
+  std::mt19937 rng(1);
+  std::uniform_int_distribution<int64_t> latency(0, WAKE_LATENCY_US);
+  int64_t now_us = 0;
+  uint32_t overflows = 0;
+
+  auto handle = [&](DmaEvent event, int64_t timestamp_us) {
+    if (event == DmaEvent::TX_DONE) {
+      playout.on_buffer_done(timestamp_us);
+    } else {
+      playout.on_overflow();
+      overflows++;
+    }
+  };
+  auto drain = [&]() {
+    model.run_until(now_us);
+    DmaEvent event;
+    while (model.pop_event(&event))
+      handle(event, 0);
+  };
+  // Blocks on the event queue; an event taken this way is timed when the task wakes
+  auto wait_event = [&](int64_t timeout_us, DmaEvent *event) -> bool {
+    model.run_until(now_us);
+    if (!model.has_event()) {
+      if (model.next_done_us() > now_us + timeout_us) {
+        now_us += timeout_us;
+        return false;
+      }
+      now_us = model.next_done_us() + latency(rng);
+      model.run_until(now_us);
+    }
+    return model.pop_event(event);
+  };
+
+  // sync_dma_() once the driver is installed
+  playout.reset(plan.dma_buffer_length, SAMPLE_RATE, now_us);
+  model.clear_events();
+  const int64_t buffer_us = playout.get_buffer_time_us();
+  DmaEvent event;
+  while (wait_event((plan.dma_buffer_count + 2) * buffer_us, &event)) {
+    if (event == DmaEvent::TX_Q_OVF) {
+      int64_t synced_us = now_us;
+      model.clear_events();
+      playout.sync(synced_us);
+      break;
+    }
+  }
+
+  std::vector<std::pair<uint64_t, int64_t>> predictions;  // presentation time of a frame when written
+  const int64_t slice_us = plan.dma_buffer_count * buffer_us / 2;
+  const int64_t chunk_us = CHUNK_FRAMES * 1000000LL / SAMPLE_RATE;
+  // play() queues at most queue_limit_ chunks ahead of the player task
+  const size_t queue_limit = std::max<size_t>(2, plan.ring_buffer_size / BUFFER_SIZE);
+  std::vector<int64_t> taken_us;
+  int64_t produced_us = scenario.first_chunk_us;
+  size_t gap = 0;
+  auto wait_for_data = [&](int64_t until_us) {
+    while (now_us < until_us) {
+      now_us = std::min(now_us + slice_us, until_us);
+      drain();
+    }
+  };
+  for (size_t chunk = 0; chunk < STREAM_CHUNKS; chunk++) {
+    // The producer decodes twice as fast as real time, apart from its stalls
+    if (gap < scenario.gaps_us.size() && chunk == (gap + 1) * STREAM_CHUNKS / (scenario.gaps_us.size() + 1))
+      produced_us += scenario.gaps_us[gap++];
+    int64_t available_us = produced_us;
+    if (chunk >= queue_limit)
+      available_us = std::max(available_us, taken_us[chunk - queue_limit]);
+    produced_us = available_us + chunk_us / 2;
+    wait_for_data(available_us);
+    taken_us.push_back(now_us);
+
+    // write_frames()
+    drain();
+    size_t remaining = CHUNK_FRAMES;
+    while (remaining > 0) {
+      predictions.emplace_back(playout.get_written(), clock.time_of(playout.get_written()));
+      size_t taken = model.write(remaining);
+      if (playout.add_written(taken))
+        tuner.report_underrun();
+      remaining -= taken;
+      if (remaining == 0 || !wait_event(2 * buffer_us, &event))
+        break;
+      handle(event, now_us);
+    }
+  }
+  // The queue stays empty until the player task gives up on the session
+  wait_for_data(now_us + 100000);
+
+  int64_t max_error_us = 0;
+  for (const auto &prediction : predictions) {
+    int64_t started_us = model.start_of(prediction.first);
+    if (started_us >= 0)
+      max_error_us = std::max(max_error_us, std::abs(prediction.second - started_us));
+  }
+  Result result;
+  result.underruns = tuner.get_session_underruns();
+  result.overflows = overflows;
+  result.grew = tuner.end_session();
+  result.max_error_us = max_error_us;
+  result.dropped_events = model.get_dropped_events();
+  result.unplayed = model.get_written() - playout.get_played();
+  return result;
+}
+
+int main() {
+  const std::vector<Scenario> scenarios = {
+      {"steady", 0, {}, 0, false},
+      {"slow_first_play", 300000, {}, 0, false},
+      {"one_gap", 0, {400000}, 1, false},
+      {"three_gaps", 300000, {400000, 400000, 400000}, 3, true},
+  };
+  bool failed = false;
+  for (const auto &scenario : scenarios) {
+    Result result = run_session(scenario);
+    bool ok = result.underruns == scenario.expected_underruns && result.grew == scenario.expect_grow &&
+              result.max_error_us <= MAX_PRESENTATION_ERROR_US && result.dropped_events == 0 && result.unplayed == 0;
+    failed |= !ok;
+    printf("{\"scenario\":\"%s\",\"underruns\":%u,\"overflows\":%u,\"grew\":%s,\"max_error_us\":%lld,"
+           "\"dropped_events\":%u,\"unplayed\":%llu,\"ok\":%s}\n",
+           scenario.name, (unsigned) result.underruns, (unsigned) result.overflows, result.grew ? "true" : "false",
+           (long long) result.max_error_us, (unsigned) result.dropped_events, (unsigned long long) result.unplayed,
+           ok ? "true" : "false");
+  }
+  return failed ? 2 : 0;
+}
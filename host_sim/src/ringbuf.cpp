@@ -0,0 +1,102 @@
+#include "sim_clock.h"
+
+#include "ringbuf.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+struct HostRingbuf {
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::vector<char> data;
+  size_t head{0};  // next byte to read
+  size_t filled{0};
+  bool done{false};
+  bool aborted{false};
+};
+
+ringbuf_handle_t rb_create(int block_size, int n_blocks) {
+  auto *rb = new HostRingbuf();
+  rb->data.resize(static_cast<size_t>(block_size) * n_blocks);
+  return rb;
+}
+
+int rb_destroy(ringbuf_handle_t rb) {
+  delete rb;
+  return RB_OK;
+}
+
+int rb_read(ringbuf_handle_t rb, char *buf, int len, TickType_t ticks_to_wait) {
+  std::unique_lock<std::mutex> lock(rb->mutex);
+  host_sim::wait_ticks(lock, rb->changed, ticks_to_wait, [rb] { return rb->filled > 0 || rb->done || rb->aborted; });
+  if (rb->aborted)
+    return RB_ABORT;
+  if (rb->filled == 0)
+    return rb->done ? RB_DONE : RB_TIMEOUT;
+
+  size_t count = std::min(static_cast<size_t>(len), rb->filled);
+  for (size_t i = 0; i < count; i++)
+    buf[i] = rb->data[(rb->head + i) % rb->data.size()];
+  rb->head = (rb->head + count) % rb->data.size();
+  rb->filled -= count;
+  rb->changed.notify_all();
+  return static_cast<int>(count);
+}
+
+int rb_write(ringbuf_handle_t rb, char *buf, int len, TickType_t ticks_to_wait) {
+  std::unique_lock<std::mutex> lock(rb->mutex);
+  size_t written = 0;
+  while (written < static_cast<size_t>(len)) {
+    if (!host_sim::wait_ticks(lock, rb->changed, ticks_to_wait,
+                              [rb] { return rb->filled < rb->data.size() || rb->aborted; }))
+      break;
+    if (rb->aborted)
+      return written > 0 ? static_cast<int>(written) : RB_ABORT;
+    size_t count = std::min(len - written, rb->data.size() - rb->filled);
+    size_t tail = rb->head + rb->filled;
+    for (size_t i = 0; i < count; i++)
+      rb->data[(tail + i) % rb->data.size()] = buf[written + i];
+    rb->filled += count;
+    written += count;
+    rb->changed.notify_all();
+  }
+  return written > 0 || ticks_to_wait != 0 ? static_cast<int>(written) : RB_TIMEOUT;
+}
+
+int rb_bytes_filled(ringbuf_handle_t rb) {
+  std::lock_guard<std::mutex> lock(rb->mutex);
+  return static_cast<int>(rb->filled);
+}
+
+int rb_bytes_available(ringbuf_handle_t rb) {
+  std::lock_guard<std::mutex> lock(rb->mutex);
+  return static_cast<int>(rb->data.size() - rb->filled);
+}
+
+int rb_get_size(ringbuf_handle_t rb) { return static_cast<int>(rb->data.size()); }
+
+int rb_done_write(ringbuf_handle_t rb) {
+  std::lock_guard<std::mutex> lock(rb->mutex);
+  rb->done = true;
+  rb->changed.notify_all();
+  return RB_OK;
+}
+
+int rb_abort(ringbuf_handle_t rb) {
+  std::lock_guard<std::mutex> lock(rb->mutex);
+  rb->aborted = true;
+  rb->changed.notify_all();
+  return RB_OK;
+}
+
+int rb_reset(ringbuf_handle_t rb) {
+  std::lock_guard<std::mutex> lock(rb->mutex);
+  rb->head = 0;
+  rb->filled = 0;
+  rb->done = false;
+  rb->aborted = false;
+  rb->changed.notify_all();
+  return RB_OK;
+}
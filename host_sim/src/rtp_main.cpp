@@ -0,0 +1,250 @@
+// Loopback test for the RTP receiver in components/rtp_receiver.
+//
+// A sender thread streams a tone as L16 RTP to 127.0.0.1, holding each packet back by a random
+// delay of up to --jitter ms (which also reorders them) and dropping --loss percent. The main
+// thread receives with the component's parser and jitter buffer and plays one packet per packet
+// duration, the way RTPReceiver::loop() does. Prints a JSON summary with the jitter buffer's
+// counters and the delay from a packet's capture time at the sender until it is played, and exits
+// with 2 unless every packet that arrived in time was played and none took longer than
+// --max-latency ms (the LAN target is 100).
+//
+//   esp_adf_rtp --seconds 10 --packet-ms 20 --jitter 15 --loss 2 --out received.wav
+
+#include "wav.h"
+
+#include "esphome/components/rtp_receiver/jitter_buffer.h"
+#include "esphome/components/rtp_receiver/rtp_packet.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace esphome::rtp_receiver;
+using Clock = std::chrono::steady_clock;
+
+static const size_t MAX_DATAGRAM_SIZE = 1472;  // as rtp_receiver's MAX_PACKET_SIZE
+
+struct Options {
+  double seconds{10.0};
+  uint32_t sample_rate{16000};
+  uint8_t channels{1};
+  uint32_t packet_ms{20};
+  uint32_t jitter_ms{0};
+  double loss_percent{0.0};
+  uint32_t min_delay_ms{20};
+  uint32_t max_delay_ms{200};
+  uint16_t port{15004};
+  uint32_t max_latency_ms{100};
+  std::string out_path;
+};
+
+static void usage() {
+  fprintf(stderr,
+          "usage: esp_adf_rtp [options]\n"
+          "  --seconds s         length of the stream (default 10)\n"
+          "  --rate hz           sample rate (default 16000)\n"
+          "  --channels n        1 or 2 (default 1)\n"
+          "  --packet-ms ms      packet duration (default 20)\n"
+          "  --jitter ms         random extra delay per packet, reorders them (default 0)\n"
+          "  --loss percent      packets dropped by the sender (default 0)\n"
+          "  --min-delay ms      jitter buffer bounds, as in the YAML (default 20)\n"
+          "  --max-delay ms      (default 200)\n"
+          "  --port port         loopback UDP port (default 15004)\n"
+          "  --max-latency ms    longest capture to playout delay that passes (default 100)\n"
+          "  --out file.wav      write what was played\n");
+}
+
+static int64_t micros_since(Clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+}
+
+/// Sends the whole stream on its own schedule: packet i is captured at i * packet duration and
+/// leaves after its random network delay.
+static void send_stream(const Options &options, Clock::time_point start, size_t packet_frames, size_t packets) {
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(options.port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  std::mt19937 random(1234);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  struct Send {
+    int64_t at_us;
+    uint16_t sequence;
+  };
+  std::vector<Send> schedule;
+  const int64_t packet_us = static_cast<int64_t>(packet_frames) * 1000000 / options.sample_rate;
+  for (size_t i = 0; i < packets; i++) {
+    if (uniform(random) * 100.0 < options.loss_percent)
+      continue;
+    int64_t delay_us = static_cast<int64_t>(uniform(random) * options.jitter_ms * 1000);
+    schedule.push_back({static_cast<int64_t>(i) * packet_us + delay_us, static_cast<uint16_t>(i)});
+  }
+  std::stable_sort(schedule.begin(), schedule.end(), [](const Send &a, const Send &b) { return a.at_us < b.at_us; });
+
+  const size_t samples = packet_frames * options.channels;
+  std::vector<int16_t> pcm(samples);
+  std::vector<uint8_t> datagram(RTP_HEADER_SIZE + samples * sizeof(int16_t));
+  for (const Send &send : schedule) {
+    std::this_thread::sleep_until(start + std::chrono::microseconds(send.at_us));
+    uint32_t timestamp = static_cast<uint32_t>(send.sequence * packet_frames);
+    for (size_t f = 0; f < packet_frames; f++) {
+      double phase = 2.0 * M_PI * 440.0 * (timestamp + f) / options.sample_rate;
+      for (size_t c = 0; c < options.channels; c++)
+        pcm[f * options.channels + c] = static_cast<int16_t>(8000.0 * std::sin(phase));
+    }
+    RTPPacket packet = {send.sequence == 0, 96, send.sequence, timestamp, 0x5EED0001u, nullptr, 0};
+    write_rtp_header(datagram.data(), packet);
+    host_to_l16(pcm.data(), datagram.data() + RTP_HEADER_SIZE, samples);
+    sendto(fd, datagram.data(), datagram.size(), 0, (sockaddr *) &address, sizeof(address));
+  }
+  close(fd);
+}
+
+int main(int argc, char **argv) {
+  Options options;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc) {
+      usage();
+      return 1;
+    }
+    const char *value = argv[++i];
+    if (arg == "--seconds") {
+      options.seconds = atof(value);
+    } else if (arg == "--rate") {
+      options.sample_rate = atoi(value);
+    } else if (arg == "--channels") {
+      options.channels = atoi(value) == 2 ? 2 : 1;
+    } else if (arg == "--packet-ms") {
+      options.packet_ms = std::max(1, atoi(value));
+    } else if (arg == "--jitter") {
+      options.jitter_ms = atoi(value);
+    } else if (arg == "--loss") {
+      options.loss_percent = atof(value);
+    } else if (arg == "--min-delay") {
+      options.min_delay_ms = atoi(value);
+    } else if (arg == "--max-delay") {
+      options.max_delay_ms = atoi(value);
+    } else if (arg == "--port") {
+      options.port = atoi(value);
+    } else if (arg == "--max-latency") {
+      options.max_latency_ms = atoi(value);
+    } else if (arg == "--out") {
+      options.out_path = value;
+    } else {
+      usage();
+      return 1;
+    }
+  }
+
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(options.port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (fd < 0 || bind(fd, (sockaddr *) &address, sizeof(address)) != 0) {
+    fprintf(stderr, "Cannot bind 127.0.0.1:%u\n", options.port);
+    return 1;
+  }
+
+  host_sim::WavWriter writer;
+  if (!options.out_path.empty() && !writer.open(options.out_path, options.sample_rate, options.channels)) {
+    fprintf(stderr, "Cannot write %s\n", options.out_path.c_str());
+    return 1;
+  }
+
+  const size_t packet_frames = options.sample_rate * options.packet_ms / 1000;
+  const size_t packets = static_cast<size_t>(options.seconds * 1000 / options.packet_ms);
+  if (RTP_HEADER_SIZE + packet_frames * options.channels * sizeof(int16_t) > MAX_DATAGRAM_SIZE) {
+    fprintf(stderr, "%u ms packets do not fit in one %zu byte datagram\n", options.packet_ms, MAX_DATAGRAM_SIZE);
+    return 1;
+  }
+  const int64_t packet_us = static_cast<int64_t>(packet_frames) * 1000000 / options.sample_rate;
+  const Clock::time_point start = Clock::now();
+  std::thread sender(send_stream, std::cref(options), start, packet_frames, packets);
+
+  JitterBuffer jitter_buffer;
+  jitter_buffer.configure(options.sample_rate, options.channels, packet_frames);
+  jitter_buffer.set_delay_range_ms(options.min_delay_ms, options.max_delay_ms);
+
+  std::vector<uint8_t> datagram(MAX_DATAGRAM_SIZE);
+  std::vector<int16_t> samples(packet_frames * options.channels);
+  std::vector<int16_t> playout(packet_frames * options.channels);
+  bool playing = false;
+  int64_t next_tick_us = 0;
+  int64_t last_packet_us = 0;
+  uint32_t played = 0;
+  double delay_sum_ms = 0.0;
+  double delay_max_ms = 0.0;
+  const int64_t end_us = static_cast<int64_t>(options.seconds * 1000000) + 1000000;
+
+  while (true) {
+    int64_t now_us = micros_since(start);
+    if (now_us > end_us || (now_us - last_packet_us > 1000000 && !playing && last_packet_us > 0))
+      break;
+    int timeout_ms = playing ? static_cast<int>(std::max<int64_t>(0, next_tick_us - now_us) / 1000) : 5;
+    pollfd descriptor = {fd, POLLIN, 0};
+    if (poll(&descriptor, 1, timeout_ms) > 0) {
+      ssize_t received = recv(fd, datagram.data(), datagram.size(), 0);
+      RTPPacket packet;
+      if (received > 0 && parse_rtp_packet(datagram.data(), received, &packet) &&
+          packet.payload_size == samples.size() * sizeof(int16_t)) {
+        last_packet_us = micros_since(start);
+        l16_to_host(packet.payload, samples.data(), samples.size());
+        jitter_buffer.insert(packet.sequence, packet.timestamp, samples.data(), last_packet_us);
+      }
+    }
+
+    now_us = micros_since(start);
+    while (!playing || now_us >= next_tick_us) {
+      uint16_t sequence = jitter_buffer.get_next_sequence();
+      PlayoutResult result = jitter_buffer.pop(playout.data());
+      if (result == PlayoutResult::BUFFERING) {
+        playing = false;
+        break;
+      }
+      if (!playing) {
+        playing = true;
+        next_tick_us = now_us;
+      }
+      if (result == PlayoutResult::PLAYED) {
+        double delay_ms = (now_us - static_cast<int64_t>(sequence) * packet_us) / 1000.0;
+        delay_sum_ms += delay_ms;
+        delay_max_ms = std::max(delay_max_ms, delay_ms);
+        played++;
+      }
+      if (!options.out_path.empty())
+        writer.write(playout.data(), packet_frames);
+      next_tick_us += packet_us;
+    }
+  }
+  sender.join();
+  close(fd);
+
+  const JitterBufferStats &stats = jitter_buffer.get_stats();
+  // Late packets and duplicates are not counted as received, packets dropped to shrink the delay are
+  bool delivered = played > 0 && played == stats.received - stats.dropped;
+  bool ok = delivered && delay_max_ms <= options.max_latency_ms;
+  printf("{\"packets\":%zu,\"received\":%u,\"played\":%u,\"concealed\":%u,\"late\":%u,\"duplicates\":%u,"
+         "\"dropped\":%u,\"resyncs\":%u,\"jitter_ms\":%.2f,\"target_ms\":%.0f,\"mean_delay_ms\":%.1f,"
+         "\"max_delay_ms\":%.1f,\"ok\":%s}\n",
+         packets, stats.received, played, stats.concealed, stats.late, stats.duplicates, stats.dropped,
+         stats.resyncs, jitter_buffer.get_jitter_us() / 1000.0,
+         jitter_buffer.get_target_packets() * packet_us / 1000.0, played > 0 ? delay_sum_ms / played : 0.0,
+         delay_max_ms, ok ? "true" : "false");
+  return ok ? 0 : 2;
+}
@@ -0,0 +1,32 @@
+#include "sim_clock.h"
+
+#include <atomic>
+#include <cerrno>
+#include <ctime>
+
+namespace host_sim {
+
+static std::atomic<double> speed{1.0};
+static const auto START = std::chrono::steady_clock::now();
+
+void set_speed(double value) { speed = value > 0.0 ? value : 1.0; }
+double get_speed() { return speed; }
+
+int64_t now_us() {
+  auto elapsed = std::chrono::steady_clock::now() - START;
+  return static_cast<int64_t>(std::chrono::duration<double, std::micro>(elapsed).count() * speed);
+}
+
+void sleep_until_us(int64_t time_us) {
+  // clock_nanosleep() is a cancellation point, which vTaskDelete() relies on
+  auto real = START + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                          std::chrono::duration<double, std::micro>(time_us / speed));
+  auto since_epoch = std::chrono::duration_cast<std::chrono::nanoseconds>(real.time_since_epoch()).count();
+  timespec deadline = {static_cast<time_t>(since_epoch / 1000000000), static_cast<long>(since_epoch % 1000000000)};
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR) {
+  }
+}
+
+void sleep_us(int64_t duration_us) { sleep_until_us(now_us() + duration_us); }
+
+}  // namespace host_sim
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+#include <pthread.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace host_sim {
+
+/// Simulated time starts at zero and runs `speed` times faster than the wall clock. Everything
+/// the components see (esp_timer_get_time(), millis(), ticks, the I2S clock) is simulated time.
+void set_speed(double speed);
+double get_speed();
+
+int64_t now_us();
+void sleep_us(int64_t duration_us);
+void sleep_until_us(int64_t time_us);
+
+/// Waits on `cv` until `pred` holds or `ticks` of simulated time have passed, like a FreeRTOS
+/// blocking call. The thread stays cancellable by vTaskDelete() but is never cancelled while
+/// inside the (noexcept) condition variable wait.
+template<typename Pred>
+bool wait_ticks(std::unique_lock<std::mutex> &lock, std::condition_variable &cv, TickType_t ticks, Pred pred) {
+  using Clock = std::chrono::steady_clock;
+  const auto slice = std::chrono::milliseconds(1);
+  const bool forever = ticks == portMAX_DELAY;
+  const auto deadline =
+      Clock::now() + std::chrono::microseconds(static_cast<int64_t>(ticks * 1000.0 / get_speed()));
+  while (!pred()) {
+    auto now = Clock::now();
+    if (!forever && now >= deadline)
+      return false;
+    auto until = forever ? now + slice : std::min(deadline, now + slice);
+    int old_state;
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &old_state);
+    cv.wait_until(lock, until);
+    pthread_setcancelstate(old_state, nullptr);
+    lock.unlock();
+    pthread_testcancel();
+    lock.lock();
+  }
+  return true;
+}
+
+}  // namespace host_sim
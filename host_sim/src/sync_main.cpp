@@ -0,0 +1,316 @@
+// Multi-room playback check for components/playback_clock and the I2S speaker's play_at().
+//
+// Simulates a time server and several devices whose crystals are off by up to --ppm, on a network
+// with --jitter ms of random extra delay per leg. Each device synchronizes with the component's
+// ClockSync, starts its I2S output at a random moment and plays a stream scheduled to begin at the
+// same shared time on all of them, following the schedule the way the speaker's player task does:
+// skip or pad to line up, then trim the resampler with the DriftController. Virtual time, so a
+// minute runs in about a second. Prints a JSON summary with each device's error against the true
+// schedule once settled, and the largest spread between devices.
+//
+//   esp_adf_sync --devices 3 --seconds 60 --ppm 50 --jitter 5
+//
+// With --serve it is instead a stand-in time server on the LAN for real devices: it answers the
+// playback_clock protocol with the host's monotonic clock.
+//
+//   esp_adf_sync --serve 5011
+
+#include "esphome/components/audio_utils/drift_controller.h"
+#include "esphome/components/audio_utils/resampler.h"
+#include "esphome/components/audio_utils/sample_clock.h"
+#include "esphome/components/audio_utils/shared_clock.h"
+#include "esphome/components/playback_clock/clock_sync.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace esphome;
+using playback_clock::ClockSync;
+
+struct Options {
+  int devices{3};
+  double seconds{60.0};
+  double ppm{50.0};
+  double jitter_ms{5.0};
+  uint32_t sample_rate{16000};
+  double settle_s{15.0};
+  uint32_t seed{1};
+};
+
+static const size_t CHUNK_FRAMES = 512;          // one DataEvent of 16-bit mono
+static const uint64_t DMA_FRAMES = 6 * 256;      // the balanced buffer plan
+static const uint64_t DMA_BUFFER_FRAMES = 256;
+static const int64_t BASE_DELAY_US = 1000;       // one network leg without queueing
+static const int64_t START_US = 3000000;         // shared time the stream starts
+
+static void usage() {
+  fprintf(stderr,
+          "usage: esp_adf_sync [options]\n"
+          "  --devices n         simulated rooms (default 3)\n"
+          "  --seconds s         simulated time (default 60)\n"
+          "  --ppm ppm           largest crystal error (default 50)\n"
+          "  --jitter ms         mean random extra delay per network leg (default 5)\n"
+          "  --rate hz           stream and output rate (default 16000)\n"
+          "  --settle s          ignore errors before this time (default 15)\n"
+          "  --seed n            (default 1)\n"
+          "   or: esp_adf_sync --serve port\n");
+}
+
+/// One room: a local clock that runs at (1 + ppm) of true time and a speaker following the schedule.
+struct Device {
+  double ppm;
+  int64_t local_offset_us;  // local time at true time 0
+  int64_t output_start_true_us;
+
+  ClockSync clock_sync;
+  audio_utils::SharedClock shared;
+  int64_t next_request_us{0};
+  int64_t reply_at_us{-1};  // true time the outstanding reply arrives
+  int64_t t0{0}, t1{0}, t2{0};
+
+  audio_utils::PolyphaseResampler<int16_t> resampler;
+  audio_utils::DriftController drift;
+  audio_utils::SampleClock sample_clock;
+  uint64_t written{0};
+  uint64_t consumed{0};
+  uint64_t skip{0};
+  bool started{false};
+  bool aligned{false};
+  int64_t last_update_local_us{0};
+  uint32_t realigns{0};
+
+  double max_error_us{0.0};
+  double sum_square_us{0.0};
+  uint64_t error_count{0};
+
+  int64_t local_at(int64_t true_us) const {
+    return local_offset_us + true_us + static_cast<int64_t>(std::llround(true_us * this->ppm * 1e-6));
+  }
+  int64_t true_at(int64_t local_us) const {
+    return static_cast<int64_t>(std::llround((local_us - local_offset_us) / (1.0 + this->ppm * 1e-6)));
+  }
+};
+
+static int serve(uint16_t port) {
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (fd < 0 || bind(fd, (sockaddr *) &address, sizeof(address)) != 0) {
+    fprintf(stderr, "Cannot bind port %u\n", port);
+    return 1;
+  }
+  fprintf(stderr, "Serving the playback clock on port %u\n", port);
+  auto now_us = []() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  };
+  uint8_t data[playback_clock::SYNC_MESSAGE_SIZE];
+  while (true) {
+    sockaddr_in from = {};
+    socklen_t from_size = sizeof(from);
+    ssize_t received = recvfrom(fd, data, sizeof(data), 0, (sockaddr *) &from, &from_size);
+    int64_t t1 = now_us();
+    playback_clock::SyncMessage message;
+    if (received <= 0 || !playback_clock::decode_sync_message(data, received, &message) ||
+        message.type != playback_clock::SyncMessageType::REQUEST)
+      continue;
+    message.type = playback_clock::SyncMessageType::RESPONSE;
+    message.t1 = t1;
+    message.t2 = now_us();
+    playback_clock::encode_sync_message(message, data);
+    sendto(fd, data, sizeof(data), 0, (sockaddr *) &from, from_size);
+  }
+}
+
+int main(int argc, char **argv) {
+  Options options;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc) {
+      usage();
+      return 1;
+    }
+    const char *value = argv[++i];
+    if (arg == "--serve") {
+      return serve(static_cast<uint16_t>(atoi(value)));
+    } else if (arg == "--devices") {
+      options.devices = std::max(1, atoi(value));
+    } else if (arg == "--seconds") {
+      options.seconds = atof(value);
+    } else if (arg == "--ppm") {
+      options.ppm = atof(value);
+    } else if (arg == "--jitter") {
+      options.jitter_ms = atof(value);
+    } else if (arg == "--rate") {
+      options.sample_rate = atoi(value);
+    } else if (arg == "--settle") {
+      options.settle_s = atof(value);
+    } else if (arg == "--seed") {
+      options.seed = atoi(value);
+    } else {
+      usage();
+      return 1;
+    }
+  }
+
+  std::mt19937 random(options.seed);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  std::exponential_distribution<double> queueing(options.jitter_ms > 0 ? 1.0 / (options.jitter_ms * 1000.0) : 1e9);
+  auto leg_delay_us = [&]() { return BASE_DELAY_US + static_cast<int64_t>(queueing(random)); };
+
+  const uint32_t rate = options.sample_rate;
+  std::vector<std::unique_ptr<Device>> devices;
+  for (int i = 0; i < options.devices; i++) {
+    auto device = std::make_unique<Device>();
+    device->ppm = options.devices == 1 ? options.ppm : options.ppm * (2.0 * i / (options.devices - 1) - 1.0);
+    device->local_offset_us = static_cast<int64_t>(uniform(random) * 1e9);  // booted at different times
+    // The pipelines come up at different moments shortly before the start
+    device->output_start_true_us = START_US - 1000000 + static_cast<int64_t>(uniform(random) * 500000);
+    device->next_request_us = static_cast<int64_t>(uniform(random) * 250000);
+    device->resampler.configure(rate, rate, 1, audio_utils::ResampleQuality::MEDIUM);
+    devices.push_back(std::move(device));
+  }
+
+  std::vector<int16_t> tone(CHUNK_FRAMES);
+  std::vector<int16_t> output(CHUNK_FRAMES * 2);
+  const int64_t end_us = static_cast<int64_t>(options.seconds * 1e6);
+  const int64_t settle_us = static_cast<int64_t>(options.settle_s * 1e6);
+  double max_spread_us = 0.0;
+  std::vector<double> true_errors(devices.size());
+
+  for (int64_t now = 0; now < end_us; now += 1000) {
+    for (size_t d = 0; d < devices.size(); d++) {
+      Device &device = *devices[d];
+
+      // Clock sync, requests every 250 ms until locked and every second after
+      if (device.reply_at_us >= 0 && now >= device.reply_at_us) {
+        if (device.clock_sync.add_exchange(device.t0, device.t1, device.t2, device.local_at(device.reply_at_us)) &&
+            device.clock_sync.is_synchronized()) {
+          int64_t anchor = device.clock_sync.get_anchor_local_us();
+          device.shared.publish(anchor, anchor + device.clock_sync.get_anchor_offset_us(),
+                                device.clock_sync.get_skew_ppm());
+        }
+        device.reply_at_us = -1;
+      }
+      if (now >= device.next_request_us && device.reply_at_us < 0) {
+        device.t0 = device.local_at(now);
+        device.t1 = now + leg_delay_us();  // the server's clock is true time
+        device.t2 = device.t1 + 50;
+        device.reply_at_us = device.t2 + leg_delay_us();
+        device.next_request_us = now + (device.clock_sync.is_synchronized() ? 1000000 : 250000);
+      }
+
+      if (now < device.output_start_true_us || !device.shared.is_synchronized())
+        continue;
+      const int64_t output_start_local = device.local_at(device.output_start_true_us);
+      if (!device.started) {
+        device.started = true;
+        device.sample_clock.reset(rate, output_start_local);
+      }
+
+      // The player task runs whenever the DMA has room for another chunk
+      const int64_t local_now = device.local_at(now);
+      auto local_of_frame = [&](uint64_t frame) {
+        return output_start_local + static_cast<int64_t>(frame * 1000000 / rate);
+      };
+      while (device.written < DMA_FRAMES || local_of_frame(device.written - DMA_FRAMES) <= local_now) {
+        // Anchor on the last completed DMA buffer, stamped a little late like the I2S event
+        const int64_t playing_us = std::max<int64_t>(0, local_now - output_start_local);
+        uint64_t played = std::min<uint64_t>(device.written, static_cast<uint64_t>(playing_us) * rate / 1000000);
+        played -= played % DMA_BUFFER_FRAMES;
+        device.sample_clock.update(played, local_of_frame(played) + static_cast<int64_t>(uniform(random) * 300));
+
+        auto schedule_error_us = [&]() {
+          double position = static_cast<double>(device.consumed) - device.resampler.get_buffered_frames();
+          int64_t due = START_US + static_cast<int64_t>(position * 1e6 / rate);
+          return device.shared.to_shared_us(device.sample_clock.time_of(device.written)) - due;
+        };
+        auto follow_schedule = [&]() {
+          int64_t error_us = schedule_error_us();
+          if (!device.aligned || audio_utils::DriftController::needs_jump(error_us)) {
+            if (error_us > 0) {
+              device.skip += static_cast<uint64_t>(error_us) * rate / 1000000;
+            } else {
+              device.written += static_cast<uint64_t>(-error_us) * rate / 1000000;  // silence
+            }
+            if (device.aligned)
+              device.realigns++;
+            device.aligned = true;
+            device.drift.reset(false);
+          } else {
+            float elapsed_s = static_cast<float>(local_now - device.last_update_local_us) * 1e-6f;
+            device.resampler.set_trim_ppm(device.drift.update(static_cast<float>(error_us), elapsed_s));
+          }
+          device.last_update_local_us = local_now;
+        };
+
+        if (!device.aligned)
+          follow_schedule();
+        for (size_t f = 0; f < CHUNK_FRAMES; f++)
+          tone[f] = static_cast<int16_t>(8000.0 * std::sin(2.0 * M_PI * 440.0 * (device.consumed + f) / rate));
+        const int16_t *in = tone.data();
+        size_t frames = CHUNK_FRAMES;
+        size_t skipped = std::min<uint64_t>(device.skip, frames);
+        in += skipped;
+        frames -= skipped;
+        device.skip -= skipped;
+        device.consumed += skipped;
+        while (true) {
+          size_t consumed;
+          size_t produced = device.resampler.process(in, frames, &consumed, output.data(), output.size());
+          in += consumed;
+          frames -= consumed;
+          device.consumed += consumed;
+          device.written += produced;
+          if (produced == 0)
+            break;
+        }
+        follow_schedule();
+      }
+
+      // Against the true schedule: when the next output frame really plays and what it should be
+      double position = static_cast<double>(device.consumed) - device.resampler.get_buffered_frames();
+      double due_us = START_US + position * 1e6 / rate;
+      double plays_us = static_cast<double>(device.true_at(local_of_frame(device.written)));
+      true_errors[d] = plays_us - due_us;
+      if (now >= settle_us && now % 100000 == 0) {
+        device.max_error_us = std::max(device.max_error_us, std::fabs(true_errors[d]));
+        device.sum_square_us += true_errors[d] * true_errors[d];
+        device.error_count++;
+      }
+    }
+    if (now >= settle_us && now % 100000 == 0) {
+      auto range = std::minmax_element(true_errors.begin(), true_errors.end());
+      max_spread_us = std::max(max_spread_us, *range.second - *range.first);
+    }
+  }
+
+  printf("{\"devices\":%d,\"seconds\":%.0f,\"jitter_ms\":%.1f,\"max_spread_us\":%.0f,\"rooms\":[", options.devices,
+         options.seconds, options.jitter_ms, max_spread_us);
+  for (size_t d = 0; d < devices.size(); d++) {
+    const Device &device = *devices[d];
+    const playback_clock::ClockSyncStats &stats = device.clock_sync.get_stats();
+    double rms = device.error_count > 0 ? std::sqrt(device.sum_square_us / device.error_count) : 0.0;
+    printf("%s{\"ppm\":%.1f,\"drift_ppm\":%.1f,\"skew_ppm\":%.1f,\"max_error_us\":%.0f,\"rms_error_us\":%.0f,"
+           "\"realigns\":%u,\"exchanges_kept\":%u,\"exchanges\":%u}",
+           d == 0 ? "" : ",", device.ppm, device.drift.get_drift_ppm(), device.clock_sync.get_skew_ppm(),
+           device.max_error_us, rms, device.realigns, stats.samples - stats.rejected, stats.samples);
+  }
+  printf("]}\n");
+  return 0;
+}
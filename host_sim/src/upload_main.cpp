@@ -0,0 +1,502 @@
+// Loopback test for the microphone uploader in components/mic_uploader.
+//
+// A capture thread produces --sessions capture sessions of 16 kHz mono audio, --speed times
+// faster than real time, into a one second buffer the way the microphone's data callback does.
+// The main thread uploads it with the component's UploadClient, batching and reconnecting the way
+// MicUploader::upload_task() does. A server thread on 127.0.0.1 decodes the chunked POSTs or the
+// WebSocket frames; it can refuse the first --refuse connections and cut every connection after
+// --drop-after kB to exercise the backoff. The samples are a running counter, so the server
+// counts every gap. Prints a JSON summary of both ends.
+//
+//   esp_adf_upload --transport ws --sessions 3 --session-s 2 --drop-after 40 --refuse 2
+
+#include "esphome/components/mic_uploader/upload_client.h"
+#include "esphome/components/mic_uploader/upload_protocol.h"
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace esphome::mic_uploader;
+using Clock = std::chrono::steady_clock;
+
+static const uint32_t SAMPLE_RATE = 16000;
+static const size_t CAPTURE_BLOCK_SAMPLES = 512;  // what one microphone read hands the callbacks
+static const uint32_t READ_TIMEOUT_MS = 20;       // as the upload task
+
+struct Options {
+  UploadTransport transport{UploadTransport::HTTP_CHUNKED};
+  uint32_t sessions{3};
+  double session_s{2.0};
+  double gap_s{0.5};
+  double speed{1.0};
+  size_t packet_size{1024};
+  uint32_t refuse{0};
+  uint32_t drop_after_kb{0};
+  uint32_t min_reconnect_ms{100};
+  uint32_t max_reconnect_ms{2000};
+  uint16_t port{15011};
+};
+
+static void usage() {
+  fprintf(stderr,
+          "usage: esp_adf_upload [options]\n"
+          "  --transport t          http or ws (default http)\n"
+          "  --sessions n           capture sessions (default 3)\n"
+          "  --session-s s          length of each (default 2)\n"
+          "  --gap-s s              pause between them (default 0.5)\n"
+          "  --speed x              capture this much faster than real time (default 1)\n"
+          "  --packet-size bytes    as in the YAML (default 1024)\n"
+          "  --refuse n             server drops the first n connections at once (default 0)\n"
+          "  --drop-after kB        server cuts each connection after this much audio (default never)\n"
+          "  --min-reconnect ms     backoff range (default 100)\n"
+          "  --max-reconnect ms     (default 2000)\n"
+          "  --port port            loopback TCP port (default 15011)\n");
+}
+
+static uint32_t millis_since(Clock::time_point start) {
+  return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count());
+}
+
+/// The microphone side: a byte ring the capture thread fills and the uploader drains.
+struct CaptureBuffer {
+  std::mutex mutex;
+  std::condition_variable readable;
+  std::deque<uint8_t> bytes;
+  size_t capacity{SAMPLE_RATE * sizeof(int16_t)};
+  uint64_t captured{0};
+  uint64_t overflowed{0};
+
+  void write(const uint8_t *data, size_t size) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    size_t room = this->capacity - this->bytes.size();
+    size_t written = std::min(room, size);
+    this->bytes.insert(this->bytes.end(), data, data + written);
+    this->captured += size;
+    this->overflowed += size - written;
+    this->readable.notify_one();
+  }
+  size_t read(uint8_t *data, size_t size, uint32_t timeout_ms) {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->readable.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this] { return !this->bytes.empty(); });
+    size_t taken = std::min(size, this->bytes.size());
+    std::copy(this->bytes.begin(), this->bytes.begin() + taken, data);
+    this->bytes.erase(this->bytes.begin(), this->bytes.begin() + taken);
+    return taken;
+  }
+  size_t available() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->bytes.size();
+  }
+};
+
+struct ServerStats {
+  uint32_t connections{0};
+  uint32_t refused{0};
+  uint32_t cut{0};
+  uint32_t streams{0};  // HTTP requests, or WebSocket connections
+  uint64_t received{0};
+  uint32_t gaps{0};
+  uint32_t pongs{0};
+};
+
+/// Buffered reads from one accepted connection.
+class ServerConnection {
+ public:
+  explicit ServerConnection(int fd) : fd_(fd) {}
+  bool need(size_t size) {
+    uint8_t block[4096];
+    while (this->buffer_.size() < size) {
+      ssize_t received = recv(this->fd_, block, sizeof(block), 0);
+      if (received == 0)
+        errno = ECONNRESET;  // closed, not a timeout
+      if (received <= 0)
+        return false;
+      this->buffer_.insert(this->buffer_.end(), block, block + received);
+    }
+    return true;
+  }
+  bool read_until(const char *delimiter, std::string *text) {
+    const size_t length = strlen(delimiter);
+    size_t searched = 0;
+    while (true) {
+      auto found = std::search(this->buffer_.begin() + searched, this->buffer_.end(), delimiter, delimiter + length);
+      if (found != this->buffer_.end()) {
+        size_t end = found - this->buffer_.begin() + length;
+        text->assign(this->buffer_.begin(), this->buffer_.begin() + end);
+        this->consume(end);
+        return true;
+      }
+      searched = this->buffer_.size() >= length ? this->buffer_.size() - length + 1 : 0;
+      if (!this->need(this->buffer_.size() + 1))
+        return false;
+    }
+  }
+  uint8_t *data() { return this->buffer_.data(); }
+  void consume(size_t size) { this->buffer_.erase(this->buffer_.begin(), this->buffer_.begin() + size); }
+  void send_text(const std::string &text) { ::send(this->fd_, text.data(), text.size(), MSG_NOSIGNAL); }
+  void send_bytes(const uint8_t *data, size_t size) { ::send(this->fd_, data, size, MSG_NOSIGNAL); }
+
+ protected:
+  int fd_;
+  std::vector<uint8_t> buffer_;
+};
+
+class Server {
+ public:
+  Server(const Options &options) : options_(options) {}
+
+  bool listen() {
+    this->fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    int enable = 1;
+    setsockopt(this->fd_, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(this->options_.port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return this->fd_ >= 0 && bind(this->fd_, (sockaddr *) &address, sizeof(address)) == 0 &&
+           ::listen(this->fd_, 4) == 0;
+  }
+
+  void run(const std::atomic<bool> &stop) {
+    while (!stop.load()) {
+      pollfd descriptor = {this->fd_, POLLIN, 0};
+      if (poll(&descriptor, 1, 50) <= 0)
+        continue;
+      int client = accept(this->fd_, nullptr, nullptr);
+      if (client < 0)
+        continue;
+      this->stats.connections++;
+      if (this->stats.refused < this->options_.refuse) {
+        this->stats.refused++;
+        close(client);
+        continue;
+      }
+      timeval timeout = {0, 200000};
+      setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+      this->serve_(client, stop);
+      close(client);
+    }
+    close(this->fd_);
+  }
+
+  ServerStats stats;
+
+ protected:
+  void serve_(int fd, const std::atomic<bool> &stop) {
+    ServerConnection connection(fd);
+    this->connection_bytes_ = 0;
+    std::string head;
+    while (!stop.load()) {
+      if (!connection.read_until("\r\n\r\n", &head)) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+          continue;  // idle keep-alive connection
+        return;
+      }
+      this->has_expected_ = false;
+      this->stats.streams++;
+      if (head.find("Upgrade: websocket") != std::string::npos) {
+        this->serve_websocket_(connection, head, stop);
+        return;
+      }
+      if (!this->serve_chunked_(connection, stop))
+        return;
+    }
+  }
+
+  bool serve_chunked_(ServerConnection &connection, const std::atomic<bool> &stop) {
+    uint64_t stream_bytes = 0;
+    std::string line;
+    while (!stop.load()) {
+      if (!connection.read_until("\r\n", &line)) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+          continue;
+        return false;
+      }
+      size_t size = strtoul(line.c_str(), nullptr, 16);
+      if (size == 0) {
+        connection.read_until("\r\n", &line);
+        const std::string body = "received " + std::to_string(stream_bytes) + " bytes";
+        connection.send_text("HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body);
+        return true;
+      }
+      if (!this->wait_for_(connection, size + 2, stop))
+        return false;
+      this->check_samples_(connection.data(), size);
+      connection.consume(size + 2);
+      stream_bytes += size;
+      if (this->cut_())
+        return false;
+    }
+    return false;
+  }
+
+  void serve_websocket_(ServerConnection &connection, const std::string &head, const std::atomic<bool> &stop) {
+    size_t key_start = head.find("Sec-WebSocket-Key: ");
+    if (key_start == std::string::npos)
+      return;
+    key_start += strlen("Sec-WebSocket-Key: ");
+    const std::string key = head.substr(key_start, head.find("\r\n", key_start) - key_start);
+    connection.send_text("HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                         "Sec-WebSocket-Accept: " +
+                         websocket_accept_key(key) + "\r\n\r\n");
+    // Ping once, the client has to answer from its poll
+    uint8_t ping[MAX_WEBSOCKET_HEADER_SIZE + 4];
+    size_t ping_size = build_websocket_frame_header(WS_OPCODE_PING, 4, nullptr, ping);
+    memcpy(ping + ping_size, "ping", 4);
+    connection.send_bytes(ping, ping_size + 4);
+
+    while (!stop.load()) {
+      WebSocketFrameHeader header;
+      size_t have = 2;
+      while (!this->wait_for_(connection, have, stop) ||
+             !parse_websocket_frame_header(connection.data(), have, &header)) {
+        if (stop.load() || this->closed_)
+          return;
+        have++;
+      }
+      if (!this->wait_for_(connection, header.header_size + header.payload_size, stop))
+        return;
+      uint8_t *payload = connection.data() + header.header_size;
+      if (header.masked)
+        apply_websocket_mask(payload, header.payload_size, header.mask);
+      if (header.opcode == WS_OPCODE_BINARY)
+        this->check_samples_(payload, header.payload_size);
+      else if (header.opcode == WS_OPCODE_PONG)
+        this->stats.pongs++;
+      else if (header.opcode == WS_OPCODE_CLOSE)
+        return;
+      connection.consume(header.header_size + header.payload_size);
+      if (this->cut_())
+        return;
+    }
+  }
+
+  /// Waits through receive timeouts until `size` bytes are buffered; false once the client is gone.
+  bool wait_for_(ServerConnection &connection, size_t size, const std::atomic<bool> &stop) {
+    this->closed_ = false;
+    while (!stop.load()) {
+      if (connection.need(size))
+        return true;
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        this->closed_ = true;
+        return false;
+      }
+    }
+    return false;
+  }
+
+  void check_samples_(const uint8_t *data, size_t size) {
+    for (size_t i = 0; i + 1 < size; i += 2) {
+      int16_t sample;
+      memcpy(&sample, data + i, sizeof(sample));
+      if (this->has_expected_ && sample != this->expected_)
+        this->stats.gaps++;
+      this->expected_ = static_cast<int16_t>(sample + 1);
+      this->has_expected_ = true;
+    }
+    this->stats.received += size;
+    this->connection_bytes_ += size;
+  }
+
+  bool cut_() {
+    if (this->options_.drop_after_kb == 0 || this->connection_bytes_ < this->options_.drop_after_kb * 1000ull)
+      return false;
+    this->stats.cut++;
+    return true;
+  }
+
+  const Options &options_;
+  int fd_{-1};
+  uint64_t connection_bytes_{0};
+  int16_t expected_{0};
+  bool has_expected_{false};
+  bool closed_{false};
+};
+
+/// Produces the capture sessions, a running sample counter in real time divided by --speed.
+static void capture(const Options &options, CaptureBuffer *buffer, std::atomic<bool> *end_requested,
+                    std::atomic<bool> *done) {
+  int16_t counter = 0;
+  std::vector<int16_t> block(CAPTURE_BLOCK_SAMPLES);
+  const auto block_duration =
+      std::chrono::duration<double>(CAPTURE_BLOCK_SAMPLES / static_cast<double>(SAMPLE_RATE) / options.speed);
+  for (uint32_t session = 0; session < options.sessions; session++) {
+    const size_t blocks = static_cast<size_t>(options.session_s * SAMPLE_RATE / CAPTURE_BLOCK_SAMPLES);
+    Clock::time_point next = Clock::now();
+    for (size_t i = 0; i < blocks; i++) {
+      for (int16_t &sample : block)
+        sample = counter++;
+      buffer->write(reinterpret_cast<const uint8_t *>(block.data()), block.size() * sizeof(int16_t));
+      next += std::chrono::duration_cast<Clock::duration>(block_duration);
+      std::this_thread::sleep_until(next);
+    }
+    end_requested->store(true);
+    std::this_thread::sleep_for(std::chrono::duration<double>(options.gap_s));
+  }
+  done->store(true);
+}
+
+int main(int argc, char **argv) {
+  Options options;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc) {
+      usage();
+      return 1;
+    }
+    const char *value = argv[++i];
+    if (arg == "--transport") {
+      options.transport = strcmp(value, "ws") == 0 ? UploadTransport::WEBSOCKET : UploadTransport::HTTP_CHUNKED;
+    } else if (arg == "--sessions") {
+      options.sessions = atoi(value);
+    } else if (arg == "--session-s") {
+      options.session_s = atof(value);
+    } else if (arg == "--gap-s") {
+      options.gap_s = atof(value);
+    } else if (arg == "--speed") {
+      options.speed = std::max(0.1, atof(value));
+    } else if (arg == "--packet-size") {
+      options.packet_size = std::max<size_t>(2, atoi(value) & ~1);
+    } else if (arg == "--refuse") {
+      options.refuse = atoi(value);
+    } else if (arg == "--drop-after") {
+      options.drop_after_kb = atoi(value);
+    } else if (arg == "--min-reconnect") {
+      options.min_reconnect_ms = atoi(value);
+    } else if (arg == "--max-reconnect") {
+      options.max_reconnect_ms = atoi(value);
+    } else if (arg == "--port") {
+      options.port = atoi(value);
+    } else {
+      usage();
+      return 1;
+    }
+  }
+
+  Server server(options);
+  if (!server.listen()) {
+    fprintf(stderr, "Cannot listen on 127.0.0.1:%u\n", options.port);
+    return 1;
+  }
+  std::atomic<bool> stop_server{false};
+  std::thread server_thread([&] { server.run(stop_server); });
+
+  CaptureBuffer buffer;
+  std::atomic<bool> end_requested{false};
+  std::atomic<bool> capture_done{false};
+  const Clock::time_point start = Clock::now();
+  std::thread capture_thread(capture, std::cref(options), &buffer, &end_requested, &capture_done);
+
+  UploadEndpoint endpoint;
+  endpoint.transport = options.transport;
+  endpoint.host = "127.0.0.1";
+  endpoint.port = options.port;
+  endpoint.path = "/stt";
+  UploadClient client;
+  client.set_endpoint(endpoint);
+  client.set_timeout_ms(1000);
+  ReconnectBackoff backoff;
+  backoff.set_delay_range_ms(options.min_reconnect_ms, options.max_reconnect_ms);
+  std::mt19937 random(1234);
+
+  std::vector<uint8_t> packet(options.packet_size);
+  size_t filled = 0;
+  uint32_t retry_at_ms = 0;
+  uint64_t sent = 0, dropped = 0;
+  uint32_t packets = 0, connects = 0, failures = 0, responses = 0;
+  uint32_t max_delay_ms = 0;
+  auto fail = [&]() {
+    client.close();
+    failures++;
+    uint32_t delay_ms = backoff.next_delay_ms(random());
+    max_delay_ms = std::max(max_delay_ms, delay_ms);
+    retry_at_ms = millis_since(start) + delay_ms;
+    fprintf(stderr, "failed: %s (errno %d, status %d), retrying in %u ms\n", client.get_error(),
+            client.get_error_number(), client.get_last_status(), delay_ms);
+  };
+
+  // MicUploader::upload_task()
+  while (!capture_done.load() || buffer.available() > 0 || end_requested.load() || filled > 0) {
+    filled += buffer.read(packet.data() + filled, packet.size() - filled, READ_TIMEOUT_MS);
+    const bool ending = end_requested.load() && buffer.available() == 0;
+    if (filled < packet.size() && !ending) {
+      if (filled == 0 && client.is_connected())
+        client.poll();
+      continue;
+    }
+
+    if (filled > 0 && !client.is_streaming()) {
+      if (static_cast<int32_t>(millis_since(start) - retry_at_ms) < 0) {
+        dropped += filled;
+        filled = 0;
+      } else {
+        if (!client.poll() && client.connect(random()))
+          connects++;
+        if (!client.is_connected() || !client.begin_stream()) {
+          dropped += filled;
+          filled = 0;
+          fail();
+        }
+      }
+    }
+    if (filled > 0) {
+      if (client.poll() && client.send(packet.data(), filled)) {
+        sent += filled;
+        packets++;
+        backoff.reset();
+      } else {
+        dropped += filled;
+        fail();
+      }
+      filled = 0;
+    }
+
+    if (ending) {
+      end_requested.store(false);
+      if (client.is_streaming()) {
+        if (!client.end_stream()) {
+          fail();
+        } else if (options.transport == UploadTransport::HTTP_CHUNKED) {
+          responses++;
+          fprintf(stderr, "stream ended, status %d: %s\n", client.get_last_status(), client.get_response().c_str());
+        }
+      }
+    }
+  }
+  const double seconds = millis_since(start) / 1000.0;
+  capture_thread.join();
+  // Let the server read what is still in flight before comparing
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  client.close();
+  stop_server.store(true);
+  server_thread.join();
+
+  const ServerStats &stats = server.stats;
+  printf("{\"transport\":\"%s\",\"packet_size\":%zu,\"seconds\":%.2f,\"captured\":%llu,\"overflowed\":%llu,"
+         "\"sent\":%llu,\"dropped\":%llu,\"packets\":%u,\"throughput_kBps\":%.1f,\"connects\":%u,\"failures\":%u,"
+         "\"max_backoff_ms\":%u,\"responses\":%u,\"server\":{\"connections\":%u,\"refused\":%u,\"cut\":%u,"
+         "\"streams\":%u,\"received\":%llu,\"gaps\":%u,\"pongs\":%u}}\n",
+         options.transport == UploadTransport::WEBSOCKET ? "ws" : "http", options.packet_size, seconds,
+         (unsigned long long) buffer.captured, (unsigned long long) buffer.overflowed, (unsigned long long) sent,
+         (unsigned long long) dropped, packets, sent / 1000.0 / seconds, connects, failures, max_delay_ms, responses,
+         stats.connections, stats.refused, stats.cut, stats.streams, (unsigned long long) stats.received, stats.gaps,
+         stats.pongs);
+  return 0;
+}
@@ -0,0 +1,116 @@
+#include "wav.h"
+
+#include <cstring>
+
+namespace host_sim {
+
+static uint32_t read_u32(const uint8_t *p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24); }
+static uint16_t read_u16(const uint8_t *p) { return p[0] | (p[1] << 8); }
+static void put_u32(uint8_t *p, uint32_t v) {
+  for (int i = 0; i < 4; i++)
+    p[i] = (v >> (8 * i)) & 0xFF;
+}
+static void put_u16(uint8_t *p, uint16_t v) {
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+}
+
+WavReader::~WavReader() {
+  if (this->file_ != nullptr)
+    fclose(this->file_);
+}
+
+bool WavReader::open(const std::string &path, std::string *error) {
+  this->file_ = fopen(path.c_str(), "rb");
+  if (this->file_ == nullptr) {
+    *error = "cannot open " + path;
+    return false;
+  }
+  uint8_t riff[12];
+  if (fread(riff, 1, sizeof(riff), this->file_) != sizeof(riff) || memcmp(riff, "RIFF", 4) != 0 ||
+      memcmp(riff + 8, "WAVE", 4) != 0) {
+    *error = path + " is not a WAV file";
+    return false;
+  }
+
+  bool have_format = false;
+  uint8_t chunk[8];
+  while (fread(chunk, 1, sizeof(chunk), this->file_) == sizeof(chunk)) {
+    uint32_t size = read_u32(chunk + 4);
+    if (memcmp(chunk, "fmt ", 4) == 0) {
+      uint8_t format[16];
+      if (size < sizeof(format) || fread(format, 1, sizeof(format), this->file_) != sizeof(format))
+        break;
+      fseek(this->file_, size - sizeof(format) + (size & 1), SEEK_CUR);
+      if (read_u16(format) != 1 || read_u16(format + 14) != 16) {
+        *error = path + " is not 16 bit PCM";
+        return false;
+      }
+      this->channels_ = read_u16(format + 2);
+      this->sample_rate_ = read_u32(format + 4);
+      have_format = this->channels_ > 0;
+    } else if (memcmp(chunk, "data", 4) == 0) {
+      if (!have_format)
+        break;
+      this->frames_ = size / (2 * this->channels_);
+      this->remaining_ = this->frames_;
+      return true;
+    } else {
+      fseek(this->file_, size + (size & 1), SEEK_CUR);
+    }
+  }
+  *error = path + " has no PCM data";
+  return false;
+}
+
+size_t WavReader::read(int16_t *samples, size_t frames) {
+  if (frames > this->remaining_)
+    frames = this->remaining_;
+  size_t read = fread(samples, 2 * this->channels_, frames, this->file_);
+  this->remaining_ -= read;
+  return read;
+}
+
+bool WavWriter::open(const std::string &path, uint32_t sample_rate, uint16_t channels) {
+  this->file_ = fopen(path.c_str(), "wb");
+  if (this->file_ == nullptr)
+    return false;
+  this->channels_ = channels;
+  uint8_t header[44] = {};
+  memcpy(header, "RIFF", 4);
+  memcpy(header + 8, "WAVEfmt ", 8);
+  put_u32(header + 16, 16);
+  put_u16(header + 20, 1);
+  put_u16(header + 22, channels);
+  put_u32(header + 24, sample_rate);
+  put_u32(header + 28, sample_rate * channels * 2);
+  put_u16(header + 32, channels * 2);
+  put_u16(header + 34, 16);
+  memcpy(header + 36, "data", 4);
+  fwrite(header, 1, sizeof(header), this->file_);
+  return true;
+}
+
+void WavWriter::write(const int16_t *samples, size_t frames) {
+  if (this->file_ == nullptr)
+    return;
+  fwrite(samples, 2 * this->channels_, frames, this->file_);
+  this->frames_ += frames;
+}
+
+void WavWriter::close() {
+  if (this->file_ == nullptr)
+    return;
+  uint32_t data_size = this->frames_ * this->channels_ * 2;
+  uint8_t size[4];
+  put_u32(size, 36 + data_size);
+  fseek(this->file_, 4, SEEK_SET);
+  fwrite(size, 1, 4, this->file_);
+  put_u32(size, data_size);
+  fseek(this->file_, 40, SEEK_SET);
+  fwrite(size, 1, 4, this->file_);
+  fclose(this->file_);
+  this->file_ = nullptr;
+}
+
+}  // namespace host_sim
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace host_sim {
+
+/// 16 bit PCM WAV files, samples interleaved.
+class WavReader {
+ public:
+  ~WavReader();
+  /// False with `error` set if the file is missing or not 16 bit PCM.
+  bool open(const std::string &path, std::string *error);
+  /// Reads up to `frames` frames, returns the number read, 0 at the end.
+  size_t read(int16_t *samples, size_t frames);
+
+  uint32_t get_sample_rate() const { return this->sample_rate_; }
+  uint16_t get_channels() const { return this->channels_; }
+  uint64_t get_frames() const { return this->frames_; }
+
+ protected:
+  FILE *file_{nullptr};
+  uint32_t sample_rate_{0};
+  uint16_t channels_{0};
+  uint64_t frames_{0};
+  uint64_t remaining_{0};
+};
+
+class WavWriter {
+ public:
+  ~WavWriter() { this->close(); }
+  bool open(const std::string &path, uint32_t sample_rate, uint16_t channels);
+  void write(const int16_t *samples, size_t frames);
+  /// Patches the header sizes, called by the destructor as well.
+  void close();
+
+  uint64_t get_frames() const { return this->frames_; }
+
+ protected:
+  FILE *file_{nullptr};
+  uint16_t channels_{0};
+  uint64_t frames_{0};
+};
+
+}  // namespace host_sim